@@ -0,0 +1,123 @@
+/*====================================================================
+Main.cpp
+This is the command line batch analyser. It scans folders for audio files, adds them to the OtoDecks library and runs the same
+TrackAnalyser the app uses on every CPU core, so the fingerprints, key, BPM, loudness and waveforms it writes are the ones the app
+reads. The library is saved every few seconds, so a scan that is stopped carries on from there when it is started again.
+====================================================================*/
+
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../Source/TrackLibrary.h"
+#include "../../Source/TrackAnalyser.h"
+#include "../../Source/WaveformCache.h"
+#include "../../Source/JobScheduler.h"
+
+static void printUsage()
+{
+    std::cout << "usage: OtoDecksAnalyser [--library=<file>] [--cache=<folder>] <folder or file>..." << std::endl
+              << "  --library  the library file to fill, the app's own library by default" << std::endl
+              << "  --cache    the waveform folder, the app's own waveform folder by default" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ArgumentList args(argc, argv);
+
+    File libraryFile = TrackLibrary::getDefaultLibraryFile();
+    File cacheFolder = WaveformCache::getDefaultCacheFolder();
+    Array<File> inputs;
+
+    for (const auto& arg : args.arguments) {
+        if (arg.text.startsWith("--library=")) {
+            libraryFile = File::getCurrentWorkingDirectory().getChildFile(arg.text.fromFirstOccurrenceOf("=", false, false).unquoted());
+        }
+        else if (arg.text.startsWith("--cache=")) {
+            cacheFolder = File::getCurrentWorkingDirectory().getChildFile(arg.text.fromFirstOccurrenceOf("=", false, false).unquoted());
+        }
+        else if (arg.isLongOption() || arg.isShortOption()) {
+            printUsage();
+            return 1;
+        }
+        else {
+            inputs.add(arg.resolveAsFile());
+        }
+    }
+
+    if (inputs.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    TrackLibrary library;
+    if (libraryFile.existsAsFile() && !library.loadFrom(libraryFile)) {
+        std::cout << "OtoDecksAnalyser: cannot read the library " << libraryFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    //nothing else runs here, so the library work may use every worker
+    JobScheduler jobScheduler;
+    jobScheduler.setConcurrencyLimit(JobScheduler::Priority::library, jobScheduler.getNumWorkers());
+
+    WaveformCache waveformCache(16, jobScheduler, cacheFolder);
+    TrackAnalyser analyser(formatManager, library, jobScheduler, &waveformCache);
+    analyser.indexLibraryFingerprints();
+
+    //finds every file the app could play in the folders
+    Array<File> files;
+    for (const auto& input : inputs) {
+        if (input.isDirectory()) {
+            files.addArray(input.findChildFiles(File::findFiles, true, formatManager.getWildcardForAllFormats()));
+        }
+        else if (input.existsAsFile()) {
+            files.add(input);
+        }
+        else {
+            std::cout << "OtoDecksAnalyser: " << input.getFullPathName() << " does not exist" << std::endl;
+        }
+    }
+
+    int numQueued = 0;
+    for (const auto& file : files) {
+        if (analyser.analyseTrack(library.addTrack(file))) {
+            ++numQueued;
+        }
+    }
+
+    std::cout << "OtoDecksAnalyser: " << files.size() << " tracks found, " << files.size() - numQueued
+              << " already analysed, analysing " << numQueued << " on " << jobScheduler.getNumWorkers() << " threads" << std::endl;
+
+    const int checkpointMs = 10000;
+    auto startMs = Time::getMillisecondCounterHiRes();
+    auto lastCheckpointMs = startMs;
+
+    while (analyser.getNumPendingJobs() > 0) {
+        Thread::sleep(1000);
+
+        auto nowMs = Time::getMillisecondCounterHiRes();
+        int numDone = numQueued - analyser.getNumPendingJobs();
+        double tracksPerSecond = numDone / jmax(0.001, (nowMs - startMs) / 1000.0);
+
+        std::cout << "\r" << numDone << "/" << numQueued << " tracks, " << String(tracksPerSecond, 2) << " tracks/s   " << std::flush;
+
+        //saves what is finished so far, so stopping the scan loses at most the tracks that were being analysed
+        if (nowMs - lastCheckpointMs >= checkpointMs) {
+            library.saveTo(libraryFile);
+            lastCheckpointMs = nowMs;
+        }
+    }
+
+    if (!library.saveTo(libraryFile)) {
+        std::cout << std::endl << "OtoDecksAnalyser: cannot write the library " << libraryFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    double seconds = (Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+    std::cout << std::endl << "OtoDecksAnalyser: " << numQueued << " tracks in " << String(seconds, 1) << " s ("
+              << String(numQueued / jmax(0.001, seconds), 2) << " tracks/s), library saved to " << libraryFile.getFullPathName() << std::endl;
+    return 0;
+}
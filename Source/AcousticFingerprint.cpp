@@ -0,0 +1,196 @@
+/*====================================================================
+AcousticFingerprint.cpp
+This class turns decoded audio into a small set of landmark hashes (pairs of spectral peaks) and keeps an index of those hashes so that
+the same song stored under another name or format can be found quickly.
+====================================================================*/
+
+
+#include "AcousticFingerprint.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //fft bin edges of the bands that peaks are picked from (about 54Hz to 3.4kHz at the analysis rate)
+    const int bandEdges[] = { 10, 20, 40, 80, 160, 320, 640 };
+
+    //only a quarter of the landmarks are kept. the choice depends on the hash alone, so two copies of a song keep the same ones
+    bool isKeptHash(uint32 hash)
+    {
+        return ((hash * 2654435761u) >> 30) == 0;
+    }
+
+    uint32 makeHash(int anchorBin, int targetBin, uint32 frameDelta)
+    {
+        return ((uint32) (anchorBin >> 1) << 15) | ((uint32) (targetBin >> 1) << 6) | (frameDelta & 0x3f);
+    }
+}
+
+FingerprintExtractor::FingerprintExtractor()
+    : frameBuffer((size_t) fftSize, 0.0f),
+      fftData((size_t) fftSize * 2, 0.0f)
+{
+}
+
+//this function collects samples into overlapping frames and analyses every complete frame
+void FingerprintExtractor::pushSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        int toCopy = jmin(numSamples, fftSize - samplesInFrame);
+        std::copy(samples, samples + toCopy, frameBuffer.begin() + samplesInFrame);
+
+        samplesInFrame += toCopy;
+        samples += toCopy;
+        numSamples -= toCopy;
+
+        if (samplesInFrame == fftSize) {
+            processFrame();
+
+            //keep the second half of the frame as the start of the next one
+            std::copy(frameBuffer.begin() + hopSize, frameBuffer.end(), frameBuffer.begin());
+            samplesInFrame = fftSize - hopSize;
+        }
+    }
+}
+
+//this function finds the strongest peaks of one frame and emits the landmarks of the frame that just left the target zone
+void FingerprintExtractor::processFrame()
+{
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    std::copy(frameBuffer.begin(), frameBuffer.end(), fftData.begin());
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    //strongest bin of each band and how far it stands out from that band's recent average
+    int peakBins[numBands];
+    float contrast[numBands];
+
+    for (int band = 0; band < numBands; ++band) {
+        int bestBin = bandEdges[band];
+        for (int bin = bandEdges[band] + 1; bin < bandEdges[band + 1]; ++bin) {
+            if (fftData[(size_t) bin] > fftData[(size_t) bestBin]) {
+                bestBin = bin;
+            }
+        }
+
+        float level = std::log(fftData[(size_t) bestBin] + 1.0e-6f);
+        contrast[band] = (fftData[(size_t) bestBin] > 1.0e-3f) ? level - bandAverage[band] : -1.0f;
+        bandAverage[band] += 0.05f * (level - bandAverage[band]);
+        peakBins[band] = bestBin;
+    }
+
+    FramePeaks& peaks = recentPeaks[numFrames % recentPeaks.size()];
+    peaks.frame = numFrames;
+    peaks.numPeaks = 0;
+
+    //keeps up to maxPeaksPerFrame bands, strongest contrast first
+    int order[numBands];
+    for (int band = 0; band < numBands; ++band) {
+        order[band] = band;
+    }
+    std::sort(order, order + numBands, [&contrast](int a, int b) { return contrast[a] > contrast[b]; });
+
+    for (int i = 0; i < maxPeaksPerFrame; ++i) {
+        if (contrast[order[i]] > 0.0f) {
+            peaks.bins[peaks.numPeaks++] = peakBins[order[i]];
+        }
+    }
+
+    if (numFrames >= (uint32) targetZoneFrames) {
+        emitLandmarks(numFrames - targetZoneFrames, numFrames);
+    }
+
+    ++numFrames;
+}
+
+//this function pairs every peak of the anchor frame with the first peaks that follow it inside the target zone
+void FingerprintExtractor::emitLandmarks(uint32 anchorFrame, uint32 lastFrame)
+{
+    const FramePeaks& anchor = recentPeaks[anchorFrame % recentPeaks.size()];
+    uint32 zoneEnd = jmin(lastFrame, anchorFrame + (uint32) targetZoneFrames);
+
+    for (int p = 0; p < anchor.numPeaks; ++p) {
+        int pairs = 0;
+
+        for (uint32 frame = anchorFrame + 1; frame <= zoneEnd && pairs < fanOut; ++frame) {
+            const FramePeaks& target = recentPeaks[frame % recentPeaks.size()];
+
+            for (int q = 0; q < target.numPeaks && pairs < fanOut; ++q, ++pairs) {
+                uint32 hash = makeHash(anchor.bins[p], target.bins[q], frame - anchorFrame);
+                if (isKeptHash(hash)) {
+                    result.landmarks.push_back({ hash, anchorFrame });
+                }
+            }
+        }
+    }
+}
+
+//this function emits the frames still waiting for their target zone and hands over the fingerprint
+AcousticFingerprint FingerprintExtractor::finish()
+{
+    if (numFrames > 0) {
+        uint32 lastFrame = numFrames - 1;
+        uint32 firstPending = numFrames > (uint32) targetZoneFrames ? numFrames - targetZoneFrames : 0;
+
+        for (uint32 anchor = firstPending; anchor < lastFrame; ++anchor) {
+            emitLandmarks(anchor, lastFrame);
+        }
+    }
+
+    return std::move(result);
+}
+
+//this function votes for (track, time offset) pairs of matching hashes and reports the best match if enough landmarks line up
+int DuplicateIndex::addAndFindDuplicate(int trackId, const AcousticFingerprint& fingerprint)
+{
+    if (landmarkCounts.count(trackId) > 0) {
+        return -1; //already indexed
+    }
+
+    std::unordered_map<uint64, int> votes;
+
+    for (const auto& landmark : fingerprint.landmarks) {
+        auto found = postings.find(landmark.hash);
+        if (found == postings.end() || found->second.size() > maxPostingsPerHash) {
+            continue;
+        }
+
+        for (const auto& posting : found->second) {
+            auto offset = (int64) posting.frame - (int64) landmark.frame;
+            votes[((uint64) (uint32) posting.trackId << 32) | (uint32) (offset + 0x7fffffff)]++;
+        }
+    }
+
+    int bestTrack = -1;
+    int bestScore = 0;
+
+    for (const auto& vote : votes) {
+        //neighbouring offsets are added in because frames of two encodings rarely line up exactly
+        auto before = votes.find(vote.first - 1);
+        auto after = votes.find(vote.first + 1);
+        int score = vote.second
+                  + (before != votes.end() ? before->second : 0)
+                  + (after != votes.end() ? after->second : 0);
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestTrack = (int) (vote.first >> 32);
+        }
+    }
+
+    int numLandmarks = (int) fingerprint.landmarks.size();
+    if (bestTrack >= 0) {
+        int shorter = jmin(numLandmarks, landmarkCounts[bestTrack]);
+        if (bestScore < jmax(12, shorter / 20)) {
+            bestTrack = -1;
+        }
+    }
+
+    for (const auto& landmark : fingerprint.landmarks) {
+        postings[landmark.hash].push_back({ trackId, landmark.frame });
+    }
+    landmarkCounts[trackId] = numLandmarks;
+
+    return bestTrack;
+}
@@ -0,0 +1,92 @@
+/*====================================================================
+AcousticFingerprint.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+//a compact landmark fingerprint of a track. every landmark is a pair of spectral peaks hashed together with the frame where the pair starts
+struct AcousticFingerprint
+{
+    struct Landmark
+    {
+        uint32 hash;
+        uint32 frame;
+    };
+
+    std::vector<Landmark> landmarks;
+
+    bool isEmpty() const { return landmarks.empty(); }
+};
+
+//this class builds a fingerprint from a mono stream at analysisSampleRate. it works frame by frame so the memory used stays the same for any track length
+class FingerprintExtractor
+{
+public:
+    //every file is resampled to this rate first so the same song in different formats gives the same hashes
+    static constexpr double analysisSampleRate = 11025.0;
+
+    FingerprintExtractor();
+
+    void pushSamples(const float* samples, int numSamples);
+
+    //flushes the last frames and returns the finished fingerprint
+    AcousticFingerprint finish();
+
+private:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+    static constexpr int numBands = 6;
+    static constexpr int maxPeaksPerFrame = 3;
+    static constexpr int targetZoneFrames = 32;
+    static constexpr int fanOut = 3;
+
+    struct FramePeaks
+    {
+        uint32 frame = 0;
+        int numPeaks = 0;
+        int bins[maxPeaksPerFrame] = {};
+    };
+
+    void processFrame();
+    void emitLandmarks(uint32 anchorFrame, uint32 lastFrame);
+
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+
+    std::vector<float> frameBuffer;
+    std::vector<float> fftData;
+    int samplesInFrame = 0;
+
+    float bandAverage[numBands] = {};
+    std::array<FramePeaks, targetZoneFrames + 1> recentPeaks;
+    uint32 numFrames = 0;
+
+    AcousticFingerprint result;
+};
+
+//this class is an inverted index from landmark hash to the tracks that contain it. a new track is matched by voting on the time offset of shared hashes, so finding duplicates never compares tracks pairwise
+class DuplicateIndex
+{
+public:
+    //adds the fingerprint to the index and returns the id of an already indexed track that sounds the same, or -1 if there is none
+    int addAndFindDuplicate(int trackId, const AcousticFingerprint& fingerprint);
+
+private:
+    struct Posting
+    {
+        int trackId;
+        uint32 frame;
+    };
+
+    //hashes that appear in this many places say nothing about a specific song, so they are skipped when voting
+    static constexpr size_t maxPostingsPerHash = 256;
+
+    std::unordered_map<uint32, std::vector<Posting>> postings;
+    std::unordered_map<int, int> landmarkCounts;
+};
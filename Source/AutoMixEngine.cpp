@@ -0,0 +1,270 @@
+/*====================================================================
+AutoMixEngine.cpp
+This class runs the automix mode. It watches the playing deck from a timer, preloads the next playlist entry into the idle deck with
+DeckGUI::loadTrackInBackground and starts a timed crossfade when the playing track reaches its outro. The gain ramps themselves run on
+the audio thread inside DJAudioPlayer.
+====================================================================*/
+
+
+#include "AutoMixEngine.h"
+#include "DeckGUI.h"
+#include "PlaylistComponent.h"
+#include <cmath>
+
+AutoMixEngine::AutoMixEngine(DeckGUI& deck1, DeckGUI& deck2, PlaylistComponent& _playlist, TrackLibrary& _library)
+    : deckGUI1(deck1),
+      deckGUI2(deck2),
+      playlist(_playlist),
+      library(_library)
+{
+}
+
+AutoMixEngine::~AutoMixEngine()
+{
+    stopTimer();
+}
+
+//this function turns automix on or off. when it is turned on it carries on from whatever is playing, or starts the playlist from the top
+void AutoMixEngine::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled == enabled) {
+        return;
+    }
+
+    if (!shouldBeEnabled) {
+        //leaves the decks in a state the user can carry on from
+        if (state == State::crossfading) {
+            finishCrossfade();
+        }
+        stopTimer();
+        enabled = false;
+        state = State::idle;
+        deckGUI1.getPlayer()->fadeTo(1.0f, 0.0);
+        deckGUI2.getPlayer()->fadeTo(1.0f, 0.0);
+        return;
+    }
+
+    enabled = true;
+    state = State::idle;
+
+    //the playing deck goes out first, otherwise a deck that is loaded
+    if (deckGUI1.getPlayer()->isPlaying() || (deckGUI1.CheckAudioLoaded() && !deckGUI2.getPlayer()->isPlaying())) {
+        outgoing = &deckGUI1;
+        incoming = &deckGUI2;
+    }
+    else {
+        outgoing = &deckGUI2;
+        incoming = &deckGUI1;
+    }
+
+    if (outgoing->CheckAudioLoaded()) {
+        outgoing->getPlayer()->start();
+        nextRow = findRowOf(*outgoing) + 1;
+
+        //a track the user already put on the other deck is mixed in next
+        if (incoming->CheckAudioLoaded()) {
+            incoming->getPlayer()->fadeTo(0.0f, 0.0);
+            state = State::ready;
+        }
+        else {
+            preloadNextTrack();
+        }
+    }
+    else if (playlist.getNumRows() > 0) {
+        //nothing is loaded, so the first entry is loaded and started
+        nextRow = 1;
+        state = State::preloading;
+        outgoing->loadTrackInBackground(playlist.getTrack(0), [this](bool loaded) {
+            if (!enabled) {
+                return;
+            }
+            if (loaded) {
+                outgoing->getPlayer()->start();
+            }
+            preloadNextTrack();
+        });
+    }
+
+    startTimer(20);
+}
+
+//this function returns whether automix is on
+bool AutoMixEngine::isEnabled() const
+{
+    return enabled;
+}
+
+//this function sets how long the crossfade takes
+void AutoMixEngine::setCrossfadeSeconds(double seconds)
+{
+    crossfadeSeconds = jmax(0.5, seconds);
+}
+
+//this function sets whether the crossfade starts on a beat
+void AutoMixEngine::setBeatAligned(bool shouldAlignBeats)
+{
+    beatAligned = shouldAlignBeats;
+}
+
+//this function loads the next playlist entry into the idle deck, keeping it silent until the crossfade
+void AutoMixEngine::preloadNextTrack()
+{
+    if (!enabled || incoming == nullptr) {
+        return;
+    }
+
+    if (nextRow >= playlist.getNumRows()) {
+        state = State::idle; //end of the playlist
+        return;
+    }
+
+    state = State::preloading;
+    incoming->loadTrackInBackground(playlist.getTrack(nextRow++), [this](bool loaded) {
+        if (!enabled) {
+            return;
+        }
+
+        if (loaded) {
+            incoming->getPlayer()->fadeTo(0.0f, 0.0);
+            state = State::ready;
+        }
+        else {
+            preloadNextTrack(); //skips files that cannot be read
+        }
+    });
+}
+
+//this function watches the playing deck and starts or finishes the crossfade
+void AutoMixEngine::timerCallback()
+{
+    if (!enabled || outgoing == nullptr) {
+        return;
+    }
+
+    if (state == State::crossfading) {
+        bool fadeDone = Time::getMillisecondCounter() - crossfadeStartMs >= (uint32) (crossfadeSeconds * 1000.0);
+        if (fadeDone || !outgoing->getPlayer()->isPlaying()) {
+            finishCrossfade();
+        }
+        return;
+    }
+
+    double phase = getBeatPhase(*outgoing);
+
+    if (state == State::ready) {
+        double secondsLeft = getSecondsLeft(*outgoing);
+
+        if (secondsLeft <= crossfadeSeconds) {
+            //waits for the outgoing track to cross a beat, but never longer than half the crossfade
+            bool canAlign = beatAligned && phase >= 0.0 && getBeatPhase(*incoming) >= 0.0;
+            bool onBeat = phase < previousPhase;
+
+            if (!canAlign || onBeat || secondsLeft <= crossfadeSeconds * 0.5) {
+                startCrossfade();
+            }
+        }
+    }
+
+    previousPhase = phase;
+}
+
+//this function starts the incoming deck (tempo and phase matched when both tracks have a beat grid) and ramps both fades
+void AutoMixEngine::startCrossfade()
+{
+    DJAudioPlayer* incomingPlayer = incoming->getPlayer();
+    DJAudioPlayer* outgoingPlayer = outgoing->getPlayer();
+
+    double startPosition = 0.0;
+
+    int outgoingId = getTrackId(*outgoing);
+    int incomingId = getTrackId(*incoming);
+    double outgoingBpm = library.getBpm(outgoingId);
+    double incomingBpm = library.getBpm(incomingId);
+
+    if (beatAligned && outgoingBpm > 0.0 && incomingBpm > 0.0) {
+        //matches the tempo when the tracks are close enough for it not to sound odd
+        double ratio = outgoingBpm * outgoingPlayer->getSpeed() / incomingBpm;
+        if (std::abs(ratio - 1.0) <= 0.08) {
+            incoming->setSpeed(ratio);
+        }
+
+        //starts the incoming track at the same point of its beat as the outgoing track
+        startPosition = library.getFirstBeat(incomingId) + jmax(0.0, getBeatPhase(*outgoing)) * 60.0 / incomingBpm;
+    }
+
+    incomingPlayer->setPosition(startPosition);
+    incomingPlayer->start();
+
+    //keeps the beats locked for the whole crossfade instead of trusting the ratio set above
+    if (beatAligned && outgoingBpm > 0.0 && incomingBpm > 0.0) {
+        incomingPlayer->setSyncMaster(outgoingPlayer);
+    }
+    incomingPlayer->fadeTo(1.0f, crossfadeSeconds);
+    outgoingPlayer->fadeTo(0.0f, crossfadeSeconds);
+
+    state = State::crossfading;
+    crossfadeStartMs = Time::getMillisecondCounter();
+}
+
+//this function clears the deck that faded out and makes it the idle deck for the next track
+void AutoMixEngine::finishCrossfade()
+{
+    //the incoming deck carries on at the ratio automix gave it
+    incoming->getPlayer()->setSyncMaster(nullptr);
+    outgoing->unloadTrack();
+    outgoing->getPlayer()->fadeTo(1.0f, 0.0);
+
+    std::swap(outgoing, incoming);
+    state = State::idle;
+    previousPhase = 0.0;
+
+    preloadNextTrack();
+}
+
+//this function returns the playing position of a deck in seconds
+double AutoMixEngine::getPositionSeconds(DeckGUI& deck) const
+{
+    DJAudioPlayer* player = deck.getPlayer();
+    double length = player->getLength();
+    return length > 0.0 ? player->getPosition() * length : 0.0;
+}
+
+//this function returns how many seconds of real time are left before the deck's track ends
+double AutoMixEngine::getSecondsLeft(DeckGUI& deck) const
+{
+    DJAudioPlayer* player = deck.getPlayer();
+    double speed = jmax(0.01, player->getSpeed());
+    return (player->getLength() - getPositionSeconds(deck)) / speed;
+}
+
+//this function returns the phase of the current beat of a deck from its beat grid
+double AutoMixEngine::getBeatPhase(DeckGUI& deck) const
+{
+    int trackId = getTrackId(deck);
+    double bpm = library.getBpm(trackId);
+    if (bpm <= 0.0) {
+        return -1.0;
+    }
+
+    double beats = (getPositionSeconds(deck) - library.getFirstBeat(trackId)) * bpm / 60.0;
+    return beats - std::floor(beats);
+}
+
+//this function returns the library id of the track loaded on a deck
+int AutoMixEngine::getTrackId(DeckGUI& deck) const
+{
+    return library.getTrackId(deck.getLoadedURL().getLocalFile());
+}
+
+//this function returns the playlist row of the deck's track, -1 if it is not in the playlist
+int AutoMixEngine::findRowOf(DeckGUI& deck) const
+{
+    juce::URL url = deck.getLoadedURL();
+
+    for (int row = 0; row < playlist.getNumRows(); ++row) {
+        if (playlist.getTrack(row) == url) {
+            return row;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,73 @@
+/*====================================================================
+AutoMixEngine.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TrackLibrary.h"
+
+class DeckGUI;
+class PlaylistComponent;
+
+//this class mixes through the playlist on its own. while one deck plays, the next entry is loaded into the other deck in the background,
+//and when the playing track reaches its outro the two decks are crossfaded (starting on a beat when both tracks have a beat grid)
+class AutoMixEngine : private Timer
+{
+public:
+    AutoMixEngine(DeckGUI& deck1, DeckGUI& deck2, PlaylistComponent& playlist, TrackLibrary& library);
+    ~AutoMixEngine() override;
+
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const;
+
+    //length of the crossfade in seconds and whether it waits for a beat of the outgoing track
+    void setCrossfadeSeconds(double seconds);
+    void setBeatAligned(bool shouldAlignBeats);
+
+private:
+    enum class State
+    {
+        idle,        //nothing is waiting on the other deck
+        preloading,  //the next track is loading in the background
+        ready,       //the next track is loaded and waiting for the outro
+        crossfading  //both decks are playing
+    };
+
+    void timerCallback() override;
+
+    void preloadNextTrack();
+    void startCrossfade();
+    void finishCrossfade();
+
+    //position in seconds and time left (at the current speed) of a deck
+    double getPositionSeconds(DeckGUI& deck) const;
+    double getSecondsLeft(DeckGUI& deck) const;
+
+    //how far through the current beat the deck is, from 0 to 1, or -1 if its track has no beat grid
+    double getBeatPhase(DeckGUI& deck) const;
+    int getTrackId(DeckGUI& deck) const;
+
+    //finds the playlist row of a deck's track so automix continues from there
+    int findRowOf(DeckGUI& deck) const;
+
+    DeckGUI& deckGUI1;
+    DeckGUI& deckGUI2;
+    PlaylistComponent& playlist;
+    TrackLibrary& library;
+
+    DeckGUI* outgoing = nullptr;
+    DeckGUI* incoming = nullptr;
+
+    State state = State::idle;
+    bool enabled = false;
+    int nextRow = 0;
+
+    double crossfadeSeconds = 8.0;
+    bool beatAligned = true;
+
+    double previousPhase = 0.0;
+    uint32 crossfadeStartMs = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoMixEngine)
+};
@@ -0,0 +1,452 @@
+/*====================================================================
+AutomationLog.cpp
+This class records the control changes of a set. A change made on the audio thread (the command queues of the decks and pads) is
+stamped where it is applied. A change made on another thread is posted for its target, and the target stamps it with its next block,
+which is the first block that can hear it. The "Automation log" thread writes the events as the samples since the last event, one byte
+for the target and type, and only the fields that type uses.
+====================================================================*/
+
+
+#include "AutomationLog.h"
+
+//the first bytes of every log, followed by the format version
+static const char magic[] = { 'O', 'T', 'O', 'A' };
+static constexpr int formatVersion = 2;
+
+//the fields an event of each type writes
+static constexpr int indexField = 1;
+static constexpr int valueField = 2;
+static constexpr int value2Field = 4;
+static constexpr int textField = 8;
+
+//the target goes in the top 2 bits of the type byte
+static_assert((int) AutomationLog::Type::numTypes <= 64, "the type has to fit in 6 bits");
+
+static int getFields(AutomationLog::Type type)
+{
+    using Type = AutomationLog::Type;
+
+    switch (type) {
+        case Type::prepare:
+        case Type::doubleStart:
+        case Type::command:
+        case Type::hotCueSet:
+        case Type::effectEnabled:
+        case Type::effectMix:
+        case Type::padTrigger:
+        case Type::padLooping:
+            return indexField | valueField;
+        case Type::blockSize:
+        case Type::hotCueTrigger:
+        case Type::hotCueRelease:
+        case Type::hotCueClear:
+        case Type::reverse:
+        case Type::slip:
+        case Type::syncMaster:
+        case Type::padStop:
+        case Type::padClear:
+            return indexField;
+        case Type::position:
+        case Type::volume:
+        case Type::speed:
+        case Type::scratchVelocity:
+        case Type::padGain:
+            return valueField;
+        case Type::fade:
+        case Type::beatGrid:
+            return valueField | value2Field;
+        case Type::load:
+            return textField;
+        case Type::doubleFrom:
+        case Type::padLoad:
+            return indexField | textField;
+        default:
+            return 0;
+    }
+}
+
+thread_local int AutomationLog::Action::depth = 0;
+
+AutomationLog::Action::Action(AutomationLog* _log, Target target, Type type, int index, double value, double value2, const String& text)
+    : log(_log),
+      outermost(depth == 0)
+{
+    event.target = target;
+    event.type = type;
+    event.index = index;
+    event.value = value;
+    event.value2 = value2;
+    event.text = text;
+    ++depth;
+}
+
+AutomationLog::Action::~Action()
+{
+    --depth;
+    if (outermost && log != nullptr) {
+        log->post(event);
+    }
+}
+
+//this function checks if an action is running on the calling thread
+bool AutomationLog::Action::isRunning()
+{
+    return depth > 0;
+}
+
+AutomationLog::Reader::Reader(const File& file)
+{
+    std::unique_ptr<FileInputStream> input(file.createInputStream());
+    if (input == nullptr || input->failedToOpen()) {
+        return;
+    }
+
+    char header[sizeof(magic)] = {};
+    if (input->read(header, (int) sizeof(magic)) != (int) sizeof(magic) || memcmp(header, magic, sizeof(magic)) != 0) {
+        return;
+    }
+
+    if (input->readByte() != formatVersion) {
+        std::cout << "AutomationLog::Reader " << file.getFileName() << " is from another version" << std::endl;
+        return;
+    }
+    limiterLookaheadMs = input->readDouble();
+
+    //the events are read a few bytes at a time
+    stream.reset(new BufferedInputStream(input.release(), 65536, true));
+    valid = true;
+}
+
+//this function checks if the file was an automation log
+bool AutomationLog::Reader::isValid() const
+{
+    return valid;
+}
+
+//this function returns the limiter look-ahead from the header
+double AutomationLog::Reader::getLimiterLookaheadMs() const
+{
+    return limiterLookaheadMs;
+}
+
+//this function reads the next event, a log that was cut short by a crash ends at its last whole event
+bool AutomationLog::Reader::readNext(Event& event)
+{
+    if (!valid || stream->getNumBytesRemaining() < 2) {
+        return false;
+    }
+
+    int delta = stream->readCompressedInt();
+    if (delta < 0) {
+        if (stream->getNumBytesRemaining() < 8) {
+            return false;
+        }
+        delta = 0;
+        sample += stream->readInt64();
+    }
+    sample += delta;
+
+    uint8 code = (uint8) stream->readByte();
+    event = {};
+    event.sample = sample;
+    event.target = (Target) (code >> 6);
+    event.type = (Type) (code & 63);
+
+    if (event.type >= Type::numTypes) {
+        std::cout << "AutomationLog::Reader type should be below " << (int) Type::numTypes << std::endl;
+        valid = false;
+        return false;
+    }
+
+    int fields = getFields(event.type);
+    if (fields & indexField) {
+        if (stream->isExhausted()) {
+            return false;
+        }
+        event.index = stream->readCompressedInt();
+    }
+    if (fields & valueField) {
+        if (stream->getNumBytesRemaining() < 8) {
+            return false;
+        }
+        event.value = stream->readDouble();
+    }
+    if (fields & value2Field) {
+        if (stream->getNumBytesRemaining() < 8) {
+            return false;
+        }
+        event.value2 = stream->readDouble();
+    }
+    if (fields & textField) {
+        event.text = stream->readString();
+    }
+    return true;
+}
+
+AutomationLog::AutomationLog()
+{
+    writerThread.addTimeSliceClient(this);
+    writerThread.startThread(Thread::Priority::low);
+}
+
+AutomationLog::~AutomationLog()
+{
+    stop();
+    writerThread.removeTimeSliceClient(this);
+    writerThread.stopThread(2000);
+}
+
+//this function opens the file, writes the header and lets the threads start posting
+bool AutomationLog::start(const File& file, double limiterLookaheadMs)
+{
+    stop();
+
+    const ScopedLock sl(writerLock);
+
+    file.deleteFile();
+    std::unique_ptr<FileOutputStream> output(file.createOutputStream());
+    if (output == nullptr || output->failedToOpen()) {
+        std::cout << "AutomationLog: cannot write to " << file.getFullPathName() << std::endl;
+        return false;
+    }
+
+    output->write(magic, sizeof(magic));
+    output->writeByte((char) formatVersion);
+    output->writeDouble(limiterLookaheadMs);
+    stream = std::move(output);
+
+    //nothing is left over from an earlier log
+    fifo.reset();
+    for (auto& target : posted) {
+        target.fifo.reset();
+    }
+    {
+        const ScopedLock tl(textLock);
+        texts.clear();
+    }
+
+    lastWrittenSample = 0;
+    nextBlockStart = 0;
+    sampleRate = 0.0;
+    droppedEvents = 0;
+    recording = true;
+    return true;
+}
+
+//this function writes what is still waiting, marks the end of the session and closes the file
+void AutomationLog::stop()
+{
+    if (!recording.exchange(false)) {
+        return;
+    }
+
+    const ScopedLock sl(writerLock);
+    writePendingEvents();
+
+    //the end says how long the session ran, so the replay renders the audio after the last change too
+    writeEntry({ nextBlockStart.load(), Target::master, Type::end, 0, 0.0, 0.0, -1 }, {});
+    stream->flush();
+    stream.reset();
+
+    if (droppedEvents.load() > 0) {
+        std::cout << "AutomationLog: " << droppedEvents.load() << " events did not fit in the queue, the log cannot be replayed exactly" << std::endl;
+    }
+}
+
+//this function checks if a log is being written
+bool AutomationLog::isRecording() const
+{
+    return recording.load();
+}
+
+//this function posts the device being prepared, the engine is prepared the same way at the same sample when it is replayed
+void AutomationLog::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    //the samples of the log are counted at one rate
+    double loggedRate = sampleRate.load();
+    if (loggedRate > 0.0 && newSampleRate != loggedRate) {
+        std::cout << "AutomationLog: the sample rate changed, the log was stopped" << std::endl;
+        stop();
+        return;
+    }
+    sampleRate = newSampleRate;
+
+    Event event;
+    event.target = Target::master;
+    event.type = Type::prepare;
+    event.index = samplesPerBlockExpected;
+    event.value = newSampleRate;
+    post(event);
+}
+
+//this function moves the master clock on by one block and stamps the block size when it changes
+void AutomationLog::beginBlock(int numSamples)
+{
+    if (!recording.load()) {
+        return;
+    }
+
+    blockStart = nextBlockStart.load();
+    nextBlockStart = blockStart + numSamples;
+
+    collect(Target::master);
+
+    //the replay renders the same blocks, the engine's smoothing and ramps go block by block
+    if (numSamples != lastBlockSize || blockStart == 0) {
+        lastBlockSize = numSamples;
+        push({ blockStart, Target::master, Type::blockSize, numSamples, 0.0, 0.0, -1 });
+    }
+}
+
+//this function moves the actions posted for the target to the writer, stamped with the start of this block
+void AutomationLog::collect(Target target)
+{
+    if (!recording.load()) {
+        return;
+    }
+
+    Posted& source = posted[(int) target];
+
+    int start1, size1, start2, size2;
+    source.fifo.prepareToRead(source.fifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1 + size2; ++i) {
+        Entry entry = source.entries[i < size1 ? start1 + i : start2 + i - size1];
+        entry.sample = blockStart;
+        push(entry);
+    }
+    source.fifo.finishedRead(size1 + size2);
+}
+
+//this function stamps a change made on the audio thread
+void AutomationLog::record(Target target, Type type, int index, double value, double value2, int offset)
+{
+    if (!recording.load()) {
+        return;
+    }
+
+    push({ blockStart + offset, target, type, index, value, value2, -1 });
+}
+
+//this function returns how many events were dropped
+int64 AutomationLog::getNumDroppedEvents() const
+{
+    return droppedEvents.load();
+}
+
+//this function returns a new file next to the recordings of the sets
+File AutomationLog::getDefaultLogFile()
+{
+    File folder = File::getSpecialLocation(File::userMusicDirectory).getChildFile("OtoDecks Recordings");
+    folder.createDirectory();
+    return folder.getNonexistentChildFile("Automation " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M"), ".otolog");
+}
+
+//this function keeps the text of an action aside and queues it for its target
+void AutomationLog::post(const Event& event)
+{
+    if (!recording.load()) {
+        return;
+    }
+
+    Entry entry{ 0, event.target, event.type, event.index, event.value, event.value2, -1 };
+    if (event.text.isNotEmpty()) {
+        const ScopedLock tl(textLock);
+        entry.text = texts.size();
+        texts.add(event.text);
+    }
+
+    Posted& target = posted[(int) event.target];
+    const SpinLock::ScopedLockType sl(target.writeLock);
+
+    int start1, size1, start2, size2;
+    target.fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 < 1) {
+        ++droppedEvents;
+        return;
+    }
+
+    target.entries[size1 > 0 ? start1 : start2] = entry;
+    target.fifo.finishedWrite(1);
+}
+
+//this function queues a stamped event for the writer thread, only the audio thread pushes
+void AutomationLog::push(const Entry& entry)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 < 1) {
+        ++droppedEvents;
+        return;
+    }
+
+    entries[size1 > 0 ? start1 : start2] = entry;
+    fifo.finishedWrite(1);
+}
+
+//this function runs on the writer thread, the file is flushed after every batch so a crash leaves the log up to it
+int AutomationLog::useTimeSlice()
+{
+    const ScopedLock sl(writerLock);
+
+    if (stream != nullptr && fifo.getNumReady() > 0) {
+        writePendingEvents();
+        stream->flush();
+    }
+    return 50;
+}
+
+//this function writes the events waiting in the fifo in the order they were stamped
+void AutomationLog::writePendingEvents()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i) {
+        const Entry& entry = entries[i < size1 ? start1 + i : start2 + i - size1];
+
+        String text;
+        if (entry.text >= 0) {
+            const ScopedLock tl(textLock);
+            text = texts[entry.text];
+        }
+        writeEntry(entry, text);
+    }
+
+    fifo.finishedRead(size1 + size2);
+}
+
+//this function writes one event, the samples since the last one fit in a byte or two for most events
+void AutomationLog::writeEntry(const Entry& entry, const String& text)
+{
+    jassert(entry.sample >= lastWrittenSample);
+    int64 delta = jmax((int64) 0, entry.sample - lastWrittenSample);
+    lastWrittenSample += delta;
+
+    if (delta <= (int64) std::numeric_limits<int>::max()) {
+        stream->writeCompressedInt((int) delta);
+    }
+    else {
+        stream->writeCompressedInt(-1);
+        stream->writeInt64(delta);
+    }
+
+    stream->writeByte((char) (((int) entry.target << 6) | (int) entry.type));
+
+    int fields = getFields(entry.type);
+    if (fields & indexField) {
+        stream->writeCompressedInt(entry.index);
+    }
+    if (fields & valueField) {
+        stream->writeDouble(entry.value);
+    }
+    if (fields & value2Field) {
+        stream->writeDouble(entry.value2);
+    }
+    if (fields & textField) {
+        stream->writeString(text);
+    }
+}
@@ -0,0 +1,214 @@
+/*====================================================================
+AutomationLog.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class records every control change of a set into a compact binary file, stamped with the sample of the master clock it took
+//effect on, so AutomationReplay can render the same mix again offline. the audio thread stamps the changes without locking or
+//allocating and a background thread writes them to disk
+class AutomationLog : private TimeSliceClient
+{
+public:
+    //what a change was made to
+    enum class Target : uint8
+    {
+        deck1,
+        deck2,
+        pads,
+        master
+    };
+
+    static constexpr int numTargets = 4;
+
+    //the kinds of change, the comment says which fields of the event they use
+    enum class Type : uint8
+    {
+        prepare,          //index: samples per block expected, value: sample rate
+        blockSize,        //index: samples in the callbacks from here on
+        end,              //the end of the session
+
+        load,             //text: the track's URL, empty to unload
+        doubleFrom,       //index: the deck copied, text: the track's URL
+        doubleStart,      //index: the deck waited for, value: the position in seconds the double plays from once that deck is there
+        play,
+        stop,
+        position,         //value: seconds
+        volume,           //value: gain
+        speed,            //value: ratio
+        command,          //index: the DJAudioPlayer::Command::Type, value: its value
+        fade,             //value: target gain, value2: seconds
+        hotCueSet,        //index: pad, value: seconds
+        hotCueTrigger,    //index: pad
+        hotCueRelease,    //index: pad
+        hotCueClear,      //index: pad
+        scratchBegin,
+        scratchVelocity,  //value: rate
+        scratchEnd,
+        reverse,          //index: 1 for on
+        slip,             //index: 1 for on
+        beatGrid,         //value: bpm, value2: first beat in seconds
+        syncMaster,       //index: the deck followed, -1 for none
+        effectEnabled,    //index: effect, value: 1 for on
+        effectMix,        //index: effect, value: mix
+
+        padTrigger,       //index: pad, value: velocity
+        padStop,          //index: pad
+        padStopAll,
+        padLoad,          //index: pad, text: the file
+        padClear,         //index: pad
+        padLooping,       //index: pad, value: 1 for on
+        padGain,          //value: gain
+
+        numTypes
+    };
+
+    struct Event
+    {
+        int64 sample = 0;
+        Target target = Target::master;
+        Type type = Type::end;
+        int index = 0;
+        double value = 0.0;
+        double value2 = 0.0;
+        String text;
+    };
+
+    //a change made on any thread but the audio thread that is not a command, such as a load. it is posted when it goes out of scope,
+    //after the change is made, and only if no other action is running on the same thread, because what an action changes itself is
+    //changed again when it is replayed
+    class Action
+    {
+    public:
+        Action(AutomationLog* log, Target target, Type type, int index = 0, double value = 0.0, double value2 = 0.0, const String& text = {});
+        ~Action();
+
+        //whether an action is running on the calling thread, the commands its change pushes are not recorded again
+        static bool isRunning();
+
+        //the change to record, fields only known once it is made can be filled in before the scope ends
+        Event event;
+
+    private:
+        AutomationLog* log;
+        bool outermost;
+
+        static thread_local int depth;
+
+        JUCE_DECLARE_NON_COPYABLE (Action)
+    };
+
+    //reads a log back one event at a time
+    class Reader
+    {
+    public:
+        Reader(const File& file);
+
+        //false if the file could not be opened or is not an automation log
+        bool isValid() const;
+
+        //the limiter look-ahead the session used
+        double getLimiterLookaheadMs() const;
+
+        //reads the next event, false at the end of the file
+        bool readNext(Event& event);
+
+    private:
+        std::unique_ptr<InputStream> stream;
+        bool valid = false;
+        double limiterLookaheadMs = 0.0;
+        int64 sample = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reader)
+    };
+
+    AutomationLog();
+    ~AutomationLog() override;
+
+    //starts a new log in the file. it is meant to start before the audio device opens, so the replay starts from the same state
+    bool start(const File& file, double limiterLookaheadMs);
+    void stop();
+    bool isRecording() const;
+
+    //records the device being prepared, called on the message thread before the callbacks start. a new sample rate stops the log
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    //called on the audio thread at the start of every callback, before anything is rendered
+    void beginBlock(int numSamples);
+
+    //stamps the actions posted for the target since its last block with the current block, called by the target on the audio thread
+    //at the start of its block
+    void collect(Target target);
+
+    //records a change made on the audio thread, offset samples into the current block. never blocks and never allocates
+    void record(Target target, Type type, int index, double value, double value2 = 0.0, int offset = 0);
+
+    //how many events did not fit in the queues since the log started, the log cannot be replayed exactly unless it is 0
+    int64 getNumDroppedEvents() const;
+
+    //a new file name next to the set recordings in the user's music folder
+    static File getDefaultLogFile();
+
+private:
+    //an event in the fifos, the text is kept in texts so the audio thread only copies plain values
+    struct Entry
+    {
+        int64 sample;
+        Target target;
+        Type type;
+        int index;
+        double value;
+        double value2;
+        int text;
+    };
+
+    //actions posted for one target, any number of threads may post and the target's audio callback collects them
+    struct Posted
+    {
+        static constexpr int size = 256;
+        AbstractFifo fifo{ size };
+        Entry entries[size];
+        SpinLock writeLock;
+    };
+
+    int useTimeSlice() override;
+
+    void post(const Event& event);
+    void push(const Entry& entry);
+
+    //writes everything waiting in the fifo, called with writerLock held
+    void writePendingEvents();
+    void writeEntry(const Entry& entry, const String& text);
+
+    //audio thread only
+    int64 blockStart = 0;
+    int lastBlockSize = 0;
+
+    std::atomic<bool> recording{ false };
+    std::atomic<int64> nextBlockStart{ 0 };
+    std::atomic<double> sampleRate{ 0.0 };
+    std::atomic<int64> droppedEvents{ 0 };
+
+    Posted posted[numTargets];
+
+    //stamped events on their way to the writer thread, the audio thread is the only one that pushes
+    static constexpr int fifoSize = 8192;
+    AbstractFifo fifo{ fifoSize };
+    Entry entries[fifoSize];
+
+    //the texts of the posted actions, only used off the audio thread
+    CriticalSection textLock;
+    StringArray texts;
+
+    //the stream is only used on the writer thread and on the message thread while starting or stopping
+    CriticalSection writerLock;
+    std::unique_ptr<OutputStream> stream;
+    int64 lastWrittenSample = 0;
+
+    TimeSliceThread writerThread{ "Automation log" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutomationLog)
+};
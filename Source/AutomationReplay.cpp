@@ -0,0 +1,351 @@
+/*====================================================================
+AutomationReplay.cpp
+This class renders an automation log offline. The engine is prepared whenever the log says the device was, blocks are rendered with
+the sizes the device used, and every change is made before the block it was stamped with, so the decks' smoothing, ramps and
+read-ahead windows see the same blocks they saw in the set. Pad commands keep the sample inside the block they were heard at. Nothing
+waits on the clock: before each block the decks take its changes and wait for their read-ahead at the position it plays from, so the
+render is only as fast as the tracks can be read.
+====================================================================*/
+
+
+#include "AutomationReplay.h"
+#include "AutomationLog.h"
+#include "DJAudioPlayer.h"
+#include "SamplerPads.h"
+#include "MasterLimiter.h"
+#include <cmath>
+
+//the longest a block waits for a deck's read-ahead before it is rendered anyway
+static constexpr int readyTimeoutMs = 10000;
+
+//this function checks if an event is a pad command, which is the only kind stamped inside a block
+static bool isPadCommand(AutomationLog::Type type)
+{
+    return type == AutomationLog::Type::padTrigger || type == AutomationLog::Type::padStop || type == AutomationLog::Type::padStopAll;
+}
+
+//this function makes a logged change to a deck, the same call the change was made with in the set
+static void applyToDeck(DJAudioPlayer& player, DJAudioPlayer* const* players, const AutomationLog::Event& event)
+{
+    using Type = AutomationLog::Type;
+
+    switch (event.type) {
+        case Type::load:
+            player.loadURL(event.text.isNotEmpty() ? URL(event.text) : URL());
+            break;
+        case Type::doubleFrom:
+            //the speed, cues and position the double copied follow as their own events
+            if (isPositiveAndBelow(event.index, 2)) {
+                player.loadDoubleOf(*players[event.index], URL(event.text));
+            }
+            break;
+        case Type::doubleStart:
+            player.pushCommand({ DJAudioPlayer::Command::Type::doubleStart, event.value, 0, 0.0,
+                                 isPositiveAndBelow(event.index, 2) ? players[event.index] : nullptr });
+            break;
+        case Type::play:
+            player.start();
+            break;
+        case Type::stop:
+            player.stop();
+            break;
+        case Type::position:
+            player.setPosition(event.value);
+            break;
+        case Type::volume:
+            player.setVolume(event.value);
+            break;
+        case Type::speed:
+            player.setSpeed(event.value);
+            break;
+        case Type::command:
+            player.pushCommand({ (DJAudioPlayer::Command::Type) event.index, event.value });
+            break;
+        case Type::fade:
+            player.fadeTo((float) event.value, event.value2);
+            break;
+        case Type::hotCueSet:
+            player.setHotCue(event.index, event.value);
+            break;
+        case Type::hotCueTrigger:
+            player.triggerHotCue(event.index);
+            break;
+        case Type::hotCueRelease:
+            player.releaseHotCue(event.index);
+            break;
+        case Type::hotCueClear:
+            player.clearHotCue(event.index);
+            break;
+        case Type::scratchBegin:
+            player.beginScratch();
+            break;
+        case Type::scratchVelocity:
+            player.setScratchVelocity(event.value);
+            break;
+        case Type::scratchEnd:
+            player.endScratch();
+            break;
+        case Type::reverse:
+            player.setReverse(event.index != 0);
+            break;
+        case Type::slip:
+            player.setSlip(event.index != 0);
+            break;
+        case Type::beatGrid:
+            player.setBeatGrid(event.value, event.value2);
+            break;
+        case Type::syncMaster:
+            //the seek that lined the phase up was logged as its own position event
+            player.setSyncMaster(isPositiveAndBelow(event.index, 2) ? players[event.index] : nullptr, false);
+            break;
+        case Type::effectEnabled:
+            player.setEffectEnabled((EffectsRack::Effect) event.index, event.value != 0.0);
+            break;
+        case Type::effectMix:
+            player.setEffectMix((EffectsRack::Effect) event.index, (float) event.value);
+            break;
+        default:
+            std::cout << "AutomationReplay: a deck cannot replay an event of type " << (int) event.type << std::endl;
+            break;
+    }
+}
+
+//this function makes a logged change to the pads, a command is queued for the sample it was heard at
+static void applyToPads(SamplerPads& samplerPads, const AutomationLog::Event& event, int64 samplePosition)
+{
+    using Type = AutomationLog::Type;
+
+    switch (event.type) {
+        case Type::padTrigger:
+            samplerPads.pushCommand({ SamplerPads::Command::Type::trigger, event.index, (float) event.value, samplePosition });
+            break;
+        case Type::padStop:
+            samplerPads.pushCommand({ SamplerPads::Command::Type::stop, event.index, 0.0f, samplePosition });
+            break;
+        case Type::padStopAll:
+            samplerPads.pushCommand({ SamplerPads::Command::Type::stopAll, 0, 0.0f, samplePosition });
+            break;
+        case Type::padLoad:
+            samplerPads.loadSample(event.index, File(event.text));
+            break;
+        case Type::padClear:
+            samplerPads.clearSample(event.index);
+            break;
+        case Type::padLooping:
+            samplerPads.setLooping(event.index, event.value != 0.0);
+            break;
+        case Type::padGain:
+            samplerPads.setGain((float) event.value);
+            break;
+        default:
+            std::cout << "AutomationReplay: the pads cannot replay an event of type " << (int) event.type << std::endl;
+            break;
+    }
+}
+
+int AutomationReplay::run(const StringArray& arguments)
+{
+    File logFile, outputFile;
+    double outputRate = 0.0;
+
+    for (auto& argument : arguments) {
+        String value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if (argument.startsWith("--replay=")) {
+            logFile = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+        if (argument.startsWith("--replay-out=")) {
+            outputFile = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+        if (argument.startsWith("--replay-rate=")) {
+            outputRate = value.getDoubleValue();
+        }
+    }
+
+    AutomationLog::Reader reader(logFile);
+    if (!reader.isValid()) {
+        std::cout << "AutomationReplay: " << logFile.getFullPathName() << " is not an automation log" << std::endl;
+        return 1;
+    }
+
+    if (outputFile == File()) {
+        outputFile = logFile.withFileExtension(".wav");
+    }
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    TimeSliceThread readAheadThread("Deck read-ahead");
+    readAheadThread.startThread(Thread::Priority::high);
+    JobScheduler jobScheduler;
+
+    //the same engine as MainComponent, without the meter and the recorder
+    DJAudioPlayer player1(formatManager, readAheadThread, jobScheduler);
+    DJAudioPlayer player2(formatManager, readAheadThread, jobScheduler);
+    DJAudioPlayer* players[] = { &player1, &player2 };
+    SamplerPads samplerPads(formatManager, jobScheduler);
+    MixerAudioSource mixerSource;
+    MasterLimiter masterLimiter;
+    masterLimiter.setLookaheadMs(reader.getLimiterLookaheadMs());
+
+    std::unique_ptr<AudioFormatWriter> writer;
+    AudioBuffer<float> buffer;
+
+    //the log counts samples at the set's rate, the render runs at renderRate and every time is scaled by the ratio
+    double renderRate = 0.0;
+    double ratio = 1.0;
+    auto scale = [&](int64 sample) { return (int64) std::llround((double) sample * ratio); };
+
+    //prepares the engine like MainComponent::prepareToPlay, and opens the output the first time
+    auto prepare = [&](int samplesPerBlockExpected, double loggedRate) {
+        if (renderRate <= 0.0) {
+            renderRate = outputRate > 0.0 ? outputRate : loggedRate;
+            ratio = renderRate / loggedRate;
+        }
+
+        int blockSize = (int) std::ceil(samplesPerBlockExpected * ratio);
+        player1.prepareToPlay(blockSize, renderRate);
+        player2.prepareToPlay(blockSize, renderRate);
+        samplerPads.prepareToPlay(blockSize, renderRate);
+
+        mixerSource.prepareToPlay(blockSize, renderRate);
+        mixerSource.addInputSource(&player1, false);
+        mixerSource.addInputSource(&player2, false);
+        mixerSource.addInputSource(&samplerPads, false);
+
+        masterLimiter.prepareToPlay(blockSize, renderRate);
+
+        if (writer != nullptr) {
+            return true;
+        }
+
+        std::unique_ptr<AudioFormat> format;
+        if (outputFile.hasFileExtension(".flac")) {
+            format.reset(new FlacAudioFormat());
+        }
+        else {
+            format.reset(new WavAudioFormat());
+        }
+
+        outputFile.deleteFile();
+        std::unique_ptr<FileOutputStream> stream(outputFile.createOutputStream());
+        if (stream == nullptr || stream->failedToOpen()) {
+            std::cout << "AutomationReplay: cannot write to " << outputFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        writer.reset(format->createWriterFor(stream.get(), renderRate, 2, 24, {}, 0));
+        if (writer == nullptr) {
+            std::cout << "AutomationReplay: cannot create a " << format->getFormatName() << " writer" << std::endl;
+            return false;
+        }
+        stream.release(); //the writer owns the stream now
+        return true;
+    };
+
+    AutomationLog::Event event;
+    bool haveEvent = reader.readNext(event);
+    int64 lastEventSample = 0;
+    int64 endSample = -1;
+
+    //the block being rendered, in the log's samples
+    int64 blockStart = 0;
+    int blockSize = 0;
+
+    int64 renderedSamples = 0;
+    int stalls = 0;
+    double startSeconds = Time::getMillisecondCounterHiRes() * 0.001;
+
+    while (true) {
+        //everything stamped with the start of the block is made before it is rendered, and the pad commands of the whole block are queued
+        while (haveEvent) {
+            if (event.sample > blockStart && !(isPadCommand(event.type) && event.sample < blockStart + blockSize)) {
+                break;
+            }
+            lastEventSample = event.sample;
+
+            if (event.type == AutomationLog::Type::end) {
+                endSample = event.sample;
+                haveEvent = false;
+                break;
+            }
+
+            if (event.type == AutomationLog::Type::prepare) {
+                if (!prepare(event.index, event.value)) {
+                    return 1;
+                }
+            }
+            else if (event.type == AutomationLog::Type::blockSize) {
+                blockSize = event.index;
+            }
+            else if (event.target == AutomationLog::Target::pads) {
+                applyToPads(samplerPads, event, scale(event.sample));
+            }
+            else if (event.target == AutomationLog::Target::deck1 || event.target == AutomationLog::Target::deck2) {
+                applyToDeck(*players[(int) event.target], players, event);
+            }
+
+            haveEvent = reader.readNext(event);
+        }
+
+        //a log cut short by a crash is rendered up to the block of its last event
+        if (!haveEvent && endSample < 0) {
+            std::cout << "AutomationReplay: the log has no end, it is rendered up to its last event" << std::endl;
+            endSample = lastEventSample + 1;
+        }
+
+        if (blockStart >= endSample && endSample >= 0) {
+            break;
+        }
+
+        if (writer == nullptr || blockSize <= 0) {
+            std::cout << "AutomationReplay: the log should start with the device being prepared" << std::endl;
+            return 1;
+        }
+
+        int64 scaledStart = scale(blockStart);
+        int numSamples = (int) (scale(blockStart + blockSize) - scaledStart);
+        if (buffer.getNumSamples() < numSamples) {
+            buffer.setSize(2, numSamples, false, false, true);
+        }
+        AudioSourceChannelInfo bufferToFill(&buffer, 0, numSamples);
+
+        //the set never waited for the disk, so the render waits for the read-ahead instead of playing silence. the decks take the block's
+        //changes first, so a seek is waited for before the block plays it
+        for (auto* player : players) {
+            player->beginBlock();
+            if (!player->waitUntilReady(readyTimeoutMs)) {
+                ++stalls;
+            }
+        }
+
+        mixerSource.getNextAudioBlock(bufferToFill);
+        masterLimiter.process(bufferToFill);
+
+        if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples)) {
+            std::cout << "AutomationReplay: writing " << outputFile.getFullPathName() << " failed" << std::endl;
+            return 1;
+        }
+
+        renderedSamples += numSamples;
+        blockStart += blockSize;
+    }
+
+    //finishes the file header
+    writer.reset();
+
+    if (renderRate <= 0.0) {
+        std::cout << "AutomationReplay: the log ended before the device was prepared, nothing was rendered" << std::endl;
+        return 1;
+    }
+
+    double renderSeconds = renderedSamples / renderRate;
+    double elapsedSeconds = Time::getMillisecondCounterHiRes() * 0.001 - startSeconds;
+    std::cout << "AutomationReplay: rendered " << renderSeconds << " s to " << outputFile.getFullPathName() << " in " << elapsedSeconds
+              << " s, " << renderSeconds / jmax(elapsedSeconds, 0.001) << " times real time" << std::endl;
+
+    if (stalls > 0) {
+        std::cout << "AutomationReplay: a deck was not ready " << stalls << " times, those blocks may differ from the set" << std::endl;
+    }
+    return 0;
+}
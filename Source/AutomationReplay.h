@@ -0,0 +1,18 @@
+/*====================================================================
+AutomationReplay.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//this class renders a set recorded with --record-automation again offline. it builds the same engine as MainComponent (two decks, the
+//sample pads, the mixer and the master limiter), applies every logged change at the sample it took effect on and writes the master
+//output to a file as fast as the tracks can be read. it is started with --replay=<log>, --replay-out=<file> names the output (the
+//log's name with .wav unless it is given, .flac works too) and --replay-rate=<Hz> renders at another sample rate
+class AutomationReplay
+{
+public:
+    //returns 0 when the whole log was rendered
+    static int run(const StringArray& arguments);
+};
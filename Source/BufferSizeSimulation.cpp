@@ -0,0 +1,101 @@
+/*====================================================================
+BufferSizeSimulation.cpp
+This file drives the BufferSizeTuner with a simulated device. Every block costs a fixed time plus a time per sample, the time per
+sample goes up for the heavy part of the set, and now and then a block takes longer for no reason, like a page fault or the GUI
+holding a lock. A block that takes longer than its own length is an xrun and delays the blocks after it, the same as a real device.
+The clock is simulated, so a few minutes of set run in a moment.
+====================================================================*/
+
+
+#include "BufferSizeSimulation.h"
+#include "BufferSizeTuner.h"
+
+//the simulated device
+static constexpr double simulatedSampleRate = 48000.0;
+static constexpr int startBufferSize = 512;
+
+//the synthetic load: the work every block does, the work per sample in the light and heavy parts, and the spikes
+static constexpr double fixedCostSeconds = 0.00025;
+static constexpr double lightCostPerSample = 0.000005;
+static constexpr double heavyCostPerSample = 0.000012;
+static constexpr double spikeSeconds = 0.0006;
+static constexpr double meanSecondsBetweenSpikes = 5.0;
+
+//the set: light, heavy from heavyStart to heavyEnd, then light again until the end. the last settledSeconds are checked for xruns
+static constexpr double heavyStart = 60.0;
+static constexpr double heavyEnd = 120.0;
+static constexpr double setSeconds = 240.0;
+static constexpr double settledSeconds = 30.0;
+
+//how often the tuner is asked for a decision, the same as the timer in MainComponent
+static constexpr double updateSeconds = 0.25;
+
+//a restarted device takes this long to call back again
+static constexpr double restartSeconds = 0.05;
+
+int BufferSizeSimulation::run()
+{
+    BufferSizeTuner tuner;
+    tuner.setDevice(simulatedSampleRate, startBufferSize, { 32, 64, 128, 256, 512, 1024, 2048 });
+    tuner.setEnabled(true);
+
+    Random random(1);
+    int bufferSize = startBufferSize;
+    double now = 0.0;
+    double nextUpdate = updateSeconds;
+    double nextSpike = random.nextDouble() * 2.0 * meanSecondsBetweenSpikes;
+    int deviceXRuns = 0;
+    int settledXRuns = 0;
+    int xrunsInPart[3] = {};
+    std::map<int, double> secondsAtSize;
+
+    while (now < setSeconds)
+    {
+        double blockSeconds = bufferSize / simulatedSampleRate;
+        bool heavy = now >= heavyStart && now < heavyEnd;
+        double cost = fixedCostSeconds + (heavy ? heavyCostPerSample : lightCostPerSample) * bufferSize;
+
+        if (now >= nextSpike) {
+            cost += spikeSeconds;
+            nextSpike = now + random.nextDouble() * 2.0 * meanSecondsBetweenSpikes;
+        }
+
+        tuner.recordCallback(now, now + cost, bufferSize);
+        secondsAtSize[bufferSize] += blockSeconds;
+
+        //a block that is late delays the next callback by as much as it overran
+        if (cost > blockSeconds) {
+            ++deviceXRuns;
+            ++xrunsInPart[now < heavyStart ? 0 : (heavy ? 1 : 2)];
+            if (now >= setSeconds - settledSeconds) {
+                ++settledXRuns;
+            }
+            now += cost;
+        }
+        else {
+            now += blockSeconds;
+        }
+
+        if (now >= nextUpdate) {
+            nextUpdate = now + updateSeconds;
+
+            float headroom = (float) tuner.getHeadroom();
+            int wanted = tuner.update(now, deviceXRuns);
+            if (wanted != bufferSize) {
+                std::cout << "BufferSizeSimulation: " << String(now, 2) << " s  " << bufferSize << " -> " << wanted << " samples, headroom "
+                          << roundToInt(headroom * 100.0f) << "%" << (heavy ? "  (heavy)" : "") << std::endl;
+                bufferSize = wanted;
+                now += restartSeconds;
+            }
+        }
+    }
+
+    std::cout << "BufferSizeSimulation: xruns " << xrunsInPart[0] << " light, " << xrunsInPart[1] << " heavy, " << xrunsInPart[2]
+              << " light again, " << settledXRuns << " in the last " << settledSeconds << " s" << std::endl;
+    for (auto& size : secondsAtSize) {
+        std::cout << "BufferSizeSimulation: " << size.first << " samples (" << String(size.first * 1000.0 / simulatedSampleRate, 2)
+                  << " ms) for " << String(size.second, 1) << " s" << std::endl;
+    }
+
+    return settledXRuns;
+}
@@ -0,0 +1,18 @@
+/*====================================================================
+BufferSizeSimulation.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//this class runs the BufferSizeTuner against a simulated device with a synthetic load instead of the sound card. the simulation runs
+//faster than real time through a light set, a heavy stretch (as if every effect was turned on) and a light set again, with short load
+//spikes all the way through, and prints every change the tuner makes. it is started with the --tune-check command line option and the
+//app exits with 1 if the tuner is still causing xruns once the load has settled
+class BufferSizeSimulation
+{
+public:
+    //returns the number of xruns in the settled part at the end
+    static int run();
+};
@@ -0,0 +1,187 @@
+/*====================================================================
+BufferSizeTuner.cpp
+This class tunes the buffer size for the low latency mode. The audio thread only keeps the peak load and a count of late callbacks
+in atomics. The decisions are made on the message thread: a size is watched for a few seconds and the next smaller one is tried
+when the busiest block would still leave enough headroom, and any xrun or load spike moves back up a size at once. A size that failed
+is not tried again until its hold runs out, which doubles on every failure so a borderline size is not retried over and over.
+====================================================================*/
+
+
+#include "BufferSizeTuner.h"
+#include <cmath>
+
+BufferSizeTuner::BufferSizeTuner()
+{
+}
+
+//this function takes the sizes the device offers as a ladder of steps at least half as big again as each other, so a step down
+//makes a real difference to the latency and a step up after an xrun gives real headroom
+void BufferSizeTuner::setDevice(double newSampleRate, int newBufferSize, const Array<int>& availableBufferSizes)
+{
+    if (newSampleRate <= 0.0 || newBufferSize <= 0) {
+        std::cout << "BufferSizeTuner::setDevice sample rate and buffer size should be above 0" << std::endl;
+        return;
+    }
+
+    Array<int> sorted(availableBufferSizes);
+    sorted.addIfNotAlreadyThere(newBufferSize);
+    sorted.sort();
+
+    Array<int> ladder;
+    for (int size : sorted) {
+        if (ladder.isEmpty() || size >= ladder.getLast() * 3 / 2 || size == newBufferSize) {
+            ladder.add(size);
+        }
+    }
+
+    //the holds belong to the device's rate, a new rate starts over
+    if (newSampleRate != sampleRate.load()) {
+        holds.clear();
+    }
+
+    availableSizes = ladder;
+    sampleRate = newSampleRate;
+    currentSize = newBufferSize;
+    bufferSize = newBufferSize;
+
+    //the measurement starts again on the next update
+    windowStart = -1.0;
+    windowPeak = 0.0f;
+    lastDeviceXRuns = -1;
+}
+
+void BufferSizeTuner::setEnabled(bool shouldBeEnabled)
+{
+    enabled = shouldBeEnabled;
+}
+
+bool BufferSizeTuner::isEnabled() const
+{
+    return enabled;
+}
+
+//this function keeps the largest load since the last update and counts the callbacks that came much later than the block before them
+void BufferSizeTuner::recordCallback(double startSeconds, double endSeconds, int numSamples)
+{
+    double rate = sampleRate.load(std::memory_order_relaxed);
+    if (rate <= 0.0 || numSamples <= 0) {
+        return;
+    }
+
+    double blockSeconds = numSamples / rate;
+    float load = (float) ((endSeconds - startSeconds) / blockSeconds);
+
+    float previous = peakLoad.load(std::memory_order_relaxed);
+    while (load > previous && !peakLoad.compare_exchange_weak(previous, load, std::memory_order_relaxed)) {
+    }
+
+    //a gap of a second or more is the device being stopped or restarted, not an xrun
+    double interval = startSeconds - lastStartSeconds;
+    if (lastStartSeconds > 0.0 && interval > lateCallbackFactor * blockSeconds && interval < 1.0) {
+        lateCallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+    lastStartSeconds = startSeconds;
+}
+
+//this function backs off on trouble and otherwise tries a smaller size at the end of every clean measurement
+int BufferSizeTuner::update(double nowSeconds, int deviceXRuns)
+{
+    float peak = peakLoad.exchange(0.0f);
+
+    //the device's own count is used when it has one, late callbacks are the best guess when it has not
+    int late = lateCallbacks.load();
+    int newXRuns = 0;
+    if (deviceXRuns >= 0) {
+        newXRuns = lastDeviceXRuns >= 0 ? jmax(0, deviceXRuns - lastDeviceXRuns) : 0;
+        lastDeviceXRuns = deviceXRuns;
+    }
+    else {
+        newXRuns = late - lastLateCallbacks;
+    }
+    lastLateCallbacks = late;
+
+    if (currentSize <= 0) {
+        return currentSize;
+    }
+
+    if (windowStart < 0.0) {
+        windowStart = nowSeconds + settleSeconds;
+    }
+
+    //the blocks right after a change still belong to the restart
+    if (nowSeconds < windowStart) {
+        return currentSize;
+    }
+
+    numXRuns += newXRuns;
+    windowPeak = jmax(windowPeak, peak);
+    headroom = jmax(0.0f, 1.0f - windowPeak);
+
+    int index = availableSizes.indexOf(currentSize);
+
+    if (enabled && (newXRuns > 0 || peak > backOffLoad)) {
+        if (index >= 0 && index + 1 < availableSizes.size()) {
+            Hold& hold = holds[currentSize];
+            ++hold.failures;
+            hold.until = nowSeconds + jmin(maxHoldSeconds, holdSeconds * std::pow(2.0, hold.failures - 1));
+            changeTo(availableSizes[index + 1], nowSeconds);
+        }
+        return currentSize;
+    }
+
+    if (nowSeconds - windowStart < measureSeconds) {
+        return currentSize;
+    }
+
+    if (enabled && index > 0) {
+        int smaller = availableSizes[index - 1];
+        double expectedLoad = windowPeak * std::pow(smallerBufferLoadGrowth, std::log2((double) currentSize / smaller));
+
+        auto hold = holds.find(smaller);
+        bool held = hold != holds.end() && nowSeconds < hold->second.until;
+
+        if (expectedLoad < safetyMargin && !held) {
+            changeTo(smaller, nowSeconds);
+            return currentSize;
+        }
+    }
+
+    //a new measurement of the same size
+    windowStart = nowSeconds;
+    windowPeak = 0.0f;
+    return currentSize;
+}
+
+int BufferSizeTuner::getBufferSize() const
+{
+    return bufferSize.load();
+}
+
+double BufferSizeTuner::getLatencySeconds() const
+{
+    double rate = sampleRate.load();
+    return rate > 0.0 ? bufferSize.load() / rate : 0.0;
+}
+
+double BufferSizeTuner::getSampleRate() const
+{
+    return sampleRate.load();
+}
+
+double BufferSizeTuner::getHeadroom() const
+{
+    return headroom.load();
+}
+
+int BufferSizeTuner::getNumXRuns() const
+{
+    return numXRuns.load();
+}
+
+void BufferSizeTuner::changeTo(int newBufferSize, double nowSeconds)
+{
+    currentSize = newBufferSize;
+    bufferSize = newBufferSize;
+    windowStart = nowSeconds + settleSeconds;
+    windowPeak = 0.0f;
+}
@@ -0,0 +1,101 @@
+/*====================================================================
+BufferSizeTuner.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <map>
+
+//this class picks the audio device's buffer size for the low latency mode. the audio callback reports how long each block took and
+//when it started, which gives the load (the share of the block's time spent rendering it) and the callbacks that came late. every
+//few seconds without trouble the tuner tries the next smaller buffer if the load would still be under the safety margin, and on an
+//xrun or a load spike it goes straight back to a larger one and leaves the smaller size alone for a while, longer each time it fails.
+//it knows nothing about the device itself, so it can be driven by a simulated device as well as the real one
+class BufferSizeTuner
+{
+public:
+    //a smaller buffer is only tried if the load is expected to stay under this
+    static constexpr double safetyMargin = 0.6;
+
+    //a block that takes more than this share of its time backs off straight away
+    static constexpr double backOffLoad = 0.85;
+
+    //the load is expected to grow by this much when the buffer is halved, for the work every callback does whatever its size
+    static constexpr double smallerBufferLoadGrowth = 1.25;
+
+    //how long a buffer size is watched before a smaller one is tried
+    static constexpr double measureSeconds = 3.0;
+
+    //the blocks right after a change are not counted, while the device settles
+    static constexpr double settleSeconds = 0.5;
+
+    //how long a size that failed is left alone the first time, doubled on every failure up to the longest
+    static constexpr double holdSeconds = 10.0;
+    static constexpr double maxHoldSeconds = 300.0;
+
+    //a callback that starts this many block lengths after the one before it is counted as an xrun
+    static constexpr double lateCallbackFactor = 1.8;
+
+    BufferSizeTuner();
+
+    //the device's rate, its current buffer size and the sizes it offers. called on the message thread whenever one of them changes
+    void setDevice(double sampleRate, int bufferSize, const Array<int>& availableBufferSizes);
+
+    //the tuner only asks for changes while it is enabled, the measurements go on regardless so the headroom can be shown
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const;
+
+    //records one callback, times in seconds on any clock that does not jump. called on the audio thread, never blocks
+    void recordCallback(double startSeconds, double endSeconds, int numSamples);
+
+    //looks at the callbacks since the last update and returns the buffer size the device should use, the current one if nothing
+    //changes. deviceXRuns is the device's own xrun count, or -1 if it does not report one. called on the message thread a few times
+    //a second
+    int update(double nowSeconds, int deviceXRuns);
+
+    //the current buffer size and its latency, and the device's rate
+    int getBufferSize() const;
+    double getLatencySeconds() const;
+    double getSampleRate() const;
+
+    //the share of the block's time left over by the busiest callback of the last measurement, from 0 to 1
+    double getHeadroom() const;
+
+    //the xruns seen so far, counting late callbacks when the device reports none
+    int getNumXRuns() const;
+
+private:
+    //switches to a size and starts measuring it from scratch
+    void changeTo(int bufferSize, double nowSeconds);
+
+    //what happened to a size that failed
+    struct Hold
+    {
+        int failures = 0;
+        double until = 0.0;
+    };
+
+    //written by the audio thread, taken by update
+    std::atomic<float> peakLoad{ 0.0f };
+    std::atomic<int> lateCallbacks{ 0 };
+    std::atomic<double> sampleRate{ 0.0 };
+    double lastStartSeconds = 0.0;
+
+    //message thread only
+    Array<int> availableSizes;
+    int currentSize = 0;
+    bool enabled = false;
+    double windowStart = 0.0;
+    float windowPeak = 0.0f;
+    int lastDeviceXRuns = -1;
+    int lastLateCallbacks = 0;
+    std::map<int, Hold> holds;
+
+    std::atomic<int> bufferSize{ 0 };
+    std::atomic<float> headroom{ 1.0f };
+    std::atomic<int> numXRuns{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferSizeTuner)
+};
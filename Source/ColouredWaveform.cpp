@@ -0,0 +1,176 @@
+/*====================================================================
+ColouredWaveform.cpp
+This class splits a track into the low, mid and high bands of the deck EQ and keeps the peak of each band per bin, so the waveform can
+be drawn in colour.
+====================================================================*/
+
+
+#include "ColouredWaveform.h"
+#include "DJAudioPlayer.h"
+#include <cmath>
+
+ColouredWaveform::ColouredWaveform(int64 _lengthInSamples, double _sampleRate, int _samplesPerBin)
+    : lengthInSamples(_lengthInSamples),
+      sampleRate(_sampleRate),
+      samplesPerBin(_samplesPerBin),
+      numBins((int) ((_lengthInSamples + _samplesPerBin - 1) / _samplesPerBin)),
+      levels((size_t) numBins * numBands, 0)
+{
+}
+
+//this function returns the length of the analysed audio in seconds
+double ColouredWaveform::getLengthInSeconds() const
+{
+    return sampleRate > 0 ? lengthInSamples / sampleRate : 0.0;
+}
+
+//this function returns the level of one band in one bin
+float ColouredWaveform::getLevel(int bin, Band band) const
+{
+    return dequantise(levels[(size_t) bin * numBands + band]);
+}
+
+//this function turns a level between 0 and 1 into a byte
+uint8 ColouredWaveform::quantise(float level)
+{
+    return (uint8) roundToInt(std::sqrt(jlimit(0.0f, 1.0f, level)) * 255.0f);
+}
+
+//this function turns a stored byte back into a level between 0 and 1
+float ColouredWaveform::dequantise(uint8 value)
+{
+    float root = value / 255.0f;
+    return root * root;
+}
+
+//identifies the saved data and its layout
+static constexpr int fileMagic = 0x4f54434f; //"OTCW"
+static constexpr int fileVersion = 1;
+
+//this function writes the header and the levels of every bin
+bool ColouredWaveform::writeTo(OutputStream& stream) const
+{
+    stream.writeInt(fileMagic);
+    stream.writeInt(fileVersion);
+    stream.writeInt64(lengthInSamples);
+    stream.writeDouble(sampleRate);
+    stream.writeInt(samplesPerBin);
+    stream.writeInt(getNumBinsReady());
+    return stream.write(levels.data(), levels.size());
+}
+
+//this function reads a waveform written by writeTo, it is complete as soon as it is returned
+ColouredWaveform::Ptr ColouredWaveform::readFrom(InputStream& stream)
+{
+    if (stream.readInt() != fileMagic || stream.readInt() != fileVersion) {
+        return nullptr;
+    }
+
+    int64 length = stream.readInt64();
+    double rate = stream.readDouble();
+    int binSize = stream.readInt();
+    int binsReady = stream.readInt();
+
+    if (length <= 0 || rate <= 0.0 || binSize <= 0) {
+        return nullptr;
+    }
+
+    Ptr waveform = new ColouredWaveform(length, rate, binSize);
+    if (binsReady != waveform->numBins || stream.read(waveform->levels.data(), (int) waveform->levels.size()) != (int) waveform->levels.size()) {
+        return nullptr;
+    }
+
+    waveform->numBinsReady.store(waveform->numBins, std::memory_order_release);
+    return waveform;
+}
+
+//the crossovers sit halfway (on a log scale) between the bass, mid and treble frequencies of the deck EQ, the mid band is the band-pass
+//between them
+ColouredWaveform::Builder::Builder(ColouredWaveform& _target, int maxBlockSize)
+    : target(_target),
+      mono(1, maxBlockSize)
+{
+    static_assert(Register::SIMDNumElements >= numBands, "every band needs a lane of its own");
+
+    float lowCrossover = std::sqrt(DJAudioPlayer::bassFrequency * DJAudioPlayer::midFrequency);
+    float highCrossover = std::sqrt(DJAudioPlayer::midFrequency * DJAudioPlayer::trebleFrequency);
+    float midCentre = std::sqrt(lowCrossover * highCrossover);
+
+    using Coefficients = juce::dsp::IIR::Coefficients<float>;
+    Coefficients::Ptr filters[numBands] = {
+        Coefficients::makeLowPass(target.sampleRate, lowCrossover),
+        Coefficients::makeBandPass(target.sampleRate, midCentre, midCentre / (highCrossover - lowCrossover)),
+        Coefficients::makeHighPass(target.sampleRate, highCrossover)
+    };
+
+    //the lanes past the bands keep zero coefficients and stay silent
+    b0 = b1 = b2 = a1 = a2 = state1 = state2 = binPeaks = Register::expand(0.0f);
+    for (int band = 0; band < numBands; ++band) {
+        const float* raw = filters[band]->getRawCoefficients();
+        b0.set((size_t) band, raw[0]);
+        b1.set((size_t) band, raw[1]);
+        b2.set((size_t) band, raw[2]);
+        a1.set((size_t) band, raw[3]);
+        a2.set((size_t) band, raw[4]);
+    }
+}
+
+//this function filters the mono mix of a decoded block into the three bands at once and collects the band peaks of every bin it covers
+void ColouredWaveform::Builder::process(const AudioBuffer<float>& block, int numSamples)
+{
+    ScopedNoDenormals noDenormals;
+
+    numSamples = jmin(numSamples, mono.getNumSamples());
+    int numChannels = block.getNumChannels();
+
+    float* mix = mono.getWritePointer(0);
+    FloatVectorOperations::copyWithMultiply(mix, block.getReadPointer(0), 1.0f / numChannels, numSamples);
+    for (int channel = 1; channel < numChannels; ++channel) {
+        FloatVectorOperations::addWithMultiply(mix, block.getReadPointer(channel), 1.0f / numChannels, numSamples);
+    }
+
+    //the registers are copied out of the members so they stay in registers through the loop
+    Register s1 = state1, s2 = state2, peaks = binPeaks;
+    const Register zero = Register::expand(0.0f);
+
+    for (int i = 0; i < numSamples; ++i) {
+        Register x = Register::expand(mix[i]);
+        Register y = Register::multiplyAdd(s1, b0, x);
+        s1 = Register::multiplyAdd(s2, b1, x) - a1 * y;
+        s2 = b2 * x - a2 * y;
+
+        peaks = Register::max(peaks, Register::max(y, zero - y));
+
+        if (++samplesInBin == target.samplesPerBin) {
+            binPeaks = peaks;
+            storeBin();
+            peaks = binPeaks;
+        }
+    }
+
+    state1 = s1;
+    state2 = s2;
+    binPeaks = peaks;
+}
+
+//this function stores the last bin if it was only partly filled
+void ColouredWaveform::Builder::finish()
+{
+    if (samplesInBin > 0) {
+        storeBin();
+    }
+}
+
+//this function writes the peaks of the current bin and makes it visible to the display
+void ColouredWaveform::Builder::storeBin()
+{
+    if (nextBin < target.numBins) {
+        for (int band = 0; band < numBands; ++band) {
+            target.levels[(size_t) nextBin * numBands + band] = quantise(binPeaks.get((size_t) band));
+        }
+        target.numBinsReady.store(++nextBin, std::memory_order_release);
+    }
+
+    binPeaks = Register::expand(0.0f);
+    samplesInBin = 0;
+}
@@ -0,0 +1,75 @@
+/*====================================================================
+ColouredWaveform.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <vector>
+
+//this class holds the low/mid/high peak levels of a track, one byte per band for every bin of samplesPerBin samples.
+//it is filled from a background thread while the display reads the bins that are already finished
+class ColouredWaveform : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<ColouredWaveform>;
+
+    enum Band { low = 0, mid, high, numBands };
+
+    ColouredWaveform(int64 lengthInSamples, double sampleRate, int samplesPerBin);
+
+    int getNumBins() const { return numBins; }
+    int getNumBinsReady() const { return numBinsReady.load(std::memory_order_acquire); }
+    bool isFinished() const { return getNumBinsReady() == numBins; }
+    int getSamplesPerBin() const { return samplesPerBin; }
+    double getLengthInSeconds() const;
+
+    //peak level of a band in a bin, from 0 to 1
+    float getLevel(int bin, Band band) const;
+
+    //the stored bytes use square root companding so quiet parts keep some detail
+    static uint8 quantise(float level);
+    static float dequantise(uint8 value);
+
+    //saves a finished waveform to a stream and reads it back, readFrom returns nullptr if the data is not a waveform
+    bool writeTo(OutputStream& stream) const;
+    static Ptr readFrom(InputStream& stream);
+
+    //this class fills a ColouredWaveform block by block during the decoding pass
+    class Builder
+    {
+    public:
+        Builder(ColouredWaveform& target, int maxBlockSize);
+
+        void process(const AudioBuffer<float>& block, int numSamples);
+        void finish();
+
+    private:
+        using Register = juce::dsp::SIMDRegister<float>;
+
+        void storeBin();
+
+        ColouredWaveform& target;
+
+        //one biquad per lane, low-pass, band-pass and high-pass in the order of the bands, each lane in transposed direct form II
+        Register b0, b1, b2, a1, a2;
+        Register state1, state2;
+
+        AudioBuffer<float> mono;
+        Register binPeaks;
+        int samplesInBin = 0;
+        int nextBin = 0;
+    };
+
+private:
+    int64 lengthInSamples;
+    double sampleRate;
+    int samplesPerBin;
+    int numBins;
+
+    std::vector<uint8> levels;
+    std::atomic<int> numBinsReady{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ColouredWaveform)
+};
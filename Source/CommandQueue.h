@@ -0,0 +1,84 @@
+/*====================================================================
+CommandQueue.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class passes commands from any number of threads to the audio thread without a lock. every slot has a sequence number: a writer
+//claims the next slot by moving the write position on with a compare-and-swap, copies its command in and then publishes the slot by
+//moving its sequence on, and the audio thread only reads a slot once it has been published. a writer that is interrupted between the
+//two holds up the commands behind it until it carries on, it never holds up another writer. it is a template because the decks and the
+//pads queue different commands, so it lives in the header only
+template <typename Item, int size>
+class CommandQueue
+{
+public:
+    static_assert(size > 1 && (size & (size - 1)) == 0, "the size of a command queue should be a power of 2");
+
+    CommandQueue()
+    {
+        for (int index = 0; index < size; ++index) {
+            slots[index].sequence.store((uint32) index, std::memory_order_relaxed);
+        }
+    }
+
+    //adds an item from any thread, returns false if the queue is full
+    bool push(const Item& item)
+    {
+        uint32 position = writePosition.load(std::memory_order_relaxed);
+
+        while (true) {
+            Slot& slot = slots[position & mask];
+            int32 ahead = (int32) (slot.sequence.load(std::memory_order_acquire) - position);
+
+            if (ahead == 0) {
+                if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.item = item;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (ahead < 0) {
+                //the audio thread has not taken this slot's item from the last time round yet
+                return false;
+            }
+            else {
+                position = writePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //takes the oldest item on the audio thread, returns false if there is none that has been published
+    bool pop(Item& item)
+    {
+        Slot& slot = slots[readPosition & mask];
+        if ((int32) (slot.sequence.load(std::memory_order_acquire) - (readPosition + 1)) < 0) {
+            return false;
+        }
+
+        item = slot.item;
+        slot.sequence.store(readPosition + (uint32) size, std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+private:
+    static constexpr uint32 mask = (uint32) size - 1;
+
+    struct Slot
+    {
+        std::atomic<uint32> sequence{ 0 };
+        Item item{};
+    };
+
+    Slot slots[size];
+    std::atomic<uint32> writePosition{ 0 };
+
+    //audio thread only
+    uint32 readPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (CommandQueue)
+};
@@ -1,261 +1,1479 @@
-/*====================================================================
-DJAudioPlayer.cpp
-I have created this with the help of the tutorial from this course. I update and change majority of the codes as well as add on additional features which will be labelled.
-This class manages all the loading, playing and removing of the audio as well as applying filters such as speed, treble, mid and bass.
-====================================================================*/
-
-
-#include "DJAudioPlayer.h"
-#include <juce_dsp/juce_dsp.h> 
-
-DJAudioPlayer::DJAudioPlayer(AudioFormatManager& _formatManager) 
-: formatManager(_formatManager)
-{
-
-}
-DJAudioPlayer::~DJAudioPlayer()
-{
-
-}
-
-//this function ensures that the necessary audio components are ready to process and play audio at the specified sample rate and block size
-void DJAudioPlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRate) 
-{
-    transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-
-    auto bassCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, 100.0f, 0.707f, 0.0f);  // Low shelf filter with gainValue for bass boost
-    bassFilter.coefficients = bassCoefficients;
-
-    auto trebleCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, 5000.0f, 0.707f, 5.0f);  // Low shelf filter with gainValue for bass boost
-    trebleFilter.coefficients = trebleCoefficients;
-}
-
-//this function is responsible for processing and applying any audio effects to the audio data during playback
-void DJAudioPlayer::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
-{
-    resampleSource.getNextAudioBlock(bufferToFill);
-
-    // Dereference the bufferToFill.buffer pointer to get the AudioBuffer
-    juce::dsp::AudioBlock<float> block(*bufferToFill.buffer);  // Dereference the pointer to access the actual buffer
-
-    // Create the context by passing the AudioBlock
-    juce::dsp::ProcessContextReplacing<float> context(block);  // ProcessContextReplacing needs the block
-
-    if (isBass) {
-        //apply the bassfilter to the audio buffer
-        bassFilter.process(context);
-    }
-
-    if (isTreble) {
-        // Apply the treble filter to the audio buffer
-        trebleFilter.process(context);
-    }
-    
-    if (isMid) {
-        // Apply the treble filter to the audio buffer
-        midrangeFilter.process(context);
-    }
-}
-
-//this function is used to release or clean up any resources that were previously allocated for audio playback
-void DJAudioPlayer::releaseResources()
-{
-    transportSource.releaseResources();
-    resampleSource.releaseResources();
-}
-
-//this function class is used to load an audio file from a given URL, and it sets up the necessary resources for playback
-void DJAudioPlayer::loadURL(URL audioURL)
-{
-    if (audioURL.isEmpty())
-    {
-        transportSource.stop();
-
-        // Reset the source (this clears the currently loaded file)
-        transportSource.setSource(nullptr);
-    }
-    else
-    {
-        auto* reader = formatManager.createReaderFor(audioURL.createInputStream(false));
-        if (reader != nullptr) //means a good file!
-        {
-            std::unique_ptr<AudioFormatReaderSource> newSource(new AudioFormatReaderSource(reader,
-                true));
-            transportSource.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-            readerSource.reset(newSource.release());
-
-        }
-    }
-}
-
-//this function helps set the gain (volume level) of the audio playback
-void DJAudioPlayer::setVolume(double volumeGain)
-{
-    if (volumeGain < 0 || volumeGain > 1.0) {
-        std::cout << "volume gain should be between 0 and 1" << std::endl;
-    }
-    else {
-        transportSource.setGain(volumeGain);
-    }
-}
-
-//this function help set the speed (speed level) of the audio playback
-void DJAudioPlayer::setSpeed(double speedRatio)
-{
-    if (speedRatio < 0 || speedRatio > 100.0) {
-        std::cout << "Speed ratio should be between 0 and 100" << std::endl;
-    }
-    else {
-        resampleSource.setResamplingRatio(speedRatio);
-    }
-}
-
-//this function sets the playback position of the audio to a specific point, given in seconds.
-void DJAudioPlayer::setPosition(double posSecs)
-{
-    transportSource.setPosition(posSecs);
-}
-
-//this function allows you to set the playback position relative to the total length of the audio track, expressed as a value between 0 and 1.
-void DJAudioPlayer::setPositionRelative(double position)
-{
-    if (position < 0 || position > 1.0) {
-        std::cout << "DJAudioPlayer::setPositionRelative pos should be between 0 and 1" << std::endl;
-    }
-    else {
-        double posInSecs = transportSource.getLengthInSeconds() * position;
-        setPosition(posInSecs);
-    }
-}
-
-//this function starts the audio
-void DJAudioPlayer::start()
-{
-    transportSource.start();
-}
-
-//this function pauses the audio
-void DJAudioPlayer::stop()
-{
-    transportSource.stop();
-}
-
-//this function gets position of the audio
-double DJAudioPlayer::getPosition()
-{
-    return transportSource.getCurrentPosition() / transportSource.getLengthInSeconds();
-}
-
-//this function returns the length of the audio source in seconds
-double DJAudioPlayer::getLength()
-{
-    return transportSource.getLengthInSeconds();
-}
-
-//this function sets the trebel based on the value from the slider in DeckGUI
-void DJAudioPlayer::setTreble(double gainValue)
-{
-    //checks if there is audio loaded
-    if (readerSource == nullptr) {
-        std::cout << "No audio loaded. Cannot set treble." << std::endl;
-        return;
-    }
-
-    //validate the gainValue that it is within the slider value
-    if (gainValue < - 0 || gainValue > 6.0)  {
-        std::cout << "DJAudioPlayer::setTreble gainValue should be between -12 and +12 dB" << std::endl;
-        return;
-    }
-    
-    //variable to get the sampleRate from the audio source
-    double sampleRate = readerSource->getAudioFormatReader()->sampleRate;
-
-    //checks if sample rate is invalid
-    if (sampleRate <= 0) {
-        std::cout << "Invalid sample rate!" << std::endl;
-        return;
-    }
-
-    //apply high-shelf filter for treble with a fixed frequency (e.g., 5000 Hz)
-    float trebleFreq = 5000.0f;  //fixed treble frequency
-    auto trebleCoefficients = juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, trebleFreq, 0.707f, static_cast<float>(gainValue));  // Use gainValue for treble boost
-    trebleFilter.coefficients = trebleCoefficients;
-
-    //changes the boolean flags for the filter
-    isTreble = true;
-    isBass = false;
-    isMid = false;
-}
-
-//this sets the bass based on the value from the slider in DeckGUI
-void DJAudioPlayer::setBass(double gainValue)
-{
-    //checks if there is audio loaded
-    if (readerSource == nullptr) {
-        std::cout << "No audio loaded. Cannot set bass." << std::endl;
-        return;
-    }
-
-    //validate the gainValue that it is within the slider value
-    if (gainValue < - 0 || gainValue > 6.0) {
-        std::cout << "DJAudioPlayer::setBass gainValue should be between -12 and +12 dB" << std::endl;
-        return;
-    }
-
-    //variable to get the sampleRate from the audio source
-    double sampleRate = readerSource->getAudioFormatReader()->sampleRate;
-
-    //checks if sample rate is invalid
-    if (sampleRate <= 0) {
-        std::cout << "Invalid sample rate!" << std::endl;
-        return;
-    }
-
-    //apply low-shelf filter for bass with a fixed frequency
-    float bassFreq = 100.0f;  //fixed bass frequency
-    auto bassCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, bassFreq, 0.707f, static_cast<float>(gainValue));  // Use gainValue for bass boost
-    bassFilter.coefficients = bassCoefficients;
-    
-    //changes the boolean flags for the filter
-    isTreble = false;
-    isBass = true;
-    isMid = false;
-}
-
-//this sets the Mid based on the value from the slider in DeckGUI
-void DJAudioPlayer::setMid(double gainValue)
-{
-    //checks if there is audio loaded
-    if (readerSource == nullptr) {
-        std::cout << "No audio loaded. Cannot set midrange." << std::endl;
-        return;
-    }
-
-    //validate the gainValue that it is within the slider value
-    if (gainValue < -12.0 || gainValue > 12.0)
-    {
-        std::cout << "DJAudioPlayer::setMidrange gainValue should be between -12 and +12 dB" << std::endl;
-        return;
-    }
-
-    //variable to get the sampleRate from the audio source
-    double sampleRate = readerSource->getAudioFormatReader()->sampleRate;
-
-    //checks if sample rate is invalid
-    if (sampleRate <= 0) {
-        std::cout << "Invalid sample rate!" << std::endl;
-        return;
-    }
-
-    //apply a bell filter (peak filter) for the midrange with a fixed frequency
-    float midrangeFreq = 1000.0f; //fixed midrange frequency
-    auto midrangeCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, midrangeFreq, 0.707f, static_cast<float>(gainValue));  // Use gainValue for midrange boost
-
-    midrangeFilter.coefficients = midrangeCoefficients;
-
-    //changes the boolean flags for the filter
-    isTreble = false;
-    isBass = false;
-    isMid = true;
+/*====================================================================
+DJAudioPlayer.cpp
+I have created this with the help of the tutorial from this course. I update and change majority of the codes as well as add on additional features which will be labelled.
+This class manages all the loading, playing and removing of the audio as well as applying filters such as speed, treble, mid and bass.
+While a scratch or reverse is on, the audio comes from the ScratchEngine's window instead of the transport, which is left where it was
+and only takes over again once the window playback reaches the point it was sent to. A slip return or a held hot cue seeks the transport
+instead, only the audio fading out from before the jump is rendered from the window.
+A synced deck sets its resampling ratio once per block from the master's beat clock, so tempo and phase follow the master instead of
+drifting away from a ratio set once.
+====================================================================*/
+
+
+#include "DJAudioPlayer.h"
+#include "Tracer.h"
+#include <juce_dsp/juce_dsp.h> 
+#include "ThrottledInputStream.h"
+#include "DecodedTrackReader.h"
+#include <cmath>
+
+//the sync loop: speed change per beat of phase error, how fast the integral removes a steady drift (per second), and the largest change
+//it may make to the tempo-matched speed, small enough not to be heard as a pitch wobble
+static constexpr double syncProportionalGain = 1.0;
+static constexpr double syncIntegralGain = 0.2;
+static constexpr double maxSyncCorrection = 0.04;
+
+//how much audio waitUntilReady waits for ahead of the read position and on each side of the scratch window's playhead
+static constexpr double readySeconds = 4.0;
+
+//a held jog wheel that sends no new velocity for this long has stopped moving
+static constexpr double jogIdleSeconds = 0.03;
+
+//the largest nudge, and how quickly it dies away once the jog wheel stops turning (the time to halve)
+static constexpr double maxNudge = 0.1;
+static constexpr double nudgeHalfLifeSeconds = 0.1;
+
+//this job opens a track and fills the read-ahead buffer with its intro, so installing it later never waits on the disk or the decoder
+class DJAudioPlayer::PreloadJob : public ThreadPoolJob
+{
+public:
+    PreloadJob(DJAudioPlayer& _owner, const URL& _url)
+        : ThreadPoolJob("Preload track"),
+          owner(_owner),
+          url(_url)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        Tracer::Scope trace("DJAudioPlayer::PreloadJob", Tracer::Category::loading);
+        auto load = std::make_unique<PendingLoad>();
+        load->url = url;
+
+        auto* reader = owner.createReaderFor(url);
+        if (reader != nullptr) //means a good file!
+        {
+            load->streamSource.reset(new StreamingAudioSource(reader, owner.readAheadThread, owner.prefetchSeconds.load()));
+            load->scratchReader.reset(owner.createReaderFor(url));
+
+            //the whole track decodes from its intro on the scheduler's other workers while the intro is buffered here
+            load->decodedTrack = owner.startWholeTrackDecoder(url);
+
+            double sampleRate = owner.deviceSampleRate.load();
+            if (sampleRate > 0.0) {
+                //preparing the stream starts its read-ahead, and the buffer is kept when the transport prepares it again on install
+                double ratio = load->streamSource->getSourceSampleRate() / sampleRate;
+                load->streamSource->prepareToPlay(roundToInt(owner.deviceBlockSize.load() * ratio), sampleRate * ratio);
+
+                while (!load->streamSource->waitUntilBuffered(introSeconds, 50))
+                {
+                    if (shouldExit()) {
+                        return jobHasFinished;
+                    }
+                }
+            }
+
+            load->loaded = true;
+        }
+
+        //hands the result to the message thread
+        {
+            const ScopedLock sl(owner.pendingLock);
+            owner.pendingLoad = std::move(load);
+        }
+        owner.triggerAsyncUpdate();
+        return jobHasFinished;
+    }
+
+private:
+    DJAudioPlayer& owner;
+    URL url;
+};
+
+DJAudioPlayer::DJAudioPlayer(AudioFormatManager& _formatManager, TimeSliceThread& _readAheadThread, JobScheduler& _jobScheduler) 
+: formatManager(_formatManager),
+  readAheadThread(_readAheadThread),
+  jobScheduler(_jobScheduler),
+  scratchEngine(_readAheadThread)
+{
+    for (auto& cue : hotCues) {
+        cue = -1.0;
+    }
+}
+DJAudioPlayer::~DJAudioPlayer()
+{
+    //stops any load that is still running before the sources go away
+    jobScheduler.removeJobs(this, 5000);
+    cancelPendingUpdate();
+    pendingLoad.reset();
+    installStream(nullptr, nullptr);
+}
+
+//this function ensures that the necessary audio components are ready to process and play audio at the specified sample rate and block size
+void DJAudioPlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRate) 
+{
+    deviceSampleRate = sampleRate;
+    deviceBlockSize = samplesPerBlockExpected;
+
+    transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    scratchEngine.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    filter.prepareToPlay(sampleRate);
+    effectsRack.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    //the fade after a slip return or a held cue is rendered into this, so it is sized here and not on the audio thread
+    slipFadeLength = jmax(1, roundToInt(slipFadeSeconds * sampleRate));
+    slipFadeBuffer.setSize(2, slipFadeLength);
+    slipFadeRemaining = 0;
+    blockBegun = false;
+    meter.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    //the decks of one mixer are prepared together, so their sample counts stay in step
+    renderedSamples = 0;
+    beatClock = {};
+
+    auto bassCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, bassFrequency, 0.707f, 0.0f);  // Low shelf filter with gainValue for bass boost
+    bassFilter.coefficients = bassCoefficients;
+
+    auto trebleCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, trebleFrequency, 0.707f, 5.0f);  // Low shelf filter with gainValue for bass boost
+    trebleFilter.coefficients = trebleCoefficients;
+
+    auto midrangeCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, midFrequency, 0.707f, 1.0f);
+    midrangeFilter.coefficients = midrangeCoefficients;
+
+    //sizes the filter state here, otherwise the first process call allocates it on the audio thread
+    bassFilter.reset();
+    trebleFilter.reset();
+    midrangeFilter.reset();
+}
+
+//this function is responsible for processing and applying any audio effects to the audio data during playback
+void DJAudioPlayer::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
+{
+    Tracer::Scope trace("DJAudioPlayer::getNextAudioBlock", Tracer::Category::audio);
+    if (!blockBegun) {
+        beginBlock();
+    }
+    blockBegun = false;
+
+    renderDeck(bufferToFill);
+    renderedSamples += bufferToFill.numSamples;
+
+    // Dereference the bufferToFill.buffer pointer to get the AudioBuffer
+    juce::dsp::AudioBlock<float> block(*bufferToFill.buffer);  // Dereference the pointer to access the actual buffer
+
+    // Create the context by passing the AudioBlock
+    juce::dsp::ProcessContextReplacing<float> context(block);  // ProcessContextReplacing needs the block
+
+    if (isBass) {
+        //apply the bassfilter to the audio buffer
+        bassFilter.process(context);
+    }
+
+    if (isTreble) {
+        // Apply the treble filter to the audio buffer
+        trebleFilter.process(context);
+    }
+    
+    if (isMid) {
+        // Apply the treble filter to the audio buffer
+        midrangeFilter.process(context);
+    }
+
+    filter.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+    //the beat-synced effects follow the beat clock of this block, or their own tempo while it is not valid
+    effectsRack.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples, beatClock.beat,
+                        beatClock.valid ? beatClock.beatsPerSample : 0.0);
+
+    //applies the fade gain, per sample while it is ramping
+    if (fadeGain.isSmoothing()) {
+        //every channel runs its own copy of the ramp from the same point, then the ramp moves on by the block
+        for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel) {
+            float* samples = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
+            SmoothedValue<float> ramp = fadeGain;
+            for (int i = 0; i < bufferToFill.numSamples; ++i) {
+                samples[i] *= ramp.getNextValue();
+            }
+        }
+        fadeGain.skip(bufferToFill.numSamples);
+    }
+    else if (fadeGain.getTargetValue() != 1.0f) {
+        bufferToFill.buffer->applyGain(bufferToFill.startSample, bufferToFill.numSamples, fadeGain.getTargetValue());
+    }
+
+    meter.process(bufferToFill);
+}
+
+//this function takes the changes made since the last block, the first part of every block
+void DJAudioPlayer::beginBlock()
+{
+    //the changes made during the last block are stamped with this one, which is the first to hear them
+    if (automationLog != nullptr) {
+        automationLog->collect(automationTarget);
+    }
+
+    //a controller move made during the last block is heard in this one
+    applyCommands();
+    updatePlayMode();
+    blockBegun = true;
+}
+
+//this function moves between the transport and the scratch window as the commands asked, and makes the seeks and jumps of the block
+void DJAudioPlayer::updatePlayMode()
+{
+    double sourceRate = scratchEngine.getSourceSampleRate();
+    bool wantsWindow = sourceRate > 0.0 && (scratchHeld.load() || reverse.load());
+    double motorRate = isPlaying() ? speedRatio.load() : 0.0;
+
+    //a new track was set, the window position belongs to the old one
+    int generation = scratchEngine.getGeneration();
+    if (generation != engineGeneration) {
+        engineGeneration = generation;
+        playMode = PlayMode::transport;
+        slipFadeRemaining = 0;
+        slipReturn = false;
+        heldCueHandled = -1;
+    }
+
+    if (wantsWindow && playMode != PlayMode::window) {
+        //picks the record up where the transport is, at the speed it was playing
+        if (playMode == PlayMode::transport) {
+            windowPosition = transportSource.getCurrentPosition() * sourceRate;
+            windowRate = motorRate;
+        }
+        playMode = PlayMode::window;
+        slipFadeRemaining = 0;
+
+        //the shadow playhead starts from where the track is audible now, unless a held cue already has it counting
+        if (heldCueHandled < 0) {
+            shadowPosition = windowPosition / sourceRate;
+        }
+    }
+    else if (!wantsWindow && playMode == PlayMode::window) {
+        //with slip on the track comes back where the shadow playhead is, the record fades out where it was left
+        if (slipReturn.exchange(false)) {
+            jumpTransport(shadowPosition, sourceRate);
+        }
+        else if (handoffTarget.load() >= 0.0) {
+            playMode = PlayMode::handoff;
+        }
+        else {
+            playMode = PlayMode::transport;
+            resampleSource.flushBuffers();
+        }
+    }
+
+    //a held hot cue plays from its cue point on the transport while the shadow playhead counts on, and letting go of it comes back to
+    //the shadow. a scratch or reverse that is on keeps the record under the hand, its release comes back to the shadow as well
+    int cue = heldCue.load();
+    if (cue != heldCueHandled) {
+        if (heldCueHandled < 0 && playMode == PlayMode::transport) {
+            shadowPosition = transportSource.getCurrentPosition();
+        }
+        bool wasHeld = heldCueHandled >= 0;
+        heldCueHandled = cue;
+
+        if (playMode != PlayMode::window) {
+            if (cue >= 0 && hotCues[cue].load() >= 0.0) {
+                jumpTransport(hotCues[cue].load(), sourceRate);
+            }
+            else if (wasHeld && slip.load()) {
+                jumpTransport(shadowPosition, sourceRate);
+            }
+        }
+    }
+
+    //a seek moves the window playhead and the shadow with it, and ends a handoff because the transport is already at the new position
+    int seek = seekRequest.load();
+    if (seek != seekRequestHandled) {
+        seekRequestHandled = seek;
+        if (playMode == PlayMode::window) {
+            windowPosition = seekSeconds.load() * sourceRate;
+            shadowPosition = seekSeconds.load();
+        }
+        else if (playMode == PlayMode::handoff) {
+            playMode = PlayMode::transport;
+            resampleSource.flushBuffers();
+        }
+        else if (heldCueHandled >= 0) {
+            shadowPosition = seekSeconds.load();
+        }
+    }
+
+    //the scratch window is kept around where the block plays from, so an offline render that waits for it waits for the right audio
+    if (playMode == PlayMode::transport) {
+        scratchEngine.setPlayhead(slipFadeRemaining > 0 ? fadeOutPosition : transportSource.getCurrentPosition() * sourceRate);
+    }
+    else {
+        scratchEngine.setPlayhead(windowPosition);
+    }
+}
+
+//this function renders the deck from the transport, or from the scratch window while a scratch, reverse or handoff is on
+void DJAudioPlayer::renderDeck(const AudioSourceChannelInfo& bufferToFill)
+{
+    double sourceRate = scratchEngine.getSourceSampleRate();
+    double motorRate = isPlaying() ? speedRatio.load() : 0.0;
+
+    if (playMode == PlayMode::transport) {
+        inWindow = false;
+
+        //the resampler ramps to a new ratio across the block, so sync corrections never click
+        double ratio = updateSync(bufferToFill.numSamples);
+        if (ratio != appliedRatio) {
+            resampleSource.setResamplingRatio(ratio);
+            appliedRatio = ratio;
+        }
+
+        //a stopped deck is not read, the block it stops in fades out and the block it starts in fades in
+        bool playing = isPlaying();
+        if (playing || deckWasPlaying) {
+            //a double plays silence until the deck it copies reaches its start, then starts on that sample
+            int waitSamples = samplesUntilDoubleStarts(bufferToFill.numSamples);
+            if (waitSamples > 0) {
+                bufferToFill.buffer->clear(bufferToFill.startSample, waitSamples);
+            }
+            if (waitSamples < bufferToFill.numSamples) {
+                resampleSource.getNextAudioBlock(AudioSourceChannelInfo(bufferToFill.buffer, bufferToFill.startSample + waitSamples,
+                                                                        bufferToFill.numSamples - waitSamples));
+            }
+
+            if (playing != deckWasPlaying) {
+                bufferToFill.buffer->applyGainRamp(bufferToFill.startSample, bufferToFill.numSamples, playing ? 0.0f : 1.0f, playing ? 1.0f : 0.0f);
+            }
+        }
+        else {
+            bufferToFill.buffer->clear(bufferToFill.startSample, bufferToFill.numSamples);
+        }
+        deckWasPlaying = playing;
+
+        if (playing) {
+            mixSlipFade(bufferToFill);
+        }
+        else {
+            slipFadeRemaining = 0;
+        }
+
+        if (heldCueHandled >= 0) {
+            moveShadow(bufferToFill.numSamples, motorRate, sourceRate);
+        }
+
+        //keeps the scratch window around the playhead so a scratch can start at any moment, and around the audio before a jump until it
+        //has faded out
+        scratchEngine.setPlayhead(slipFadeRemaining > 0 ? fadeOutPosition : transportSource.getCurrentPosition() * sourceRate);
+        return;
+    }
+
+    inWindow = true;
+    deckWasPlaying = isPlaying();
+    beatClock.valid = false;
+    beatClock.running = false;
+    wasSyncing = false;
+    auto& buffer = *bufferToFill.buffer;
+    int rendered;
+
+    if (playMode == PlayMode::window) {
+        double targetRate = scratchHeld.load() ? scratchVelocity.load() : (reverse.load() ? -motorRate : motorRate);
+        rendered = scratchEngine.render(buffer, bufferToFill.startSample, bufferToFill.numSamples, windowPosition, windowRate, targetRate);
+    }
+    else {
+        rendered = scratchEngine.render(buffer, bufferToFill.startSample, bufferToFill.numSamples, windowPosition, windowRate, motorRate,
+                                        handoffTarget.load() * sourceRate);
+    }
+
+    moveShadow(bufferToFill.numSamples, motorRate, sourceRate);
+
+    //the transport's volume is applied here because the window playback does not go through it
+    buffer.applyGain(bufferToFill.startSample, rendered, transportSource.getGain());
+
+    windowPositionSeconds = windowPosition / sourceRate;
+    scratchEngine.setPlayhead(windowPosition);
+
+    //the handoff point was reached in this block, the transport plays the rest of it from exactly there
+    if (rendered < bufferToFill.numSamples) {
+        playMode = PlayMode::transport;
+        inWindow = false;
+        resampleSource.flushBuffers();
+        resampleSource.getNextAudioBlock(AudioSourceChannelInfo(&buffer, bufferToFill.startSample + rendered, bufferToFill.numSamples - rendered));
+    }
+}
+
+//this function seeks the transport to a slip return or a held cue and plays on from there, and starts fading out the audio from where
+//the deck was. the audio after the jump comes from the read-ahead, so only the fading audio is rendered from the scratch window, which
+//holds it because it was around the playhead
+void DJAudioPlayer::jumpTransport(double seconds, double sourceRate)
+{
+    if (playMode == PlayMode::transport) {
+        fadeOutPosition = transportSource.getCurrentPosition() * sourceRate;
+        fadeOutRate = isPlaying() ? appliedRatio : 0.0;
+    }
+    else {
+        fadeOutPosition = windowPosition;
+        fadeOutRate = windowRate;
+    }
+    slipFadeRemaining = slipFadeLength;
+
+    transportSource.setPosition(seconds);
+    resampleSource.flushBuffers();
+    playMode = PlayMode::transport;
+}
+
+//this function mixes the audio from before a jump into the start of the block, fading it out over slipFadeSeconds. the transport's
+//volume is applied to it here because it does not go through the transport
+void DJAudioPlayer::mixSlipFade(const AudioSourceChannelInfo& bufferToFill)
+{
+    if (slipFadeRemaining <= 0) {
+        return;
+    }
+
+    int numFade = jmin(slipFadeRemaining, bufferToFill.numSamples, slipFadeBuffer.getNumSamples());
+    scratchEngine.render(slipFadeBuffer, 0, numFade, fadeOutPosition, fadeOutRate, fadeOutRate);
+
+    float volume = transportSource.getGain();
+    int numChannels = jmin(bufferToFill.buffer->getNumChannels(), slipFadeBuffer.getNumChannels());
+    for (int channel = 0; channel < numChannels; ++channel) {
+        float* samples = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
+        const float* fading = slipFadeBuffer.getReadPointer(channel);
+        for (int i = 0; i < numFade; ++i) {
+            float gain = (float) (slipFadeRemaining - i) / (float) slipFadeLength;
+            samples[i] = samples[i] * (1.0f - gain) + fading[i] * gain * volume;
+        }
+    }
+    slipFadeRemaining -= numFade;
+}
+
+//this function moves the shadow playhead on at the motor's speed whatever the record does, so it stays where the track would have been
+void DJAudioPlayer::moveShadow(int numSamples, double motorRate, double sourceRate)
+{
+    double sampleRate = deviceSampleRate.load();
+    if (sampleRate > 0.0 && sourceRate > 0.0) {
+        double length = (double) scratchEngine.getTotalLength() / sourceRate;
+        shadowPosition = jlimit(0.0, length, shadowPosition + motorRate * numSamples / sampleRate);
+    }
+}
+
+//this function follows the master's beat clock: the tempo ratio matches the beats per second and a PI loop on the phase error takes out
+//whatever is left, including the drift from a tempo that was rounded or measured slightly wrong
+double DJAudioPlayer::updateSync(int numSamples)
+{
+    double ratio = speedRatio.load();
+    double bpm = beatGridBpm.load();
+    double sampleRate = deviceSampleRate.load();
+    bool playing = isPlaying();
+    double position = transportSource.getCurrentPosition();
+    double beat = (position - beatGridFirstBeat.load()) * bpm / 60.0;
+
+    bool syncing = false;
+    DJAudioPlayer* master = syncMaster.load();
+
+    if (master != nullptr && playing && bpm > 0.0 && sampleRate > 0.0 && master->beatClock.valid && master->beatClock.beatsPerSample > 0.0) {
+        //the master's clock is from the start of this block, or of the last one if it is rendered after this deck
+        const BeatClock& clock = master->beatClock;
+        double masterBeat = clock.beat + (double) (renderedSamples - clock.sample) * clock.beatsPerSample;
+        double tempoRatio = clock.beatsPerSample * sampleRate * 60.0 / bpm;
+
+        //the phase error to the nearest beat of the master, positive when this deck is behind
+        double error = masterBeat - beat;
+        error -= std::round(error);
+
+        if (!wasSyncing) {
+            syncIntegral = 0.0;
+        }
+        syncIntegral = jlimit(-maxSyncCorrection, maxSyncCorrection, syncIntegral + error * syncIntegralGain * numSamples / sampleRate);
+
+        double correction = jlimit(-maxSyncCorrection, maxSyncCorrection, error * syncProportionalGain + syncIntegral);
+        ratio = jlimit(0.01, 100.0, tempoRatio * (1.0 + correction));
+        syncing = true;
+    }
+    wasSyncing = syncing;
+
+    //a synced deck's loop pulls it back into phase once the nudge has died away
+    ratio *= 1.0 + nudge;
+    if (nudge != 0.0 && sampleRate > 0.0) {
+        nudge *= std::pow(0.5, numSamples / (nudgeHalfLifeSeconds * sampleRate));
+        if (std::abs(nudge) < 1.0e-4) {
+            nudge = 0.0;
+        }
+    }
+
+    beatClock.sample = renderedSamples;
+    beatClock.beat = beat;
+    beatClock.beatsPerSample = playing && sampleRate > 0.0 ? bpm / 60.0 * ratio / sampleRate : 0.0;
+    beatClock.valid = bpm > 0.0;
+    beatClock.position = position;
+    beatClock.secondsPerSample = playing && sampleRate > 0.0 ? ratio / sampleRate : 0.0;
+    beatClock.running = true;
+    return ratio;
+}
+
+//this function works out where the deck being copied is at the start of this block from its clock, the same way sync does, and how
+//many samples are left until it reaches the double's start. a deck that stopped or is being scratched is not waited for
+int DJAudioPlayer::samplesUntilDoubleStarts(int numSamples)
+{
+    DJAudioPlayer* source = doubleSource.load();
+    if (source == nullptr) {
+        return 0;
+    }
+
+    const BeatClock& clock = source->beatClock;
+    if (clock.running && clock.secondsPerSample > 0.0) {
+        double sourcePosition = clock.position + (double) (renderedSamples - clock.sample) * clock.secondsPerSample;
+        double wait = (doubleStartSeconds.load() - sourcePosition) / clock.secondsPerSample;
+        if (wait >= numSamples) {
+            return numSamples;
+        }
+        if (doubleSource.compare_exchange_strong(source, nullptr)) {
+            return jmax(0, roundToInt(wait));
+        }
+        return 0;
+    }
+
+    doubleSource.compare_exchange_strong(source, nullptr);
+    return 0;
+}
+
+//this function applies the commands queued since the last block, in the order they were pushed
+void DJAudioPlayer::applyCommands()
+{
+    //a thread that keeps pushing cannot hold up the block, what is left over is applied in the next one
+    Command command{};
+    for (int count = 0; count < commandQueueSize && commandQueue.pop(command); ++count) {
+        if (automationLog != nullptr && command.logged) {
+            recordCommand(command);
+        }
+
+        switch (command.type) {
+            case Command::Type::volume:
+                transportSource.setGain((float) command.value);
+                break;
+            case Command::Type::speed:
+                speedRatio = command.value;
+                break;
+            case Command::Type::bass:
+            case Command::Type::mid:
+            case Command::Type::treble:
+                applyEq(command.type, command.value);
+                break;
+            case Command::Type::filter:
+                filter.setPosition((float) command.value);
+                break;
+            case Command::Type::filterResonance:
+                filter.setResonance((float) command.value);
+                break;
+            case Command::Type::jogVelocity:
+                scratchVelocity = jlimit(-ScratchEngine::maxRate, ScratchEngine::maxRate, command.value);
+                lastJogSample = renderedSamples;
+                break;
+            case Command::Type::nudge:
+                nudge = jlimit(-maxNudge, maxNudge, nudge + command.value);
+                break;
+            case Command::Type::play:
+                startPlaying();
+                break;
+            case Command::Type::stop:
+                deckPlaying = false;
+                doubleSource = nullptr;
+                break;
+            case Command::Type::togglePlay:
+                if (isPlaying()) {
+                    deckPlaying = false;
+                    doubleSource = nullptr;
+                }
+                else {
+                    startPlaying();
+                }
+                break;
+            case Command::Type::hotCueTrigger:
+                pressHotCue((int) command.value);
+                break;
+            case Command::Type::hotCueRelease:
+                letGoOfHotCue((int) command.value);
+                break;
+            case Command::Type::scratchBegin:
+                holdRecord();
+                break;
+            case Command::Type::scratchEnd:
+                letGoOfRecord();
+                break;
+            case Command::Type::position:
+                moveTo(command.value);
+                break;
+            case Command::Type::doubleStart:
+                //the seek clears a double that was still waiting, so the new one is set after it
+                moveTo(command.value);
+                doubleStartSeconds = command.value;
+                doubleSource = command.master;
+                break;
+            case Command::Type::fade: {
+                //the ramp starts from wherever the gain is now
+                float currentGain = fadeGain.getCurrentValue();
+                fadeGain.reset(deviceSampleRate.load(), command.value2);
+                fadeGain.setCurrentAndTargetValue(currentGain);
+                fadeGain.setTargetValue((float) command.value);
+                break;
+            }
+            case Command::Type::hotCueSet:
+                if (isPositiveAndBelow(command.index, numHotCues)) {
+                    hotCues[command.index] = jmax(-1.0, command.value);
+                }
+                break;
+            case Command::Type::scratchVelocity:
+                scratchVelocity = jlimit(-ScratchEngine::maxRate, ScratchEngine::maxRate, command.value);
+                break;
+            case Command::Type::reverse:
+                applyReverse(command.value != 0.0);
+                break;
+            case Command::Type::slip:
+                slip = command.value != 0.0;
+                break;
+            case Command::Type::beatGrid:
+                beatGridBpm = jmax(0.0, command.value);
+                beatGridFirstBeat = command.value2;
+                break;
+            case Command::Type::syncMaster:
+                syncMaster = command.master;
+                break;
+            case Command::Type::effectEnabled:
+                if (isPositiveAndBelow(command.index, EffectsRack::numEffects)) {
+                    effectsRack.setEnabled((EffectsRack::Effect) command.index, command.value != 0.0);
+                }
+                break;
+            case Command::Type::effectMix:
+                if (isPositiveAndBelow(command.index, EffectsRack::numEffects)) {
+                    effectsRack.setMix((EffectsRack::Effect) command.index, (float) command.value);
+                }
+                break;
+        }
+    }
+
+    //a controller only sends jog messages while the wheel turns, so a held wheel that has gone quiet is standing still
+    double sampleRate = deviceSampleRate.load();
+    if (lastJogSample >= 0 && renderedSamples - lastJogSample > (int64) (jogIdleSeconds * sampleRate)) {
+        if (scratchHeld.load()) {
+            scratchVelocity = 0.0;
+        }
+        lastJogSample = -1;
+    }
+}
+
+//this function records a command as the change it makes, so a change reads the same in the log whichever control made it
+void DJAudioPlayer::recordCommand(const Command& command)
+{
+    using Type = AutomationLog::Type;
+    AutomationLog::Target target = automationTarget;
+
+    switch (command.type) {
+        case Command::Type::volume:
+            automationLog->record(target, Type::volume, 0, command.value);
+            break;
+        case Command::Type::speed:
+            automationLog->record(target, Type::speed, 0, command.value);
+            break;
+        case Command::Type::position:
+            automationLog->record(target, Type::position, 0, command.value);
+            break;
+        case Command::Type::doubleStart:
+            automationLog->record(target, Type::doubleStart, command.master != nullptr ? (int) command.master->automationTarget : -1, command.value);
+            break;
+        case Command::Type::fade:
+            automationLog->record(target, Type::fade, 0, command.value, command.value2);
+            break;
+        case Command::Type::hotCueSet:
+            if (command.value < 0.0) {
+                automationLog->record(target, Type::hotCueClear, command.index, 0.0);
+            }
+            else {
+                automationLog->record(target, Type::hotCueSet, command.index, command.value);
+            }
+            break;
+        case Command::Type::scratchBegin:
+            automationLog->record(target, Type::scratchBegin, 0, 0.0);
+            break;
+        case Command::Type::scratchVelocity:
+            automationLog->record(target, Type::scratchVelocity, 0, command.value);
+            break;
+        case Command::Type::scratchEnd:
+            automationLog->record(target, Type::scratchEnd, 0, 0.0);
+            break;
+        case Command::Type::reverse:
+            automationLog->record(target, Type::reverse, command.value != 0.0 ? 1 : 0, 0.0);
+            break;
+        case Command::Type::slip:
+            automationLog->record(target, Type::slip, command.value != 0.0 ? 1 : 0, 0.0);
+            break;
+        case Command::Type::beatGrid:
+            automationLog->record(target, Type::beatGrid, 0, command.value, command.value2);
+            break;
+        case Command::Type::syncMaster:
+            automationLog->record(target, Type::syncMaster, command.master != nullptr ? (int) command.master->automationTarget : -1, 0.0);
+            break;
+        case Command::Type::effectEnabled:
+            automationLog->record(target, Type::effectEnabled, command.index, command.value);
+            break;
+        case Command::Type::effectMix:
+            automationLog->record(target, Type::effectMix, command.index, command.value);
+            break;
+        default:
+            automationLog->record(target, Type::command, (int) command.type, command.value);
+            break;
+    }
+}
+
+//this function recalculates the coefficients of one EQ band. only that band is applied, as with the sliders
+void DJAudioPlayer::applyEq(Command::Type band, double gainDb)
+{
+    double sampleRate = deviceSampleRate.load();
+    if (sampleRate <= 0.0 || bassFilter.coefficients == nullptr) {
+        return;
+    }
+
+    //the filters run after the resampler, so they are designed for the device rate
+    float gain = Decibels::decibelsToGain((float) gainDb);
+    using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+
+    if (band == Command::Type::bass) {
+        *bassFilter.coefficients = ArrayCoefficients::makeLowShelf(sampleRate, bassFrequency, 0.707f, gain);
+    }
+    else if (band == Command::Type::treble) {
+        *trebleFilter.coefficients = ArrayCoefficients::makeHighShelf(sampleRate, trebleFrequency, 0.707f, gain);
+    }
+    else {
+        *midrangeFilter.coefficients = ArrayCoefficients::makePeakFilter(sampleRate, midFrequency, 0.707f, gain);
+    }
+
+    isBass = band == Command::Type::bass;
+    isTreble = band == Command::Type::treble;
+    isMid = band == Command::Type::mid;
+}
+
+//this function is used to release or clean up any resources that were previously allocated for audio playback
+void DJAudioPlayer::releaseResources()
+{
+    transportSource.releaseResources();
+    resampleSource.releaseResources();
+}
+
+//this function class is used to load an audio file from a given URL, and it sets up the necessary resources for playback
+void DJAudioPlayer::loadURL(URL audioURL)
+{
+    Tracer::Scope trace("DJAudioPlayer::loadURL", Tracer::Category::loading);
+    AutomationLog::Action action(automationLog, automationTarget, AutomationLog::Type::load, 0, 0.0, 0.0, audioURL.toString(true));
+
+    if (audioURL.isEmpty())
+    {
+        transportSource.stop();
+
+        // Reset the source (this clears the currently loaded file)
+        installStream(nullptr, nullptr);
+    }
+    else
+    {
+        auto* reader = createReaderFor(audioURL);
+        if (reader != nullptr) //means a good file!
+        {
+            //the read-ahead starts filling as soon as the transport prepares the stream, normally long before play is pressed
+            installStream(std::make_unique<StreamingAudioSource>(reader, readAheadThread, prefetchSeconds.load()),
+                          std::unique_ptr<AudioFormatReader>(createReaderFor(audioURL)), startWholeTrackDecoder(audioURL));
+        }
+    }
+}
+
+//this function opens a reader for the track, wrapping the file in a throttled stream when slow storage is simulated
+AudioFormatReader* DJAudioPlayer::createReaderFor(const URL& audioURL)
+{
+    std::unique_ptr<InputStream> stream = audioURL.createInputStream(false);
+
+    if (stream != nullptr && (readLatencyMs.load() > 0 || readSpikeMs.load() > 0)) {
+        stream.reset(new ThrottledInputStream(stream.release(), readLatencyMs.load(), readSpikeMs.load(), readSpikeInterval.load()));
+    }
+
+    return formatManager.createReaderFor(std::move(stream));
+}
+
+//this function starts the parallel decoder of a track. the decoder asks its reader whether each worker can start anywhere in the
+//track, and decodes it from the start on one worker if not
+ParallelTrackDecoder::Ptr DJAudioPlayer::startWholeTrackDecoder(const URL& audioURL)
+{
+    if (!preloadWholeTracks.load()) {
+        return nullptr;
+    }
+
+    ParallelTrackDecoder::Ptr decoder = new ParallelTrackDecoder([this, audioURL] { return createReaderFor(audioURL); }, jobScheduler);
+    if (!decoder->start()) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+//this function hands a new stream to the transport and reports how the old one coped with the storage
+void DJAudioPlayer::installStream(std::unique_ptr<StreamingAudioSource> newStream, std::unique_ptr<AudioFormatReader> scratchReader,
+                                  ParallelTrackDecoder::Ptr decodedTrack)
+{
+    Tracer::Scope trace("DJAudioPlayer::installStream", Tracer::Category::loading);
+    if (streamSource != nullptr) {
+        auto statistics = streamSource->getStatistics();
+        if (statistics.numStalls > 0) {
+            std::cout << "DJAudioPlayer: " << statistics.numStalls << " stalls in " << statistics.numBlocks << " blocks, "
+                      << statistics.stalledSeconds << " s of silence, longest " << statistics.longestStallSeconds << " s" << std::endl;
+        }
+    }
+
+    if (newStream != nullptr) {
+        transportSource.setSource(newStream.get(), 0, nullptr, newStream->getSourceSampleRate());
+    }
+    else {
+        transportSource.setSource(nullptr);
+    }
+    streamSource = std::move(newStream);
+    scratchEngine.setReader(scratchReader.release(), decodedTrack);
+    this->decodedTrack = decodedTrack;
+    windowPositionSeconds = 0.0;
+    doubleSource = nullptr;
+
+    //the cues belonged to the old track
+    for (auto& cue : hotCues) {
+        cue = -1.0;
+    }
+    heldCue = -1;
+}
+
+//this function starts a background load, cancelling any load that is still running
+void DJAudioPlayer::loadURLInBackground(URL audioURL, std::function<void(bool)> onLoaded)
+{
+    jobScheduler.removeJobs(this, 5000);
+
+    {
+        const ScopedLock sl(pendingLock);
+        pendingLoad.reset();
+    }
+    pendingCallback = std::move(onLoaded);
+
+    jobScheduler.addJob(new PreloadJob(*this, audioURL), JobScheduler::Priority::deck, this, true);
+}
+
+//this function installs the source prepared by the preload job and tells the caller
+void DJAudioPlayer::handleAsyncUpdate()
+{
+    std::unique_ptr<PendingLoad> load;
+    {
+        const ScopedLock sl(pendingLock);
+        load = std::move(pendingLoad);
+    }
+
+    if (load == nullptr) {
+        return;
+    }
+
+    if (load->loaded) {
+        stop();
+
+        AutomationLog::Action action(automationLog, automationTarget, AutomationLog::Type::load, 0, 0.0, 0.0, load->url.toString(true));
+        installStream(std::move(load->streamSource), std::move(load->scratchReader), load->decodedTrack);
+    }
+
+    if (pendingCallback != nullptr) {
+        auto callback = std::move(pendingCallback);
+        pendingCallback = nullptr;
+        callback(load->loaded);
+    }
+}
+
+//this function helps set the gain (volume level) of the audio playback
+void DJAudioPlayer::setVolume(double volumeGain)
+{
+    if (volumeGain < 0 || volumeGain > 1.0) {
+        std::cout << "volume gain should be between 0 and 1" << std::endl;
+    }
+    else {
+        pushCommand({ Command::Type::volume, volumeGain });
+    }
+}
+
+//this function help set the speed (speed level) of the audio playback
+void DJAudioPlayer::setSpeed(double speedRatio)
+{
+    if (speedRatio < 0 || speedRatio > 100.0) {
+        std::cout << "Speed ratio should be between 0 and 100" << std::endl;
+    }
+    else {
+        //the audio thread passes it on to the resampler, unless the deck is synced
+        pushCommand({ Command::Type::speed, speedRatio });
+    }
+}
+
+//this function sets the playback position of the audio to a specific point, given in seconds.
+void DJAudioPlayer::setPosition(double posSecs)
+{
+    pushCommand({ Command::Type::position, posSecs });
+}
+
+//this function does the seek of a position command and a hot cue on the audio thread
+void DJAudioPlayer::moveTo(double seconds)
+{
+    //a double that was still waiting starts from here instead
+    doubleSource = nullptr;
+    transportSource.setPosition(seconds);
+
+    //also moves the window playback if a scratch or reverse is on
+    windowPositionSeconds = seconds;
+    seekSeconds = seconds;
+    ++seekRequest;
+}
+
+//this function allows you to set the playback position relative to the total length of the audio track, expressed as a value between 0 and 1.
+void DJAudioPlayer::setPositionRelative(double position)
+{
+    if (position < 0 || position > 1.0) {
+        std::cout << "DJAudioPlayer::setPositionRelative pos should be between 0 and 1" << std::endl;
+    }
+    else {
+        double posInSecs = transportSource.getLengthInSeconds() * position;
+        setPosition(posInSecs);
+    }
+}
+
+//this function starts the audio
+void DJAudioPlayer::start()
+{
+    pushCommand({ Command::Type::play, 0.0 });
+}
+
+//this function pauses the audio
+void DJAudioPlayer::stop()
+{
+    pushCommand({ Command::Type::stop, 0.0 });
+}
+
+//this function checks if the audio is playing, the transport stops on its own at the end of the track
+bool DJAudioPlayer::isPlaying() const
+{
+    return deckPlaying.load() && transportSource.isPlaying();
+}
+
+//this function plays the deck on the audio thread. the transport is only started when it is not running already, after a load or at
+//the end of the track, which takes its lock for a moment but never waits like stopping it does
+void DJAudioPlayer::startPlaying()
+{
+    if (!transportSource.isPlaying()) {
+        transportSource.start();
+    }
+    deckPlaying = true;
+}
+
+//this function asks the audio thread to ramp the fade gain
+void DJAudioPlayer::fadeTo(float targetGain, double seconds)
+{
+    pushCommand({ Command::Type::fade, (double) targetGain, 0, seconds });
+}
+
+//this function returns the deck's effects
+EffectsRack& DJAudioPlayer::getEffects()
+{
+    return effectsRack;
+}
+
+//this function turns one of the deck's effects on or off
+void DJAudioPlayer::setEffectEnabled(EffectsRack::Effect effect, bool shouldBeEnabled)
+{
+    pushCommand({ Command::Type::effectEnabled, shouldBeEnabled ? 1.0 : 0.0, (int) effect });
+}
+
+//this function sets how much of one of the deck's effects is heard
+void DJAudioPlayer::setEffectMix(EffectsRack::Effect effect, float mix)
+{
+    pushCommand({ Command::Type::effectMix, (double) mix, (int) effect });
+}
+
+//this function returns the deck's level meter
+LevelMeter& DJAudioPlayer::getMeter()
+{
+    return meter;
+}
+
+//this function adds a command to the queue from any thread
+bool DJAudioPlayer::pushCommand(Command command)
+{
+    //a command pushed by a load or a double is part of that change, which makes it again when it is replayed
+    if (AutomationLog::Action::isRunning()) {
+        command.logged = false;
+    }
+    return commandQueue.push(command);
+}
+
+//this function queues a hot cue press for the audio thread
+void DJAudioPlayer::triggerHotCue(int index)
+{
+    pushCommand({ Command::Type::hotCueTrigger, (double) index });
+}
+
+//this function stores the playhead on an empty pad, or jumps to the stored cue and plays from there. it runs on the audio thread, so a
+//replay of the logged command stores the cue on the same sample
+void DJAudioPlayer::pressHotCue(int index)
+{
+    if (!isPositiveAndBelow(index, numHotCues) || getLength() <= 0.0) {
+        return;
+    }
+
+    double cue = hotCues[index].load();
+    if (cue < 0.0) {
+        hotCues[index] = getPosition() * getLength();
+        return;
+    }
+
+    //with slip on, a playing deck plays the cue while the pad is held and the track carries on underneath, renderDeck makes the jump
+    if (slip.load() && isPlaying()) {
+        heldCue = index;
+        return;
+    }
+
+    moveTo(cue);
+    startPlaying();
+}
+
+//this function queues a hot cue release for the audio thread
+void DJAudioPlayer::releaseHotCue(int index)
+{
+    pushCommand({ Command::Type::hotCueRelease, (double) index });
+}
+
+//this function lets go of a held hot cue, renderDeck brings the track back where the shadow playhead is
+void DJAudioPlayer::letGoOfHotCue(int index)
+{
+    if (heldCue.load() == index) {
+        heldCue = -1;
+    }
+}
+
+//this function empties a hot cue pad
+void DJAudioPlayer::clearHotCue(int index)
+{
+    pushCommand({ Command::Type::hotCueSet, -1.0, index });
+}
+
+//this function stores a hot cue that is already known
+void DJAudioPlayer::setHotCue(int index, double seconds)
+{
+    pushCommand({ Command::Type::hotCueSet, seconds, index });
+}
+
+//this function returns a hot cue in seconds, -1 if the pad is empty
+double DJAudioPlayer::getHotCue(int index) const
+{
+    return isPositiveAndBelow(index, numHotCues) ? hotCues[index].load() : -1.0;
+}
+
+//this function gets position of the audio
+double DJAudioPlayer::getPosition()
+{
+    if (inWindow.load() || scratchHeld.load() || reverse.load()) {
+        return windowPositionSeconds.load() / transportSource.getLengthInSeconds();
+    }
+    return transportSource.getCurrentPosition() / transportSource.getLengthInSeconds();
+}
+
+//this function returns the length of the audio source in seconds
+double DJAudioPlayer::getLength()
+{
+    return transportSource.getLengthInSeconds();
+}
+
+//this function returns the current speed ratio
+double DJAudioPlayer::getSpeed() const
+{
+    return speedRatio.load();
+}
+
+//this function takes hold of the record, it stands still until the first velocity arrives
+void DJAudioPlayer::beginScratch()
+{
+    pushCommand({ Command::Type::scratchBegin, 0.0 });
+}
+
+//this function takes hold of the record for a scratch begin command, on the audio thread
+void DJAudioPlayer::holdRecord()
+{
+    if (!inWindow.load() && !reverse.load()) {
+        windowPositionSeconds = transportSource.getCurrentPosition();
+    }
+    scratchVelocity = 0.0;
+    scratchHeld = true;
+}
+
+//this function sets how fast the record is being moved by hand
+void DJAudioPlayer::setScratchVelocity(double rate)
+{
+    pushCommand({ Command::Type::scratchVelocity, rate });
+}
+
+//this function lets go of the record, the motor takes over again from wherever it was left
+void DJAudioPlayer::endScratch()
+{
+    pushCommand({ Command::Type::scratchEnd, 0.0 });
+}
+
+//this function lets go of the record for a scratch end command, on the audio thread
+void DJAudioPlayer::letGoOfRecord()
+{
+    if (!scratchHeld.load()) {
+        return;
+    }
+
+    if (!reverse.load()) {
+        releaseWindow();
+    }
+    scratchHeld = false;
+}
+
+//this function checks if the record is being held
+bool DJAudioPlayer::isScratching() const
+{
+    return scratchHeld.load();
+}
+
+//this function turns reverse playback on or off
+void DJAudioPlayer::setReverse(bool shouldReverse)
+{
+    pushCommand({ Command::Type::reverse, shouldReverse ? 1.0 : 0.0 });
+}
+
+//this function turns reverse playback on or off for a reverse command, on the audio thread
+void DJAudioPlayer::applyReverse(bool shouldReverse)
+{
+    if (shouldReverse == reverse.load()) {
+        return;
+    }
+
+    if (shouldReverse) {
+        if (!inWindow.load() && !scratchHeld.load()) {
+            windowPositionSeconds = transportSource.getCurrentPosition();
+        }
+        reverse = true;
+    }
+    else {
+        if (!scratchHeld.load()) {
+            releaseWindow();
+        }
+        reverse = false;
+    }
+}
+
+//this function checks if the deck plays backwards
+bool DJAudioPlayer::isReversed() const
+{
+    return reverse.load();
+}
+
+//this function copies another deck. the track is loaded first, then the other deck's speed, beat grid, cues and position are read on
+//this thread and pushed as the commands the controls use, so the audio thread applies them and the log records each one
+bool DJAudioPlayer::doubleFrom(DJAudioPlayer& source, const URL& audioURL, double atSeconds)
+{
+    Tracer::Scope trace("DJAudioPlayer::doubleFrom", Tracer::Category::loading);
+
+    if (!loadDoubleOf(source, audioURL)) {
+        return false;
+    }
+
+    setSpeed(source.speedRatio.load());
+    setBeatGrid(source.getBeatGridBpm(), source.getFirstBeatSeconds());
+    for (int index = 0; index < numHotCues; ++index) {
+        //the load emptied every pad
+        double cue = source.getHotCue(index);
+        if (cue >= 0.0) {
+            setHotCue(index, cue);
+        }
+    }
+
+    //a stopped, scratched or reversed deck is copied where it is
+    if (!source.isPlaying() || source.inWindow.load() || source.scratchHeld.load() || source.reverse.load() ||
+        source.heldCue.load() >= 0) {
+        setPosition(atSeconds >= 0.0 ? atSeconds : source.getPosition() * source.getLength());
+        if (source.isPlaying()) {
+            start();
+        }
+        return true;
+    }
+
+    //the read-ahead fills from the start point while the other deck plays up to it
+    double startSeconds = atSeconds >= 0.0 ? atSeconds
+                                           : jmin(getLength(), source.transportSource.getCurrentPosition() + doubleLeadSeconds * source.speedRatio.load());
+    pushCommand({ Command::Type::doubleStart, startSeconds, 0, 0.0, &source });
+    start();
+    return true;
+}
+
+//this function loads the track of another deck for a double. with whole-track preloading the double reads the other deck's decoded
+//track through a DecodedTrackReader, which only opens the file for the chunks that are not decoded yet. otherwise the other deck only
+//keeps its read-ahead window in memory, so the double opens the track and decodes it again like loadURL
+bool DJAudioPlayer::loadDoubleOf(DJAudioPlayer& source, const URL& audioURL)
+{
+    AutomationLog::Action action(automationLog, automationTarget, AutomationLog::Type::doubleFrom, (int) source.automationTarget, 0.0, 0.0, audioURL.toString(true));
+
+    if (&source == this || source.streamSource == nullptr || audioURL.isEmpty()) {
+        std::cout << "DJAudioPlayer::doubleFrom source should be another deck with a track loaded" << std::endl;
+        return false;
+    }
+
+    ParallelTrackDecoder::Ptr shared = source.decodedTrack;
+    std::unique_ptr<AudioFormatReader> streamReader;
+    std::unique_ptr<AudioFormatReader> scratchReader;
+
+    if (shared != nullptr) {
+        //failed chunks are read from the file like the ones still decoding
+        bool decoded = shared->isFinished() && !shared->hasFailed();
+        streamReader.reset(new DecodedTrackReader(shared, decoded ? nullptr : createReaderFor(audioURL)));
+        scratchReader.reset(new DecodedTrackReader(shared, decoded ? nullptr : createReaderFor(audioURL)));
+    }
+    else {
+        streamReader.reset(createReaderFor(audioURL));
+        scratchReader.reset(createReaderFor(audioURL));
+    }
+
+    if (streamReader == nullptr) {
+        return false;
+    }
+
+    stop();
+    installStream(std::make_unique<StreamingAudioSource>(streamReader.release(), readAheadThread, prefetchSeconds.load()),
+                  std::move(scratchReader), shared);
+    return true;
+}
+
+//this function sets the beat grid used by sync
+void DJAudioPlayer::setBeatGrid(double bpm, double firstBeatSeconds)
+{
+    pushCommand({ Command::Type::beatGrid, bpm, 0, firstBeatSeconds });
+}
+
+//these functions return the beat grid set by setBeatGrid
+double DJAudioPlayer::getBeatGridBpm() const
+{
+    return beatGridBpm.load();
+}
+
+double DJAudioPlayer::getFirstBeatSeconds() const
+{
+    return beatGridFirstBeat.load();
+}
+
+//this function turns sync on or off
+void DJAudioPlayer::setSyncMaster(DJAudioPlayer* master, bool alignPhase)
+{
+    if (master == this) {
+        master = nullptr;
+    }
+
+    //two decks following each other would never settle, so the master stops following this one
+    if (master != nullptr && master->syncMaster.load() == this) {
+        master->setSyncMaster(nullptr);
+    }
+
+    //the jump is a position command of its own, queued ahead of the sync. a replay makes the same seek instead of working out the phase again
+    if (alignPhase && master != nullptr && syncMaster.load() != master) {
+        alignPhaseTo(*master);
+    }
+
+    Command command{ Command::Type::syncMaster, 0.0 };
+    command.master = master;
+    pushCommand(command);
+}
+
+//this function checks if the deck follows a master
+bool DJAudioPlayer::isSynced() const
+{
+    return syncMaster.load() != nullptr;
+}
+
+//this function jumps forwards to the master's beat phase, only forwards so the read-ahead buffer is kept
+void DJAudioPlayer::alignPhaseTo(DJAudioPlayer& master)
+{
+    double bpm = beatGridBpm.load();
+    double masterBpm = master.beatGridBpm.load();
+    if (bpm <= 0.0 || masterBpm <= 0.0 || !isPlaying() || !master.isPlaying()) {
+        return;
+    }
+
+    double position = transportSource.getCurrentPosition();
+    double beat = (position - beatGridFirstBeat.load()) * bpm / 60.0;
+    double masterBeat = (master.transportSource.getCurrentPosition() - master.beatGridFirstBeat.load()) * masterBpm / 60.0;
+
+    double error = masterBeat - beat;
+    if (std::abs(error - std::round(error)) > 0.05) {
+        setPosition(position + (error - std::floor(error)) * 60.0 / bpm);
+    }
+}
+
+//this function moves the transport to the window playback, a little ahead of it on a playing deck so its read-ahead is ready in time.
+//with slip on the audio thread seeks it to the shadow playhead instead and fades the window over to it
+void DJAudioPlayer::releaseWindow()
+{
+    double position = windowPositionSeconds.load();
+
+    //the audio thread never took over, so the transport is still where the playback is
+    if (!inWindow.load()) {
+        handoffTarget = -1.0;
+        return;
+    }
+
+    if (slip.load()) {
+        handoffTarget = -1.0;
+        slipReturn = true;
+        return;
+    }
+
+    if (isPlaying()) {
+        double target = jmin(transportSource.getLengthInSeconds(), position + handoffSeconds * speedRatio.load());
+        transportSource.setPosition(target);
+        handoffTarget = target;
+    }
+    else {
+        transportSource.setPosition(position);
+        handoffTarget = -1.0;
+    }
+}
+
+//this function turns slip mode on or off, an excursion that is going on when it is turned on comes back to the shadow as well
+void DJAudioPlayer::setSlip(bool shouldSlip)
+{
+    pushCommand({ Command::Type::slip, shouldSlip ? 1.0 : 0.0 });
+}
+
+//this function checks if slip mode is on
+bool DJAudioPlayer::isSlipOn() const
+{
+    return slip.load();
+}
+
+//this function sets the read-ahead window of the next loads
+void DJAudioPlayer::setPrefetchSeconds(double seconds)
+{
+    if (seconds < 1.0 || seconds > 600.0) {
+        std::cout << "DJAudioPlayer::setPrefetchSeconds seconds should be between 1 and 600" << std::endl;
+    }
+    else {
+        prefetchSeconds = seconds;
+    }
+}
+
+//this function returns the read-ahead window in seconds
+double DJAudioPlayer::getPrefetchSeconds() const
+{
+    return prefetchSeconds.load();
+}
+
+//this function turns the simulated slow storage on or off for the next loads
+void DJAudioPlayer::setSimulatedReadLatency(int latencyMs, int spikeMs, int spikeInterval)
+{
+    readLatencyMs = jmax(0, latencyMs);
+    readSpikeMs = jmax(0, spikeMs);
+    readSpikeInterval = jmax(0, spikeInterval);
+}
+
+//this function turns decoding whole tracks into RAM on or off for the next loads
+void DJAudioPlayer::setPreloadWholeTracks(bool shouldPreload)
+{
+    preloadWholeTracks = shouldPreload;
+}
+
+//this function returns the stall statistics of the loaded track, all zero if nothing is loaded
+StreamingAudioSource::Statistics DJAudioPlayer::getStreamingStatistics() const
+{
+    if (streamSource == nullptr) {
+        return {};
+    }
+    return streamSource->getStatistics();
+}
+
+//this function sets the log the deck's changes are recorded in
+void DJAudioPlayer::setAutomationLog(AutomationLog* log, AutomationLog::Target target)
+{
+    automationLog = log;
+    automationTarget = target;
+}
+
+//this function waits for the buffers the audio thread reads, on the thread that renders the deck offline
+bool DJAudioPlayer::waitUntilReady(int timeoutMs)
+{
+    bool buffered = streamSource == nullptr || streamSource->waitUntilBuffered(readySeconds, timeoutMs);
+    return scratchEngine.waitUntilFilled(readySeconds, timeoutMs) && buffered;
+}
+
+//this function sets the trebel based on the value from the slider in DeckGUI
+void DJAudioPlayer::setTreble(double gainValue)
+{
+    //checks if there is audio loaded
+    if (streamSource == nullptr) {
+        std::cout << "No audio loaded. Cannot set treble." << std::endl;
+        return;
+    }
+
+    //validate the gainValue that it is within the slider value
+    if (gainValue < - 0 || gainValue > 6.0)  {
+        std::cout << "DJAudioPlayer::setTreble gainValue should be between -12 and +12 dB" << std::endl;
+        return;
+    }
+    
+    //the audio thread recalculates the filter, so it is never changed while a block is being filtered
+    pushCommand({ Command::Type::treble, gainValue });
+}
+
+//this sets the bass based on the value from the slider in DeckGUI
+void DJAudioPlayer::setBass(double gainValue)
+{
+    //checks if there is audio loaded
+    if (streamSource == nullptr) {
+        std::cout << "No audio loaded. Cannot set bass." << std::endl;
+        return;
+    }
+
+    //validate the gainValue that it is within the slider value
+    if (gainValue < - 0 || gainValue > 6.0) {
+        std::cout << "DJAudioPlayer::setBass gainValue should be between -12 and +12 dB" << std::endl;
+        return;
+    }
+
+    //the audio thread recalculates the filter, so it is never changed while a block is being filtered
+    pushCommand({ Command::Type::bass, gainValue });
+}
+
+//this sets the Mid based on the value from the slider in DeckGUI
+void DJAudioPlayer::setMid(double gainValue)
+{
+    //checks if there is audio loaded
+    if (streamSource == nullptr) {
+        std::cout << "No audio loaded. Cannot set midrange." << std::endl;
+        return;
+    }
+
+    //validate the gainValue that it is within the slider value
+    if (gainValue < -12.0 || gainValue > 12.0)
+    {
+        std::cout << "DJAudioPlayer::setMidrange gainValue should be between -12 and +12 dB" << std::endl;
+        return;
+    }
+
+    //the audio thread recalculates the filter, so it is never changed while a block is being filtered
+    pushCommand({ Command::Type::mid, gainValue });
+}
+
+//this function sets the filter knob, left of 0 is a low-pass and right of it a high-pass
+void DJAudioPlayer::setFilter(double position)
+{
+    if (position < -1.0 || position > 1.0) {
+        std::cout << "DJAudioPlayer::setFilter position should be between -1 and 1" << std::endl;
+        return;
+    }
+
+    pushCommand({ Command::Type::filter, position });
+}
+
+//this function sets how much the filter rings at its cutoff
+void DJAudioPlayer::setFilterResonance(double resonance)
+{
+    if (resonance < 0.0 || resonance > 1.0) {
+        std::cout << "DJAudioPlayer::setFilterResonance resonance should be between 0 and 1" << std::endl;
+        return;
+    }
+
+    pushCommand({ Command::Type::filterResonance, resonance });
 }
\ No newline at end of file
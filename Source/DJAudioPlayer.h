@@ -1,58 +1,427 @@
-/*====================================================================
-DJAudioPlayer.h
-====================================================================*/
-
-
-#pragma once
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include <juce_dsp/juce_dsp.h> 
-
-//this class handles all the event listener for the DJplayer such as loading, playing, and manipulating audio files, with additional features like adjusting volume, speed
-class DJAudioPlayer : public AudioSource {
-  public:
-
-    DJAudioPlayer(AudioFormatManager& _formatManager);
-    ~DJAudioPlayer();
-
-    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
-    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
-    void releaseResources() override;
-
-    void loadURL(URL audioURL);
-
-    //functions that runs when user interacts with the program
-    void setVolume(double gain);
-    void setSpeed(double ratio);
-    void setPosition(double posInSecs);
-    void setPositionRelative(double pos);
-    void setTreble(double gainValue);
-    void setBass(double gainValue);
-    void setMid(double gainValue);
-    void start();
-    void stop();
-
-    //gets the position and length of the audio source
-    double getPosition();
-    double getLength();
-
-private:
-    AudioFormatManager& formatManager;
-    std::unique_ptr<AudioFormatReaderSource> readerSource;
-    AudioTransportSource transportSource; 
-    ResamplingAudioSource resampleSource{&transportSource, false, 2};
-
-    //boolean flags
-    bool isTreble = false;
-    bool isBass = false;
-    bool isMid = false;
-
-    //button filters
-    juce::dsp::IIR::Filter<float> trebleFilter;
-    juce::dsp::IIR::Filter<float> bassFilter;
-    juce::dsp::IIR::Filter<float> midrangeFilter;
-};
-
-
-
-
+/*====================================================================
+DJAudioPlayer.h
+====================================================================*/
+
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <juce_dsp/juce_dsp.h> 
+#include "StreamingAudioSource.h"
+#include "ScratchEngine.h"
+#include "EffectsRack.h"
+#include "DJFilter.h"
+#include "LevelMeter.h"
+#include "AutomationLog.h"
+#include "JobScheduler.h"
+#include "CommandQueue.h"
+#include <atomic>
+#include <functional>
+
+//this class handles all the event listener for the DJplayer such as loading, playing, and manipulating audio files, with additional features like adjusting volume, speed
+class DJAudioPlayer : public AudioSource,
+                      private AsyncUpdater {
+  public:
+
+    //centre frequencies of the bass, mid and treble EQ, the coloured waveform splits its bands around them too
+    static constexpr float bassFrequency = 100.0f;
+    static constexpr float midFrequency = 1000.0f;
+    static constexpr float trebleFrequency = 5000.0f;
+
+    //how much audio is read ahead of the playhead by default, and how much of the intro must be buffered before a background load counts as done
+    static constexpr double defaultPrefetchSeconds = 30.0;
+    static constexpr double introSeconds = 20.0;
+
+    //when a scratch or reverse ends on a playing deck, the transport is sent this far ahead and takes over once the window reaches it
+    static constexpr double handoffSeconds = 0.5;
+
+    //a doubled playing deck is cued this far ahead of the deck it copies and starts when that deck gets there
+    static constexpr double doubleLeadSeconds = 0.2;
+
+    //how long the audio from before a slip return or a held cue fades out over the audio after it
+    static constexpr double slipFadeSeconds = 0.01;
+
+    //the number of hot cue pads of each deck
+    static constexpr int numHotCues = 8;
+
+    //a change that is applied by the audio thread at the start of its next block, which is also the block the automation log stamps it with
+    struct Command
+    {
+        enum class Type
+        {
+            volume,        //gain from 0 to 1
+            speed,         //speed ratio
+            bass,          //EQ gains in dB
+            mid,
+            treble,
+            filter,            //the filter knob from -1 (low-pass) to 1 (high-pass)
+            filterResonance,   //0 to 1
+            jogVelocity,   //the velocity of a held jog wheel, it drops to 0 when no new velocity arrives for a moment
+            nudge,         //a short speed change from turning the jog wheel without holding it
+            play,
+            stop,
+            togglePlay,      //plays a stopped deck and stops a playing one, as the deck is when the audio thread takes it
+            hotCueTrigger,   //the value is the pad
+            hotCueRelease,
+            scratchBegin,    //the touch sensor of a jog wheel
+            scratchEnd,
+            position,          //seconds
+            fade,              //the target gain, value2 is the time in seconds
+            hotCueSet,         //the index is the pad, the value is seconds or -1 to empty it
+            scratchVelocity,   //the velocity of a scratch held with the mouse, it stays until the next one
+            reverse,           //1 for on
+            slip,              //1 for on
+            beatGrid,          //bpm, value2 is the first beat in seconds
+            syncMaster,        //master is the deck followed, nullptr for none
+            effectEnabled,     //the index is the effect, 1 for on
+            effectMix,         //the index is the effect
+            doubleStart        //seconds, master is the deck a double waits for before it plays from there
+        };
+
+        Type type;
+        double value;
+        int index = 0;
+        double value2 = 0.0;
+        DJAudioPlayer* master = nullptr;
+
+        //false for a command pushed while an AutomationLog::Action runs, the log records that change as a whole
+        bool logged = true;
+    };
+
+    DJAudioPlayer(AudioFormatManager& _formatManager, TimeSliceThread& _readAheadThread, JobScheduler& _jobScheduler);
+    ~DJAudioPlayer();
+
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    void loadURL(URL audioURL);
+
+    //opens the file and buffers its intro on background threads, then swaps it in on the message thread and calls onLoaded
+    void loadURLInBackground(URL audioURL, std::function<void(bool)> onLoaded);
+
+    //functions that runs when user interacts with the program
+    void setVolume(double gain);
+    void setSpeed(double ratio);
+    void setPosition(double posInSecs);
+    void setPositionRelative(double pos);
+    void setTreble(double gainValue);
+    void setBass(double gainValue);
+    void setMid(double gainValue);
+    void setFilter(double position);
+    void setFilterResonance(double resonance);
+
+    //every change of the deck is a command, so the getters follow once the audio thread has taken it
+    void start();
+    void stop();
+    bool isPlaying() const;
+
+    //ramps an extra gain stage to targetGain over the given time on the audio thread, used for crossfades (0 seconds sets it at once)
+    void fadeTo(float targetGain, double seconds);
+
+    //the insert effects, which run after the EQ
+    EffectsRack& getEffects();
+
+    //the level of what the deck sends to the mixer, after the effects and the fade
+    LevelMeter& getMeter();
+
+    //queues a command for the audio thread, from any other thread. returns false if the queue is full
+    bool pushCommand(Command command);
+
+    //turns an effect on or off and sets its mix, the same as on the effects rack but applied on the audio thread and recorded in the log
+    void setEffectEnabled(EffectsRack::Effect effect, bool shouldBeEnabled);
+    void setEffectMix(EffectsRack::Effect effect, float mix);
+
+    //a hot cue pad: the first press stores the playhead, later presses jump there and play. the cues are cleared when a track is loaded.
+    //with slip on, a playing deck only plays the cue while the pad is held and releaseHotCue brings the track back. a press and a
+    //release are queued as commands, so the cue is stored at the playhead of the block that takes them
+    void triggerHotCue(int index);
+    void releaseHotCue(int index);
+    void clearHotCue(int index);
+    double getHotCue(int index) const;
+
+    //stores a hot cue in seconds, -1 empties the pad
+    void setHotCue(int index, double seconds);
+
+    //gets the position and length of the audio source
+    double getPosition();
+    double getLength();
+
+    //gets the speed ratio set by setSpeed
+    double getSpeed() const;
+
+    //while a scratch is held the record follows the jog velocity (1 is normal speed, negative is backwards) instead of the motor.
+    //each new velocity is reached by a ramp over the next audio block
+    void beginScratch();
+    void setScratchVelocity(double rate);
+    void endScratch();
+    bool isScratching() const;
+
+    //plays the track backwards at the set speed while it is on
+    void setReverse(bool shouldReverse);
+    bool isReversed() const;
+
+    //slip mode: while a scratch, reverse or held hot cue plays, a shadow playhead carries on at the deck's speed underneath. on release
+    //the track comes back where the shadow is, crossfaded from where the record was left. the shadow is only counted, never decoded
+    void setSlip(bool shouldSlip);
+    bool isSlipOn() const;
+
+    //loads the track of another deck with its position, speed, beat grid and hot cues. the audio is read from the other deck's
+    //decoded track when it has one instead of decoding the file again, and a playing deck is started on the audio thread on the
+    //sample the other deck reaches the same point, so the two play in phase. returns false if the other deck has nothing loaded.
+    //atSeconds puts the double at a given position instead of working it out from the other deck, -1 works it out
+    bool doubleFrom(DJAudioPlayer& source, const URL& audioURL, double atSeconds = -1.0);
+
+    //only loads the other deck's track the way doubleFrom does, which is the part of a double the log records as a load. the rest of
+    //the double is logged as the commands it pushes
+    bool loadDoubleOf(DJAudioPlayer& source, const URL& audioURL);
+
+    //sets the beat grid of the loaded track from the library, a bpm of 0 means it has none
+    void setBeatGrid(double bpm, double firstBeatSeconds);
+    double getBeatGridBpm() const;
+    double getFirstBeatSeconds() const;
+
+    //locks this deck's tempo and beat phase to the master deck with a phase-locked loop on the audio thread, nullptr turns it off.
+    //both decks must be inputs of the same mixer, so they are rendered one after the other on the same thread and count the same samples.
+    //the deck jumps forwards to the master's beat phase first unless alignPhase is false
+    void setSyncMaster(DJAudioPlayer* master, bool alignPhase = true);
+    bool isSynced() const;
+
+    //sets how many seconds are read ahead of the playhead, used from the next load on. a larger window rides out longer storage stalls
+    void setPrefetchSeconds(double seconds);
+    double getPrefetchSeconds() const;
+
+    //makes every read of the next loads slow, to test playback from slow storage with local files (0 turns it off)
+    void setSimulatedReadLatency(int latencyMs, int spikeMs, int spikeInterval);
+
+    //decodes the whole of the next loaded tracks into RAM on several threads for the scratch window, off by default because a long
+    //track takes hundreds of megabytes
+    void setPreloadWholeTracks(bool shouldPreload);
+
+    //stall statistics of the loaded track
+    StreamingAudioSource::Statistics getStreamingStatistics() const;
+
+    //records every control change of the deck in the log as the target, nullptr stops it. set before the audio device starts
+    void setAutomationLog(AutomationLog* log, AutomationLog::Target target);
+
+    //applies the queued commands and works out where the next block plays from. getNextAudioBlock calls it unless an offline render
+    //called it first, on the same thread, so it can wait for the read-ahead at a new position before the block is rendered
+    void beginBlock();
+
+    //waits for the read-ahead and the scratch window to hold the audio around the playhead, so an offline render never plays the
+    //silence of a buffer that is still filling. returns false if it timed out
+    bool waitUntilReady(int timeoutMs);
+
+private:
+    class PreloadJob;
+
+    //a source that was opened and buffered by a PreloadJob and is waiting to be installed
+    struct PendingLoad
+    {
+        std::unique_ptr<StreamingAudioSource> streamSource;
+        std::unique_ptr<AudioFormatReader> scratchReader;
+        ParallelTrackDecoder::Ptr decodedTrack;
+        URL url;
+        bool loaded = false;
+    };
+
+    //where the deck's beat was at the start of its latest block, only used on the audio thread
+    struct BeatClock
+    {
+        int64 sample = 0;             //output samples rendered before the block
+        double beat = 0.0;            //beats since the first beat of the grid
+        double beatsPerSample = 0.0;  //beats per output sample, 0 while the deck is stopped
+        bool valid = false;           //false without a beat grid or while the window plays
+        double position = 0.0;        //transport position in seconds at the start of the block
+        double secondsPerSample = 0.0; //how far the transport moves per output sample, 0 while the deck is stopped
+        bool running = false;         //false while the window plays
+    };
+
+    //where the deck's audio comes from, only changed on the audio thread
+    enum class PlayMode
+    {
+        transport,   //normal playback through the read-ahead buffer and the resampler
+        window,      //scratching or reverse, from the scratch engine's window
+        handoff      //still from the window, forwards at the set speed until it reaches the point the transport was sent to
+    };
+
+    void handleAsyncUpdate() override;
+
+    //switches between the transport and the scratch window and makes the jumps, before the block is rendered
+    void updatePlayMode();
+
+    //renders the deck before the EQ and fade, from the transport or the scratch window
+    void renderDeck(const AudioSourceChannelInfo& bufferToFill);
+
+    //sends the transport to where the window playback is when a scratch or reverse ends
+    void releaseWindow();
+
+    //moves the transport and the window playback to a new position
+    void moveTo(double seconds);
+
+    //the play, hot cue, scratch and reverse commands, audio thread only. the transport is never stopped here because stopping it waits
+    //for the next block, a stopped deck is simply not read
+    void startPlaying();
+    void pressHotCue(int index);
+    void letGoOfHotCue(int index);
+    void holdRecord();
+    void letGoOfRecord();
+    void applyReverse(bool shouldReverse);
+
+    //applies the queued commands, called at the start of every block
+    void applyCommands();
+
+    //stamps a command in the automation log as the change it makes
+    void recordCommand(const Command& command);
+
+    //seeks the transport and plays on from there, fading out the audio from where the deck was over slipFadeSeconds
+    void jumpTransport(double seconds, double sourceRate);
+    void mixSlipFade(const AudioSourceChannelInfo& bufferToFill);
+    void moveShadow(int numSamples, double motorRate, double sourceRate);
+
+    //recalculates an EQ band in place, so it does not allocate on the audio thread
+    void applyEq(Command::Type band, double gainDb);
+
+    //how many samples of the block a double waits before it starts, 0 when it is not waiting
+    int samplesUntilDoubleStarts(int numSamples);
+
+    //works out the resampling ratio of the next block, following the master when synced, and publishes this deck's beat clock
+    double updateSync(int numSamples);
+
+    //moves a playing deck forwards to the nearest beat of the master, the loop then takes care of what is left
+    void alignPhaseTo(DJAudioPlayer& master);
+
+    //opens the track, through the simulated slow storage if it is turned on
+    AudioFormatReader* createReaderFor(const URL& audioURL);
+
+    //starts decoding the whole track when that is turned on, nullptr when it is not or the track cannot be decoded whole
+    ParallelTrackDecoder::Ptr startWholeTrackDecoder(const URL& audioURL);
+
+    //swaps in a new stream and the reader for the scratch window (or none), printing the stall statistics of the old stream
+    void installStream(std::unique_ptr<StreamingAudioSource> newStream, std::unique_ptr<AudioFormatReader> scratchReader,
+                       ParallelTrackDecoder::Ptr decodedTrack = nullptr);
+
+    AudioFormatManager& formatManager;
+    TimeSliceThread& readAheadThread;
+
+    //runs the background loads in the deck class, ahead of the playlist and the library
+    JobScheduler& jobScheduler;
+    std::unique_ptr<StreamingAudioSource> streamSource;
+    AudioTransportSource transportSource; 
+    ResamplingAudioSource resampleSource{&transportSource, false, 2};
+    ScratchEngine scratchEngine;
+
+    //the decoded track of the loaded track, nullptr unless whole tracks are preloaded. a double shares it
+    ParallelTrackDecoder::Ptr decodedTrack;
+
+    //the last valid ratio given to setSpeed
+    std::atomic<double> speedRatio{ 1.0 };
+
+    //scratch and reverse state, set by the commands
+    std::atomic<bool> scratchHeld{ false };
+    std::atomic<bool> reverse{ false };
+    std::atomic<double> scratchVelocity{ 0.0 };
+    std::atomic<double> handoffTarget{ -1.0 };
+    std::atomic<double> seekSeconds{ 0.0 };
+    std::atomic<int> seekRequest{ 0 };
+
+    //the window playback as last rendered, for the position display and the handoff
+    std::atomic<double> windowPositionSeconds{ 0.0 };
+    std::atomic<bool> inWindow{ false };
+
+    //slip mode, the hot cue pad held down (-1 for none) and whether the end of a scratch or reverse goes back to the shadow
+    std::atomic<bool> slip{ false };
+    std::atomic<int> heldCue{ -1 };
+    std::atomic<bool> slipReturn{ false };
+
+    //audio thread only
+    PlayMode playMode = PlayMode::transport;
+    double windowPosition = 0.0;
+    double windowRate = 0.0;
+    int seekRequestHandled = 0;
+    int engineGeneration = 0;
+    bool blockBegun = false;
+
+    //the shadow playhead in seconds and the fade after a jump of the transport, audio thread only
+    double shadowPosition = 0.0;
+    int heldCueHandled = -1;
+    AudioBuffer<float> slipFadeBuffer;
+    int slipFadeLength = 0;
+    int slipFadeRemaining = 0;
+    double fadeOutPosition = 0.0;
+    double fadeOutRate = 0.0;
+
+    //beat grid and sync, the clock and loop state are audio thread only
+    std::atomic<double> beatGridBpm{ 0.0 };
+    std::atomic<double> beatGridFirstBeat{ 0.0 };
+    std::atomic<DJAudioPlayer*> syncMaster{ nullptr };
+    BeatClock beatClock;
+    int64 renderedSamples = 0;
+    double appliedRatio = 1.0;
+    double syncIntegral = 0.0;
+    bool wasSyncing = false;
+
+    //the deck a double waits for and the position it starts at, set by a doubleStart command and cleared once the double starts
+    std::atomic<DJAudioPlayer*> doubleSource{ nullptr };
+    std::atomic<double> doubleStartSeconds{ 0.0 };
+
+    //commands from the message thread and controllers, any number of threads may push
+    static constexpr int commandQueueSize = 256;
+    CommandQueue<Command, commandQueueSize> commandQueue;
+
+    //whether the deck plays, only changed by the audio thread. the transport is left started underneath a stopped deck and nothing
+    //reads it, so this is false while the transport plays. deckWasPlaying is the same for the last block, to fade in and out
+    std::atomic<bool> deckPlaying{ false };
+    bool deckWasPlaying = false;
+
+    //the block the latest jog velocity arrived in and the nudge that is left, audio thread only
+    int64 lastJogSample = -1;
+    double nudge = 0.0;
+
+    //hot cue positions in seconds, -1 when a pad is empty
+    std::atomic<double> hotCues[numHotCues];
+
+    //boolean flags
+    bool isTreble = false;
+    bool isBass = false;
+    bool isMid = false;
+
+    //button filters
+    juce::dsp::IIR::Filter<float> trebleFilter;
+    juce::dsp::IIR::Filter<float> bassFilter;
+    juce::dsp::IIR::Filter<float> midrangeFilter;
+
+    //the filter knob, after the EQ and before the effects
+    DJFilter filter;
+
+    EffectsRack effectsRack;
+
+    LevelMeter meter;
+
+    //streaming settings, read by the preload job
+    std::atomic<double> prefetchSeconds{ defaultPrefetchSeconds };
+    std::atomic<int> readLatencyMs{ 0 };
+    std::atomic<int> readSpikeMs{ 0 };
+    std::atomic<int> readSpikeInterval{ 0 };
+    std::atomic<bool> preloadWholeTracks{ false };
+
+    //the device settings, read by the preload job to prepare sources the same way the transport will
+    std::atomic<double> deviceSampleRate{ 0.0 };
+    std::atomic<int> deviceBlockSize{ 0 };
+
+    //the crossfade gain, audio thread only
+    SmoothedValue<float> fadeGain{ 1.0f };
+
+    //the automation log and what the deck is called in it
+    AutomationLog* automationLog = nullptr;
+    AutomationLog::Target automationTarget = AutomationLog::Target::deck1;
+
+    //background loading
+    CriticalSection pendingLock;
+    std::unique_ptr<PendingLoad> pendingLoad;
+    std::function<void(bool)> pendingCallback;
+};
+
+
+
+
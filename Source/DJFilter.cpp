@@ -0,0 +1,123 @@
+/*====================================================================
+DJFilter.cpp
+This class filters a deck with a trapezoidal-integrated state-variable filter (as described by Zavalishin and Simper). It gives the
+low-pass and high-pass from the same two integrators, so the knob can cross the middle from one to the other. While the knob or the
+resonance is moving, the coefficients are worked out for every sample, once for both channels. The left and right channel are two
+lanes of a SIMD register, so each step of the filter is done for both with one instruction.
+====================================================================*/
+
+
+#include "DJFilter.h"
+#include <cmath>
+
+//how far from the middle the filter is faded in over
+static constexpr float wetFadeWidth = 0.1f;
+
+DJFilter::DJFilter()
+{
+}
+
+DJFilter::~DJFilter()
+{
+}
+
+void DJFilter::prepareToPlay(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    position.reset(sampleRate, smoothingSeconds);
+    position.setCurrentAndTargetValue(0.0f);
+    resonance.reset(sampleRate, smoothingSeconds);
+    resonance.setCurrentAndTargetValue(resonance.getTargetValue());
+    reset();
+}
+
+//this function clears the integrators
+void DJFilter::reset()
+{
+    ic1eq = Register::expand(0.0f);
+    ic2eq = Register::expand(0.0f);
+}
+
+//this function moves the knob, the filter glides there over the next few milliseconds
+void DJFilter::setPosition(float newPosition)
+{
+    position.setTargetValue(jlimit(-1.0f, 1.0f, newPosition));
+}
+
+//this function sets the resonance, the filter glides there over the next few milliseconds
+void DJFilter::setResonance(float newResonance)
+{
+    resonance.setTargetValue(jlimit(0.0f, 1.0f, newResonance));
+}
+
+//this function maps the knob to a cutoff on an exponential scale and the resonance to a Q from 0.707 to 5, and works out the filter's
+//coefficients
+DJFilter::Coefficients DJFilter::makeCoefficients(float knob, float amountOfResonance) const
+{
+    float damping = 1.0f / jmap(amountOfResonance, 1.0f / MathConstants<float>::sqrt2, 5.0f);
+
+    float amount = std::abs(knob);
+    float cutoff = knob < 0.0f ? openFrequency * std::pow(lowPassMinFrequency / openFrequency, amount)
+                               : closedFrequency * std::pow(highPassMaxFrequency / closedFrequency, amount);
+    cutoff = jmin(cutoff, (float) (sampleRate * 0.45));
+
+    float g = std::tan(MathConstants<float>::pi * cutoff / (float) sampleRate);
+
+    Coefficients c;
+    c.a1 = 1.0f / (1.0f + g * (g + damping));
+    c.a2 = g * c.a1;
+    c.a3 = g * c.a2;
+    c.damping = damping;
+    c.highPass = knob > 0.0f ? 1.0f : 0.0f;
+    c.wet = jmin(1.0f, amount / wetFadeWidth);
+    return c;
+}
+
+//this function filters the block, the knob position and the resonance are followed sample by sample while they move
+void DJFilter::process(AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    bool moving = position.isSmoothing() || resonance.isSmoothing();
+
+    //the middle is off, and the filter starts from silence when it is turned on again
+    if (!position.isSmoothing() && position.getTargetValue() == 0.0f) {
+        resonance.skip(numSamples);
+        reset();
+        return;
+    }
+
+    int numChannels = jmin(2, buffer.getNumChannels());
+    float* channels[2] = {};
+    for (int channel = 0; channel < numChannels; ++channel) {
+        channels[channel] = buffer.getWritePointer(channel, startSample);
+    }
+
+    Coefficients c = makeCoefficients(position.getCurrentValue(), resonance.getCurrentValue());
+
+    //the lanes past the two channels stay at 0
+    Register v0 = Register::expand(0.0f);
+
+    for (int i = 0; i < numSamples; ++i) {
+        if (moving) {
+            c = makeCoefficients(position.getNextValue(), resonance.getNextValue());
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            v0.set((size_t) channel, channels[channel][i]);
+        }
+
+        Register v3 = v0 - ic2eq;
+        Register v1 = ic1eq * c.a1 + v3 * c.a2;
+        Register v2 = ic2eq + ic1eq * c.a2 + v3 * c.a3;
+        ic1eq = v1 * 2.0f - ic1eq;
+        ic2eq = v2 * 2.0f - ic2eq;
+
+        //the high-pass is what is left after taking away the low-pass and the damped band-pass
+        Register high = v0 - v1 * c.damping - v2;
+        Register filtered = v2 + (high - v2) * c.highPass;
+        Register output = v0 + (filtered - v0) * c.wet;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            channels[channel][i] = output.get((size_t) channel);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*====================================================================
+DJFilter.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <juce_dsp/juce_dsp.h>
+
+//this class is the one-knob filter of a deck: turning left closes a low-pass, turning right opens a high-pass and the middle is off.
+//it is a topology-preserving state-variable filter, so the cutoff and the resonance can move every sample without clicks and without
+//recalculating any coefficient objects. the two channels run in the lanes of one SIMD register. it is only used on the audio thread
+class DJFilter
+{
+public:
+    //the cutoff range of each side, the low-pass closes from the top down and the high-pass opens from the bottom up
+    static constexpr float lowPassMinFrequency = 60.0f;
+    static constexpr float highPassMaxFrequency = 12000.0f;
+    static constexpr float openFrequency = 20000.0f;
+    static constexpr float closedFrequency = 20.0f;
+
+    //how long the knob position and the resonance take to reach a new value
+    static constexpr double smoothingSeconds = 0.02;
+
+    DJFilter();
+    ~DJFilter();
+
+    void prepareToPlay(double sampleRate);
+    void reset();
+
+    //-1 is a fully closed low-pass, 0 is off and 1 a fully open high-pass
+    void setPosition(float position);
+
+    //0 is a flat filter, 1 a strong peak at the cutoff, it glides there like the knob
+    void setResonance(float resonance);
+
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+private:
+    using Register = juce::dsp::SIMDRegister<float>;
+
+    //the state-variable filter's coefficients at one knob position and resonance
+    struct Coefficients
+    {
+        float a1, a2, a3;
+        float damping;   //1 / Q
+        float highPass;  //1 for the high-pass output, 0 for the low-pass
+        float wet;       //how much of the filter is heard, it fades in near the middle so leaving the off position never clicks
+    };
+
+    Coefficients makeCoefficients(float knob, float resonance) const;
+
+    double sampleRate = 44100.0;
+    SmoothedValue<float> position{ 0.0f };
+    SmoothedValue<float> resonance{ 0.0f };
+
+    //the two integrator states, the left channel in lane 0 and the right one in lane 1
+    Register ic1eq = Register::expand(0.0f);
+    Register ic2eq = Register::expand(0.0f);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DJFilter)
+};
@@ -1,353 +1,677 @@
-/*====================================================================
-DeckGUI.cpp
-I have created this with the help of the tutorial from this course. I update and change majority of the codes as well as add on additional features which will be labelled.
-The purpose of this cpp allows users to interact with various audio control features like volume, speed, treble, bass, and midrange levels, along with play/pause/stop functionality. It draws the user interface of the DJ application.
-====================================================================*/
-
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "DeckGUI.h"
-
-//==============================================================================
-DeckGUI::DeckGUI(DJAudioPlayer* _player, 
-                AudioFormatManager & 	formatManagerToUse,
-                AudioThumbnailCache & 	cacheToUse
-           ) : player(_player), 
-               waveformDisplay(formatManagerToUse, cacheToUse)
-{
-    //styling play button
-    //load custom image (like a PNG icon)
-    Image playImage = ImageFileFormat::loadFrom(BinaryData::play_png, BinaryData::play_pngSize);
-    //set the button images for the normal, hovered, and clicked states
-    playButton.setImages(true, true, true,
-        playImage, 1.0f, juce::Colours::transparentBlack,  //normal state
-        playImage, 1.0f, juce::Colours::black.withAlpha(0.5f),  //hovered state
-        playImage, 1.0f, juce::Colours::black.withAlpha(0.7f)); //pressed state
-
-    //styling pause button
-    //load custom image (like a PNG icon)
-    Image pauseImage = ImageFileFormat::loadFrom(BinaryData::pause_png, BinaryData::pause_pngSize);
-    //set the button images for the normal, hovered and clicked states
-    pauseButton.setImages(true, true, true,
-        pauseImage, 1.0f, juce::Colours::transparentBlack,  //normal state
-        pauseImage, 1.0f, juce::Colours::black.withAlpha(0.5f),  //hovered state
-        pauseImage, 1.0f, juce::Colours::black.withAlpha(0.7f)); //pressed state
-
-    //styling stop button
-    //load custom image (like a PNG icon)
-    Image stopImage = ImageFileFormat::loadFrom(BinaryData::stop_png, BinaryData::stop_pngSize);
-    //set the button images for the normal, hovered and clicked states
-    stopButton.setImages(true, true, true,
-        stopImage, 1.0f, juce::Colours::transparentBlack,  //normal state
-        stopImage, 1.0f, juce::Colours::black.withAlpha(0.5f),  //hovered state
-        stopImage, 1.0f, juce::Colours::black.withAlpha(0.7f)); //pressed state
-
-    //styling position slider
-    posSlider.setRange(0.0, 1.0);
-    //for the slider’s track color (the line the thumb moves along)
-    posSlider.setColour(juce::Slider::trackColourId, juce::Colour::fromRGB(39, 102, 123));
-    //for the slider’s thumb color (the draggable part)
-    posSlider.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(161, 227, 249));
-    //for the slider’s background color
-    posSlider.setColour(juce::Slider::backgroundColourId, juce::Colour::fromRGB(68, 68, 68));
-    posSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-
-    //styling volumne slider
-    volSlider.setRange(0, 1, 0.1);
-    volSlider.setSliderStyle(juce::Slider::Rotary);
-    // Set the custom LookAndFeel
-    volSlider.setLookAndFeel(&customLookAndFeel);
-
-    //styling speed slider
-    speedSlider.setRange(0.1, 5.0, 0.01);
-    speedSlider.setSliderStyle(juce::Slider::Rotary);
-    // Set the custom LookAndFeel
-    speedSlider.setLookAndFeel(&customLookAndFeel);
-
-    //styling treble slider
-    trebleSlider.setRange(0, 6.0, 0.1);
-    trebleSlider.setSliderStyle(juce::Slider::Rotary);
-    // Set the custom LookAndFeel
-    trebleSlider.setLookAndFeel(&customLookAndFeel);
-
-    //styling base slider
-    bassSlider.setRange(0.0, 6.0, 0.1);
-    bassSlider.setSliderStyle(juce::Slider::Rotary);
-    // Set the custom LookAndFeel
-    bassSlider.setLookAndFeel(&customLookAndFeel);
-
-    //styling mids slider
-    midSlider.setRange(0.0, 6.0, 0.1);
-    midSlider.setSliderStyle(juce::Slider::Rotary);
-    // Set the custom LookAndFeel
-    midSlider.setLookAndFeel(&customLookAndFeel);
-    
-    //make the buttons visible
-    addAndMakeVisible(playButton);
-    addAndMakeVisible(pauseButton);
-    addAndMakeVisible(stopButton);
-
-    //make the slider visible
-    addAndMakeVisible(volSlider);
-    addAndMakeVisible(speedSlider);
-    addAndMakeVisible(posSlider);
-    addAndMakeVisible(trebleSlider);
-    addAndMakeVisible(bassSlider);
-    addAndMakeVisible(midSlider);
-
-    //make the waveform visible
-    addAndMakeVisible(waveformDisplay);
-
-    //adds listener for the buttons
-    playButton.addListener(this);
-    pauseButton.addListener(this);
-    stopButton.addListener(this);
-
-    //adds listener for slider
-    volSlider.addListener(this);
-    speedSlider.addListener(this);
-    posSlider.addListener(this);
-    trebleSlider.addListener(this);
-    bassSlider.addListener(this);
-    midSlider.addListener(this);
-
-    //setting timer to allow refreshes per 500ms
-    startTimer(500);
-}
-
-DeckGUI::~DeckGUI()
-{
-    //stops timer
-    stopTimer();
-}
-
-//this function paints the playlist component (background and color)
-void DeckGUI::paint (Graphics& g)
-{
-    g.fillAll (Colour::fromRGB(29, 22, 22));
-    g.setColour (Colour::fromRGB(29, 22, 22));
-    g.drawRect (getLocalBounds(), 1); //draw an outline around the component
-
-    //text title for volume
-    //set the text color
-    g.setColour(juce::Colours::white);
-
-    //set the font and draw the text for volume
-    g.setFont(juce::Font(volSlider.getWidth() / 15)); //set the font size
-    g.drawText("Vol", volSlider.getX() - volSlider.getWidth() / 6.5, volSlider.getY() + volSlider.getHeight() / 1.15, volSlider.getWidth(), 20,
-        juce::Justification::centred, true);
-
-    //set the font and draw the text for speed
-    g.setFont(juce::Font(speedSlider.getWidth() / 15)); //set the font size
-    g.drawText("Speed", speedSlider.getX() - speedSlider.getWidth() / 5.3, speedSlider.getY() + speedSlider.getHeight() / 1.15, speedSlider.getWidth(), 20,
-        juce::Justification::centred, true);
-
-    //set the font and draw the text for treble
-    g.setFont(juce::Font(trebleSlider.getWidth() / 15)); //set the font size
-    g.drawText("Treble", trebleSlider.getX() - trebleSlider.getWidth() / 4, trebleSlider.getY() + trebleSlider.getHeight() / 1.125, trebleSlider.getWidth(), 20,
-        juce::Justification::centred, true);
-
-    //set the font and draw the text for bass
-    g.setFont(juce::Font(bassSlider.getWidth() / 15)); //set the font size
-    g.drawText("Bass", bassSlider.getX() - bassSlider.getWidth() / 4, bassSlider.getY() + bassSlider.getHeight() / 1.125, bassSlider.getWidth(), 20,
-        juce::Justification::centred, true);
-
-    //set the font and draw the text for bass
-    g.setFont(juce::Font(midSlider.getWidth() / 15)); //set the font size
-    g.drawText("Mid", midSlider.getX() - midSlider.getWidth() / 4, midSlider.getY() + midSlider.getHeight() / 1.125, midSlider.getWidth(), 20,
-        juce::Justification::centred, true);
-
-    //if the audio is not loaded, the fucntion will end here and it will not run the codes below.
-    if (!isAudioLoaded) {
-        return;
-    }
-    
-    //set the font and color for the text display
-    g.setFont(getWidth() / 30);  //you can adjust the font size
-    g.setColour(Colours::white);  //setting the color of the next text
-
-    //get the total length of the audio in seconds
-    float totalLength = player->getLength(); //assuming this is the total length in seconds
-
-    //converts total length from seconds to minutes and seconds
-    int minutes_length = static_cast<int>(totalLength) / 60;
-    int seconds_length = static_cast<int>(totalLength) % 60;
-
-    //format minutes and seconds into a string
-    String timeString = String::formatted("%02d:%02d", minutes_length, seconds_length);
-
-    //get the relative position of the audio in seconds
-    float relative_positionbefore = player->getPosition();
-    float relative_position = relative_positionbefore * totalLength;
-
-    //convert total length of the audio in seconds
-    int minutes_relativepos = static_cast<int>(relative_position) / 60;
-    int seconds_relativepos = static_cast<int>(relative_position) % 60;
-
-    //format minutes and seconds into string
-    String relativeposString = String::formatted("%02d:%02d", minutes_relativepos, seconds_relativepos);
-
-    //creating rectangle for the text
-    Rectangle<int> textArea(getWidth() / 30, getHeight() / 8 * 7.25, getWidth(), getHeight() / 11);
-
-    //draw the text displaying the total length in minute and secons format
-    g.drawText(relativeposString + " / " + timeString, textArea,
-        Justification::left, true); //position it with padding and centered
-}
-
-//this function lays out the child component and resize it
-void DeckGUI::resized()
-{
-    double rowH = getHeight() / 8; 
-    double sliderWidth = getWidth() / 9;
-    double buttonWidth = getWidth() / 11;
-
-    //creating the textbox with the volume slider value
-    volSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 14, rowH / 3);
-
-    //creating the textbox with the volume slider value
-    speedSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 14, rowH / 3);
-    speedSlider.setTextValueSuffix("x");
-
-    //creating the textbox with the volume slider value
-    trebleSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 10, rowH / 3);
-    trebleSlider.setTextValueSuffix("dB");
-
-    //creating the textbox with the volume slider value
-    bassSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 10, rowH / 3);
-    bassSlider.setTextValueSuffix("dB");
-
-    //creating the textbox with the volume slider value
-    midSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 10, rowH / 3);
-    midSlider.setTextValueSuffix("dB");
-
-    //set the coordination for the sliders
-    volSlider.setBounds(sliderWidth * 1.45, rowH / 10, getWidth() / 3, rowH * 2.4);
-    speedSlider.setBounds(sliderWidth * 4.4, rowH / 10, getWidth() / 3, rowH * 2.4);
-    trebleSlider.setBounds(sliderWidth / 34, rowH * 2.8, getWidth() / 3, rowH * 2.4);
-    bassSlider.setBounds(sliderWidth * 3, rowH * 2.8, getWidth() / 3, rowH * 2.4);
-    midSlider.setBounds(sliderWidth * 6, rowH * 2.8, getWidth() / 3, rowH * 2.4);
-    posSlider.setBounds(0, rowH * 3, getWidth(), rowH);
-    posSlider.setBounds(0, rowH * 6.7, getWidth(), rowH);
-
-    //set the coordination for the waveform
-    waveformDisplay.setBounds(0, rowH * 5.4, getWidth(), rowH * 1.5);
-
-    //set the coordination for the buttons
-    playButton.setBounds(buttonWidth * 4.25, rowH * 7.5, buttonWidth, rowH * 0.3);
-    pauseButton.setBounds(buttonWidth * 5, rowH * 7.5, buttonWidth, rowH * 0.3);
-    stopButton.setBounds(buttonWidth * 5.75, rowH * 7.5, buttonWidth, rowH * 0.3);
-}
-
-//this function handles the eventlistener for button when it is clicked
-void DeckGUI::buttonClicked(Button* button)
-{
-    //runs when the playButton is clicked
-    if (button == &playButton) {
-        player->start();
-    }
-
-    //runs when the pauseButton is clicked
-    if (button == &pauseButton) {
-        player->stop();
-    }
-
-    //runs when the stopButton is clicked
-    if (button == &stopButton) {
-        player->stop(); //stop playback
-
-        //reset the audio source
-        player->loadURL(URL{}); //clear the loaded audio file
-        waveformDisplay.clear(); //clear the waveform display
-
-        //reset all the slider positions
-        speedSlider.setValue(1.0);
-        volSlider.setValue(0);
-        posSlider.setValue(0.0);
-        trebleSlider.setValue(0.0);
-        bassSlider.setValue(0.0);
-        midSlider.setValue(0.0);
-        
-        //change the flag to false
-        isAudioLoaded = false;
-
-        //trigger the paint function again
-        repaint();
-    }
-}
-
-//this function handles the eventlistener for sliders when it is clicked
-void DeckGUI::sliderValueChanged (Slider *slider)
-{
-    //runs when the volSlider is moved
-    if (slider == &volSlider) {
-        player->setVolume(slider->getValue());
-    }
-
-    //runs when speedslider is moved
-    if (slider == &speedSlider) {
-        player->setSpeed(slider->getValue());
-    }
-    
-    //runs when posslider is moved
-    if (slider == &posSlider) {
-        player->setPositionRelative(slider->getValue());
-    }
-
-    //runs when trebleslider is moved
-    if (slider == &trebleSlider) {
-        player->setTreble(slider->getValue());
-    }
-    
-    //runs when bassslider is moved
-    if (slider == &bassSlider) {
-        player->setBass(slider->getValue());
-    }
-
-    //runs when midslider is moved
-    if (slider == &midSlider) {
-        player->setMid(slider->getValue());
-    }
-}
-
-//this function is to update the UI component especially for posSlider and WaveformDisplay
-void DeckGUI::timerCallback()
-{
-    //std::cout << "DeckGUI::timerCallback" << std::endl;
-    waveformDisplay.setPositionRelative(
-            player->getPosition());
-
-    // Get the total length and current position of the audio
-    float totalLength = player->getLength();
-    float relativePosition = player->getPosition();
-
-    // Ensure the current position is within the total length to avoid out-of-bounds errors
-    if (totalLength > 0) {
-        // Update the slider's value
-        posSlider.setValue(relativePosition);
-    }
-
-    //trigger repaint to update the display
-    repaint();
-}
-    
-//this function load the track from the playlist 
-void DeckGUI::loadTrackFromPlaylist(juce::URL trackURL)
-{
-    if (trackURL.isEmpty()) {
-        return;
-    }
-
-    player->loadURL(trackURL);
-    waveformDisplay.loadURL(trackURL);
-    isAudioLoaded = true;
-
-    volSlider.setValue(100);
-    speedSlider.setValue(1.0);
-}
-
-//this checks if the audio is loaded.
-bool DeckGUI::CheckAudioLoaded() 
-{
-    return isAudioLoaded; 
-}
+/*====================================================================
+DeckGUI.cpp
+I have created this with the help of the tutorial from this course. I update and change majority of the codes as well as add on additional features which will be labelled.
+The purpose of this cpp allows users to interact with various audio control features like volume, speed, treble, bass, and midrange levels, along with play/pause/stop functionality. It draws the user interface of the DJ application.
+====================================================================*/
+
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DeckGUI.h"
+#include "Tracer.h"
+
+//==============================================================================
+DeckGUI::DeckGUI(DJAudioPlayer* _player, 
+                AudioFormatManager & 	formatManagerToUse,
+                WaveformCache & 	cacheToUse,
+                TrackLibrary & 	libraryToUse
+           ) : trackLibrary(libraryToUse),
+               waveformDisplay(formatManagerToUse, cacheToUse),
+               scrollingWaveform(*_player, waveformDisplay),
+               jogWheel(*_player),
+               levelMeter(_player->getMeter()),
+               player(_player)
+{
+    //styling play button
+    //load custom image (like a PNG icon)
+    Image playImage = ImageFileFormat::loadFrom(BinaryData::play_png, BinaryData::play_pngSize);
+    //set the button images for the normal, hovered, and clicked states
+    playButton.setImages(true, true, true,
+        playImage, 1.0f, juce::Colours::transparentBlack,  //normal state
+        playImage, 1.0f, juce::Colours::black.withAlpha(0.5f),  //hovered state
+        playImage, 1.0f, juce::Colours::black.withAlpha(0.7f)); //pressed state
+
+    //styling pause button
+    //load custom image (like a PNG icon)
+    Image pauseImage = ImageFileFormat::loadFrom(BinaryData::pause_png, BinaryData::pause_pngSize);
+    //set the button images for the normal, hovered and clicked states
+    pauseButton.setImages(true, true, true,
+        pauseImage, 1.0f, juce::Colours::transparentBlack,  //normal state
+        pauseImage, 1.0f, juce::Colours::black.withAlpha(0.5f),  //hovered state
+        pauseImage, 1.0f, juce::Colours::black.withAlpha(0.7f)); //pressed state
+
+    //styling stop button
+    //load custom image (like a PNG icon)
+    Image stopImage = ImageFileFormat::loadFrom(BinaryData::stop_png, BinaryData::stop_pngSize);
+    //set the button images for the normal, hovered and clicked states
+    stopButton.setImages(true, true, true,
+        stopImage, 1.0f, juce::Colours::transparentBlack,  //normal state
+        stopImage, 1.0f, juce::Colours::black.withAlpha(0.5f),  //hovered state
+        stopImage, 1.0f, juce::Colours::black.withAlpha(0.7f)); //pressed state
+
+    //styling reverse button
+    reverseButton.setClickingTogglesState(true);
+    reverseButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77)); //button background
+    reverseButton.setColour(TextButton::buttonOnColourId, juce::Colours::darkcyan); //button background when on
+    reverseButton.setColour(TextButton::textColourOffId, juce::Colours::white); //text color
+    reverseButton.setColour(TextButton::textColourOnId, juce::Colours::white); //text when on
+
+    //styling slip button
+    slipButton.setClickingTogglesState(true);
+    slipButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77)); //button background
+    slipButton.setColour(TextButton::buttonOnColourId, juce::Colours::darkcyan); //button background when on
+    slipButton.setColour(TextButton::textColourOffId, juce::Colours::white); //text color
+    slipButton.setColour(TextButton::textColourOnId, juce::Colours::white); //text when on
+
+    //styling sync button
+    syncButton.setClickingTogglesState(true);
+    syncButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77)); //button background
+    syncButton.setColour(TextButton::buttonOnColourId, juce::Colours::darkcyan); //button background when on
+    syncButton.setColour(TextButton::textColourOffId, juce::Colours::white); //text color
+    syncButton.setColour(TextButton::textColourOnId, juce::Colours::white); //text when on
+
+    //styling double button
+    doubleButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77)); //button background
+    doubleButton.setColour(TextButton::textColourOffId, juce::Colours::white); //text color
+    doubleButton.setColour(TextButton::textColourOnId, juce::Colours::white); //text when pressed
+
+    //styling filter slider, a double click puts it back in the middle
+    filterSlider.setRange(-1.0, 1.0, 0.01);
+    filterSlider.setValue(0.0, dontSendNotification);
+    filterSlider.setDoubleClickReturnValue(true, 0.0);
+    filterSlider.setSliderStyle(juce::Slider::Rotary);
+    filterSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    // Set the custom LookAndFeel
+    filterSlider.setLookAndFeel(&customLookAndFeel);
+
+    //styling resonance knob, next to the filter and flat by default
+    resonanceSlider.setRange(0.0, 1.0, 0.01);
+    resonanceSlider.setValue(0.0, dontSendNotification);
+    resonanceSlider.setDoubleClickReturnValue(true, 0.0);
+    resonanceSlider.setSliderStyle(juce::Slider::Rotary);
+    resonanceSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    resonanceSlider.setLookAndFeel(&customLookAndFeel);
+
+    //styling effect controls
+    for (int index = 0; index < EffectsRack::numEffects; ++index) {
+        effectSelector.addItem(EffectsRack::getName((EffectsRack::Effect) index), index + 1);
+    }
+    effectSelector.setSelectedId(1, dontSendNotification);
+    effectSelector.setColour(ComboBox::backgroundColourId, juce::Colour::fromRGB(39, 55, 77)); //box background
+    effectSelector.setColour(ComboBox::textColourId, juce::Colours::white); //text color
+    effectButton.setClickingTogglesState(true);
+    effectButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77)); //button background
+    effectButton.setColour(TextButton::buttonOnColourId, juce::Colours::darkcyan); //button background when on
+    effectButton.setColour(TextButton::textColourOffId, juce::Colours::white); //text color
+    effectButton.setColour(TextButton::textColourOnId, juce::Colours::white); //text when on
+    effectMixSlider.setRange(0.0, 1.0, 0.01);
+    effectMixSlider.setValue(player->getEffects().getMix(getSelectedEffect()), dontSendNotification);
+    effectMixSlider.setColour(juce::Slider::trackColourId, juce::Colour::fromRGB(39, 102, 123));
+    effectMixSlider.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(161, 227, 249));
+    effectMixSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+
+    //styling position slider
+    posSlider.setRange(0.0, 1.0);
+    //for the slider’s track color (the line the thumb moves along)
+    posSlider.setColour(juce::Slider::trackColourId, juce::Colour::fromRGB(39, 102, 123));
+    //for the slider’s thumb color (the draggable part)
+    posSlider.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(161, 227, 249));
+    //for the slider’s background color
+    posSlider.setColour(juce::Slider::backgroundColourId, juce::Colour::fromRGB(68, 68, 68));
+    posSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+
+    //styling volumne slider
+    volSlider.setRange(0, 1, 0.1);
+    volSlider.setSliderStyle(juce::Slider::Rotary);
+    // Set the custom LookAndFeel
+    volSlider.setLookAndFeel(&customLookAndFeel);
+
+    //styling speed slider
+    speedSlider.setRange(0.1, 5.0, 0.01);
+    speedSlider.setSliderStyle(juce::Slider::Rotary);
+    // Set the custom LookAndFeel
+    speedSlider.setLookAndFeel(&customLookAndFeel);
+
+    //styling treble slider
+    trebleSlider.setRange(0, 6.0, 0.1);
+    trebleSlider.setSliderStyle(juce::Slider::Rotary);
+    // Set the custom LookAndFeel
+    trebleSlider.setLookAndFeel(&customLookAndFeel);
+
+    //styling base slider
+    bassSlider.setRange(0.0, 6.0, 0.1);
+    bassSlider.setSliderStyle(juce::Slider::Rotary);
+    // Set the custom LookAndFeel
+    bassSlider.setLookAndFeel(&customLookAndFeel);
+
+    //styling mids slider
+    midSlider.setRange(0.0, 6.0, 0.1);
+    midSlider.setSliderStyle(juce::Slider::Rotary);
+    // Set the custom LookAndFeel
+    midSlider.setLookAndFeel(&customLookAndFeel);
+    
+    //make the buttons visible
+    addAndMakeVisible(playButton);
+    addAndMakeVisible(pauseButton);
+    addAndMakeVisible(stopButton);
+    addAndMakeVisible(reverseButton);
+    addAndMakeVisible(slipButton);
+    addAndMakeVisible(syncButton);
+    addAndMakeVisible(doubleButton);
+    addAndMakeVisible(effectSelector);
+    addAndMakeVisible(effectButton);
+    addAndMakeVisible(effectMixSlider);
+
+    //make the slider visible
+    addAndMakeVisible(volSlider);
+    addAndMakeVisible(speedSlider);
+    addAndMakeVisible(posSlider);
+    addAndMakeVisible(trebleSlider);
+    addAndMakeVisible(bassSlider);
+    addAndMakeVisible(midSlider);
+    addAndMakeVisible(filterSlider);
+    addAndMakeVisible(resonanceSlider);
+
+    //make the waveforms and the platter visible
+    addAndMakeVisible(waveformDisplay);
+    addAndMakeVisible(scrollingWaveform);
+    addAndMakeVisible(jogWheel);
+
+    //the meter sits over the edge of the mid knob's area, so clicks go through it to the knob
+    addAndMakeVisible(levelMeter);
+    levelMeter.setInterceptsMouseClicks(false, false);
+
+    //adds listener for the buttons
+    playButton.addListener(this);
+    pauseButton.addListener(this);
+    stopButton.addListener(this);
+    reverseButton.addListener(this);
+    slipButton.addListener(this);
+    syncButton.addListener(this);
+    doubleButton.addListener(this);
+    effectButton.addListener(this);
+    effectSelector.addListener(this);
+
+    //adds listener for slider
+    volSlider.addListener(this);
+    speedSlider.addListener(this);
+    posSlider.addListener(this);
+    trebleSlider.addListener(this);
+    bassSlider.addListener(this);
+    midSlider.addListener(this);
+    effectMixSlider.addListener(this);
+    filterSlider.addListener(this);
+    resonanceSlider.addListener(this);
+
+    //setting timer to allow refreshes per 500ms
+    startTimer(500);
+}
+
+DeckGUI::~DeckGUI()
+{
+    //stops timer
+    stopTimer();
+}
+
+//this function paints the playlist component (background and color)
+void DeckGUI::paint (Graphics& g)
+{
+    g.fillAll (Colour::fromRGB(29, 22, 22));
+    g.setColour (Colour::fromRGB(29, 22, 22));
+    g.drawRect (getLocalBounds(), 1); //draw an outline around the component
+
+    //text title for volume
+    //set the text color
+    g.setColour(juce::Colours::white);
+
+    //set the font and draw the text for volume
+    g.setFont(juce::Font(volSlider.getWidth() / 15)); //set the font size
+    g.drawText("Vol", volSlider.getX() - volSlider.getWidth() / 6.5, volSlider.getY() + volSlider.getHeight() / 1.15, volSlider.getWidth(), 20,
+        juce::Justification::centred, true);
+
+    //set the font and draw the text for speed
+    g.setFont(juce::Font(speedSlider.getWidth() / 15)); //set the font size
+    g.drawText("Speed", speedSlider.getX() - speedSlider.getWidth() / 5.3, speedSlider.getY() + speedSlider.getHeight() / 1.15, speedSlider.getWidth(), 20,
+        juce::Justification::centred, true);
+
+    //set the font and draw the text for treble
+    g.setFont(juce::Font(trebleSlider.getWidth() / 15)); //set the font size
+    g.drawText("Treble", trebleSlider.getX() - trebleSlider.getWidth() / 4, trebleSlider.getY() + trebleSlider.getHeight() / 1.125, trebleSlider.getWidth(), 20,
+        juce::Justification::centred, true);
+
+    //set the font and draw the text for bass
+    g.setFont(juce::Font(bassSlider.getWidth() / 15)); //set the font size
+    g.drawText("Bass", bassSlider.getX() - bassSlider.getWidth() / 4, bassSlider.getY() + bassSlider.getHeight() / 1.125, bassSlider.getWidth(), 20,
+        juce::Justification::centred, true);
+
+    //set the font and draw the text for bass
+    g.setFont(juce::Font(midSlider.getWidth() / 15)); //set the font size
+    g.drawText("Mid", midSlider.getX() - midSlider.getWidth() / 4, midSlider.getY() + midSlider.getHeight() / 1.125, midSlider.getWidth(), 20,
+        juce::Justification::centred, true);
+
+    //set the font and draw the text for the filter
+    g.setFont(juce::Font(filterSlider.getHeight() / 4.0f)); //set the font size
+    g.drawText("Filter", filterSlider.getX(), filterSlider.getY() - filterSlider.getHeight() / 4, filterSlider.getWidth(), filterSlider.getHeight() / 4,
+        juce::Justification::centred, true);
+
+    //set the font and draw the text for the resonance
+    g.setFont(juce::Font(resonanceSlider.getHeight() / 4.0f)); //set the font size
+    g.drawText("Res", resonanceSlider.getX(), resonanceSlider.getY() - resonanceSlider.getHeight() / 4, resonanceSlider.getWidth(), resonanceSlider.getHeight() / 4,
+        juce::Justification::centred, true);
+
+    //the time the chosen effect takes out of each block while it runs
+    auto load = player->getEffects().getLoad(getSelectedEffect());
+    if (load.average > 0.0f) {
+        g.setFont(juce::Font(effectButton.getHeight() * 0.6f));
+        g.drawText(String(load.average * 100.0f, 1) + "%", effectButton.getRight(), effectButton.getY(),
+            effectSelector.getRight() - effectButton.getRight(), effectButton.getHeight(), juce::Justification::centred, true);
+    }
+
+    //if the audio is not loaded, the fucntion will end here and it will not run the codes below.
+    if (!isAudioLoaded) {
+        return;
+    }
+    
+    //set the font and color for the text display
+    g.setFont(getWidth() / 30);  //you can adjust the font size
+    g.setColour(Colours::white);  //setting the color of the next text
+
+    //get the total length of the audio in seconds
+    float totalLength = player->getLength(); //assuming this is the total length in seconds
+
+    //converts total length from seconds to minutes and seconds
+    int minutes_length = static_cast<int>(totalLength) / 60;
+    int seconds_length = static_cast<int>(totalLength) % 60;
+
+    //format minutes and seconds into a string
+    String timeString = String::formatted("%02d:%02d", minutes_length, seconds_length);
+
+    //get the relative position of the audio in seconds
+    float relative_positionbefore = player->getPosition();
+    float relative_position = relative_positionbefore * totalLength;
+
+    //convert total length of the audio in seconds
+    int minutes_relativepos = static_cast<int>(relative_position) / 60;
+    int seconds_relativepos = static_cast<int>(relative_position) % 60;
+
+    //format minutes and seconds into string
+    String relativeposString = String::formatted("%02d:%02d", minutes_relativepos, seconds_relativepos);
+
+    //creating rectangle for the text
+    Rectangle<int> textArea(getWidth() / 30, getHeight() / 8 * 7.25, getWidth(), getHeight() / 11);
+
+    //draw the text displaying the total length in minute and secons format
+    g.drawText(relativeposString + " / " + timeString, textArea,
+        Justification::left, true); //position it with padding and centered
+
+    //shows when the storage could not keep up with playback, with the total silence it caused
+    auto statistics = player->getStreamingStatistics();
+    if (statistics.numStalls > 0) {
+        g.setColour(Colours::orange);
+        g.drawText("Stalls: " + String(statistics.numStalls) + " (" + String(statistics.stalledSeconds, 2) + " s)",
+            textArea.withTrimmedRight(getWidth() / 15), Justification::right, true);
+    }
+}
+
+//this function lays out the child component and resize it
+void DeckGUI::resized()
+{
+    double rowH = getHeight() / 8; 
+    double sliderWidth = getWidth() / 9;
+    double buttonWidth = getWidth() / 11;
+
+    //creating the textbox with the volume slider value
+    volSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 14, rowH / 3);
+
+    //creating the textbox with the volume slider value
+    speedSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 14, rowH / 3);
+    speedSlider.setTextValueSuffix("x");
+
+    //creating the textbox with the volume slider value
+    trebleSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 10, rowH / 3);
+    trebleSlider.setTextValueSuffix("dB");
+
+    //creating the textbox with the volume slider value
+    bassSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 10, rowH / 3);
+    bassSlider.setTextValueSuffix("dB");
+
+    //creating the textbox with the volume slider value
+    midSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, getWidth() / 10, rowH / 3);
+    midSlider.setTextValueSuffix("dB");
+
+    //set the coordination for the sliders
+    volSlider.setBounds(sliderWidth * 1.45, rowH / 10, getWidth() / 3, rowH * 2.4);
+    speedSlider.setBounds(sliderWidth * 4.4, rowH / 10, getWidth() / 3, rowH * 2.4);
+    trebleSlider.setBounds(sliderWidth / 34, rowH * 2.8, getWidth() / 3, rowH * 2.4);
+    bassSlider.setBounds(sliderWidth * 3, rowH * 2.8, getWidth() / 3, rowH * 2.4);
+    midSlider.setBounds(sliderWidth * 6, rowH * 2.8, getWidth() / 3, rowH * 2.4);
+    posSlider.setBounds(0, rowH * 3, getWidth(), rowH);
+    posSlider.setBounds(0, rowH * 6.7, getWidth(), rowH);
+
+    //set the coordination for the waveforms, the zoomed view above the whole track
+    scrollingWaveform.setBounds(0, rowH * 5.3, getWidth(), rowH * 0.75);
+    waveformDisplay.setBounds(0, rowH * 6.05, getWidth(), rowH * 0.85);
+
+    //set the coordination for the buttons
+    playButton.setBounds(buttonWidth * 4.25, rowH * 7.5, buttonWidth, rowH * 0.3);
+    pauseButton.setBounds(buttonWidth * 5, rowH * 7.5, buttonWidth, rowH * 0.3);
+    stopButton.setBounds(buttonWidth * 5.75, rowH * 7.5, buttonWidth, rowH * 0.3);
+
+    //set the coordination for the platter, the filter and resonance knobs and the reverse and slip buttons, in the free corners next to the volume and speed
+    jogWheel.setBounds(getWidth() * 0.82, rowH * 0.3, getWidth() * 0.17, rowH * 1.5);
+    filterSlider.setBounds(getWidth() * 0.82, rowH * 2.0, getWidth() * 0.09, rowH * 0.8);
+    resonanceSlider.setBounds(getWidth() * 0.91, rowH * 2.0, getWidth() * 0.08, rowH * 0.8);
+    reverseButton.setBounds(getWidth() / 60, rowH * 0.3, buttonWidth * 0.6, rowH * 0.35);
+    slipButton.setBounds(getWidth() / 60 + buttonWidth * 0.6, rowH * 0.3, buttonWidth * 0.6, rowH * 0.35);
+    syncButton.setBounds(getWidth() / 60, rowH * 0.75, buttonWidth * 1.2, rowH * 0.35);
+
+    //the effect controls go under them, with the effect's load next to its button
+    effectSelector.setBounds(getWidth() / 60, rowH * 1.2, buttonWidth * 1.2, rowH * 0.35);
+    effectButton.setBounds(getWidth() / 60, rowH * 1.6, buttonWidth * 0.6, rowH * 0.35);
+    doubleButton.setBounds(getWidth() / 60 + buttonWidth * 0.6, rowH * 1.6, buttonWidth * 0.6, rowH * 0.35);
+    effectMixSlider.setBounds(getWidth() / 60, rowH * 2.0, buttonWidth * 1.2, rowH * 0.35);
+
+    //the level meter runs down the right edge next to the EQ
+    levelMeter.setBounds(getWidth() * 0.955, rowH * 2.9, getWidth() * 0.035, rowH * 2.3);
+}
+
+//this function handles the eventlistener for button when it is clicked
+void DeckGUI::buttonClicked(Button* button)
+{
+    //runs when the playButton is clicked
+    if (button == &playButton) {
+        player->start();
+    }
+
+    //runs when the pauseButton is clicked
+    if (button == &pauseButton) {
+        player->stop();
+    }
+
+    //runs when the stopButton is clicked
+    if (button == &stopButton) {
+        unloadTrack();
+    }
+
+    //runs when the reverseButton is toggled
+    if (button == &reverseButton) {
+        player->setReverse(reverseButton.getToggleState());
+    }
+
+    //runs when the slipButton is toggled
+    if (button == &slipButton) {
+        player->setSlip(slipButton.getToggleState());
+    }
+
+    //runs when the syncButton is toggled
+    if (button == &syncButton) {
+        player->setSyncMaster(syncButton.getToggleState() ? syncMaster : nullptr);
+    }
+
+    //runs when the doubleButton is clicked
+    if (button == &doubleButton && doubleSource != nullptr) {
+        doubleFrom(*doubleSource);
+    }
+
+    //runs when the effectButton is toggled
+    if (button == &effectButton) {
+        player->setEffectEnabled(getSelectedEffect(), effectButton.getToggleState());
+    }
+}
+
+//this function stops playback, clears the loaded track and resets the controls
+void DeckGUI::unloadTrack()
+{
+    player->stop(); //stop playback
+    reverseButton.setToggleState(false, sendNotification); //plays forwards again
+    syncButton.setToggleState(false, sendNotification); //stops following the other deck
+    player->setBeatGrid(0.0, 0.0);
+
+    //reset the audio source
+    player->loadURL(URL{}); //clear the loaded audio file
+    waveformDisplay.clear(); //clear the waveform display
+
+    //reset all the slider positions
+    speedSlider.setValue(1.0);
+    volSlider.setValue(0);
+    posSlider.setValue(0.0);
+    trebleSlider.setValue(0.0);
+    bassSlider.setValue(0.0);
+    midSlider.setValue(0.0);
+    filterSlider.setValue(0.0);
+    resonanceSlider.setValue(0.0);
+    
+    //change the flag to false
+    isAudioLoaded = false;
+    loadedURL = URL{};
+
+    //trigger the paint function again
+    repaint();
+}
+
+//this function handles the eventlistener for sliders when it is clicked
+void DeckGUI::sliderValueChanged (Slider *slider)
+{
+    //runs when the volSlider is moved
+    if (slider == &volSlider) {
+        player->setVolume(slider->getValue());
+    }
+
+    //runs when speedslider is moved
+    if (slider == &speedSlider) {
+        player->setSpeed(slider->getValue());
+    }
+    
+    //runs when posslider is moved
+    if (slider == &posSlider) {
+        player->setPositionRelative(slider->getValue());
+    }
+
+    //runs when trebleslider is moved
+    if (slider == &trebleSlider) {
+        player->setTreble(slider->getValue());
+        lastEqSlider = slider;
+    }
+    
+    //runs when bassslider is moved
+    if (slider == &bassSlider) {
+        player->setBass(slider->getValue());
+        lastEqSlider = slider;
+    }
+
+    //runs when midslider is moved
+    if (slider == &midSlider) {
+        player->setMid(slider->getValue());
+        lastEqSlider = slider;
+    }
+
+    //runs when filterslider is moved
+    if (slider == &filterSlider) {
+        player->setFilter(slider->getValue());
+    }
+
+    //runs when the resonance knob is moved
+    if (slider == &resonanceSlider) {
+        player->setFilterResonance(slider->getValue());
+    }
+
+    //runs when the effect mix slider is moved
+    if (slider == &effectMixSlider) {
+        player->setEffectMix(getSelectedEffect(), (float) slider->getValue());
+    }
+}
+
+//this function shows the state of the effect that was picked
+void DeckGUI::comboBoxChanged(ComboBox* comboBox)
+{
+    if (comboBox == &effectSelector) {
+        EffectsRack& effects = player->getEffects();
+        effectButton.setToggleState(effects.isEnabled(getSelectedEffect()), dontSendNotification);
+        effectMixSlider.setValue(effects.getMix(getSelectedEffect()), dontSendNotification);
+    }
+}
+
+//this function returns the effect picked in the selector
+EffectsRack::Effect DeckGUI::getSelectedEffect() const
+{
+    return (EffectsRack::Effect) jlimit(0, EffectsRack::numEffects - 1, effectSelector.getSelectedId() - 1);
+}
+
+//this function is to update the UI component especially for posSlider and WaveformDisplay
+void DeckGUI::timerCallback()
+{
+    Tracer::Scope trace("DeckGUI::timerCallback", Tracer::Category::gui);
+    //std::cout << "DeckGUI::timerCallback" << std::endl;
+    waveformDisplay.setPositionRelative(
+            player->getPosition());
+
+    // Get the total length and current position of the audio
+    float totalLength = player->getLength();
+    float relativePosition = player->getPosition();
+
+    //the other deck turns this deck's sync off when it syncs to it
+    syncButton.setToggleState(player->isSynced(), dontSendNotification);
+
+    // Ensure the current position is within the total length to avoid out-of-bounds errors
+    if (totalLength > 0) {
+        // Update the slider's value, without sending it back to the player as a seek
+        posSlider.setValue(relativePosition, dontSendNotification);
+    }
+
+    //trigger repaint to update the display
+    repaint();
+}
+    
+//this function load the track from the playlist 
+void DeckGUI::loadTrackFromPlaylist(juce::URL trackURL)
+{
+    if (trackURL.isEmpty()) {
+        return;
+    }
+
+    player->loadURL(trackURL);
+    setBeatGridFor(trackURL);
+    waveformDisplay.loadURL(trackURL);
+    isAudioLoaded = true;
+    loadedURL = trackURL;
+
+    volSlider.setValue(100);
+    speedSlider.setValue(1.0);
+}
+
+//this function loads the track on background threads, the deck only shows it once the intro is buffered
+void DeckGUI::loadTrackInBackground(juce::URL trackURL, std::function<void(bool)> onLoaded)
+{
+    if (trackURL.isEmpty()) {
+        return;
+    }
+
+    Component::SafePointer<DeckGUI> safeThis(this);
+    player->loadURLInBackground(trackURL, [safeThis, trackURL, onLoaded](bool loaded) {
+        if (safeThis == nullptr) {
+            return;
+        }
+
+        if (loaded) {
+            safeThis->setBeatGridFor(trackURL);
+            safeThis->waveformDisplay.loadURL(trackURL);
+            safeThis->isAudioLoaded = true;
+            safeThis->loadedURL = trackURL;
+
+            safeThis->volSlider.setValue(100);
+            safeThis->speedSlider.setValue(1.0);
+        }
+
+        if (onLoaded != nullptr) {
+            onLoaded(loaded);
+        }
+    });
+}
+
+//this function sets the speed of the player directly and moves the slider without sending it back to the player
+void DeckGUI::setSpeed(double ratio)
+{
+    player->setSpeed(ratio);
+    speedSlider.setValue(ratio, dontSendNotification);
+}
+
+//this function sets which player the sync button follows
+void DeckGUI::setSyncMaster(DJAudioPlayer* master)
+{
+    syncMaster = master;
+}
+
+//this function sets which deck the double button copies
+void DeckGUI::setDoubleSource(DeckGUI* deck)
+{
+    doubleSource = deck;
+}
+
+//this function copies the other deck. the player shares the other deck's audio and the waveform display its waveform data, so
+//nothing is decoded again, and the controls are set to the other deck's without moving the player a second time
+void DeckGUI::doubleFrom(DeckGUI& other)
+{
+    if (&other == this || !other.isAudioLoaded) {
+        return;
+    }
+
+    reverseButton.setToggleState(false, sendNotification); //plays forwards like a fresh load
+    syncButton.setToggleState(false, sendNotification);
+
+    if (!player->doubleFrom(*other.player, other.loadedURL)) {
+        return;
+    }
+
+    waveformDisplay.shareFrom(other.waveformDisplay, other.loadedURL);
+    isAudioLoaded = true;
+    loadedURL = other.loadedURL;
+
+    //the player already has the speed
+    speedSlider.setValue(other.speedSlider.getValue(), dontSendNotification);
+    volSlider.setValue(other.volSlider.getValue());
+    filterSlider.setValue(other.filterSlider.getValue(), dontSendNotification);
+    player->setFilter(filterSlider.getValue());
+    resonanceSlider.setValue(other.resonanceSlider.getValue(), dontSendNotification);
+    player->setFilterResonance(resonanceSlider.getValue());
+
+    //only one EQ band is applied at a time, so the band moved last on the other deck is the one sent to the player
+    Slider* eqSliders[] = { &trebleSlider, &bassSlider, &midSlider };
+    Slider* otherEqSliders[] = { &other.trebleSlider, &other.bassSlider, &other.midSlider };
+    lastEqSlider = nullptr;
+    for (int band = 0; band < 3; ++band) {
+        eqSliders[band]->setValue(otherEqSliders[band]->getValue(), dontSendNotification);
+        if (otherEqSliders[band] == other.lastEqSlider) {
+            sliderValueChanged(eqSliders[band]);
+        }
+    }
+}
+
+//this function looks the track up in the library and gives its beat grid to the player, sync needs it
+void DeckGUI::setBeatGridFor(const juce::URL& trackURL)
+{
+    int trackId = trackLibrary.getTrackId(trackURL.getLocalFile());
+
+    if (trackId >= 0 && trackLibrary.isAnalysed(trackId)) {
+        player->setBeatGrid(trackLibrary.getBpm(trackId), trackLibrary.getFirstBeat(trackId));
+    }
+    else {
+        player->setBeatGrid(0.0, 0.0);
+    }
+}
+
+//this checks if the audio is loaded.
+bool DeckGUI::CheckAudioLoaded() 
+{
+    return isAudioLoaded; 
+}
+
+//this function returns the url of the loaded track, it is empty when nothing is loaded
+juce::URL DeckGUI::getLoadedURL() const
+{
+    return loadedURL;
+}
+
+//this function returns the player this deck controls
+DJAudioPlayer* DeckGUI::getPlayer() const
+{
+    return player;
+}
@@ -1,114 +1,189 @@
-/*===================================================================
-DeckGUI.h
-====================================================================*/
-
-#pragma once
-
-#include <juce_gui_basics/juce_gui_basics.h>
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "DJAudioPlayer.h"
-#include "WaveformDisplay.h"
-#include "PlaylistComponent.h"
-
-class CustomRotarySlider : public juce::LookAndFeel_V4
-{
-public:
-    void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
-        float sliderPosProportional, float rotaryStartAngle,
-        float rotaryEndAngle, juce::Slider& slider) override
-    {
-        auto r = juce::jmin(width / 2, height / 2) - 4.0f;
-        auto cX = x + width * 0.5f;
-        auto cY = y + height * 0.5f;
-        auto rx = cX - r;
-        auto ry = cY - r;
-        auto rw = r * 2.0f;
-        auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
-
-        //this creates a glowing effect on the outer circke
-        juce::ColourGradient glow(juce::Colours::cyan.withAlpha(0.3f), cX, cY,
-            juce::Colours::transparentBlack, cX, cY + r, true);
-        g.setGradientFill(glow);
-        g.fillEllipse(rx - 5, ry - 5, rw + 10, rw + 10);
-
-        //this creates a background color with gradient
-        juce::ColourGradient baseGradient(juce::Colours::darkgrey, rx, ry,
-            juce::Colours::black, rx + rw, ry + rw, false);
-        g.setGradientFill(baseGradient);
-        g.fillEllipse(rx, ry, rw, rw);
-
-        //this creates an inner glowing knob
-        juce::ColourGradient knobGradient(juce::Colours::darkcyan, cX, cY,
-            juce::Colours::black, cX, cY + r * 0.7f, true);
-        g.setGradientFill(knobGradient);
-        g.fillEllipse(rx + 6, ry + 6, rw - 12, rw - 12);
-
-        //this creates an indicator
-        juce::Path pointer;
-        float pointerLength = r * 0.7f;
-        float pointerThickness = 4.0f;
-        pointer.addRoundedRectangle(-pointerThickness * 0.5f, -r + 10, pointerThickness, pointerLength, 2.0f);
-
-        g.setColour(juce::Colours::white);
-        g.fillPath(pointer, juce::AffineTransform::rotation(angle).translated(cX, cY));
-
-        //this add reflector effects
-        g.setColour(juce::Colours::white.withAlpha(0.2f));
-        g.fillEllipse(rx + 8, ry + 8, rw - 16, rw - 16);
-    }
-};
-
-//this function manage the graphical user interface and provide controls for playback, volume, speed, position, and audio effects (treble, bass, mid)
-class DeckGUI    : public Component,
-                   public Button::Listener, 
-                   public Slider::Listener,
-                   public Timer
-{
-public:
-    DeckGUI(DJAudioPlayer* player, 
-           AudioFormatManager & 	formatManagerToUse,
-           AudioThumbnailCache & 	cacheToUse
-           );
-    ~DeckGUI();
-
-    void paint (Graphics&) override;
-    void resized() override;
-
-    //implementing listener for button and slider
-    void buttonClicked (Button *) override;
-    void sliderValueChanged (Slider *slider) override;
-    void loadTrackFromPlaylist(juce::URL trackURL);
-    bool CheckAudioLoaded();
-    void timerCallback() override; 
-
-private:
-
-    //this checks if the audio is loaded
-    bool isAudioLoaded = false;
-
-    //creating button variables
-    ImageButton playButton{"PLAY"};
-    ImageButton pauseButton{"PAUSE"};
-    ImageButton stopButton{"STOP"};
-
-    //creating image variables
-    juce::Image playImage;
-    juce::Image pauseImage;
-    juce::Image stopImage;
-
-    //creating sliders variables
-    Slider volSlider; 
-    Slider speedSlider;
-    Slider posSlider;
-    Slider trebleSlider;
-    Slider bassSlider;
-    Slider midSlider;
-    
-    WaveformDisplay waveformDisplay;
-
-    CustomRotarySlider customLookAndFeel;
-
-    DJAudioPlayer* player; 
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckGUI)
+/*===================================================================
+DeckGUI.h
+====================================================================*/
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+#include "WaveformDisplay.h"
+#include "ScrollingWaveform.h"
+#include "JogWheel.h"
+#include "LevelMeterComponent.h"
+#include "TrackLibrary.h"
+#include "PlaylistComponent.h"
+
+class CustomRotarySlider : public juce::LookAndFeel_V4
+{
+public:
+    void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
+        float sliderPosProportional, float rotaryStartAngle,
+        float rotaryEndAngle, juce::Slider& slider) override
+    {
+        auto r = juce::jmin(width / 2, height / 2) - 4.0f;
+        auto cX = x + width * 0.5f;
+        auto cY = y + height * 0.5f;
+        auto rx = cX - r;
+        auto ry = cY - r;
+        auto rw = r * 2.0f;
+        auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
+
+        //this creates a glowing effect on the outer circke
+        juce::ColourGradient glow(juce::Colours::cyan.withAlpha(0.3f), cX, cY,
+            juce::Colours::transparentBlack, cX, cY + r, true);
+        g.setGradientFill(glow);
+        g.fillEllipse(rx - 5, ry - 5, rw + 10, rw + 10);
+
+        //this creates a background color with gradient
+        juce::ColourGradient baseGradient(juce::Colours::darkgrey, rx, ry,
+            juce::Colours::black, rx + rw, ry + rw, false);
+        g.setGradientFill(baseGradient);
+        g.fillEllipse(rx, ry, rw, rw);
+
+        //this creates an inner glowing knob
+        juce::ColourGradient knobGradient(juce::Colours::darkcyan, cX, cY,
+            juce::Colours::black, cX, cY + r * 0.7f, true);
+        g.setGradientFill(knobGradient);
+        g.fillEllipse(rx + 6, ry + 6, rw - 12, rw - 12);
+
+        //this creates an indicator
+        juce::Path pointer;
+        float pointerLength = r * 0.7f;
+        float pointerThickness = 4.0f;
+        pointer.addRoundedRectangle(-pointerThickness * 0.5f, -r + 10, pointerThickness, pointerLength, 2.0f);
+
+        g.setColour(juce::Colours::white);
+        g.fillPath(pointer, juce::AffineTransform::rotation(angle).translated(cX, cY));
+
+        //this add reflector effects
+        g.setColour(juce::Colours::white.withAlpha(0.2f));
+        g.fillEllipse(rx + 8, ry + 8, rw - 16, rw - 16);
+    }
+};
+
+//this function manage the graphical user interface and provide controls for playback, volume, speed, position, and audio effects (treble, bass, mid)
+class DeckGUI    : public Component,
+                   public Button::Listener, 
+                   public Slider::Listener,
+                   public ComboBox::Listener,
+                   public Timer
+{
+public:
+    DeckGUI(DJAudioPlayer* player, 
+           AudioFormatManager & 	formatManagerToUse,
+           WaveformCache & 	cacheToUse,
+           TrackLibrary & 	libraryToUse
+           );
+    ~DeckGUI();
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+    //implementing listener for button and slider
+    void buttonClicked (Button *) override;
+    void sliderValueChanged (Slider *slider) override;
+    void comboBoxChanged (ComboBox* comboBox) override;
+    void loadTrackFromPlaylist(juce::URL trackURL);
+
+    //loads a track without blocking the message thread, onLoaded is called once it can start playing without waiting on the disk
+    void loadTrackInBackground(juce::URL trackURL, std::function<void(bool)> onLoaded);
+
+    //stops the deck and clears the loaded track, the same as pressing stop
+    void unloadTrack();
+
+    //sets the speed ratio exactly, without the rounding of the speed slider
+    void setSpeed(double ratio);
+
+    //the deck the sync button locks this deck to
+    void setSyncMaster(DJAudioPlayer* master);
+
+    //the deck the double button copies
+    void setDoubleSource(DeckGUI* deck);
+
+    //loads the other deck's track into this one with its position, speed, EQ and filter, playing in phase with it
+    void doubleFrom(DeckGUI& other);
+    bool CheckAudioLoaded();
+    void timerCallback() override; 
+
+    //gets the track loaded from the playlist and the player of this deck
+    juce::URL getLoadedURL() const;
+    DJAudioPlayer* getPlayer() const;
+
+private:
+
+    //this checks if the audio is loaded
+    bool isAudioLoaded = false;
+
+    //the track that was loaded last
+    juce::URL loadedURL;
+
+    //gives the player the beat grid of a track when it is loaded
+    void setBeatGridFor(const juce::URL& trackURL);
+
+    //the effect picked in the effect selector
+    EffectsRack::Effect getSelectedEffect() const;
+
+    TrackLibrary& trackLibrary;
+    DJAudioPlayer* syncMaster = nullptr;
+    DeckGUI* doubleSource = nullptr;
+
+    //the EQ knob moved last, the player only applies that band
+    Slider* lastEqSlider = nullptr;
+
+    //creating button variables
+    ImageButton playButton{"PLAY"};
+    ImageButton pauseButton{"PAUSE"};
+    ImageButton stopButton{"STOP"};
+
+    //plays the track backwards while it is on
+    TextButton reverseButton{"REV"};
+
+    //keeps the track going underneath a scratch, reverse or held hot cue while it is on
+    TextButton slipButton{"SLIP"};
+
+    //locks the tempo and beat phase to the other deck while it is on
+    TextButton syncButton{"SYNC"};
+
+    //copies the other deck into this one
+    TextButton doubleButton{"DBL"};
+
+    //picks an effect, turns it on and off and sets how much of it is heard
+    ComboBox effectSelector;
+    TextButton effectButton{"FX"};
+    Slider effectMixSlider;
+
+    //creating image variables
+    juce::Image playImage;
+    juce::Image pauseImage;
+    juce::Image stopImage;
+
+    //creating sliders variables
+    Slider volSlider; 
+    Slider speedSlider;
+    Slider posSlider;
+    Slider trebleSlider;
+    Slider bassSlider;
+    Slider midSlider;
+
+    //low-pass to the left, high-pass to the right, off in the middle, and how much it rings at the cutoff
+    Slider filterSlider;
+    Slider resonanceSlider;
+    
+    WaveformDisplay waveformDisplay;
+
+    //the zoomed view around the playhead, above the overview
+    ScrollingWaveform scrollingWaveform;
+
+    //the platter for scratching
+    JogWheel jogWheel;
+
+    //the level the deck sends to the mixer
+    LevelMeterComponent levelMeter;
+
+    CustomRotarySlider customLookAndFeel;
+
+    DJAudioPlayer* player; 
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckGUI)
 };  
\ No newline at end of file
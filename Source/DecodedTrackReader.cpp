@@ -0,0 +1,91 @@
+/*====================================================================
+DecodedTrackReader.cpp
+This class gives a second deck a reader over the audio another deck's ParallelTrackDecoder holds in RAM. A read is cut into the
+decoder's chunks: the finished ones are copied straight out of the shared buffer and the others go through the fallback reader, so
+the result is the same wherever the decoder has got to. It is read on the read-ahead thread, never on the audio thread.
+====================================================================*/
+
+
+#include "DecodedTrackReader.h"
+
+DecodedTrackReader::DecodedTrackReader(ParallelTrackDecoder::Ptr _decodedTrack, AudioFormatReader* _fallback)
+    : AudioFormatReader(nullptr, "Decoded track"),
+      decodedTrack(_decodedTrack),
+      fallback(_fallback)
+{
+    sampleRate = decodedTrack->getSampleRate();
+    lengthInSamples = decodedTrack->getLengthInSamples();
+    numChannels = (unsigned int) decodedTrack->getBuffer().getNumChannels();
+    bitsPerSample = 32;
+    usesFloatingPointData = true;
+}
+
+DecodedTrackReader::~DecodedTrackReader()
+{
+}
+
+//this function copies the decoded chunks and reads the rest from the file
+bool DecodedTrackReader::readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                     int64 startSampleInFile, int numSamples)
+{
+    clearSamplesBeyondAvailableLength(destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples, lengthInSamples);
+
+    const AudioBuffer<float>& buffer = decodedTrack->getBuffer();
+    bool ok = true;
+
+    while (numSamples > 0)
+    {
+        //one piece never crosses a chunk, so it is either decoded or not
+        int64 chunkEnd = (startSampleInFile / ParallelTrackDecoder::chunkSize + 1) * ParallelTrackDecoder::chunkSize;
+        int numInPiece = (int) jmin((int64) numSamples, chunkEnd - startSampleInFile);
+
+        if (decodedTrack->isRangeDecoded(startSampleInFile, startSampleInFile + numInPiece)) {
+            for (int channel = 0; channel < numDestChannels; ++channel) {
+                if (destSamples[channel] != nullptr) {
+                    int sourceChannel = jmin(channel, buffer.getNumChannels() - 1);
+                    FloatVectorOperations::copy(reinterpret_cast<float*>(destSamples[channel] + startOffsetInDestBuffer),
+                                                buffer.getReadPointer(sourceChannel, (int) startSampleInFile), numInPiece);
+                }
+            }
+        }
+        else {
+            ok = readFromFallback(destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numInPiece) && ok;
+        }
+
+        startOffsetInDestBuffer += numInPiece;
+        startSampleInFile += numInPiece;
+        numSamples -= numInPiece;
+    }
+
+    return ok;
+}
+
+//this function reads from the file the same way the decoder does, silence if there is no file to read
+bool DecodedTrackReader::readFromFallback(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                          int64 startSampleInFile, int numSamples)
+{
+    int* channels[2] = {};
+    for (int channel = 0; channel < jmin(2, numDestChannels); ++channel) {
+        if (destSamples[channel] != nullptr) {
+            channels[channel] = destSamples[channel] + startOffsetInDestBuffer;
+        }
+    }
+
+    if (fallback == nullptr || !fallback->read(channels, jmin(2, numDestChannels), startSampleInFile, numSamples, false)) {
+        for (int channel = 0; channel < numDestChannels; ++channel) {
+            if (destSamples[channel] != nullptr) {
+                zeromem(destSamples[channel] + startOffsetInDestBuffer, sizeof(int) * (size_t) numSamples);
+            }
+        }
+        return false;
+    }
+
+    if (!fallback->usesFloatingPointData) {
+        for (auto* samples : channels) {
+            if (samples != nullptr) {
+                FloatVectorOperations::convertFixedToFloat(reinterpret_cast<float*>(samples), samples, 1.0f / (float) 0x7fffffff, numSamples);
+            }
+        }
+    }
+    return true;
+}
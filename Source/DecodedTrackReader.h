@@ -0,0 +1,32 @@
+/*====================================================================
+DecodedTrackReader.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "ParallelTrackDecoder.h"
+
+//this class reads a track out of a ParallelTrackDecoder's buffer, so a second deck can play a track another deck has already decoded
+//without opening or decoding the file again. the buffer is shared by reference and only read. the parts that are not decoded yet
+//come from the fallback reader, which is not needed (and can be nullptr) once the decoder has finished
+class DecodedTrackReader : public AudioFormatReader
+{
+public:
+    //takes ownership of the fallback reader
+    DecodedTrackReader(ParallelTrackDecoder::Ptr decodedTrack, AudioFormatReader* fallback);
+    ~DecodedTrackReader() override;
+
+    bool readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                     int64 startSampleInFile, int numSamples) override;
+
+private:
+    //reads a range that is not decoded yet through the fallback, as floats like the rest of the reader
+    bool readFromFallback(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                          int64 startSampleInFile, int numSamples);
+
+    ParallelTrackDecoder::Ptr decodedTrack;
+    std::unique_ptr<AudioFormatReader> fallback;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedTrackReader)
+};
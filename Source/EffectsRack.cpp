@@ -0,0 +1,351 @@
+/*====================================================================
+EffectsRack.cpp
+This class runs a deck's insert effects after the EQ. Each effect writes what it adds to the signal into a shared wet buffer, which
+is mixed into the deck with the effect's wet gain, so fading an effect in or out is one ramp for every effect. The block operations
+use FloatVectorOperations, and the effects that have to work sample by sample (the flanger and the gate envelope) work out their
+sweep once per sample for both channels.
+====================================================================*/
+
+
+#include "EffectsRack.h"
+#include "Tracer.h"
+#include <cmath>
+
+//the longest echo that can be set, reached at 0.75 beats below 23 bpm
+static constexpr double maxEchoSeconds = 2.0;
+static constexpr float echoFeedback = 0.45f;
+
+//the flanger sweeps its delay between these times
+static constexpr double flangerMinSeconds = 0.0005;
+static constexpr double flangerMaxSeconds = 0.004;
+static constexpr float flangerFeedback = 0.6f;
+
+//how quickly the gate opens and closes
+static constexpr double gateSmoothingSeconds = 0.002;
+
+//how much each block moves the average load, and how slowly the peak load falls
+static constexpr float loadSmoothing = 0.05f;
+static constexpr float peakDecay = 0.999f;
+
+EffectsRack::EffectsRack()
+{
+}
+
+EffectsRack::~EffectsRack()
+{
+}
+
+//this function allocates everything the effects use, nothing is allocated while processing
+void EffectsRack::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = jmax(1, samplesPerBlockExpected);
+
+    wetBuffer.setSize(2, maxBlockSize);
+    gains.allocate((size_t) maxBlockSize, true);
+    workBuffer.allocate((size_t) maxBlockSize, true);
+
+    echoLine.setSize(2, (int) (maxEchoSeconds * sampleRate) + maxBlockSize);
+    flangerLine.setSize(2, (int) (flangerMaxSeconds * sampleRate) + 2);
+
+    reverb.setSampleRate(sampleRate);
+    Reverb::Parameters parameters;
+    parameters.roomSize = 0.7f;
+    parameters.damping = 0.5f;
+    parameters.wetLevel = 0.33f;
+    parameters.dryLevel = 0.0f;
+    reverb.setParameters(parameters);
+
+    for (int index = 0; index < numEffects; ++index) {
+        resetEffect((Effect) index);
+        slots[index].wet.reset(sampleRate, rampSeconds);
+        slots[index].wet.setCurrentAndTargetValue(0.0f);
+        slots[index].active = false;
+    }
+}
+
+//this function splits the block into chunks that fit the work buffers and follows the beat through them
+void EffectsRack::process(AudioBuffer<float>& buffer, int startSample, int numSamples, double beat, double beatsPerSample)
+{
+    Tracer::Scope trace("EffectsRack::process", Tracer::Category::audio);
+    if (maxBlockSize == 0) {
+        return;
+    }
+
+    //a deck without a beat grid gets a steady tempo of its own
+    double samplesPerBeat = sampleRate * 60.0 / defaultBpm;
+    if (beatsPerSample > 0.0) {
+        samplesPerBeat = 1.0 / beatsPerSample;
+    }
+    else {
+        beat = freeBeat;
+    }
+
+    int numChannels = jmin(2, buffer.getNumChannels());
+    float* channels[2] = {};
+
+    for (int done = 0; done < numSamples;) {
+        int chunk = jmin(maxBlockSize, numSamples - done);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            channels[channel] = buffer.getWritePointer(channel, startSample + done);
+        }
+
+        processChunk(channels, numChannels, chunk, beat + done / samplesPerBeat, samplesPerBeat);
+        done += chunk;
+    }
+
+    //64 beats is a whole number of every effect's period
+    freeBeat = std::fmod(beat + numSamples / samplesPerBeat, 64.0);
+}
+
+//this function runs the effects in order, each one on the output of the one before
+void EffectsRack::processChunk(float* const* channels, int numChannels, int numSamples, double beat, double samplesPerBeat)
+{
+    for (int index = 0; index < numEffects; ++index) {
+        Slot& slot = slots[index];
+        bool enabled = slot.enabled.load();
+
+        //a bypassed effect costs this check and nothing else
+        if (!slot.active) {
+            if (!enabled) {
+                continue;
+            }
+            resetEffect((Effect) index);
+            slot.wet.setCurrentAndTargetValue(0.0f);
+            slot.active = true;
+        }
+        slot.wet.setTargetValue(enabled ? slot.mix.load() : 0.0f);
+
+        auto startTicks = Time::getHighResolutionTicks();
+
+        //the wet gain of every sample, shared by the channels
+        bool ramping = slot.wet.isSmoothing();
+        if (ramping) {
+            for (int i = 0; i < numSamples; ++i) {
+                gains[i] = slot.wet.getNextValue();
+            }
+        }
+
+        switch ((Effect) index) {
+            case Effect::echo:
+                renderEcho(channels, numChannels, numSamples, samplesPerBeat);
+                break;
+            case Effect::reverb:
+                renderReverb(channels, numChannels, numSamples);
+                break;
+            case Effect::flanger:
+                renderFlanger(channels, numChannels, numSamples, beat, samplesPerBeat);
+                break;
+            case Effect::gater:
+                renderGater(channels, numChannels, numSamples, beat, samplesPerBeat);
+                break;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            if (ramping) {
+                FloatVectorOperations::addWithMultiply(channels[channel], wetBuffer.getReadPointer(channel), gains.get(), numSamples);
+            }
+            else {
+                FloatVectorOperations::addWithMultiply(channels[channel], wetBuffer.getReadPointer(channel), slot.wet.getTargetValue(), numSamples);
+            }
+        }
+
+        float load = (float) (Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * sampleRate / numSamples);
+        slot.averageLoad = slot.averageLoad.load() + loadSmoothing * (load - slot.averageLoad.load());
+        slot.peakLoad = jmax(load, slot.peakLoad.load() * peakDecay);
+
+        //the effect is skipped from the next chunk on once it has faded out
+        if (!enabled && !slot.wet.isSmoothing()) {
+            slot.active = false;
+            slot.averageLoad = 0.0f;
+        }
+    }
+}
+
+//this function feeds the deck into the delay line and returns the repeats, which are fed back so each one is quieter
+void EffectsRack::renderEcho(float* const* channels, int numChannels, int numSamples, double samplesPerBeat)
+{
+    int lineLength = echoLine.getNumSamples();
+
+    //never shorter than the chunk, so the repeats read are never the samples being written
+    int delay = jlimit(numSamples, lineLength, roundToInt(echoBeats * samplesPerBeat));
+    int readPosition = (echoWritePosition - delay + lineLength) % lineLength;
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        float* wet = wetBuffer.getWritePointer(channel);
+        float* line = echoLine.getWritePointer(channel);
+
+        readLine(line, lineLength, readPosition, wet, numSamples);
+
+        FloatVectorOperations::copy(workBuffer.get(), channels[channel], numSamples);
+        FloatVectorOperations::addWithMultiply(workBuffer.get(), wet, echoFeedback, numSamples);
+        writeLine(line, lineLength, echoWritePosition, workBuffer.get(), numSamples);
+    }
+
+    echoWritePosition = (echoWritePosition + numSamples) % lineLength;
+}
+
+//this function returns the reverb of the deck on its own
+void EffectsRack::renderReverb(float* const* channels, int numChannels, int numSamples)
+{
+    for (int channel = 0; channel < numChannels; ++channel) {
+        FloatVectorOperations::copy(wetBuffer.getWritePointer(channel), channels[channel], numSamples);
+    }
+
+    if (numChannels == 2) {
+        reverb.processStereo(wetBuffer.getWritePointer(0), wetBuffer.getWritePointer(1), numSamples);
+    }
+    else {
+        reverb.processMono(wetBuffer.getWritePointer(0), numSamples);
+    }
+}
+
+//this function returns the deck through a short delay that sweeps with the beat, with both channels read at the same delay
+void EffectsRack::renderFlanger(float* const* channels, int numChannels, int numSamples, double beat, double samplesPerBeat)
+{
+    int lineLength = flangerLine.getNumSamples();
+    float minDelay = (float) (flangerMinSeconds * sampleRate);
+    float depth = (float) ((flangerMaxSeconds - flangerMinSeconds) * sampleRate);
+
+    double phase = beat / flangerBeats;
+    double phaseStep = 1.0 / (flangerBeats * samplesPerBeat);
+
+    float* lines[2] = {};
+    float* wet[2] = {};
+    for (int channel = 0; channel < numChannels; ++channel) {
+        lines[channel] = flangerLine.getWritePointer(channel);
+        wet[channel] = wetBuffer.getWritePointer(channel);
+    }
+
+    for (int i = 0; i < numSamples; ++i) {
+        //a triangle sweep, the delay goes up and down once per period
+        float sweep = (float) std::abs(2.0 * (phase - std::floor(phase)) - 1.0);
+        float readPosition = (float) flangerWritePosition - (minDelay + sweep * depth);
+        if (readPosition < 0.0f) {
+            readPosition += (float) lineLength;
+        }
+
+        int first = (int) readPosition;
+        int second = first + 1 < lineLength ? first + 1 : 0;
+        float t = readPosition - (float) first;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float delayed = lines[channel][first] + t * (lines[channel][second] - lines[channel][first]);
+            lines[channel][flangerWritePosition] = channels[channel][i] + flangerFeedback * delayed;
+            wet[channel][i] = delayed;
+        }
+
+        if (++flangerWritePosition == lineLength) {
+            flangerWritePosition = 0;
+        }
+        phase += phaseStep;
+    }
+}
+
+//this function returns what the gate takes away, the gate is open for the first half of every gateBeats
+void EffectsRack::renderGater(float* const* channels, int numChannels, int numSamples, double beat, double samplesPerBeat)
+{
+    double phase = beat / gateBeats;
+    double phaseStep = 1.0 / (gateBeats * samplesPerBeat);
+    float smoothing = (float) (1.0 - std::exp(-1.0 / (gateSmoothingSeconds * sampleRate)));
+
+    //the envelope is worked out once and applied to both channels
+    for (int i = 0; i < numSamples; ++i) {
+        float target = phase - std::floor(phase) < 0.5 ? 1.0f : 0.0f;
+        gateLevel += smoothing * (target - gateLevel);
+        workBuffer[i] = gateLevel - 1.0f;
+        phase += phaseStep;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        FloatVectorOperations::multiply(wetBuffer.getWritePointer(channel), channels[channel], workBuffer.get(), numSamples);
+    }
+}
+
+//this function clears the memory of one effect
+void EffectsRack::resetEffect(Effect effect)
+{
+    switch (effect) {
+        case Effect::echo:
+            echoLine.clear();
+            echoWritePosition = 0;
+            break;
+        case Effect::reverb:
+            reverb.reset();
+            break;
+        case Effect::flanger:
+            flangerLine.clear();
+            flangerWritePosition = 0;
+            break;
+        case Effect::gater:
+            gateLevel = 1.0f;
+            break;
+    }
+}
+
+//this function copies numSamples from a delay line into a block, in at most two parts
+void EffectsRack::readLine(const float* line, int lineLength, int position, float* dest, int numSamples)
+{
+    int firstPart = jmin(numSamples, lineLength - position);
+    FloatVectorOperations::copy(dest, line + position, firstPart);
+    if (firstPart < numSamples) {
+        FloatVectorOperations::copy(dest + firstPart, line, numSamples - firstPart);
+    }
+}
+
+//this function copies a block into a delay line, in at most two parts
+void EffectsRack::writeLine(float* line, int lineLength, int position, const float* src, int numSamples)
+{
+    int firstPart = jmin(numSamples, lineLength - position);
+    FloatVectorOperations::copy(line + position, src, firstPart);
+    if (firstPart < numSamples) {
+        FloatVectorOperations::copy(line, src + firstPart, numSamples - firstPart);
+    }
+}
+
+//this function turns an effect on or off, the audio thread fades it
+void EffectsRack::setEnabled(Effect effect, bool shouldBeEnabled)
+{
+    slots[(int) effect].enabled = shouldBeEnabled;
+}
+
+//this function checks if an effect is on
+bool EffectsRack::isEnabled(Effect effect) const
+{
+    return slots[(int) effect].enabled.load();
+}
+
+//this function sets how much of an effect is heard
+void EffectsRack::setMix(Effect effect, float mix)
+{
+    slots[(int) effect].mix = jlimit(0.0f, 1.0f, mix);
+}
+
+//this function returns how much of an effect is heard
+float EffectsRack::getMix(Effect effect) const
+{
+    return slots[(int) effect].mix.load();
+}
+
+//this function returns the time an effect takes, 0 while it is bypassed
+EffectsRack::Load EffectsRack::getLoad(Effect effect) const
+{
+    const Slot& slot = slots[(int) effect];
+    return { slot.averageLoad.load(), slot.peakLoad.load() };
+}
+
+//this function returns the name shown for an effect
+String EffectsRack::getName(Effect effect)
+{
+    switch (effect) {
+        case Effect::echo:
+            return "Echo";
+        case Effect::reverb:
+            return "Reverb";
+        case Effect::flanger:
+            return "Flanger";
+        case Effect::gater:
+            return "Gater";
+    }
+    return {};
+}
@@ -0,0 +1,123 @@
+/*====================================================================
+EffectsRack.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class is the insert effects of one deck: a beat-synced echo, a reverb, a flanger and a beat-synced gater, in that order. every
+//buffer is allocated in prepareToPlay, each effect fades its wet signal in and out when it is turned on or off, and an effect that is
+//off and has faded out is skipped. the time each effect takes is measured on the audio thread and can be read from any thread
+class EffectsRack
+{
+public:
+    enum class Effect
+    {
+        echo,
+        reverb,
+        flanger,
+        gater
+    };
+
+    static constexpr int numEffects = 4;
+
+    //the echo repeats every echoBeats, the gater opens once every gateBeats and the flanger sweeps over flangerBeats
+    static constexpr double echoBeats = 0.75;
+    static constexpr double gateBeats = 0.25;
+    static constexpr double flangerBeats = 8.0;
+
+    //the tempo the effects follow when the deck has no beat grid
+    static constexpr double defaultBpm = 120.0;
+
+    //how long an effect takes to fade in or out, or to follow its mix knob
+    static constexpr double rampSeconds = 0.05;
+
+    //the time an effect takes as a fraction of the audio it processed, 1 would use the whole callback
+    struct Load
+    {
+        float average = 0.0f;
+        float peak = 0.0f;
+    };
+
+    EffectsRack();
+    ~EffectsRack();
+
+    //allocates the delay lines, the reverb and the work buffers for blocks of up to samplesPerBlockExpected (longer blocks are split)
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    //runs the effects that are on. beat is where the deck was at the start of the block and beatsPerSample its tempo, 0 when it has
+    //no beat grid or is stopped. called on the audio thread
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, double beat, double beatsPerSample);
+
+    //turns an effect on or off and sets how much of it is heard, from 0 to 1
+    void setEnabled(Effect effect, bool shouldBeEnabled);
+    bool isEnabled(Effect effect) const;
+    void setMix(Effect effect, float mix);
+    float getMix(Effect effect) const;
+
+    Load getLoad(Effect effect) const;
+
+    static String getName(Effect effect);
+
+private:
+    struct Slot
+    {
+        std::atomic<bool> enabled{ false };
+        std::atomic<float> mix{ 0.5f };
+
+        //audio thread only, active is false once a disabled effect has faded out
+        SmoothedValue<float> wet;
+        bool active = false;
+
+        //the measured load, written by the audio thread
+        std::atomic<float> averageLoad{ 0.0f };
+        std::atomic<float> peakLoad{ 0.0f };
+    };
+
+    //runs one chunk that fits in the work buffers
+    void processChunk(float* const* channels, int numChannels, int numSamples, double beat, double samplesPerBeat);
+
+    //each effect writes what it adds to the signal into the wet buffer, the rack mixes it in
+    void renderEcho(float* const* channels, int numChannels, int numSamples, double samplesPerBeat);
+    void renderReverb(float* const* channels, int numChannels, int numSamples);
+    void renderFlanger(float* const* channels, int numChannels, int numSamples, double beat, double samplesPerBeat);
+    void renderGater(float* const* channels, int numChannels, int numSamples, double beat, double samplesPerBeat);
+
+    //clears what an effect remembers, so turning it on again does not bring back an old tail
+    void resetEffect(Effect effect);
+
+    //copies between a delay line and a block, wrapping round the end of the line
+    static void readLine(const float* line, int lineLength, int position, float* dest, int numSamples);
+    static void writeLine(float* line, int lineLength, int position, const float* src, int numSamples);
+
+    Slot slots[numEffects];
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+
+    //the wet signal, the per-sample wet gains and a buffer for working in, shared by every effect
+    AudioBuffer<float> wetBuffer;
+    HeapBlock<float> gains;
+    HeapBlock<float> workBuffer;
+
+    //echo
+    AudioBuffer<float> echoLine;
+    int echoWritePosition = 0;
+
+    //reverb
+    Reverb reverb;
+
+    //flanger
+    AudioBuffer<float> flangerLine;
+    int flangerWritePosition = 0;
+
+    //gater, the gate is smoothed so its edges do not click
+    float gateLevel = 1.0f;
+
+    //where a deck without a beat grid is in its beat
+    double freeBeat = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectsRack)
+};
@@ -0,0 +1,77 @@
+/*====================================================================
+HarmonicIndex.cpp
+This class keeps the analysed tracks grouped by key and sorted by tempo so that mix suggestions can be updated live while a deck plays.
+====================================================================*/
+
+
+#include "HarmonicIndex.h"
+#include <algorithm>
+
+//this function inserts the track into the bpm-sorted list of its key
+void HarmonicIndex::addTrack(int trackId, int key, double bpm)
+{
+    removeTrack(trackId);
+
+    if (key < 0 || key >= 24 || bpm <= 0.0) {
+        return;
+    }
+
+    auto& items = tracksByKey[key];
+    auto position = std::lower_bound(items.begin(), items.end(), bpm,
+                                     [](const Item& item, double value) { return item.bpm < value; });
+    items.insert(position, { bpm, trackId });
+    keyOfTrack[trackId] = key;
+}
+
+//this function takes a track out of the list it is in
+void HarmonicIndex::removeTrack(int trackId)
+{
+    auto found = keyOfTrack.find(trackId);
+    if (found == keyOfTrack.end()) {
+        return;
+    }
+
+    auto& items = tracksByKey[found->second];
+    items.erase(std::remove_if(items.begin(), items.end(), [trackId](const Item& item) { return item.trackId == trackId; }),
+                items.end());
+    keyOfTrack.erase(found);
+}
+
+//this function collects the tracks of the compatible keys that fall inside the tempo range
+void HarmonicIndex::findCompatible(int key, double bpm, double bpmTolerance, std::vector<int>& result, int excludeTrackId) const
+{
+    if (key < 0 || key >= 24 || bpm <= 0.0) {
+        return;
+    }
+
+    int compatibleKeys[4];
+    getCompatibleKeys(key, compatibleKeys);
+
+    double lowest = bpm * (1.0 - bpmTolerance);
+    double highest = bpm * (1.0 + bpmTolerance);
+
+    for (int compatibleKey : compatibleKeys) {
+        const auto& items = tracksByKey[compatibleKey];
+        auto it = std::lower_bound(items.begin(), items.end(), lowest,
+                                   [](const Item& item, double value) { return item.bpm < value; });
+
+        for (; it != items.end() && it->bpm <= highest; ++it) {
+            if (it->trackId != excludeTrackId) {
+                result.push_back(it->trackId);
+            }
+        }
+    }
+}
+
+//this function returns the keys that mix well with the given key: itself, the relative major/minor and one step either way round the wheel
+void HarmonicIndex::getCompatibleKeys(int key, int (&compatibleKeys)[4])
+{
+    bool minor = key >= 12;
+    int tonic = key % 12;
+    int modeOffset = minor ? 12 : 0;
+
+    compatibleKeys[0] = key;
+    compatibleKeys[1] = minor ? (tonic + 3) % 12 : (tonic + 9) % 12 + 12; //relative major or minor
+    compatibleKeys[2] = (tonic + 7) % 12 + modeOffset; //one step clockwise
+    compatibleKeys[3] = (tonic + 5) % 12 + modeOffset; //one step anticlockwise
+}
@@ -0,0 +1,36 @@
+/*====================================================================
+HarmonicIndex.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <unordered_map>
+#include <vector>
+
+//this class answers "which tracks mix harmonically with this one" without scanning the library.
+//tracks are kept in one bpm-sorted list per key, so a query only looks at the 4 compatible keys and binary searches the tempo range
+class HarmonicIndex
+{
+public:
+    //adds or moves a track, tracks without a key or tempo are left out
+    void addTrack(int trackId, int key, double bpm);
+
+    //appends the ids of tracks in a compatible key whose tempo is within bpmTolerance (e.g. 0.06 for 6%) of bpm
+    void findCompatible(int key, double bpm, double bpmTolerance, std::vector<int>& result, int excludeTrackId = -1) const;
+
+    //the same key, its relative major/minor and its neighbours on the Camelot wheel
+    static void getCompatibleKeys(int key, int (&compatibleKeys)[4]);
+
+private:
+    struct Item
+    {
+        double bpm;
+        int trackId;
+    };
+
+    void removeTrack(int trackId);
+
+    std::vector<Item> tracksByKey[24];
+    std::unordered_map<int, int> keyOfTrack;
+};
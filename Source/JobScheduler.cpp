@@ -0,0 +1,456 @@
+/*====================================================================
+JobScheduler.cpp
+This class keeps one queue per priority class on every worker. A job added from a worker goes into that worker's queue and a job added
+from any other thread is dealt out to the workers in turn. A worker runs the oldest job of its own queue and steals the newest job of
+another worker's queue when its own is empty, going through the classes most urgent first and skipping a class whose limit is used up.
+Taking a job only locks the two workers involved, in the order of the workers, while cancelling locks every worker in the same order,
+so a job that is being stolen is always found either in a queue or on the worker that took it.
+A running job is stopped the same way a ThreadPool stops it, by signalJobShouldExit, and is expected to check shouldExit.
+====================================================================*/
+
+
+#include "JobScheduler.h"
+
+//how long an idle worker sleeps before it looks at the queues again, in case a place in a full class came free
+static constexpr int idleWaitMs = 100;
+
+class JobScheduler::Worker : public Thread
+{
+public:
+    Worker(JobScheduler& _owner, int _index)
+        : Thread("Job worker " + String(_index + 1)),
+          owner(_owner),
+          index(_index)
+    {
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            Entry entry;
+            JobScheduler::Priority priority;
+            if (!owner.takeJob(*this, entry, priority)) {
+                //the worker counts as idle before it looks once more, so a job added in between is either found now or wakes it
+                idle = true;
+                if (!owner.takeJob(*this, entry, priority)) {
+                    wake.wait(idleWaitMs);
+                    idle = false;
+                    continue;
+                }
+                idle = false;
+            }
+
+            //a deck is waiting for its jobs, so they run at normal priority and everything else at low
+            Thread::Priority wanted = priority == JobScheduler::Priority::deck ? Thread::Priority::normal : Thread::Priority::low;
+            if (wanted != threadPriority) {
+                threadPriority = wanted;
+                setPriority(wanted);
+            }
+
+            ThreadPoolJob::JobStatus status = entry.job->runJob();
+            owner.finishJob(*this, entry, priority, status);
+        }
+    }
+
+    JobScheduler& owner;
+    int index;
+
+    //the queues and the running job are only touched with lock held
+    CriticalSection lock;
+    std::deque<Entry> queues[numPriorities];
+    Entry current;
+
+    WaitableEvent wake;
+    std::atomic<bool> idle{ false };
+
+    //the priority the thread was last set to, only used on the worker's thread
+    Thread::Priority threadPriority = Thread::Priority::low;
+};
+
+//this class holds the lock of every worker, taken in the order of the workers like takeFrom takes its two, so nothing moves between
+//the workers while it is held
+class JobScheduler::AllWorkersLock
+{
+public:
+    AllWorkersLock(const OwnedArray<Worker>& _workers)
+        : workers(_workers)
+    {
+        for (auto* worker : workers) {
+            worker->lock.enter();
+        }
+    }
+
+    ~AllWorkersLock()
+    {
+        for (int index = workers.size(); --index >= 0;) {
+            workers[index]->lock.exit();
+        }
+    }
+
+private:
+    const OwnedArray<Worker>& workers;
+
+    JUCE_DECLARE_NON_COPYABLE (AllWorkersLock)
+};
+
+//how many bits of the packed running counts each class has
+static constexpr int runningBits = 16;
+
+//this function reads the running jobs of one class out of the packed counts
+static int getRunning(uint64 numRunning, int priority)
+{
+    return (int) ((numRunning >> (priority * runningBits)) & (((uint64) 1 << runningBits) - 1));
+}
+
+JobScheduler::JobScheduler(int numWorkers)
+{
+    numWorkers = jmax(2, numWorkers);
+
+    limits[(int) Priority::deck] = numWorkers;
+    limits[(int) Priority::visible] = numWorkers - 1;
+    limits[(int) Priority::library] = jmax(1, numWorkers / 2);
+
+    for (int priority = 0; priority < numPriorities; ++priority) {
+        numWaiting[priority] = 0;
+    }
+
+    for (int index = 0; index < numWorkers; ++index) {
+        workers.add(new Worker(*this, index));
+    }
+    for (auto* worker : workers) {
+        worker->startThread(Thread::Priority::low);
+    }
+}
+
+JobScheduler::~JobScheduler()
+{
+    //the owners remove their jobs before they go, anything left is stopped here
+    for (auto* worker : workers) {
+        worker->signalThreadShouldExit();
+        worker->wake.signal();
+
+        const ScopedLock sl(worker->lock);
+        if (worker->current.job != nullptr) {
+            worker->current.job->signalJobShouldExit();
+        }
+    }
+
+    for (auto* worker : workers) {
+        worker->stopThread(10000);
+
+        for (auto& queue : worker->queues) {
+            for (auto& entry : queue) {
+                if (entry.deleteWhenFinished) {
+                    delete entry.job;
+                }
+            }
+            queue.clear();
+        }
+    }
+}
+
+//this function returns how many threads run the jobs
+int JobScheduler::getNumWorkers() const
+{
+    return workers.size();
+}
+
+//this function sets how many workers the class and the ones below it may use
+void JobScheduler::setConcurrencyLimit(Priority priority, int maxWorkers)
+{
+    if (maxWorkers < 1 || maxWorkers > workers.size()) {
+        std::cout << "JobScheduler::setConcurrencyLimit maxWorkers should be between 1 and " << workers.size() << std::endl;
+        return;
+    }
+
+    limits[(int) priority] = maxWorkers;
+    wakeWorker();
+}
+
+//this function returns the limit of the class
+int JobScheduler::getConcurrencyLimit(Priority priority) const
+{
+    return limits[(int) priority].load();
+}
+
+//this function queues the job on the calling worker, or on the next worker in turn
+void JobScheduler::addJob(ThreadPoolJob* job, Priority priority, const void* owner, bool deleteWhenFinished)
+{
+    jassert(job != nullptr);
+
+    Worker* target = nullptr;
+    for (auto* worker : workers) {
+        if (worker == Thread::getCurrentThread()) {
+            target = worker;
+        }
+    }
+    if (target == nullptr) {
+        target = workers[nextWorker++ % workers.size()];
+    }
+
+    {
+        const ScopedLock sl(target->lock);
+        target->queues[(int) priority].push_back({ job, owner, deleteWhenFinished });
+        ++numWaiting[(int) priority];
+    }
+
+    wakeWorker();
+}
+
+//this function moves a waiting job to the back of another class on the same worker
+bool JobScheduler::setPriority(ThreadPoolJob* job, Priority priority)
+{
+    const AllWorkersLock sl(workers);
+
+    for (auto* worker : workers) {
+        for (int from = 0; from < numPriorities; ++from) {
+            auto& queue = worker->queues[from];
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                if (it->job != job) {
+                    continue;
+                }
+                if (from != (int) priority) {
+                    Entry entry = *it;
+                    queue.erase(it);
+                    --numWaiting[from];
+                    worker->queues[(int) priority].push_back(entry);
+                    ++numWaiting[(int) priority];
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//this function removes a waiting job, or stops a running one and waits for it
+bool JobScheduler::removeJob(ThreadPoolJob* job, bool interruptIfRunning, int timeoutMs)
+{
+    return removeMatching([job](const Entry& entry) { return entry.job == job; }, interruptIfRunning, timeoutMs);
+}
+
+//this function removes the waiting jobs of the owner, stops its running ones and waits for them
+bool JobScheduler::removeJobs(const void* owner, int timeoutMs)
+{
+    return removeMatching([owner](const Entry& entry) { return entry.owner == owner; }, true, timeoutMs);
+}
+
+//this function looks at every queue and every running job with all the workers locked, until none of the jobs is left
+bool JobScheduler::removeMatching(const std::function<bool(const Entry&)>& test, bool interruptIfRunning, int timeoutMs)
+{
+    uint32 start = Time::getMillisecondCounter();
+
+    while (true)
+    {
+        //the jobs are deleted once the workers are unlocked
+        OwnedArray<ThreadPoolJob> removed;
+        bool running = false;
+        {
+            const AllWorkersLock sl(workers);
+
+            for (auto* worker : workers) {
+                for (int priority = 0; priority < numPriorities; ++priority) {
+                    auto& queue = worker->queues[priority];
+                    for (auto it = queue.begin(); it != queue.end();) {
+                        if (test(*it)) {
+                            if (it->deleteWhenFinished) {
+                                removed.add(it->job);
+                            }
+                            it = queue.erase(it);
+                            --numWaiting[priority];
+                        }
+                        else {
+                            ++it;
+                        }
+                    }
+                }
+
+                if (worker->current.job != nullptr && test(worker->current)) {
+                    if (interruptIfRunning) {
+                        worker->current.job->signalJobShouldExit();
+                    }
+                    running = true;
+                }
+            }
+        }
+
+        if (!running) {
+            return true;
+        }
+        if ((int) (Time::getMillisecondCounter() - start) >= timeoutMs) {
+            return false;
+        }
+        jobFinished.wait(10);
+    }
+}
+
+//this function looks for the job in every queue and on every worker until it is gone
+bool JobScheduler::waitForJobToFinish(const ThreadPoolJob* job, int timeoutMs) const
+{
+    uint32 start = Time::getMillisecondCounter();
+
+    while (true)
+    {
+        bool found = false;
+        {
+            const AllWorkersLock sl(workers);
+
+            for (auto* worker : workers) {
+                if (worker->current.job == job) {
+                    found = true;
+                }
+                for (auto& queue : worker->queues) {
+                    for (auto& entry : queue) {
+                        if (entry.job == job) {
+                            found = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!found) {
+            return true;
+        }
+        if ((int) (Time::getMillisecondCounter() - start) >= timeoutMs) {
+            return false;
+        }
+        jobFinished.wait(10);
+    }
+}
+
+//this function returns the jobs of a class that are waiting or running
+int JobScheduler::getNumJobs(Priority priority) const
+{
+    return numWaiting[(int) priority].load() + getRunning(numRunning.load(), (int) priority);
+}
+
+//this function returns every job that is waiting or running
+int JobScheduler::getNumJobs() const
+{
+    int total = 0;
+    for (int priority = 0; priority < numPriorities; ++priority) {
+        total += getNumJobs((Priority) priority);
+    }
+    return total;
+}
+
+//this function goes through the classes most urgent first and takes a job from the first one that has a free place
+bool JobScheduler::takeJob(Worker& worker, Entry& entry, Priority& priority)
+{
+    for (int candidate = 0; candidate < numPriorities; ++candidate) {
+        if (numWaiting[candidate].load() == 0 || !claimPlace((Priority) candidate)) {
+            continue;
+        }
+
+        if (takeFrom(worker, (Priority) candidate, entry)) {
+            priority = (Priority) candidate;
+            return true;
+        }
+
+        //another worker took the job first
+        releasePlace((Priority) candidate);
+    }
+    return false;
+}
+
+//this function claims a place in the class with a compare-and-swap, so two workers cannot both take the last free place
+bool JobScheduler::claimPlace(Priority priority)
+{
+    uint64 running = numRunning.load();
+
+    while (true) {
+        //the limit counts the jobs of this class and of every class below it
+        int used = 0;
+        for (int below = (int) priority; below < numPriorities; ++below) {
+            used += getRunning(running, below);
+        }
+        if (used >= limits[(int) priority].load()) {
+            return false;
+        }
+
+        if (numRunning.compare_exchange_weak(running, running + ((uint64) 1 << ((int) priority * runningBits)))) {
+            return true;
+        }
+    }
+}
+
+//this function gives a place in the class back
+void JobScheduler::releasePlace(Priority priority)
+{
+    numRunning -= (uint64) 1 << ((int) priority * runningBits);
+}
+
+//this function takes a job of the class from the worker's own queue or steals one from the others, starting with the next worker
+bool JobScheduler::takeFrom(Worker& worker, Priority priority, Entry& entry)
+{
+    int numWorkers = workers.size();
+
+    for (int offset = 0; offset < numWorkers; ++offset) {
+        Worker* victim = workers[(worker.index + offset) % numWorkers];
+        bool own = victim == &worker;
+
+        //both workers stay locked until the job is marked as running, so a cancel that locks every worker finds it in one place or
+        //the other. the two locks are taken in the order of the workers, so two workers stealing from each other cannot deadlock
+        Worker* first = victim->index < worker.index ? victim : &worker;
+        Worker* second = victim->index < worker.index ? &worker : victim;
+        const ScopedLock firstLock(first->lock);
+        const ScopedLock secondLock(second->lock);
+
+        auto& queue = victim->queues[(int) priority];
+        if (queue.empty()) {
+            continue;
+        }
+
+        //the owner works from the front and thieves from the back, so they rarely want the same job
+        if (own) {
+            entry = queue.front();
+            queue.pop_front();
+        }
+        else {
+            entry = queue.back();
+            queue.pop_back();
+        }
+        --numWaiting[(int) priority];
+        worker.current = entry;
+        return true;
+    }
+    return false;
+}
+
+//this function puts a job that wants to run again back in the queue, or deletes it, and frees its place in the class
+void JobScheduler::finishJob(Worker& worker, const Entry& entry, Priority priority, ThreadPoolJob::JobStatus status)
+{
+    bool again = status == ThreadPoolJob::jobNeedsRunningAgain && !entry.job->shouldExit();
+    {
+        //the place is given back with the worker locked, so a cancel never sees the job gone while it still counts
+        const ScopedLock sl(worker.lock);
+        worker.current = {};
+        releasePlace(priority);
+        if (again) {
+            worker.queues[(int) priority].push_back(entry);
+            ++numWaiting[(int) priority];
+        }
+    }
+
+    if (!again && entry.deleteWhenFinished) {
+        delete entry.job;
+    }
+
+    jobFinished.signal();
+
+    //this worker looks at the queues again itself, another one is woken in case the place that came free is one it can use
+    wakeWorker();
+}
+
+//this function wakes the first idle worker, the others stay asleep until there is more to do
+void JobScheduler::wakeWorker()
+{
+    for (auto* worker : workers) {
+        if (worker->idle.exchange(false)) {
+            worker->wake.signal();
+            return;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*====================================================================
+JobScheduler.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+
+//this class runs the background jobs of the app (track loads, waveform builds and library analysis) on one set of worker threads, so
+//they share the CPU and the disk instead of every part having a pool of its own. each job is in a priority class and a worker always
+//takes the most urgent job it is allowed to run, from its own queue first and otherwise stolen from another worker. every class has a
+//limit on the workers it may use that also counts the classes below it, so bulk work always leaves a worker free for a deck, and a
+//worker runs a deck's job at normal priority and the rest at low. the jobs are ordinary ThreadPoolJobs, and they can be cancelled one
+//at a time or all the jobs of an owner at once
+class JobScheduler
+{
+public:
+    //the classes, most urgent first
+    enum class Priority
+    {
+        deck,      //the track a deck is loading, its waveform and its analysis
+        visible,   //the tracks on the playlist rows on screen
+        library    //bulk work on the rest of the library
+    };
+
+    static constexpr int numPriorities = 3;
+
+    //there are at least 2 workers, so one can be kept for the decks
+    JobScheduler(int numWorkers = SystemStats::getNumCpus());
+    ~JobScheduler();
+
+    int getNumWorkers() const;
+
+    //the most workers the class and the classes below it may use at once, from 1 to the number of workers. by default bulk work
+    //uses half of them and the rows on screen all but one
+    void setConcurrencyLimit(Priority priority, int maxWorkers);
+    int getConcurrencyLimit(Priority priority) const;
+
+    //queues a job. owner is any pointer the caller cancels its jobs with, the job is deleted once it has finished if
+    //deleteWhenFinished. a job that was asked to stop cannot be added again, its shouldExit stays true
+    void addJob(ThreadPoolJob* job, Priority priority, const void* owner, bool deleteWhenFinished);
+
+    //moves a job that has not started to another class, returns false if it is running or already gone
+    bool setPriority(ThreadPoolJob* job, Priority priority);
+
+    //takes a job out of the queue, or asks it to stop if it is running and waits up to timeoutMs for it. returns false if it is
+    //still running
+    bool removeJob(ThreadPoolJob* job, bool interruptIfRunning, int timeoutMs);
+
+    //does the same for every job of the owner, e.g. the load of a track the user has replaced with another one
+    bool removeJobs(const void* owner, int timeoutMs);
+
+    //waits up to timeoutMs until the job is neither waiting nor running, returns false if it is still there
+    bool waitForJobToFinish(const ThreadPoolJob* job, int timeoutMs) const;
+
+    //the jobs waiting or running, in one class or in all of them
+    int getNumJobs(Priority priority) const;
+    int getNumJobs() const;
+
+private:
+    class Worker;
+    class AllWorkersLock;
+
+    struct Entry
+    {
+        ThreadPoolJob* job = nullptr;
+        const void* owner = nullptr;
+        bool deleteWhenFinished = false;
+    };
+
+    //takes the next job the worker may run and marks it as running there, false if there is none
+    bool takeJob(Worker& worker, Entry& entry, Priority& priority);
+
+    //claims a place in the class if its limit is not used up, and gives it back
+    bool claimPlace(Priority priority);
+    void releasePlace(Priority priority);
+
+    //takes the oldest job of the class from the worker's own queue or the newest one of another worker, with a place in the class claimed
+    bool takeFrom(Worker& worker, Priority priority, Entry& entry);
+
+    //called by the worker once runJob returns
+    void finishJob(Worker& worker, const Entry& entry, Priority priority, ThreadPoolJob::JobStatus status);
+
+    //removes the waiting jobs that match the test and asks the running ones to stop, then waits for them. a job that asked to run
+    //again is taken out of its queue on the next look
+    bool removeMatching(const std::function<bool(const Entry&)>& test, bool interruptIfRunning, int timeoutMs);
+
+    //wakes one idle worker to look at the queues
+    void wakeWorker();
+
+    OwnedArray<Worker> workers;
+    std::atomic<int> nextWorker{ 0 };
+
+    std::atomic<int> limits[numPriorities];
+    std::atomic<int> numWaiting[numPriorities];
+
+    //the running jobs of every class packed in one word, so a worker checks a limit and claims a place with one compare-and-swap
+    //instead of a lock shared by every worker
+    std::atomic<uint64> numRunning{ 0 };
+
+    //signalled whenever a job finishes, for removeJob and waitForJobToFinish to wait on
+    WaitableEvent jobFinished;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JobScheduler)
+};
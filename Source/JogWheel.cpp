@@ -0,0 +1,117 @@
+/*====================================================================
+JogWheel.cpp
+This class turns mouse drags on the platter into scratch velocities. Each drag event gives the angle moved since the last one, which
+is turned into seconds of audio and divided by the time between the events. The player ramps to each new velocity over one audio
+block, so the movement is heard within a block without clicks.
+====================================================================*/
+
+
+#include "JogWheel.h"
+#include <cmath>
+
+//if no drag arrives for this long the hand is holding the platter still
+static constexpr double holdSeconds = 0.03;
+
+JogWheel::JogWheel(DJAudioPlayer& _player)
+    : player(_player)
+{
+    startTimerHz(60);
+}
+
+JogWheel::~JogWheel()
+{
+    stopTimer();
+}
+
+//this function draws the platter with a marker that turns with the track
+void JogWheel::paint(Graphics& g)
+{
+    auto area = getLocalBounds().toFloat().reduced(2.0f);
+    float size = jmin(area.getWidth(), area.getHeight());
+    auto platter = area.withSizeKeepingCentre(size, size);
+    auto centre = platter.getCentre();
+    float radius = size * 0.5f;
+
+    //the record
+    g.setColour(Colours::black);
+    g.fillEllipse(platter);
+    g.setColour(Colours::darkgrey);
+    for (float groove = 0.55f; groove < 0.95f; groove += 0.1f) {
+        g.drawEllipse(platter.withSizeKeepingCentre(size * groove, size * groove), 1.0f);
+    }
+
+    //the label, darkcyan while the record is held
+    g.setColour(player.isScratching() ? Colours::darkcyan : Colour::fromRGB(39, 55, 77));
+    g.fillEllipse(platter.withSizeKeepingCentre(size * 0.35f, size * 0.35f));
+
+    //the marker
+    Path marker;
+    marker.addRoundedRectangle(-2.0f, -radius + 3.0f, 4.0f, radius * 0.4f, 2.0f);
+    g.setColour(Colours::white);
+    g.fillPath(marker, AffineTransform::rotation(drawnAngle).translated(centre.x, centre.y));
+}
+
+//this function takes hold of the record
+void JogWheel::mouseDown(const MouseEvent& e)
+{
+    lastAngle = getAngle(e.position);
+    lastDragSeconds = Time::getMillisecondCounterHiRes() / 1000.0;
+    velocity = 0.0;
+    player.beginScratch();
+}
+
+//this function moves the record with the hand
+void JogWheel::mouseDrag(const MouseEvent& e)
+{
+    double now = Time::getMillisecondCounterHiRes() / 1000.0;
+    double elapsed = now - lastDragSeconds;
+    if (elapsed < 0.001) {
+        return;
+    }
+
+    //the shortest way round from the last angle
+    float angle = getAngle(e.position);
+    float moved = angle - lastAngle;
+    if (moved > MathConstants<float>::pi) {
+        moved -= MathConstants<float>::twoPi;
+    }
+    else if (moved < -MathConstants<float>::pi) {
+        moved += MathConstants<float>::twoPi;
+    }
+
+    //averages with the last velocity a little, the mouse reports positions unevenly
+    double rate = moved / MathConstants<double>::twoPi * ScratchEngine::secondsPerTurn / elapsed;
+    velocity = 0.5 * velocity + 0.5 * rate;
+    player.setScratchVelocity(velocity);
+
+    lastAngle = angle;
+    lastDragSeconds = now;
+}
+
+//this function lets go of the record
+void JogWheel::mouseUp(const MouseEvent&)
+{
+    velocity = 0.0;
+    player.endScratch();
+    repaint();
+}
+
+void JogWheel::timerCallback()
+{
+    if (player.isScratching() && velocity != 0.0 && Time::getMillisecondCounterHiRes() / 1000.0 - lastDragSeconds > holdSeconds) {
+        velocity = 0.0;
+        player.setScratchVelocity(0.0);
+    }
+
+    float angle = (float) std::fmod(player.getPosition() * player.getLength() / ScratchEngine::secondsPerTurn, 1.0) * MathConstants<float>::twoPi;
+    if (std::isfinite(angle) && angle != drawnAngle) {
+        drawnAngle = angle;
+        repaint();
+    }
+}
+
+float JogWheel::getAngle(Point<float> position) const
+{
+    auto centre = getLocalBounds().toFloat().getCentre();
+    return std::atan2(position.x - centre.x, centre.y - position.y);
+}
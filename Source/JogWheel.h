@@ -0,0 +1,42 @@
+/*====================================================================
+JogWheel.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+
+//this class draws the platter of a deck and scratches the track when it is dragged round. the speed of the drag is sent to the player
+//as a scratch velocity, and holding the platter still stops the record
+class JogWheel : public Component,
+                 public Timer
+{
+public:
+    JogWheel(DJAudioPlayer& player);
+    ~JogWheel() override;
+
+    void paint(Graphics& g) override;
+
+    void mouseDown(const MouseEvent& e) override;
+    void mouseDrag(const MouseEvent& e) override;
+    void mouseUp(const MouseEvent& e) override;
+
+    //stops the record when the platter is held still and turns the drawing with the track
+    void timerCallback() override;
+
+private:
+    //the angle of a point around the centre of the platter
+    float getAngle(Point<float> position) const;
+
+    DJAudioPlayer& player;
+
+    float lastAngle = 0.0f;
+    double lastDragSeconds = 0.0;
+    double velocity = 0.0;
+
+    //the angle the platter was last drawn at
+    float drawnAngle = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JogWheel)
+};
@@ -0,0 +1,162 @@
+/*====================================================================
+KeyDetector.cpp
+This class builds a chromagram of a track with juce::dsp::FFT and compares it with the Krumhansl-Kessler key profiles to pick the
+most likely key.
+====================================================================*/
+
+
+#include "KeyDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const double majorProfile[12] = { 6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88 };
+    const double minorProfile[12] = { 6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17 };
+
+    const char* const noteNames[12] = { "C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B" };
+
+    //pearson correlation between the chroma and a profile rotated to the given tonic
+    double correlate(const double* chroma, const double* profile, int tonic)
+    {
+        double meanChroma = 0.0, meanProfile = 0.0;
+        for (int i = 0; i < 12; ++i) {
+            meanChroma += chroma[i] / 12.0;
+            meanProfile += profile[i] / 12.0;
+        }
+
+        double covariance = 0.0, chromaVariance = 0.0, profileVariance = 0.0;
+        for (int i = 0; i < 12; ++i) {
+            double c = chroma[(i + tonic) % 12] - meanChroma;
+            double p = profile[i] - meanProfile;
+            covariance += c * p;
+            chromaVariance += c * c;
+            profileVariance += p * p;
+        }
+
+        return covariance / std::sqrt(chromaVariance * profileVariance + 1.0e-12);
+    }
+}
+
+KeyDetector::KeyDetector(double sampleRate)
+    : frameBuffer((size_t) fftSize, 0.0f),
+      fftData((size_t) fftSize * 2, 0.0f),
+      binPitchClass((size_t) fftSize / 2, -1)
+{
+    //only bins between about 80Hz and 2kHz are used, below that the bins are wider than a semitone
+    for (int bin = 1; bin < fftSize / 2; ++bin) {
+        double frequency = bin * sampleRate / fftSize;
+        if (frequency >= 80.0 && frequency <= 2000.0) {
+            int midiNote = roundToInt(12.0 * std::log2(frequency / 440.0) + 69.0);
+            binPitchClass[(size_t) bin] = midiNote % 12;
+        }
+    }
+}
+
+//this function collects samples into overlapping frames and analyses every complete frame
+void KeyDetector::pushSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        int toCopy = jmin(numSamples, fftSize - samplesInFrame);
+        std::copy(samples, samples + toCopy, frameBuffer.begin() + samplesInFrame);
+
+        samplesInFrame += toCopy;
+        samples += toCopy;
+        numSamples -= toCopy;
+
+        if (samplesInFrame == fftSize) {
+            processFrame();
+
+            std::copy(frameBuffer.begin() + hopSize, frameBuffer.end(), frameBuffer.begin());
+            samplesInFrame = fftSize - hopSize;
+        }
+    }
+}
+
+//this function adds the normalised chroma of one frame to the running totals
+void KeyDetector::processFrame()
+{
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    std::copy(frameBuffer.begin(), frameBuffer.end(), fftData.begin());
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    double frameChroma[12] = {};
+    double total = 0.0;
+
+    for (size_t bin = 0; bin < binPitchClass.size(); ++bin) {
+        if (binPitchClass[bin] >= 0) {
+            double energy = (double) fftData[bin] * fftData[bin];
+            frameChroma[binPitchClass[bin]] += energy;
+            total += energy;
+        }
+    }
+
+    //silent frames are skipped, every other frame counts the same however loud it is
+    if (total < 1.0e-6) {
+        return;
+    }
+
+    for (int i = 0; i < 12; ++i) {
+        chroma[i] += frameChroma[i] / total;
+    }
+}
+
+//this function tries all 24 keys and returns the one whose profile correlates best with the chroma
+int KeyDetector::getKey() const
+{
+    if (*std::max_element(chroma, chroma + 12) <= 0.0) {
+        return -1;
+    }
+
+    int bestKey = -1;
+    double bestScore = -2.0;
+
+    for (int tonic = 0; tonic < 12; ++tonic) {
+        double majorScore = correlate(chroma, majorProfile, tonic);
+        double minorScore = correlate(chroma, minorProfile, tonic);
+
+        if (majorScore > bestScore) {
+            bestScore = majorScore;
+            bestKey = tonic;
+        }
+        if (minorScore > bestScore) {
+            bestScore = minorScore;
+            bestKey = tonic + 12;
+        }
+    }
+
+    return bestKey;
+}
+
+//this function returns the number (1-12) of the key on the Camelot wheel, minor keys share the number of their relative major
+int KeyDetector::getCamelotNumber(int key)
+{
+    if (key < 0) {
+        return 0;
+    }
+
+    int majorTonic = isMinor(key) ? (key - 12 + 3) % 12 : key;
+    return (majorTonic * 7 + 7) % 12 + 1;
+}
+
+//this function returns the Camelot code of a key such as "8A" for A minor or "8B" for C major
+String KeyDetector::getCamelotName(int key)
+{
+    if (key < 0) {
+        return {};
+    }
+
+    return String(getCamelotNumber(key)) + (isMinor(key) ? "A" : "B");
+}
+
+//this function returns the usual name of a key such as "Am" or "C"
+String KeyDetector::getKeyName(int key)
+{
+    if (key < 0) {
+        return {};
+    }
+
+    return String(noteNames[key % 12]) + (isMinor(key) ? "m" : "");
+}
@@ -0,0 +1,46 @@
+/*====================================================================
+KeyDetector.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <vector>
+
+//this class estimates the musical key of a track from a chromagram. the chroma of every frame is added into 12 running totals, so memory stays the same for any track length.
+//keys are numbered 0-11 for C major to B major and 12-23 for C minor to B minor, -1 means unknown
+class KeyDetector
+{
+public:
+    KeyDetector(double sampleRate);
+
+    void pushSamples(const float* samples, int numSamples);
+
+    //returns the key that best matches the chroma collected so far
+    int getKey() const;
+
+    //helpers to show a key to the user in the Camelot wheel notation DJs use (e.g. "8A")
+    static int getCamelotNumber(int key);
+    static bool isMinor(int key) { return key >= 12; }
+    static String getCamelotName(int key);
+    static String getKeyName(int key);
+
+private:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+
+    void processFrame();
+
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+
+    std::vector<float> frameBuffer;
+    std::vector<float> fftData;
+    int samplesInFrame = 0;
+
+    //pitch class of every fft bin that is used, -1 for bins outside the range
+    std::vector<int> binPitchClass;
+
+    double chroma[12] = {};
+};
@@ -0,0 +1,165 @@
+/*====================================================================
+LevelMeter.cpp
+This class meters a block in one pass per channel. The peak comes from FloatVectorOperations::findMinAndMax and the RMS from a sum of
+squares, both whole-block reductions. The K-weighted copy for the loudness goes through the same two filter stages as the
+LoudnessAnalyser, and its energy is kept in 100 ms steps, so the short-term loudness is the mean of the last 30 steps.
+====================================================================*/
+
+
+#include "LevelMeter.h"
+#include "LoudnessAnalyser.h"
+#include <cmath>
+
+LevelMeter::LevelMeter()
+{
+    for (int channel = 0; channel < 2; ++channel) {
+        publishedPeak[channel] = 0.0f;
+        publishedMeanSquare[channel] = 0.0f;
+    }
+}
+
+LevelMeter::~LevelMeter()
+{
+}
+
+//this function sets up the filters and the steps for the device rate
+void LevelMeter::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = jmax(1, samplesPerBlockExpected);
+    weighted.allocate((size_t) maxBlockSize, true);
+
+    auto shelf = LoudnessAnalyser::makeKWeightingShelf(sampleRate);
+    auto highPass = LoudnessAnalyser::makeKWeightingHighPass(sampleRate);
+    for (int channel = 0; channel < 2; ++channel) {
+        shelfFilters[channel].coefficients = shelf;
+        highPassFilters[channel].coefficients = highPass;
+
+        //sizes the filter state here, otherwise the first process call allocates it on the audio thread
+        shelfFilters[channel].reset();
+        highPassFilters[channel].reset();
+
+        peak[channel] = 0.0f;
+        meanSquare[channel] = 0.0f;
+        publishedPeak[channel] = 0.0f;
+        publishedMeanSquare[channel] = 0.0f;
+    }
+
+    samplesPerStep = jmax(1, roundToInt(sampleRate * shortTermSeconds / numShortTermSteps));
+    samplesInStep = 0;
+    stepSum = 0.0;
+    for (double& step : stepMeanSquares) {
+        step = 0.0;
+    }
+    stepPosition = 0;
+    numSteps = 0;
+    publishedShortTerm = 0.0;
+}
+
+//this function splits the block at the work buffer size and at the 100 ms steps, then publishes the levels
+void LevelMeter::process(const AudioSourceChannelInfo& bufferToFill)
+{
+    if (maxBlockSize == 0 || bufferToFill.buffer->getNumChannels() == 0) {
+        return;
+    }
+
+    int numChannels = jmin(2, bufferToFill.buffer->getNumChannels());
+    const float* channels[2] = {};
+
+    for (int done = 0; done < bufferToFill.numSamples;) {
+        int chunk = jmin(maxBlockSize, bufferToFill.numSamples - done, samplesPerStep - samplesInStep);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            channels[channel] = bufferToFill.buffer->getReadPointer(channel, bufferToFill.startSample + done);
+        }
+
+        processChunk(channels, numChannels, chunk);
+        done += chunk;
+    }
+
+    //a mono block shows the same level on both sides
+    for (int channel = 0; channel < 2; ++channel) {
+        int source = jmin(channel, numChannels - 1);
+        publishedPeak[channel] = peak[source];
+        publishedMeanSquare[channel] = meanSquare[source];
+    }
+}
+
+//this function measures one chunk and finishes a step when the chunk reaches its end
+void LevelMeter::processChunk(const float* const* channels, int numChannels, int numSamples)
+{
+    //how far the held peak falls and how much of the new mean square goes into the RMS over this chunk
+    float fall = (float) std::exp(-peakFallDbPerSecond * MathConstants<double>::ln10 / 20.0 * numSamples / sampleRate);
+    float follow = (float) (1.0 - std::exp(-numSamples / (rmsSeconds * sampleRate)));
+
+    float* weightedChannels[1] = { weighted.get() };
+    juce::dsp::AudioBlock<float> weightedBlock(weightedChannels, 1, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> weightedContext(weightedBlock);
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        auto range = FloatVectorOperations::findMinAndMax(channels[channel], numSamples);
+        float chunkPeak = jmax(-range.getStart(), range.getEnd());
+        peak[channel] = jmax(chunkPeak, peak[channel] * fall);
+
+        float chunkMeanSquare = (float) (sumOfSquares(channels[channel], numSamples) / numSamples);
+        meanSquare[channel] += (chunkMeanSquare - meanSquare[channel]) * follow;
+
+        //left and right have a weight of 1 in the loudness
+        FloatVectorOperations::copy(weighted.get(), channels[channel], numSamples);
+        shelfFilters[channel].process(weightedContext);
+        highPassFilters[channel].process(weightedContext);
+        stepSum += sumOfSquares(weighted.get(), numSamples);
+    }
+
+    samplesInStep += numSamples;
+    if (samplesInStep < samplesPerStep) {
+        return;
+    }
+
+    stepMeanSquares[stepPosition] = stepSum / samplesPerStep;
+    stepPosition = (stepPosition + 1) % numShortTermSteps;
+    numSteps = jmin(numSteps + 1, numShortTermSteps);
+    stepSum = 0.0;
+    samplesInStep = 0;
+
+    //until 3 s have been heard the window is as long as what there is
+    double sum = 0.0;
+    for (int step = 0; step < numSteps; ++step) {
+        sum += stepMeanSquares[step];
+    }
+    publishedShortTerm = sum / numSteps;
+}
+
+//this function adds up the squares of a block
+double LevelMeter::sumOfSquares(const float* data, int numSamples)
+{
+    float sums[4] = {};
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4) {
+        sums[0] += data[i] * data[i];
+        sums[1] += data[i + 1] * data[i + 1];
+        sums[2] += data[i + 2] * data[i + 2];
+        sums[3] += data[i + 3] * data[i + 3];
+    }
+    for (; i < numSamples; ++i) {
+        sums[0] += data[i] * data[i];
+    }
+
+    return (double) sums[0] + sums[1] + sums[2] + sums[3];
+}
+
+//this function turns the published gains and mean squares into decibels and LUFS
+LevelMeter::Levels LevelMeter::getLevels() const
+{
+    Levels levels;
+
+    for (int channel = 0; channel < 2; ++channel) {
+        levels.peakDb[channel] = Decibels::gainToDecibels(publishedPeak[channel].load(), floorDb);
+        levels.rmsDb[channel] = Decibels::gainToDecibels(std::sqrt(publishedMeanSquare[channel].load()), floorDb);
+    }
+
+    double shortTerm = publishedShortTerm.load();
+    levels.shortTermLufs = shortTerm > 0.0 ? jmax(floorDb, (float) LoudnessAnalyser::meanSquareToLoudness(shortTerm)) : floorDb;
+
+    return levels;
+}
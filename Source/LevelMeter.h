@@ -0,0 +1,79 @@
+/*====================================================================
+LevelMeter.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class measures the level of a deck or of the master on the audio thread: the peak and RMS of each channel and the short-term
+//loudness (3 s, EBU R128) of both together. the audio thread only does block reductions and stores plain gains and mean squares in
+//atomics, the decibels are worked out by whoever reads them, so there are no locks and no logs in the callback
+class LevelMeter
+{
+public:
+    //how fast the published peak falls back, and how long the RMS is averaged over
+    static constexpr float peakFallDbPerSecond = 20.0f;
+    static constexpr double rmsSeconds = 0.3;
+
+    //the short-term loudness window, made of 100 ms steps
+    static constexpr double shortTermSeconds = 3.0;
+    static constexpr int numShortTermSteps = 30;
+
+    //the quietest level reported, silence reads as this
+    static constexpr float floorDb = -100.0f;
+
+    //the levels in decibels, as read by the GUI
+    struct Levels
+    {
+        float peakDb[2] = { floorDb, floorDb };
+        float rmsDb[2] = { floorDb, floorDb };
+        float shortTermLufs = floorDb;
+    };
+
+    LevelMeter();
+    ~LevelMeter();
+
+    //makes the K-weighting filters for the device rate and allocates the work buffer
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    //measures the block without changing it, called on the audio thread after everything that changes the sound
+    void process(const AudioSourceChannelInfo& bufferToFill);
+
+    //the latest levels, from any thread
+    Levels getLevels() const;
+
+private:
+    //measures one chunk that fits in the work buffer and does not cross a 100 ms step
+    void processChunk(const float* const* channels, int numChannels, int numSamples);
+
+    //the sum of the squares of a block, with four partial sums so the adds do not wait on each other
+    static double sumOfSquares(const float* data, int numSamples);
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+
+    juce::dsp::IIR::Filter<float> shelfFilters[2];
+    juce::dsp::IIR::Filter<float> highPassFilters[2];
+    HeapBlock<float> weighted;
+
+    //the peak and RMS as the audio thread keeps them, as gains and mean squares
+    float peak[2] = {};
+    float meanSquare[2] = {};
+
+    //the K-weighted energy of the step being filled and of the last numShortTermSteps steps
+    int samplesPerStep = 1;
+    int samplesInStep = 0;
+    double stepSum = 0.0;
+    double stepMeanSquares[numShortTermSteps] = {};
+    int stepPosition = 0;
+    int numSteps = 0;
+
+    //what is published for the GUI
+    std::atomic<float> publishedPeak[2];
+    std::atomic<float> publishedMeanSquare[2];
+    std::atomic<double> publishedShortTerm{ 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+};
@@ -0,0 +1,93 @@
+/*====================================================================
+LevelMeterComponent.cpp
+This class polls a LevelMeter on a 30 Hz timer. Reading the meter is only a few atomic loads, so the audio thread never waits for the
+GUI. The peak hold is kept here: a new peak raises the line at once, and it falls back to the live peak once it has been held for a
+moment.
+====================================================================*/
+
+
+#include "LevelMeterComponent.h"
+
+LevelMeterComponent::LevelMeterComponent(LevelMeter& _meter)
+    : meter(_meter)
+{
+    startTimerHz(30);
+}
+
+LevelMeterComponent::~LevelMeterComponent()
+{
+    stopTimer();
+}
+
+//this function draws the bars, the hold lines and the loudness
+void LevelMeterComponent::paint(Graphics& g)
+{
+    auto area = getLocalBounds().toFloat();
+    bool vertical = area.getHeight() > area.getWidth();
+
+    //the loudness goes under a vertical meter and to the right of a horizontal one
+    auto textArea = vertical ? area.removeFromBottom(jmin(14.0f, area.getHeight() / 6.0f))
+                             : area.removeFromRight(jmin(70.0f, area.getWidth() / 4.0f));
+
+    for (int channel = 0; channel < 2; ++channel) {
+        auto bar = vertical ? area.withWidth(area.getWidth() / 2.0f).translated(channel * area.getWidth() / 2.0f, 0.0f).reduced(1.0f, 0.0f)
+                            : area.withHeight(area.getHeight() / 2.0f).translated(0.0f, channel * area.getHeight() / 2.0f).reduced(0.0f, 1.0f);
+
+        //the part of the bar up to a level
+        auto upTo = [&](float db)
+        {
+            float proportion = toProportion(db);
+            return vertical ? bar.withTop(bar.getBottom() - bar.getHeight() * proportion)
+                            : bar.withWidth(bar.getWidth() * proportion);
+        };
+
+        g.setColour(Colours::black);
+        g.fillRect(bar);
+
+        g.setColour(Colour::fromRGB(161, 227, 249).withAlpha(0.5f));
+        g.fillRect(upTo(levels.peakDb[channel]));
+
+        g.setColour(levels.rmsDb[channel] > -6.0f ? Colours::orange : Colours::darkcyan);
+        g.fillRect(upTo(levels.rmsDb[channel]));
+
+        //the hold line turns red at the limiter's ceiling
+        if (heldPeakDb[channel] > minimumDb) {
+            auto held = upTo(heldPeakDb[channel]);
+            g.setColour(heldPeakDb[channel] >= -1.0f ? Colours::red : Colours::white);
+            if (vertical) {
+                g.fillRect(bar.getX(), held.getY(), bar.getWidth(), 2.0f);
+            }
+            else {
+                g.fillRect(held.getRight() - 2.0f, bar.getY(), 2.0f, bar.getHeight());
+            }
+        }
+    }
+
+    //below the absolute gate there is nothing worth showing, a narrow vertical meter only has room for the number
+    g.setColour(Colours::white);
+    g.setFont(jmin(textArea.getHeight() * 0.8f, 14.0f));
+    String loudness = levels.shortTermLufs > -70.0f ? String(levels.shortTermLufs, 1) : String("-");
+    g.drawFittedText(vertical ? loudness : loudness + " LUFS", textArea.toNearestInt(), Justification::centred, 1, 0.5f);
+}
+
+//this function reads the latest levels and raises or drops the hold lines
+void LevelMeterComponent::timerCallback()
+{
+    levels = meter.getLevels();
+    double now = Time::getMillisecondCounterHiRes() / 1000.0;
+
+    for (int channel = 0; channel < 2; ++channel) {
+        if (levels.peakDb[channel] >= heldPeakDb[channel] || now - heldSince[channel] > holdSeconds) {
+            heldPeakDb[channel] = levels.peakDb[channel];
+            heldSince[channel] = now;
+        }
+    }
+
+    repaint();
+}
+
+//this function maps a level to the bar
+float LevelMeterComponent::toProportion(float db)
+{
+    return jlimit(0.0f, 1.0f, (db - minimumDb) / (maximumDb - minimumDb));
+}
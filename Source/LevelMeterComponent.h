@@ -0,0 +1,43 @@
+/*====================================================================
+LevelMeterComponent.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "LevelMeter.h"
+
+//this class draws a LevelMeter: a bar for each channel with the RMS filled in, the peak above it and a peak hold line, and the
+//short-term loudness as a number. it is vertical when it is taller than it is wide and horizontal otherwise, and redraws at 30 fps
+class LevelMeterComponent : public Component,
+                            public Timer
+{
+public:
+    //the range the bars cover
+    static constexpr float minimumDb = -48.0f;
+    static constexpr float maximumDb = 0.0f;
+
+    //how long a peak hold line stays before it falls to the peak
+    static constexpr double holdSeconds = 1.5;
+
+    LevelMeterComponent(LevelMeter& meter);
+    ~LevelMeterComponent() override;
+
+    void paint(Graphics& g) override;
+
+    //reads the meter and moves the peak hold
+    void timerCallback() override;
+
+private:
+    //how far along a bar a level is, from 0 to 1
+    static float toProportion(float db);
+
+    LevelMeter& meter;
+    LevelMeter::Levels levels;
+
+    //the held peaks and when they were last raised
+    float heldPeakDb[2] = { LevelMeter::floorDb, LevelMeter::floorDb };
+    double heldSince[2] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterComponent)
+};
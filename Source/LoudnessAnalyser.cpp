@@ -0,0 +1,122 @@
+/*====================================================================
+LoudnessAnalyser.cpp
+This class works out the loudness of a whole track while it is decoded. The K-weighting filters run per channel at the track's own
+sample rate, the energy is summed in 100 ms steps and every four steps make one gating block, so only one number per block is kept.
+====================================================================*/
+
+
+#include "LoudnessAnalyser.h"
+#include <cmath>
+
+LoudnessAnalyser::LoudnessAnalyser(double sampleRate, int _numChannels)
+    : numChannels(jmax(1, _numChannels)),
+      samplesPerStep(jmax(1, roundToInt(sampleRate * 0.1)))
+{
+    auto shelf = makeKWeightingShelf(sampleRate);
+    auto highPass = makeKWeightingHighPass(sampleRate);
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        shelfFilters.add(new juce::dsp::IIR::Filter<float>(shelf));
+        highPassFilters.add(new juce::dsp::IIR::Filter<float>(highPass));
+    }
+}
+
+//this function filters a block and adds its energy to the 100 ms steps, finishing a 400 ms block at every step
+void LoudnessAnalyser::process(const AudioBuffer<float>& block, int numSamples)
+{
+    int channelsToUse = jmin(numChannels, block.getNumChannels());
+
+    for (int i = 0; i < numSamples; ++i) {
+        //left and right (and any other channel of a stereo or mono file) have a weight of 1
+        double energy = 0.0;
+        for (int channel = 0; channel < channelsToUse; ++channel) {
+            float weighted = highPassFilters[channel]->processSample(shelfFilters[channel]->processSample(block.getSample(channel, i)));
+            energy += (double) weighted * weighted;
+        }
+        stepSum += energy;
+
+        if (++samplesInStep == samplesPerStep) {
+            double stepMeanSquare = stepSum / samplesPerStep;
+
+            if (numSteps >= 3) {
+                blockMeanSquares.push_back((previousSteps[0] + previousSteps[1] + previousSteps[2] + stepMeanSquare) * 0.25);
+            }
+
+            previousSteps[0] = previousSteps[1];
+            previousSteps[1] = previousSteps[2];
+            previousSteps[2] = stepMeanSquare;
+            ++numSteps;
+
+            stepSum = 0.0;
+            samplesInStep = 0;
+        }
+    }
+}
+
+//this function applies the absolute and relative gates to the blocks and returns the loudness of what is left
+double LoudnessAnalyser::getIntegratedLoudness() const
+{
+    const double absoluteGate = -70.0;
+
+    double sum = 0.0;
+    int count = 0;
+    for (double meanSquare : blockMeanSquares) {
+        if (meanSquareToLoudness(meanSquare) > absoluteGate) {
+            sum += meanSquare;
+            ++count;
+        }
+    }
+
+    if (count == 0) {
+        return absoluteGate;
+    }
+
+    double relativeGate = meanSquareToLoudness(sum / count) - 10.0;
+
+    sum = 0.0;
+    count = 0;
+    for (double meanSquare : blockMeanSquares) {
+        double loudness = meanSquareToLoudness(meanSquare);
+        if (loudness > absoluteGate && loudness > relativeGate) {
+            sum += meanSquare;
+            ++count;
+        }
+    }
+
+    return count > 0 ? meanSquareToLoudness(sum / count) : absoluteGate;
+}
+
+//this function makes the first K-weighting stage, the high shelf that models the head, for any sample rate
+juce::dsp::IIR::Coefficients<float>::Ptr LoudnessAnalyser::makeKWeightingShelf(double sampleRate)
+{
+    const double frequency = 1681.974450955533;
+    const double gainDb = 3.999843853973347;
+    const double q = 0.7071752369554196;
+
+    double k = std::tan(MathConstants<double>::pi * frequency / sampleRate);
+    double vh = std::pow(10.0, gainDb / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+
+    return new juce::dsp::IIR::Coefficients<float>((float) (vh + vb * k / q + k * k), (float) (2.0 * (k * k - vh)), (float) (vh - vb * k / q + k * k),
+                                                   (float) (1.0 + k / q + k * k), (float) (2.0 * (k * k - 1.0)), (float) (1.0 - k / q + k * k));
+}
+
+//this function makes the second K-weighting stage, the high-pass, for any sample rate
+juce::dsp::IIR::Coefficients<float>::Ptr LoudnessAnalyser::makeKWeightingHighPass(double sampleRate)
+{
+    const double frequency = 38.13547087602444;
+    const double q = 0.5003270373238773;
+
+    double k = std::tan(MathConstants<double>::pi * frequency / sampleRate);
+    double a0 = 1.0 + k / q + k * k;
+
+    //the numerator is 1, -2, 1 before normalising, so it is scaled by a0 because the constructor divides everything by it
+    return new juce::dsp::IIR::Coefficients<float>((float) a0, (float) (-2.0 * a0), (float) a0,
+                                                   (float) a0, (float) (2.0 * (k * k - 1.0)), (float) (1.0 - k / q + k * k));
+}
+
+//this function turns a K-weighted mean square into LUFS
+double LoudnessAnalyser::meanSquareToLoudness(double meanSquare)
+{
+    return -0.691 + 10.0 * std::log10(jmax(meanSquare, 1.0e-12));
+}
@@ -0,0 +1,47 @@
+/*====================================================================
+LoudnessAnalyser.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <vector>
+
+//this class measures the integrated loudness of a track in LUFS (ITU-R BS.1770 / EBU R128): K-weighted mean square over 400 ms blocks
+//with 75% overlap, gated at -70 LUFS and then at 10 LU below the loudness of the blocks that passed the first gate
+class LoudnessAnalyser
+{
+public:
+    LoudnessAnalyser(double sampleRate, int numChannels);
+
+    //takes blocks of the track at its own sample rate, with all its channels
+    void process(const AudioBuffer<float>& block, int numSamples);
+
+    //returns the integrated loudness, -70 (the absolute gate) for silence
+    double getIntegratedLoudness() const;
+
+    //the two K-weighting stages (a high shelf and a high-pass) for a sample rate
+    static juce::dsp::IIR::Coefficients<float>::Ptr makeKWeightingShelf(double sampleRate);
+    static juce::dsp::IIR::Coefficients<float>::Ptr makeKWeightingHighPass(double sampleRate);
+
+    //turns a mean square into LUFS
+    static double meanSquareToLoudness(double meanSquare);
+
+private:
+    int numChannels;
+    int samplesPerStep;
+
+    OwnedArray<juce::dsp::IIR::Filter<float>> shelfFilters;
+    OwnedArray<juce::dsp::IIR::Filter<float>> highPassFilters;
+
+    //mean square of the 100 ms step being filled and of the last three finished steps
+    double stepSum = 0.0;
+    int samplesInStep = 0;
+    double previousSteps[3] = {};
+    int numSteps = 0;
+
+    //the mean square of every 400 ms block
+    std::vector<double> blockMeanSquares;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessAnalyser)
+};
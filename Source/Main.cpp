@@ -1,73 +1,100 @@
-/*====================================================================
-Main.cpp file
-I did not code this file as it was auto-generated.
-This contains the basic startup code to run a JUCE application.
-====================================================================*/
-
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "MainComponent.h"
-
-class OtoDecksApplication  : public JUCEApplication
-{
-public:
-    OtoDecksApplication() {}
-    const String getApplicationName() override       { return ProjectInfo::projectName; }
-    const String getApplicationVersion() override    { return ProjectInfo::versionString; }
-    bool moreThanOneInstanceAllowed() override       { return true; }
-
-    void initialise (const String& commandLine) override
-    {
-        mainWindow.reset (new MainWindow (getApplicationName()));
-    }
-
-    void shutdown() override
-    {
-        mainWindow = nullptr; // (deletes our window)
-    }
-
-    void systemRequestedQuit() override
-    {
-        quit();
-    }
-
-    void anotherInstanceStarted (const String& commandLine) override
-    {
-        
-    }
-
-    class MainWindow    : public DocumentWindow
-    {
-    public:
-        MainWindow (String name)  : DocumentWindow (name,
-                                                    Desktop::getInstance().getDefaultLookAndFeel()
-                                                                          .findColour (ResizableWindow::backgroundColourId),
-                                                    DocumentWindow::allButtons)
-        {
-            setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
-
-           #if JUCE_IOS || JUCE_ANDROID
-            setFullScreen (true);
-           #else
-            setResizable (true, true);
-            centreWithSize (getWidth(), getHeight());
-           #endif
-
-            setVisible (true);
-        }
-
-        void closeButtonPressed() override
-        {
-            JUCEApplication::getInstance()->systemRequestedQuit();
-        }
-
-    private:
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
-    };
-
-private:
-    std::unique_ptr<MainWindow> mainWindow;
-};
-
-START_JUCE_APPLICATION (OtoDecksApplication)
+/*====================================================================
+Main.cpp file
+I did not code this file as it was auto-generated.
+This contains the basic startup code to run a JUCE application.
+====================================================================*/
+
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MainComponent.h"
+#include "RealtimeSafetyHarness.h"
+#include "BufferSizeSimulation.h"
+#include "AutomationReplay.h"
+
+class OtoDecksApplication  : public JUCEApplication
+{
+public:
+    OtoDecksApplication() {}
+    const String getApplicationName() override       { return ProjectInfo::projectName; }
+    const String getApplicationVersion() override    { return ProjectInfo::versionString; }
+    bool moreThanOneInstanceAllowed() override       { return true; }
+
+    void initialise (const String& commandLine) override
+    {
+        //runs the real-time safety checks instead of opening the window
+        if (commandLine.contains ("--rt-check"))
+        {
+            setApplicationReturnValue (RealtimeSafetyHarness::run() == 0 ? 0 : 1);
+            quit();
+            return;
+        }
+
+        //runs the buffer size tuner against a simulated device instead of opening the window
+        if (commandLine.contains ("--tune-check"))
+        {
+            setApplicationReturnValue (BufferSizeSimulation::run() == 0 ? 0 : 1);
+            quit();
+            return;
+        }
+
+        //renders a recorded automation log to a file instead of opening the window
+        if (commandLine.contains ("--replay="))
+        {
+            setApplicationReturnValue (AutomationReplay::run (getCommandLineParameterArray()));
+            quit();
+            return;
+        }
+
+        mainWindow.reset (new MainWindow (getApplicationName()));
+    }
+
+    void shutdown() override
+    {
+        mainWindow = nullptr; // (deletes our window)
+    }
+
+    void systemRequestedQuit() override
+    {
+        quit();
+    }
+
+    void anotherInstanceStarted (const String& commandLine) override
+    {
+        
+    }
+
+    class MainWindow    : public DocumentWindow
+    {
+    public:
+        MainWindow (String name)  : DocumentWindow (name,
+                                                    Desktop::getInstance().getDefaultLookAndFeel()
+                                                                          .findColour (ResizableWindow::backgroundColourId),
+                                                    DocumentWindow::allButtons)
+        {
+            setUsingNativeTitleBar (true);
+            setContentOwned (new MainComponent(), true);
+
+           #if JUCE_IOS || JUCE_ANDROID
+            setFullScreen (true);
+           #else
+            setResizable (true, true);
+            centreWithSize (getWidth(), getHeight());
+           #endif
+
+            setVisible (true);
+        }
+
+        void closeButtonPressed() override
+        {
+            JUCEApplication::getInstance()->systemRequestedQuit();
+        }
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
+    };
+
+private:
+    std::unique_ptr<MainWindow> mainWindow;
+};
+
+START_JUCE_APPLICATION (OtoDecksApplication)
@@ -1,82 +1,258 @@
-/*====================================================================
-MainComponent.cpp
-This is a basic framework for an audio application that handles both the UI and audio processing components.
-These codes are from the tutorial from the course that I have updated with my own codes
-====================================================================*/
-
-
-#include "MainComponent.h"
-
-MainComponent::MainComponent()
-{
-    //resize the window
-    setSize (1200, 800);
-
-    //some platforms require permissions to open input channels so request that here
-    if (RuntimePermissions::isRequired (RuntimePermissions::recordAudio)
-        && ! RuntimePermissions::isGranted (RuntimePermissions::recordAudio)) {
-        RuntimePermissions::request (RuntimePermissions::recordAudio,
-                                     [&] (bool granted) { if (granted)  setAudioChannels (2, 2); });
-    }  
-    else {
-        //specify the number of input and output channels that we want to open
-        setAudioChannels (0, 2);
-    }  
-
-    addAndMakeVisible(deckGUI1); 
-    addAndMakeVisible(deckGUI2);  
-    
-    addAndMakeVisible(playlistComponent);
-
-    formatManager.registerBasicFormats();
-}
-
-MainComponent::~MainComponent()
-{
-    //this shuts down the audio device and clears the audio source.
-    shutdownAudio();
-}
-
-//this function ensures that the necessary audio components are ready to process and play audio at the specified sample rate and block size
-void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
-{
-    player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    
-    mixerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-
-    mixerSource.addInputSource(&player1, false);
-    mixerSource.addInputSource(&player2, false);
-
- }
-
-//this function is responsible for processing and applying any audio effects to the audio data during playback
-void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
-{
-    mixerSource.getNextAudioBlock(bufferToFill);
-}
-
-//this function is used to release or clean up any resources that were previously allocated for audio playback
-void MainComponent::releaseResources()
-{
-    player1.releaseResources();
-    player2.releaseResources();
-    mixerSource.releaseResources();
-}
-
-//this function paints the playlist component (background and color)
-void MainComponent::paint (Graphics& g)
-{
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll (Colour::fromRGB(29, 22, 22));
-}
-
-//this function lays out the child component and resize it
-void MainComponent::resized()
-{
-    deckGUI1.setBounds(0, 0, getWidth() / 2,getHeight() * 2 / 3);
-    deckGUI2.setBounds(getWidth()/2, 0, getWidth() / 2, getHeight() * 2 / 3);
-    
-    playlistComponent.setBounds(0, getHeight() - getHeight() * 1 / 3, getWidth(), getHeight() / 3);
-}
-
+/*====================================================================
+MainComponent.cpp
+This is a basic framework for an audio application that handles both the UI and audio processing components.
+These codes are from the tutorial from the course that I have updated with my own codes
+====================================================================*/
+
+
+#include "MainComponent.h"
+#include "RealtimeSafetyChecker.h"
+#include "Tracer.h"
+
+MainComponent::MainComponent()
+{
+    //resize the window
+    setSize (1200, 800);
+
+    setWantsKeyboardFocus(true);
+    bool tracing = true;
+
+    //options for testing playback from slow storage: --prefetch=<seconds> sets the read-ahead window and
+    //--throttle-io=<latency ms>,<spike ms> makes every file read slow, with a long stall every 16 reads.
+    //they are read before the audio device is opened, so its first prepareToPlay already uses them
+    for (auto& argument : JUCEApplicationBase::getCommandLineParameterArray()) {
+        String value = argument.fromFirstOccurrenceOf("=", false, false);
+
+        if (argument.startsWith("--prefetch=")) {
+            player1.setPrefetchSeconds(value.getDoubleValue());
+            player2.setPrefetchSeconds(value.getDoubleValue());
+        }
+
+        //--limiter-lookahead=<ms> sets the master limiter's look-ahead, which is also the latency it adds
+        if (argument.startsWith("--limiter-lookahead=")) {
+            masterLimiter.setLookaheadMs(value.getDoubleValue());
+        }
+
+        //--preload-tracks decodes every loaded track whole into RAM on several threads, for scratching without the read-ahead window
+        if (argument == "--preload-tracks") {
+            player1.setPreloadWholeTracks(true);
+            player2.setPreloadWholeTracks(true);
+        }
+
+        //--low-latency starts with the low latency mode on, which tunes the buffer size while playing
+        if (argument == "--low-latency") {
+            bufferSizeTuner.setEnabled(true);
+        }
+
+        //--no-trace turns the event tracing off, so its rings are never allocated
+        if (argument == "--no-trace") {
+            tracing = false;
+        }
+
+        if (argument.startsWith("--throttle-io=")) {
+            StringArray values = StringArray::fromTokens(value, ",", "");
+            player1.setSimulatedReadLatency(values[0].getIntValue(), values[1].getIntValue(), 16);
+            player2.setSimulatedReadLatency(values[0].getIntValue(), values[1].getIntValue(), 16);
+        }
+    }
+
+    //tracing is cheap enough to leave on, ctrl+shift+T (cmd on a mac) writes the last few seconds out as a Chrome trace
+    Tracer::setEnabled(tracing);
+
+    //--record-automation[=<file>] logs every control change of the set, for rendering it again with --replay=<file>.
+    //it starts after the other options and before the device opens, so the log starts from the state the replay starts from
+    player1.setAutomationLog(&automationLog, AutomationLog::Target::deck1);
+    player2.setAutomationLog(&automationLog, AutomationLog::Target::deck2);
+    samplerPads.setAutomationLog(&automationLog);
+
+    for (auto& argument : JUCEApplicationBase::getCommandLineParameterArray()) {
+        if (argument == "--record-automation" || argument.startsWith("--record-automation=")) {
+            String value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+            File file = value.isNotEmpty() ? File::getCurrentWorkingDirectory().getChildFile(value) : AutomationLog::getDefaultLogFile();
+            if (automationLog.start(file, masterLimiter.getLookaheadMs())) {
+                std::cout << "MainComponent: recording automation to " << file.getFullPathName() << std::endl;
+            }
+        }
+    }
+
+    //some platforms require permissions to open input channels so request that here
+    if (RuntimePermissions::isRequired (RuntimePermissions::recordAudio)
+        && ! RuntimePermissions::isGranted (RuntimePermissions::recordAudio)) {
+        RuntimePermissions::request (RuntimePermissions::recordAudio,
+                                     [&] (bool granted) { if (granted)  setAudioChannels (2, 2); });
+    }  
+    else {
+        //specify the number of input and output channels that we want to open
+        setAudioChannels (0, 2);
+    }  
+
+    addAndMakeVisible(deckGUI1); 
+    addAndMakeVisible(deckGUI2);  
+    
+    addAndMakeVisible(playlistComponent);
+
+    addAndMakeVisible(masterStrip);
+    addAndMakeVisible(samplerPadsComponent);
+
+    //each deck's sync button follows the other deck
+    deckGUI1.setSyncMaster(&player2);
+    deckGUI2.setSyncMaster(&player1);
+    deckGUI1.setDoubleSource(&deckGUI2);
+    deckGUI2.setDoubleSource(&deckGUI1);
+
+    formatManager.registerBasicFormats();
+
+    readAheadThread.startThread(Thread::Priority::high);
+
+    //uses the user's mapping table, writing the default one the first time so there is a file to edit
+    File mappingFile = MidiController::getDefaultMappingFile();
+    if (mappingFile.existsAsFile()) {
+        midiController.setMappings(MidiController::loadMappings(mappingFile));
+    }
+    else {
+        MidiController::saveMappings(midiController.getMappings(), mappingFile);
+    }
+    midiController.openInputs();
+
+    //loads the analysis results of earlier sessions
+    trackLibrary.loadFrom(TrackLibrary::getDefaultLibraryFile());
+    trackAnalyser.indexLibraryFingerprints();
+
+    startTimerHz(4);
+}
+
+MainComponent::~MainComponent()
+{
+    stopTimer();
+
+    //no controller moves the decks while they are shut down
+    midiController.closeInputs();
+
+    //this shuts down the audio device and clears the audio source.
+    shutdownAudio();
+
+    //finishes the file of a recording that is still running
+    masterRecorder.stopRecording();
+    automationLog.stop();
+
+    //keeps the analysis results for the next session
+    trackLibrary.saveTo(TrackLibrary::getDefaultLibraryFile());
+}
+
+//this function ensures that the necessary audio components are ready to process and play audio at the specified sample rate and block size
+void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    automationLog.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    samplerPads.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    
+    mixerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    mixerSource.addInputSource(&player1, false);
+    mixerSource.addInputSource(&player2, false);
+    mixerSource.addInputSource(&samplerPads, false);
+
+    masterLimiter.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    masterMeter.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    masterRecorder.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+ }
+
+//this function is responsible for processing and applying any audio effects to the audio data during playback
+void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
+{
+    //reports anything that is not real-time safe in the callback when the checker is compiled in
+    RealtimeSafetyChecker::ScopedAudioCallback audioCallback;
+    Tracer::Scope trace("MainComponent::getNextAudioBlock", Tracer::Category::audio);
+    double callbackStart = Time::getMillisecondCounterHiRes() * 0.001;
+
+    //moves the log's clock on before the decks and pads stamp their changes with it
+    automationLog.beginBlock(bufferToFill.numSamples);
+
+    mixerSource.getNextAudioBlock(bufferToFill);
+
+    //the recording is limited the same as what is heard
+    masterLimiter.process(bufferToFill);
+    masterMeter.process(bufferToFill);
+
+    //only copies the block into the recorder's fifo
+    masterRecorder.pushBlock(bufferToFill);
+
+    bufferSizeTuner.recordCallback(callbackStart, Time::getMillisecondCounterHiRes() * 0.001, bufferToFill.numSamples);
+}
+
+//this function is used to release or clean up any resources that were previously allocated for audio playback
+void MainComponent::releaseResources()
+{
+    player1.releaseResources();
+    player2.releaseResources();
+    mixerSource.releaseResources();
+}
+
+//this function paints the playlist component (background and color)
+void MainComponent::paint (Graphics& g)
+{
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    g.fillAll (Colour::fromRGB(29, 22, 22));
+}
+
+//this function writes the trace on ctrl+shift+T, the key presses no child used come up to here
+bool MainComponent::keyPressed(const KeyPress& key)
+{
+    if (key == KeyPress('t', ModifierKeys::commandModifier | ModifierKeys::shiftModifier, 0)) {
+        File file = Tracer::getDefaultTraceFile();
+        if (Tracer::writeChromeTrace(file)) {
+            std::cout << "MainComponent: trace written to " << file.getFullPathName() << std::endl;
+        }
+        return true;
+    }
+    return false;
+}
+
+//this function tells the tuner about the device whenever it changes, and restarts the device with the size the tuner asks for
+void MainComponent::timerCallback()
+{
+    AudioIODevice* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr) {
+        return;
+    }
+
+    //the device was changed in its settings, or did not take the size it was asked for
+    int deviceBufferSize = device->getCurrentBufferSizeSamples();
+    double deviceSampleRate = device->getCurrentSampleRate();
+    if (deviceBufferSize != bufferSizeTuner.getBufferSize() || deviceSampleRate != bufferSizeTuner.getSampleRate()) {
+        bufferSizeTuner.setDevice(deviceSampleRate, deviceBufferSize, device->getAvailableBufferSizes());
+    }
+
+    int wanted = bufferSizeTuner.update(Time::getMillisecondCounterHiRes() * 0.001, device->getXRunCount());
+    if (wanted != deviceBufferSize) {
+        AudioDeviceManager::AudioDeviceSetup setup;
+        deviceManager.getAudioDeviceSetup(setup);
+        setup.bufferSize = wanted;
+
+        String error = deviceManager.setAudioDeviceSetup(setup, true);
+        if (error.isNotEmpty()) {
+            std::cout << "MainComponent: cannot set the buffer size to " << wanted << ": " << error << std::endl;
+        }
+    }
+}
+
+//this function lays out the child component and resize it
+void MainComponent::resized()
+{
+    int masterStripHeight = 30;
+    int padStripHeight = 30;
+    int stripsTop = getHeight() * 2 / 3 - masterStripHeight - padStripHeight;
+
+    deckGUI1.setBounds(0, 0, getWidth() / 2, stripsTop);
+    deckGUI2.setBounds(getWidth()/2, 0, getWidth() / 2, stripsTop);
+
+    //the master strip with the sample pads under it
+    masterStrip.setBounds(0, stripsTop, getWidth(), masterStripHeight);
+    samplerPadsComponent.setBounds(0, stripsTop + masterStripHeight, getWidth(), padStripHeight);
+    
+    playlistComponent.setBounds(0, getHeight() - getHeight() * 1 / 3, getWidth(), getHeight() / 3);
+}
+
@@ -1,43 +1,97 @@
-/*====================================================================
-MainComponent.h
-====================================================================*/
-
-
-#pragma once
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "DJAudioPlayer.h"
-#include "DeckGUI.h"
-#include "PlaylistComponent.h"
-
-//this class is the core component of your audio application, it is where everything should be handled
-class MainComponent   : public AudioAppComponent
-{
-public:
-    MainComponent();
-    ~MainComponent();
-
-    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
-    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
-    void releaseResources() override;
-
-    void paint (Graphics& g) override;
-    void resized() override;
-
-private:
-    AudioFormatManager formatManager;
-    AudioThumbnailCache thumbCache{100}; 
-
-    DJAudioPlayer player1{formatManager};
-    DeckGUI deckGUI1{&player1, formatManager, thumbCache};
-
-    DJAudioPlayer player2{formatManager};
-    DeckGUI deckGUI2{&player2, formatManager, thumbCache}; 
-
-    PlaylistComponent playlistComponent{ deckGUI1,deckGUI2 };
-
-    MixerAudioSource mixerSource;
-    
-    
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
-};
+/*====================================================================
+MainComponent.h
+====================================================================*/
+
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+#include "DeckGUI.h"
+#include "PlaylistComponent.h"
+#include "TrackLibrary.h"
+#include "TrackAnalyser.h"
+#include "WaveformCache.h"
+#include "MasterRecorder.h"
+#include "MasterLimiter.h"
+#include "MasterStripComponent.h"
+#include "MidiController.h"
+#include "SamplerPads.h"
+#include "SamplerPadsComponent.h"
+#include "BufferSizeTuner.h"
+#include "AutomationLog.h"
+#include "JobScheduler.h"
+
+//this class is the core component of your audio application, it is where everything should be handled
+class MainComponent   : public AudioAppComponent,
+                        public Timer
+{
+public:
+    MainComponent();
+    ~MainComponent();
+
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+
+    //writes the trace on demand
+    bool keyPressed(const KeyPress& key) override;
+
+    //follows the device and applies the buffer size the low latency mode picks
+    void timerCallback() override;
+
+private:
+    AudioFormatManager formatManager;
+
+    //runs the track loads, waveform builds and analysis, the deck being loaded first, then the playlist rows on screen, then the library
+    JobScheduler jobScheduler;
+
+    WaveformCache waveformCache{100, jobScheduler}; 
+
+    //reads the decks' audio ahead of the playhead so loading and playback never wait on the disk
+    TimeSliceThread readAheadThread{ "Deck read-ahead" };
+
+    //records the control changes for --record-automation, it outlives the decks and pads that post to it
+    AutomationLog automationLog;
+
+    //the decks look up the beat grids of their tracks in the library
+    TrackLibrary trackLibrary;
+
+    DJAudioPlayer player1{formatManager, readAheadThread, jobScheduler};
+    DeckGUI deckGUI1{&player1, formatManager, waveformCache, trackLibrary};
+
+    DJAudioPlayer player2{formatManager, readAheadThread, jobScheduler};
+    DeckGUI deckGUI2{&player2, formatManager, waveformCache, trackLibrary}; 
+
+    //controllers move the decks straight from the MIDI thread
+    MidiController midiController{ player1, player2 };
+
+    TrackAnalyser trackAnalyser{ formatManager, trackLibrary, jobScheduler, &waveformCache };
+
+    PlaylistComponent playlistComponent{ deckGUI1,deckGUI2, trackLibrary, trackAnalyser };
+
+    //the sample pads are mixed into the master next to the decks
+    SamplerPads samplerPads{ formatManager, jobScheduler };
+    SamplerPadsComponent samplerPadsComponent{ samplerPads };
+
+    MixerAudioSource mixerSource;
+
+    //keeps the mix under the ceiling before it goes to the device and the recorder
+    MasterLimiter masterLimiter;
+
+    //the level of the master output, after the limiter
+    LevelMeter masterMeter;
+
+    //measures the callback and picks the buffer size in the low latency mode
+    BufferSizeTuner bufferSizeTuner;
+
+    //records the master output and the strip that controls it
+    MasterRecorder masterRecorder;
+    MasterStripComponent masterStrip{ masterRecorder, masterLimiter, masterMeter, bufferSizeTuner };
+    
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
+};
@@ -0,0 +1,235 @@
+/*====================================================================
+MasterLimiter.cpp
+This class is the look-ahead limiter on the master output. For every sample it finds the true peak with a 4x polyphase interpolator,
+the gain that would bring that peak down to the ceiling, and the smallest such gain over the look-ahead. That gain is released slowly
+and averaged over the look-ahead, so the gain has ramped all the way down by the time the delayed peak comes out. The interpolation,
+the gain and its application are whole-block vector operations; only the running minimum and average go sample by sample.
+====================================================================*/
+
+
+#include "MasterLimiter.h"
+#include "Tracer.h"
+#include <cmath>
+#include <cstring>
+
+//the taps of each interpolation phase, the peak found for a sample is half of them behind the newest input
+static constexpr int numTaps = 8;
+static constexpr int halfTaps = numTaps / 2;
+static constexpr int oversampling = 4;
+
+MasterLimiter::MasterLimiter()
+{
+    //windowed sinc filters for the points a quarter, a half and three quarters of the way to the next sample
+    phaseFilters.allocate((size_t) ((oversampling - 1) * numTaps), true);
+
+    for (int phase = 1; phase < oversampling; ++phase) {
+        float* taps = phaseFilters + (phase - 1) * numTaps;
+        float sum = 0.0f;
+
+        for (int tap = 0; tap < numTaps; ++tap) {
+            double distance = tap - (halfTaps - 1) - (double) phase / oversampling;
+            double sinc = distance == 0.0 ? 1.0 : std::sin(MathConstants<double>::pi * distance) / (MathConstants<double>::pi * distance);
+            double window = 0.5 + 0.5 * std::cos(MathConstants<double>::pi * distance / halfTaps);
+            taps[tap] = (float) (sinc * window);
+            sum += taps[tap];
+        }
+
+        //unity gain at DC
+        for (int tap = 0; tap < numTaps; ++tap) {
+            taps[tap] /= sum;
+        }
+    }
+}
+
+MasterLimiter::~MasterLimiter()
+{
+}
+
+//this function sets the look-ahead for the next prepareToPlay
+void MasterLimiter::setLookaheadMs(double milliseconds)
+{
+    if (milliseconds < 0.5 || milliseconds > maxLookaheadMs) {
+        std::cout << "MasterLimiter::setLookaheadMs milliseconds should be between 0.5 and " << maxLookaheadMs << std::endl;
+        return;
+    }
+    lookaheadMs = milliseconds;
+}
+
+//this function returns the look-ahead the next prepareToPlay uses
+double MasterLimiter::getLookaheadMs() const
+{
+    return lookaheadMs.load();
+}
+
+//this function allocates everything for the device's block size and rate
+void MasterLimiter::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = jmax(1, samplesPerBlockExpected);
+
+    //the window must cover the interpolator, and the output waits for both
+    lookaheadSamples = jmax(numTaps, roundToInt(lookaheadMs.load() * 0.001 * sampleRate));
+    delaySamples = halfTaps + lookaheadSamples - 1;
+    historyLength = jmax(delaySamples, numTaps - 1);
+
+    ceiling = Decibels::decibelsToGain(ceilingDb);
+    releaseCoefficient = (float) std::exp(-1.0 / (releaseSeconds * sampleRate));
+
+    workBuffer.setSize(2, historyLength + maxBlockSize);
+    workBuffer.clear();
+    peakBuffer.allocate((size_t) maxBlockSize, true);
+    interpolated.allocate((size_t) maxBlockSize, true);
+    gains.allocate((size_t) maxBlockSize, true);
+
+    minimumValues.allocate((size_t) lookaheadSamples + 1, true);
+    minimumPositions.allocate((size_t) lookaheadSamples + 1, true);
+    minimumFront = 0;
+    minimumSize = 0;
+    samplePosition = 0;
+
+    releasedGain = 1.0f;
+    averageRing.allocate((size_t) lookaheadSamples, false);
+    for (int i = 0; i < lookaheadSamples; ++i) {
+        averageRing[i] = 1.0f;
+    }
+    averagePosition = 0;
+    averageSum = lookaheadSamples;
+
+    latencySamples = delaySamples;
+    gainReductionDb = 0.0f;
+
+    std::cout << "MasterLimiter: " << delaySamples << " samples (" << getLatencySeconds() * 1000.0 << " ms) of latency" << std::endl;
+}
+
+//this function splits the block into chunks that fit the work buffers
+void MasterLimiter::process(const AudioSourceChannelInfo& bufferToFill)
+{
+    Tracer::Scope trace("MasterLimiter::process", Tracer::Category::audio);
+    if (maxBlockSize == 0) {
+        return;
+    }
+
+    int numChannels = jmin(2, bufferToFill.buffer->getNumChannels());
+    float* channels[2] = {};
+    float lowestGain = 1.0f;
+
+    for (int done = 0; done < bufferToFill.numSamples;) {
+        int chunk = jmin(maxBlockSize, bufferToFill.numSamples - done);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            channels[channel] = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample + done);
+        }
+
+        processChunk(channels, numChannels, chunk);
+        lowestGain = jmin(lowestGain, FloatVectorOperations::findMinimum(gains.get(), chunk));
+        done += chunk;
+    }
+
+    gainReductionDb = Decibels::gainToDecibels(lowestGain);
+}
+
+//this function limits one chunk: peaks, needed gain, look-ahead minimum, release, average and then the delayed output
+void MasterLimiter::processChunk(float* const* channels, int numChannels, int numSamples)
+{
+    //the chunk goes in after each channel's history
+    for (int channel = 0; channel < numChannels; ++channel) {
+        FloatVectorOperations::copy(workBuffer.getWritePointer(channel, historyLength), channels[channel], numSamples);
+    }
+
+    findTruePeaks(numChannels, numSamples);
+
+    //the gain each sample needs, 1 below the ceiling
+    FloatVectorOperations::max(peakBuffer.get(), peakBuffer.get(), ceiling, numSamples);
+    for (int i = 0; i < numSamples; ++i) {
+        peakBuffer[i] = ceiling / peakBuffer[i];
+    }
+
+    for (int i = 0; i < numSamples; ++i) {
+        float needed = peakBuffer[i];
+
+        //the running minimum over the look-ahead, values that can never be the minimum again are dropped from the back
+        while (minimumSize > 0 && minimumValues[(minimumFront + minimumSize - 1) % (lookaheadSamples + 1)] >= needed) {
+            --minimumSize;
+        }
+        int back = (minimumFront + minimumSize) % (lookaheadSamples + 1);
+        minimumValues[back] = needed;
+        minimumPositions[back] = samplePosition;
+        ++minimumSize;
+
+        if (minimumPositions[minimumFront] <= samplePosition - lookaheadSamples) {
+            minimumFront = (minimumFront + 1) % (lookaheadSamples + 1);
+            --minimumSize;
+        }
+        ++samplePosition;
+
+        //goes down at once and comes back up slowly
+        float minimum = minimumValues[minimumFront];
+        releasedGain = minimum < releasedGain ? minimum : minimum + (releasedGain - minimum) * releaseCoefficient;
+
+        //the average over the look-ahead ramps the gain down before a peak, and is never above the gain the peak needs
+        averageSum += releasedGain - averageRing[averagePosition];
+        averageRing[averagePosition] = releasedGain;
+        if (++averagePosition == lookaheadSamples) {
+            averagePosition = 0;
+        }
+        gains[i] = jmin(1.0f, (float) (averageSum / lookaheadSamples));
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        float* work = workBuffer.getWritePointer(channel);
+
+        FloatVectorOperations::multiply(channels[channel], work + historyLength - delaySamples, gains.get(), numSamples);
+
+        //the last line of protection against rounding in the gain, nothing ever leaves above full scale
+        FloatVectorOperations::clip(channels[channel], channels[channel], -1.0f, 1.0f, numSamples);
+
+        //keeps the newest samples as the history of the next chunk
+        std::memmove(work, work + numSamples, (size_t) historyLength * sizeof(float));
+    }
+}
+
+//this function takes the largest of the sample itself and the three interpolated points after it, over both channels
+void MasterLimiter::findTruePeaks(int numChannels, int numSamples)
+{
+    for (int channel = 0; channel < numChannels; ++channel) {
+        const float* input = workBuffer.getReadPointer(channel, historyLength);
+
+        //the sample the peak belongs to, halfTaps behind the newest input
+        FloatVectorOperations::abs(interpolated.get(), input - halfTaps, numSamples);
+        if (channel == 0) {
+            FloatVectorOperations::copy(peakBuffer.get(), interpolated.get(), numSamples);
+        }
+        else {
+            FloatVectorOperations::max(peakBuffer.get(), peakBuffer.get(), interpolated.get(), numSamples);
+        }
+
+        for (int phase = 1; phase < oversampling; ++phase) {
+            const float* taps = phaseFilters + (phase - 1) * numTaps;
+
+            FloatVectorOperations::clear(interpolated.get(), numSamples);
+            for (int tap = 0; tap < numTaps; ++tap) {
+                FloatVectorOperations::addWithMultiply(interpolated.get(), input - (numTaps - 1) + tap, taps[tap], numSamples);
+            }
+
+            FloatVectorOperations::abs(interpolated.get(), interpolated.get(), numSamples);
+            FloatVectorOperations::max(peakBuffer.get(), peakBuffer.get(), interpolated.get(), numSamples);
+        }
+    }
+}
+
+//this function returns the latency in samples
+int MasterLimiter::getLatencySamples() const
+{
+    return latencySamples.load();
+}
+
+//this function returns the latency in seconds
+double MasterLimiter::getLatencySeconds() const
+{
+    return sampleRate > 0.0 ? latencySamples.load() / sampleRate : 0.0;
+}
+
+//this function returns the gain reduction of the last block
+float MasterLimiter::getGainReductionDb() const
+{
+    return gainReductionDb.load();
+}
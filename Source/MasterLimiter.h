@@ -0,0 +1,91 @@
+/*====================================================================
+MasterLimiter.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class keeps the master output under a true-peak ceiling. it delays the mix by a short look-ahead and turns the gain down ahead of
+//each peak, so two loud decks are limited instead of clipped. peaks between samples are found by 4x oversampling. all buffers are
+//allocated in prepareToPlay and the gain is worked out a block at a time with FloatVectorOperations
+class MasterLimiter
+{
+public:
+    //the highest true peak let through, 1 dB under full scale
+    static constexpr float ceilingDb = -1.0f;
+
+    //how long the gain takes to come back after a peak
+    static constexpr double releaseSeconds = 0.1;
+
+    //the look-ahead used unless another one is set, and the longest allowed
+    static constexpr double defaultLookaheadMs = 5.0;
+    static constexpr double maxLookaheadMs = 20.0;
+
+    MasterLimiter();
+    ~MasterLimiter();
+
+    //sets the look-ahead, used from the next prepareToPlay on
+    void setLookaheadMs(double milliseconds);
+    double getLookaheadMs() const;
+
+    //allocates the delay and the work buffers, and reports the latency
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    //limits the block in place, called on the audio thread
+    void process(const AudioSourceChannelInfo& bufferToFill);
+
+    //how much later the output is than the mix, in samples and seconds
+    int getLatencySamples() const;
+    double getLatencySeconds() const;
+
+    //the most the gain was turned down in the last block, 0 or less
+    float getGainReductionDb() const;
+
+private:
+    //limits one chunk that fits in the work buffers
+    void processChunk(float* const* channels, int numChannels, int numSamples);
+
+    //works out the true peak of every sample of the chunk across the channels, into peakBuffer
+    void findTruePeaks(int numChannels, int numSamples);
+
+    std::atomic<double> lookaheadMs{ defaultLookaheadMs };
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+    int lookaheadSamples = 0;
+    int delaySamples = 0;
+    int historyLength = 0;
+    float ceiling = 1.0f;
+    float releaseCoefficient = 0.0f;
+
+    //each channel's history followed by the chunk being limited
+    AudioBuffer<float> workBuffer;
+
+    //the true peaks, then the gain needed by each sample, and the gain applied
+    HeapBlock<float> peakBuffer;
+    HeapBlock<float> interpolated;
+    HeapBlock<float> gains;
+
+    //the interpolation filters of the three in-between phases
+    HeapBlock<float> phaseFilters;
+
+    //the smallest needed gain over the look-ahead, kept as a queue of falling values
+    HeapBlock<float> minimumValues;
+    HeapBlock<int64> minimumPositions;
+    int minimumFront = 0;
+    int minimumSize = 0;
+    int64 samplePosition = 0;
+
+    //the released gain, and its moving average over the look-ahead
+    float releasedGain = 1.0f;
+    HeapBlock<float> averageRing;
+    int averagePosition = 0;
+    double averageSum = 0.0;
+
+    std::atomic<int> latencySamples{ 0 };
+    std::atomic<float> gainReductionDb{ 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MasterLimiter)
+};
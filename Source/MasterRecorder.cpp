@@ -0,0 +1,257 @@
+/*====================================================================
+MasterRecorder.cpp
+This class records the master output. The audio thread copies each block into an AbstractFifo that is allocated before playback
+starts, and the "Master recorder" thread drains it into an AudioFormatWriter. Blocks that do not fit in the fifo are dropped and
+counted, and the recording stops cleanly when a write fails or the disk is nearly full.
+====================================================================*/
+
+
+#include "MasterRecorder.h"
+
+//the recording stops when less than this is left on the disk, so the file can still be finished
+static constexpr int64 minimumFreeBytes = 64 * 1024 * 1024;
+
+MasterRecorder::MasterRecorder(int _numChannels, double _fifoSeconds)
+    : numChannels(_numChannels),
+      fifoSeconds(_fifoSeconds)
+{
+    writerThread.addTimeSliceClient(this);
+    writerThread.startThread(Thread::Priority::normal);
+}
+
+MasterRecorder::~MasterRecorder()
+{
+    stopRecording();
+    writerThread.removeTimeSliceClient(this);
+    writerThread.stopThread(2000);
+}
+
+//this function sizes the fifo for the device, it runs before the audio callback starts so it may allocate
+void MasterRecorder::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    //the file header holds the sample rate, so a recording cannot carry on at a new one
+    if (newSampleRate != sampleRate.load() && isRecording()) {
+        std::cout << "MasterRecorder: the sample rate changed, recording stopped" << std::endl;
+        stopRecording();
+    }
+
+    const ScopedLock sl(writerLock);
+    sampleRate = newSampleRate;
+
+    int fifoSize = jmax(samplesPerBlockExpected * 4, (int) (fifoSeconds * newSampleRate));
+    if (fifoBuffer.getNumSamples() != fifoSize) {
+        fifoBuffer.setSize(numChannels, fifoSize);
+        fifo.setTotalSize(fifoSize);
+    }
+}
+
+//this function opens the file and a writer for it, then lets the audio thread start filling the fifo
+bool MasterRecorder::startRecording(const File& file)
+{
+    stopRecording();
+
+    const ScopedLock sl(writerLock);
+
+    if (sampleRate.load() <= 0.0) {
+        std::cout << "MasterRecorder: the audio device is not running" << std::endl;
+        return false;
+    }
+
+    std::unique_ptr<AudioFormat> format;
+    if (file.hasFileExtension(".flac")) {
+        format.reset(new FlacAudioFormat());
+    }
+    else {
+        format.reset(new WavAudioFormat());
+    }
+
+    file.deleteFile();
+    std::unique_ptr<FileOutputStream> stream(file.createOutputStream());
+    if (stream == nullptr || stream->failedToOpen()) {
+        std::cout << "MasterRecorder: cannot write to " << file.getFullPathName() << std::endl;
+        return false;
+    }
+
+    writer.reset(format->createWriterFor(stream.get(), sampleRate.load(), (unsigned int) numChannels, 24, {}, 0));
+    if (writer == nullptr) {
+        std::cout << "MasterRecorder: cannot create a " << format->getFormatName() << " writer" << std::endl;
+        return false;
+    }
+    stream.release(); //the writer owns the stream now
+
+    //throws away anything left from the last recording, only the writer side of the fifo is touched here
+    fifo.finishedRead(fifo.getNumReady());
+
+    recordingFile = file;
+    samplesWritten = 0;
+    droppedSamples = 0;
+    diskFull = false;
+    writeFailed = false;
+    lastSpaceCheckMs = 0;
+
+    recording.store(true, std::memory_order_release);
+    return true;
+}
+
+//this function stops the audio thread filling the fifo, writes what is left and finishes the file
+void MasterRecorder::stopRecording()
+{
+    recording.store(false, std::memory_order_release);
+
+    const ScopedLock sl(writerLock);
+    if (writer != nullptr) {
+        writePendingData();
+        closeWriter();
+    }
+}
+
+//this function returns whether a recording is running
+bool MasterRecorder::isRecording() const
+{
+    return recording.load(std::memory_order_acquire);
+}
+
+//this function copies the master output into the fifo, anything that does not fit is counted as dropped
+void MasterRecorder::pushBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+    if (!recording.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    int numSamples = bufferToFill.numSamples;
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    int sourceChannels = bufferToFill.buffer->getNumChannels();
+    for (int channel = 0; channel < numChannels; ++channel) {
+        int source = jmin(channel, sourceChannels - 1);
+        if (size1 > 0) {
+            fifoBuffer.copyFrom(channel, start1, *bufferToFill.buffer, source, bufferToFill.startSample, size1);
+        }
+        if (size2 > 0) {
+            fifoBuffer.copyFrom(channel, start2, *bufferToFill.buffer, source, bufferToFill.startSample + size1, size2);
+        }
+    }
+
+    fifo.finishedWrite(size1 + size2);
+
+    if (size1 + size2 < numSamples) {
+        droppedSamples.store(droppedSamples.load(std::memory_order_relaxed) + numSamples - size1 - size2, std::memory_order_relaxed);
+    }
+}
+
+//this function returns the file of the last or current recording
+File MasterRecorder::getRecordingFile() const
+{
+    return recordingFile;
+}
+
+//this function returns how much has been written to the file
+double MasterRecorder::getRecordedSeconds() const
+{
+    double rate = sampleRate.load();
+    return rate > 0.0 ? samplesWritten.load() / rate : 0.0;
+}
+
+//this function returns how many samples were lost because the disk could not keep up
+int64 MasterRecorder::getNumDroppedSamples() const
+{
+    return droppedSamples.load();
+}
+
+//this function returns whether the last recording stopped because the disk was full
+bool MasterRecorder::hasDiskFilledUp() const
+{
+    return diskFull.load();
+}
+
+//this function returns whether the last recording stopped because a write failed
+bool MasterRecorder::hasWriteFailed() const
+{
+    return writeFailed.load();
+}
+
+//this function makes a file name from the date and time, in the OtoDecks folder of the user's music
+File MasterRecorder::getDefaultRecordingFile(const String& extension)
+{
+    File folder = File::getSpecialLocation(File::userMusicDirectory).getChildFile("OtoDecks Recordings");
+    folder.createDirectory();
+    return folder.getNonexistentChildFile("Set " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M"), extension);
+}
+
+//this function runs on the writer thread, draining the fifo and watching the free disk space
+int MasterRecorder::useTimeSlice()
+{
+    const ScopedLock sl(writerLock);
+
+    if (writer == nullptr) {
+        return 100;
+    }
+
+    bool wroteSomething = writePendingData();
+
+    //checks the free space about once a second
+    uint32 now = Time::getMillisecondCounter();
+    if (writer != nullptr && now - lastSpaceCheckMs > 1000) {
+        lastSpaceCheckMs = now;
+        if (recordingFile.getBytesFreeOnVolume() < minimumFreeBytes) {
+            std::cout << "MasterRecorder: the disk is full, recording stopped" << std::endl;
+            diskFull = true;
+            recording.store(false, std::memory_order_release);
+            closeWriter();
+        }
+    }
+
+    return wroteSomething ? 0 : 20;
+}
+
+//this function writes everything in the fifo, returns whether anything was written
+bool MasterRecorder::writePendingData()
+{
+    int numReady = fifo.getNumReady();
+    if (numReady <= 0 || writer == nullptr) {
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    bool ok = true;
+    if (size1 > 0) {
+        ok = writer->writeFromAudioSampleBuffer(fifoBuffer, start1, size1);
+    }
+    if (ok && size2 > 0) {
+        ok = writer->writeFromAudioSampleBuffer(fifoBuffer, start2, size2);
+    }
+
+    fifo.finishedRead(size1 + size2);
+
+    if (ok) {
+        samplesWritten = samplesWritten.load() + size1 + size2;
+    }
+    else {
+        //a failed write on a nearly full disk is reported as a full disk
+        if (recordingFile.getBytesFreeOnVolume() < minimumFreeBytes) {
+            std::cout << "MasterRecorder: the disk is full, recording stopped" << std::endl;
+            diskFull = true;
+        }
+        else {
+            std::cout << "MasterRecorder: writing " << recordingFile.getFullPathName() << " failed, recording stopped" << std::endl;
+            writeFailed = true;
+        }
+        recording.store(false, std::memory_order_release);
+        closeWriter();
+    }
+    return true;
+}
+
+//this function deletes the writer, which finishes the file header
+void MasterRecorder::closeWriter()
+{
+    writer.reset();
+
+    int64 dropped = droppedSamples.load();
+    if (dropped > 0) {
+        std::cout << "MasterRecorder: " << dropped << " samples were dropped because the disk could not keep up" << std::endl;
+    }
+}
@@ -0,0 +1,70 @@
+/*====================================================================
+MasterRecorder.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class records the master output to a WAV or FLAC file. the audio thread only copies each block into a preallocated lock-free fifo,
+//a background thread encodes it and writes it to disk, so a slow or full disk can never block the audio callback
+class MasterRecorder : private TimeSliceClient
+{
+public:
+    //fifoSeconds is how much audio can wait for the disk before blocks are dropped
+    MasterRecorder(int numChannels = 2, double fifoSeconds = 10.0);
+    ~MasterRecorder() override;
+
+    //allocates the fifo for the device sample rate, a running recording is stopped if the rate changes
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    //starts recording to the file, FLAC if its extension is .flac and WAV otherwise
+    bool startRecording(const File& file);
+    void stopRecording();
+    bool isRecording() const;
+
+    //called on the audio thread with the master output, never blocks and never allocates
+    void pushBlock(const AudioSourceChannelInfo& bufferToFill);
+
+    //the state of the last or current recording, for the UI
+    File getRecordingFile() const;
+    double getRecordedSeconds() const;
+    int64 getNumDroppedSamples() const;
+    bool hasDiskFilledUp() const;
+    bool hasWriteFailed() const;
+
+    //a new file name in the user's music folder, with the extension of the format to record in (.wav or .flac)
+    static File getDefaultRecordingFile(const String& extension = ".wav");
+
+private:
+    int useTimeSlice() override;
+
+    //writes everything waiting in the fifo, called with writerLock held
+    bool writePendingData();
+    void closeWriter();
+
+    int numChannels;
+    double fifoSeconds;
+    //set on the message thread and read by the UI and the writer thread
+    std::atomic<double> sampleRate{ 0.0 };
+
+    AbstractFifo fifo{ 1 };
+    AudioBuffer<float> fifoBuffer;
+
+    //the writer is only used on the writer thread and on the message thread while starting or stopping
+    CriticalSection writerLock;
+    std::unique_ptr<AudioFormatWriter> writer;
+    File recordingFile;
+    uint32 lastSpaceCheckMs = 0;
+
+    std::atomic<bool> recording{ false };
+    std::atomic<int64> samplesWritten{ 0 };
+    std::atomic<int64> droppedSamples{ 0 };
+    std::atomic<bool> diskFull{ false };
+    std::atomic<bool> writeFailed{ false };
+
+    TimeSliceThread writerThread{ "Master recorder" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MasterRecorder)
+};
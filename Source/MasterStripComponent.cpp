@@ -0,0 +1,165 @@
+/*====================================================================
+MasterStripComponent.cpp
+This class draws the master strip. It starts and stops the MasterRecorder in the format chosen next to the record button and shows how
+long the set has been recorded for, and whether blocks were dropped or the recording stopped on a disk problem. The low latency button hands the buffer size to the
+BufferSizeTuner, and the buffer latency and headroom of the callback are shown next to it. On the right it shows the level of the
+master and how far the MasterLimiter is turning the mix down and the latency it adds.
+====================================================================*/
+
+
+#include "MasterStripComponent.h"
+
+MasterStripComponent::MasterStripComponent(MasterRecorder& _recorder, MasterLimiter& _limiter, LevelMeter& meter, BufferSizeTuner& _tuner)
+    : recorder(_recorder),
+      limiter(_limiter),
+      tuner(_tuner),
+      levelMeter(meter)
+{
+    //initializing and styling the record button
+    addAndMakeVisible(recordButton);
+    recordButton.addListener(this);
+    recordButton.setClickingTogglesState(true);
+    recordButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77)); //button background
+    recordButton.setColour(TextButton::buttonOnColourId, juce::Colours::darkred); //button background while recording
+    recordButton.setColour(TextButton::textColourOffId, juce::Colours::white); //text color
+    recordButton.setColour(TextButton::textColourOnId, juce::Colours::white); //text while recording
+
+    //the format selector is styled like the deck's effect selector, FLAC is lossless at about half the size
+    addAndMakeVisible(formatSelector);
+    formatSelector.addItem("WAV", 1);
+    formatSelector.addItem("FLAC", 2);
+    formatSelector.setSelectedId(1, dontSendNotification);
+    formatSelector.setColour(ComboBox::backgroundColourId, juce::Colour::fromRGB(39, 55, 77)); //box background
+    formatSelector.setColour(ComboBox::textColourId, juce::Colours::white); //text color
+
+    //the low latency button is darkcyan while it is on, the same as the deck toggles
+    addAndMakeVisible(lowLatencyButton);
+    lowLatencyButton.addListener(this);
+    lowLatencyButton.setClickingTogglesState(true);
+    lowLatencyButton.setColour(TextButton::buttonColourId, juce::Colour::fromRGB(39, 55, 77));
+    lowLatencyButton.setColour(TextButton::buttonOnColourId, juce::Colours::darkcyan);
+    lowLatencyButton.setColour(TextButton::textColourOffId, juce::Colours::white);
+    lowLatencyButton.setColour(TextButton::textColourOnId, juce::Colours::white);
+
+    addAndMakeVisible(levelMeter);
+
+    startTimer(250);
+}
+
+MasterStripComponent::~MasterStripComponent()
+{
+    stopTimer();
+}
+
+//this function paints the background and the recording status
+void MasterStripComponent::paint(Graphics& g)
+{
+    g.fillAll(Colour::fromRGB(29, 22, 22));
+
+    g.setColour(statusIsWarning ? Colours::orange : Colours::white);
+    g.setFont(getHeight() * 0.5f);
+    //the latency takes what it needs left of the meter and the status has the rest
+    int latencyWidth = g.getCurrentFont().getStringWidth(latencyText);
+    g.drawText(statusText, getLocalBounds().withTrimmedLeft(lowLatencyButton.getRight() + 10).withRight(levelMeter.getX() - 20 - latencyWidth),
+        Justification::centredLeft, true);
+
+    g.setColour(Colours::white);
+    g.drawText(latencyText, getLocalBounds().withRight(levelMeter.getX() - 10), Justification::centredRight, true);
+
+    g.setColour(Colours::white);
+    g.drawText(limiterText, getLocalBounds().withTrimmedRight(10), Justification::centredRight, true);
+}
+
+//this function lays out the record button and the meter, which leaves a quarter of the strip for the limiter on the right
+void MasterStripComponent::resized()
+{
+    recordButton.setBounds(0, 0, getWidth() / 12, getHeight());
+    formatSelector.setBounds(recordButton.getRight() + 4, 0, getWidth() / 16, getHeight());
+    lowLatencyButton.setBounds(formatSelector.getRight() + 4, 0, getWidth() / 12, getHeight());
+    levelMeter.setBounds(getWidth() / 2, 2, getWidth() / 4, getHeight() - 4);
+}
+
+//this function starts or stops the recording when the record button is toggled
+void MasterStripComponent::buttonClicked(Button* button)
+{
+    if (button == &recordButton) {
+        if (recordButton.getToggleState()) {
+            String extension = formatSelector.getSelectedId() == 2 ? ".flac" : ".wav";
+            if (!recorder.startRecording(MasterRecorder::getDefaultRecordingFile(extension))) {
+                recordButton.setToggleState(false, dontSendNotification);
+            }
+        }
+        else {
+            recorder.stopRecording();
+        }
+        timerCallback();
+    }
+
+    if (button == &lowLatencyButton) {
+        tuner.setEnabled(lowLatencyButton.getToggleState());
+    }
+}
+
+//this function refreshes the status text and releases the button if the recorder stopped on its own
+void MasterStripComponent::timerCallback()
+{
+    bool recording = recorder.isRecording();
+    if (!recording && recordButton.getToggleState()) {
+        recordButton.setToggleState(false, dontSendNotification);
+    }
+
+    //the format of a running recording cannot change
+    formatSelector.setEnabled(!recording);
+
+    //the mode can also be turned on from the command line
+    if (lowLatencyButton.getToggleState() != tuner.isEnabled()) {
+        lowLatencyButton.setToggleState(tuner.isEnabled(), dontSendNotification);
+    }
+
+    String newText;
+    bool warning = false;
+
+    File file = recorder.getRecordingFile();
+    if (file != File()) {
+        int seconds = (int) recorder.getRecordedSeconds();
+        newText = String::formatted("%02d:%02d:%02d", seconds / 3600, seconds / 60 % 60, seconds % 60) + "  " + file.getFileName();
+
+        if (recorder.hasDiskFilledUp()) {
+            newText += "  -  stopped, the disk is full";
+            warning = true;
+        }
+        else if (recorder.hasWriteFailed()) {
+            newText += "  -  stopped, writing failed";
+            warning = true;
+        }
+
+        int64 dropped = recorder.getNumDroppedSamples();
+        if (dropped > 0) {
+            newText += "  -  " + String(dropped) + " samples dropped";
+            warning = true;
+        }
+    }
+
+    //the reduction is only shown while the limiter is working
+    String newLimiterText = "Limiter";
+    float reduction = limiter.getGainReductionDb();
+    if (reduction < -0.1f) {
+        newLimiterText += " " + String(reduction, 1) + " dB";
+    }
+    newLimiterText += "  " + String(limiter.getLatencySeconds() * 1000.0, 1) + " ms";
+
+    //the buffer's own latency, the device and its driver add their own on top
+    String newLatencyText;
+    if (tuner.getBufferSize() > 0) {
+        newLatencyText = String(tuner.getBufferSize()) + " samples  " + String(tuner.getLatencySeconds() * 1000.0, 1) + " ms  headroom "
+                         + String(roundToInt(tuner.getHeadroom() * 100.0)) + "%";
+    }
+
+    if (newText != statusText || warning != statusIsWarning || newLimiterText != limiterText || newLatencyText != latencyText) {
+        statusText = newText;
+        statusIsWarning = warning;
+        limiterText = newLimiterText;
+        latencyText = newLatencyText;
+        repaint();
+    }
+}
@@ -0,0 +1,59 @@
+/*====================================================================
+MasterStripComponent.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MasterRecorder.h"
+#include "MasterLimiter.h"
+#include "LevelMeterComponent.h"
+#include "BufferSizeTuner.h"
+
+//this class is the strip between the decks and the playlist with the controls for the master output: the record button and the
+//format it records in, the state of the recording, the low latency mode with the buffer it chose, the level of the master and what the limiter is doing
+class MasterStripComponent : public Component,
+                             public Button::Listener,
+                             public Timer
+{
+public:
+    MasterStripComponent(MasterRecorder& recorder, MasterLimiter& limiter, LevelMeter& meter, BufferSizeTuner& tuner);
+    ~MasterStripComponent() override;
+
+    void paint(Graphics& g) override;
+    void resized() override;
+
+    void buttonClicked(Button* button) override;
+
+    //updates the recording time and warnings
+    void timerCallback() override;
+
+private:
+    MasterRecorder& recorder;
+    MasterLimiter& limiter;
+    BufferSizeTuner& tuner;
+
+    //starts and stops the recording, it stays pressed while recording
+    TextButton recordButton{ "Rec" };
+
+    //the format the next recording is written in, WAV or FLAC
+    ComboBox formatSelector;
+
+    //turns the low latency mode on and off
+    TextButton lowLatencyButton{ "Low latency" };
+
+    //the level of the master output, left of the limiter
+    LevelMeterComponent levelMeter;
+
+    //the recording time, file and any problems
+    String statusText;
+    bool statusIsWarning = false;
+
+    //the buffer latency and headroom, shown left of the meter
+    String latencyText;
+
+    //the limiter's gain reduction and latency, shown on the right
+    String limiterText;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MasterStripComponent)
+};
@@ -0,0 +1,288 @@
+/*====================================================================
+MidiController.cpp
+This class connects MIDI controllers to the decks. Every message is checked against the mapping table on the thread it arrives on.
+Every control becomes a command in the deck's queue, which the audio thread applies at the start of its next block, so the MIDI thread
+never waits on the transport. Play toggles the deck as the audio thread finds it, and a hot cue stores the playhead of that block.
+====================================================================*/
+
+
+#include "MidiController.h"
+#include <cmath>
+
+//the name used for each choice in the mapping file
+static const char* const messageNames[] = { "cc", "note", "pitchwheel" };
+static const char* const controlNames[] = { "volume", "speed", "bass", "mid", "treble", "jogTurn", "jogTouch", "playPause", "hotCue", "filter", "filterResonance" };
+
+//a jog wheel that has been still for longer than this is treated as starting from rest
+static constexpr double maxJogGapSeconds = 0.03;
+
+MidiController::MidiController(DJAudioPlayer& deck1, DJAudioPlayer& deck2, const Array<Mapping>& _mappings)
+    : decks{ &deck1, &deck2 },
+      mappings(_mappings)
+{
+}
+
+MidiController::~MidiController()
+{
+    closeInputs();
+}
+
+//this function opens every input device and the virtual input, messages start arriving straight away
+void MidiController::openInputs()
+{
+    closeInputs();
+
+    for (auto& device : MidiInput::getAvailableDevices()) {
+        if (auto input = MidiInput::openDevice(device.identifier, this)) {
+            input->start();
+            inputs.push_back(std::move(input));
+        }
+        else {
+            std::cout << "MidiController: could not open " << device.name << std::endl;
+        }
+    }
+
+   #if ! JUCE_WINDOWS
+    if (auto input = MidiInput::createNewDevice("OtoDecks", this)) {
+        input->start();
+        inputs.push_back(std::move(input));
+    }
+   #endif
+}
+
+//this function stops and closes the inputs, no callback runs after it returns
+void MidiController::closeInputs()
+{
+    for (auto& input : inputs) {
+        input->stop();
+    }
+    inputs.clear();
+}
+
+//this function handles a message that did not come from a device
+void MidiController::injectMessage(const MidiMessage& message)
+{
+    handleIncomingMidiMessage(nullptr, message);
+}
+
+//this function replaces the mapping table
+void MidiController::setMappings(const Array<Mapping>& newMappings)
+{
+    const ScopedLock sl(mappingLock);
+    mappings = newMappings;
+}
+
+//this function returns a copy of the mapping table
+Array<MidiController::Mapping> MidiController::getMappings() const
+{
+    const ScopedLock sl(mappingLock);
+    return mappings;
+}
+
+//this function applies every line of the table that matches the message, on the MIDI thread
+void MidiController::handleIncomingMidiMessage(MidiInput*, const MidiMessage& message)
+{
+    const ScopedLock sl(mappingLock);
+
+    for (const auto& mapping : mappings) {
+        if (matches(mapping, message)) {
+            apply(mapping, message);
+        }
+    }
+}
+
+//this function checks the channel, the kind of message and its number
+bool MidiController::matches(const Mapping& mapping, const MidiMessage& message)
+{
+    if (mapping.channel != 0 && !message.isForChannel(mapping.channel)) {
+        return false;
+    }
+
+    switch (mapping.message) {
+        case Mapping::Message::controller:
+            return message.isController() && message.getControllerNumber() == mapping.number;
+        case Mapping::Message::note:
+            return (message.isNoteOn() || message.isNoteOff()) && message.getNoteNumber() == mapping.number;
+        case Mapping::Message::pitchWheel:
+            return message.isPitchWheel();
+    }
+    return false;
+}
+
+//this function scales the message to the control's range and sends it to the deck
+void MidiController::apply(const Mapping& mapping, const MidiMessage& message)
+{
+    if (!isPositiveAndBelow(mapping.deck, 2)) {
+        return;
+    }
+
+    DJAudioPlayer& deck = *decks[mapping.deck];
+
+    //0 to 1 from a CC or the pitch wheel, and whether a button is down
+    double value = 0.0;
+    if (message.isController()) {
+        value = message.getControllerValue() / 127.0;
+    }
+    else if (message.isPitchWheel()) {
+        value = message.getPitchWheelValue() / 16383.0;
+    }
+    bool pressed = message.isNoteOn();
+
+    switch (mapping.control) {
+        case Mapping::Control::volume:
+            deck.pushCommand({ DJAudioPlayer::Command::Type::volume, value });
+            break;
+        case Mapping::Control::speed:
+            deck.pushCommand({ DJAudioPlayer::Command::Type::speed, 1.0 + (value * 2.0 - 1.0) * speedRange });
+            break;
+        case Mapping::Control::bass:
+            deck.pushCommand({ DJAudioPlayer::Command::Type::bass, value * maxEqGainDb });
+            break;
+        case Mapping::Control::mid:
+            deck.pushCommand({ DJAudioPlayer::Command::Type::mid, value * maxEqGainDb });
+            break;
+        case Mapping::Control::treble:
+            deck.pushCommand({ DJAudioPlayer::Command::Type::treble, value * maxEqGainDb });
+            break;
+        case Mapping::Control::filter:
+            //a knob has no exact middle, so the two steps either side of it are off
+            deck.pushCommand({ DJAudioPlayer::Command::Type::filter, std::abs(value * 2.0 - 1.0) < 1.5 / 127.0 ? 0.0 : value * 2.0 - 1.0 });
+            break;
+        case Mapping::Control::filterResonance:
+            deck.pushCommand({ DJAudioPlayer::Command::Type::filterResonance, value });
+            break;
+        case Mapping::Control::jogTurn:
+            if (message.isController()) {
+                int ticks = message.getControllerValue();
+                applyJogTurn(mapping.deck, ticks < 64 ? ticks : ticks - 128);
+            }
+            break;
+        case Mapping::Control::jogTouch:
+            jogs[mapping.deck] = {};
+            jogs[mapping.deck].touched = pressed;
+            deck.pushCommand({ pressed ? DJAudioPlayer::Command::Type::scratchBegin : DJAudioPlayer::Command::Type::scratchEnd, 0.0 });
+            break;
+        case Mapping::Control::playPause:
+            if (pressed) {
+                deck.pushCommand({ DJAudioPlayer::Command::Type::togglePlay, 0.0 });
+            }
+            break;
+        case Mapping::Control::hotCue:
+            deck.pushCommand({ pressed ? DJAudioPlayer::Command::Type::hotCueTrigger : DJAudioPlayer::Command::Type::hotCueRelease,
+                               (double) mapping.index });
+            break;
+    }
+}
+
+//this function turns jog ticks into the velocity of a held record, or nudges a deck that is playing on its own
+void MidiController::applyJogTurn(int deckIndex, int ticks)
+{
+    DJAudioPlayer& deck = *decks[deckIndex];
+
+    //the deck only takes hold of the record in its next block, so the touch is kept here for the ticks that follow it at once
+    if (!jogs[deckIndex].touched) {
+        deck.pushCommand({ DJAudioPlayer::Command::Type::nudge, ticks * nudgePerTick });
+        return;
+    }
+
+    JogState& jog = jogs[deckIndex];
+    double now = Time::getMillisecondCounterHiRes() / 1000.0;
+    double elapsed = jlimit(0.001, maxJogGapSeconds, now - jog.lastSeconds);
+    jog.lastSeconds = now;
+
+    //controllers send ticks in uneven bursts, so the velocity is averaged with the last one a little
+    double rate = (double) ticks / ticksPerTurn * ScratchEngine::secondsPerTurn / elapsed;
+    jog.velocity = 0.5 * jog.velocity + 0.5 * rate;
+    deck.pushCommand({ DJAudioPlayer::Command::Type::jogVelocity, jog.velocity });
+}
+
+//this function returns the layout described in the header
+Array<MidiController::Mapping> MidiController::getDefaultMappings()
+{
+    using Message = Mapping::Message;
+    using Control = Mapping::Control;
+
+    Array<Mapping> table;
+
+    for (int deck = 0; deck < 2; ++deck) {
+        int channel = deck + 1;
+
+        table.add({ channel, Message::controller, 7, deck, Control::volume });
+        table.add({ channel, Message::controller, 13, deck, Control::speed });
+        table.add({ channel, Message::controller, 16, deck, Control::bass });
+        table.add({ channel, Message::controller, 17, deck, Control::mid });
+        table.add({ channel, Message::controller, 18, deck, Control::treble });
+        table.add({ channel, Message::controller, 19, deck, Control::filter });
+        table.add({ channel, Message::controller, 20, deck, Control::filterResonance });
+        table.add({ channel, Message::controller, 22, deck, Control::jogTurn });
+        table.add({ channel, Message::note, 54, deck, Control::jogTouch });
+        table.add({ channel, Message::note, 11, deck, Control::playPause });
+
+        for (int pad = 0; pad < DJAudioPlayer::numHotCues; ++pad) {
+            table.add({ channel, Message::note, pad, deck, Control::hotCue, pad });
+        }
+    }
+
+    return table;
+}
+
+//this function returns where the mapping table is saved
+File MidiController::getDefaultMappingFile()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory)
+        .getChildFile("OtoDecks")
+        .getChildFile("midi-mapping.xml");
+}
+
+//this function reads the table, skipping lines with a name it does not know
+Array<MidiController::Mapping> MidiController::loadMappings(const File& file)
+{
+    Array<Mapping> table;
+
+    std::unique_ptr<XmlElement> xml = XmlDocument::parse(file);
+    if (xml == nullptr || !xml->hasTagName("MIDIMAPPING")) {
+        return table;
+    }
+
+    for (auto* line : xml->getChildWithTagNameIterator("MAP")) {
+        int message = StringArray(messageNames, numElementsInArray(messageNames)).indexOf(line->getStringAttribute("message"));
+        int control = StringArray(controlNames, numElementsInArray(controlNames)).indexOf(line->getStringAttribute("control"));
+        if (message < 0 || control < 0) {
+            std::cout << "MidiController: unknown mapping in " << file.getFullPathName() << std::endl;
+            continue;
+        }
+
+        Mapping mapping;
+        mapping.channel = line->getIntAttribute("channel");
+        mapping.message = (Mapping::Message) message;
+        mapping.number = line->getIntAttribute("number");
+        mapping.deck = line->getIntAttribute("deck", 1) - 1;
+        mapping.control = (Mapping::Control) control;
+        mapping.index = line->getIntAttribute("index");
+        table.add(mapping);
+    }
+
+    return table;
+}
+
+//this function writes the table, decks are numbered from 1 in the file
+bool MidiController::saveMappings(const Array<Mapping>& table, const File& file)
+{
+    XmlElement xml("MIDIMAPPING");
+
+    for (const auto& mapping : table) {
+        auto* line = xml.createNewChildElement("MAP");
+        line->setAttribute("channel", mapping.channel);
+        line->setAttribute("message", messageNames[(int) mapping.message]);
+        line->setAttribute("number", mapping.number);
+        line->setAttribute("deck", mapping.deck + 1);
+        line->setAttribute("control", controlNames[(int) mapping.control]);
+
+        if (mapping.control == Mapping::Control::hotCue) {
+            line->setAttribute("index", mapping.index);
+        }
+    }
+
+    file.getParentDirectory().createDirectory();
+    return xml.writeTo(file);
+}
@@ -0,0 +1,115 @@
+/*====================================================================
+MidiController.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+
+//this class takes MIDI from DJ controllers and moves the decks with it. messages are handled on the MIDI thread as they arrive and every
+//change, buttons included, goes through each deck's command queue, so it is heard in the next audio block without waiting for the
+//message thread. which control does what comes from a mapping table that can be edited in a file
+class MidiController : private MidiInputCallback
+{
+public:
+    //one line of the mapping table
+    struct Mapping
+    {
+        enum class Message
+        {
+            controller,   //a CC, 0 to 127
+            note,         //note on and off, for buttons and pads
+            pitchWheel    //14 bit, used by some controllers for the pitch faders
+        };
+
+        enum class Control
+        {
+            volume,
+            speed,        //+/- speedRange around normal speed
+            bass,         //EQ knobs, over the same range as the sliders
+            mid,
+            treble,
+            jogTurn,      //relative CC in two's complement (1 is one tick forwards, 127 one tick back)
+            jogTouch,     //the touch sensor on top of the jog wheel, a note
+            playPause,
+            hotCue,
+            filter,           //the filter knob, low-pass below the centre and high-pass above it
+            filterResonance   //how much the filter rings at its cutoff
+        };
+
+        int channel = 0;                     //1 to 16, 0 matches every channel
+        Message message = Message::controller;
+        int number = 0;                      //controller or note number, not used for the pitch wheel
+        int deck = 0;                        //0 for the left deck, 1 for the right
+        Control control = Control::volume;
+        int index = 0;                       //the pad of a hot cue
+    };
+
+    //how far the pitch fader moves the speed either side of normal
+    static constexpr double speedRange = 0.08;
+
+    //the range of the EQ knobs in dB, the same as the sliders
+    static constexpr double maxEqGainDb = 6.0;
+
+    //jog wheel ticks in one turn, and how much one tick nudges the speed of a deck that is not held
+    static constexpr int ticksPerTurn = 128;
+    static constexpr double nudgePerTick = 0.005;
+
+    MidiController(DJAudioPlayer& deck1, DJAudioPlayer& deck2, const Array<Mapping>& mappings = getDefaultMappings());
+    ~MidiController() override;
+
+    //opens every MIDI input, and a virtual input called "OtoDecks" that other programs and test tools can send to (not on Windows)
+    void openInputs();
+    void closeInputs();
+
+    //handles a message exactly as if a device had sent it, from any thread
+    void injectMessage(const MidiMessage& message);
+
+    //replaces the mapping table
+    void setMappings(const Array<Mapping>& newMappings);
+    Array<Mapping> getMappings() const;
+
+    //deck 1 on channel 1 and deck 2 on channel 2: CC 7 volume, CC 13 pitch, CC 16-18 bass, mid and treble, CC 19 filter, CC 20 filter
+    //resonance, CC 22 jog,
+    //note 54 jog touch, note 11 play and notes 0-7 the hot cues
+    static Array<Mapping> getDefaultMappings();
+
+    //where the user's mapping table is kept
+    static File getDefaultMappingFile();
+
+    //reads a table written by saveMappings, returning an empty table if the file cannot be read
+    static Array<Mapping> loadMappings(const File& file);
+    static bool saveMappings(const Array<Mapping>& mappings, const File& file);
+
+private:
+    //what a jog wheel did last, only used on the MIDI thread
+    struct JogState
+    {
+        double lastSeconds = 0.0;
+        double velocity = 0.0;
+        bool touched = false;
+    };
+
+    void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
+
+    //checks a message against one line of the table
+    static bool matches(const Mapping& mapping, const MidiMessage& message);
+
+    //turns a matching message into a change on the deck
+    void apply(const Mapping& mapping, const MidiMessage& message);
+
+    //a jog message carries the ticks turned since the last one, which become a scratch velocity or a nudge
+    void applyJogTurn(int deck, int ticks);
+
+    DJAudioPlayer* decks[2];
+    JogState jogs[2];
+
+    //the table is only swapped on the message thread, the lock keeps the MIDI threads from reading it halfway
+    CriticalSection mappingLock;
+    Array<Mapping> mappings;
+
+    std::vector<std::unique_ptr<MidiInput>> inputs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiController)
+};
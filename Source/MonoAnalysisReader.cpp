@@ -0,0 +1,82 @@
+/*====================================================================
+MonoAnalysisReader.cpp
+This class is shared by all the background analysis. It decodes a file in fixed size blocks, mixes it down to mono and resamples it
+to the rate the analysis runs at.
+====================================================================*/
+
+
+#include "MonoAnalysisReader.h"
+
+MonoAnalysisReader::MonoAnalysisReader(AudioFormatReader& _reader, double targetSampleRate, int _blockSize)
+    : reader(_reader),
+      ratio(_reader.sampleRate / targetSampleRate),
+      blockSize(_blockSize),
+      readBuffer(jmax(1, (int) _reader.numChannels), _blockSize),
+      monoBuffer(1, _blockSize * 2)
+{
+}
+
+//this function resamples the mono samples that are waiting into dest, decoding another block whenever it runs short
+int MonoAnalysisReader::read(float* dest, int maxSamples)
+{
+    int produced = 0;
+
+    while (produced < maxSamples)
+    {
+        //the interpolator can use one sample more than the ratio suggests, so keep a sample in reserve
+        int numOut = jmin(maxSamples - produced, (int) ((monoAvailable - 1) / ratio));
+
+        if (numOut <= 0) {
+            if (!refill()) {
+                break;
+            }
+            continue;
+        }
+
+        int used = interpolator.process(ratio, monoBuffer.getReadPointer(0, monoStart), dest + produced, numOut);
+        monoStart += used;
+        monoAvailable -= used;
+        produced += numOut;
+    }
+
+    return produced;
+}
+
+//this function decodes the next block of the file and appends its mono mix to the waiting samples
+bool MonoAnalysisReader::refill()
+{
+    int numToRead = (int) jmin((int64) blockSize, reader.lengthInSamples - readPosition);
+    if (numToRead <= 0) {
+        return false;
+    }
+
+    //move the samples that are still waiting to the front
+    if (monoStart > 0) {
+        float* mono = monoBuffer.getWritePointer(0);
+        std::memmove(mono, mono + monoStart, sizeof(float) * (size_t) monoAvailable);
+        monoStart = 0;
+    }
+
+    reader.read(&readBuffer, 0, numToRead, readPosition, true, true);
+
+    if (onBlockDecoded != nullptr) {
+        onBlockDecoded(readBuffer, readPosition, numToRead);
+    }
+    readPosition += numToRead;
+
+    int numChannels = readBuffer.getNumChannels();
+    monoBuffer.copyFrom(0, monoAvailable, readBuffer, 0, 0, numToRead);
+    for (int channel = 1; channel < numChannels; ++channel) {
+        monoBuffer.addFrom(0, monoAvailable, readBuffer, channel, 0, numToRead);
+    }
+    monoBuffer.applyGain(0, monoAvailable, numToRead, 1.0f / numChannels);
+
+    monoAvailable += numToRead;
+    return true;
+}
+
+//this function returns how much of the file has been decoded so far
+double MonoAnalysisReader::getProgress() const
+{
+    return reader.lengthInSamples > 0 ? (double) readPosition / (double) reader.lengthInSamples : 1.0;
+}
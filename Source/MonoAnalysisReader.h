@@ -0,0 +1,42 @@
+/*====================================================================
+MonoAnalysisReader.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <functional>
+
+//this class reads a whole file block by block as a single mono channel at the sample rate the analysis wants, so analysis code never has to hold the full track in memory
+class MonoAnalysisReader
+{
+public:
+    MonoAnalysisReader(AudioFormatReader& reader, double targetSampleRate, int blockSize = 8192);
+
+    //fills dest with up to maxSamples samples and returns how many were written, 0 means the end of the file
+    int read(float* dest, int maxSamples);
+
+    //how far through the file the reader is, from 0 to 1
+    double getProgress() const;
+
+    //called with every block as it is decoded, before the mixdown, so analysis that needs all channels at the file's own rate
+    //(loudness, waveforms) can share the decoding pass
+    std::function<void(const AudioBuffer<float>& block, int64 startSample, int numSamples)> onBlockDecoded;
+
+private:
+    bool refill();
+
+    AudioFormatReader& reader;
+    double ratio;
+    int blockSize;
+
+    AudioBuffer<float> readBuffer;
+    AudioBuffer<float> monoBuffer;
+    int monoStart = 0;
+    int monoAvailable = 0;
+    int64 readPosition = 0;
+
+    LagrangeInterpolator interpolator;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MonoAnalysisReader)
+};
@@ -0,0 +1,316 @@
+/*====================================================================
+ParallelTrackDecoder.cpp
+This class decodes a whole track into RAM with jobs on the JobScheduler's deck class. The buffer is allocated once for the full length
+and cut into chunks, each with a state the jobs claim with a compare and swap, so no two jobs decode the same chunk and no lock is
+held while decoding. A job decodes one chunk a run and then goes to the back of the queue, so a deck's other jobs are never held up
+behind a whole track. Every job reads through its own AudioFormatReader into its chunk's place in the buffer, and the audio thread
+only ever reads the chunks that are marked done. A chunk that cannot be read is tried again a few times and then marked failed, and
+the last job to stop fails whatever nobody took, so the decoder always finishes and reports the failure instead of waiting.
+====================================================================*/
+
+
+#include "ParallelTrackDecoder.h"
+#include "Tracer.h"
+
+//one job claims and decodes a chunk with its own reader each time it runs, until there are none left
+class ParallelTrackDecoder::DecodeJob : public ThreadPoolJob
+{
+public:
+    DecodeJob(ParallelTrackDecoder& _owner)
+        : ThreadPoolJob("Decode track"),
+          owner(_owner)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        //the reader is opened on the first run and kept for the next ones
+        if (reader == nullptr) {
+            reader.reset(owner.createReader());
+            if (reader == nullptr) {
+                std::cout << "ParallelTrackDecoder: a job cannot open the track" << std::endl;
+                return finish();
+            }
+        }
+
+        int chunk = shouldExit() ? -1 : owner.claimNextChunk();
+        if (chunk < 0) {
+            return finish();
+        }
+
+        //no other job may be left to take the chunk, so this one tries it again with a fresh reader before it gives up
+        int attempt = 1;
+        while (!owner.decodeChunk(*reader, chunk) && attempt < maxAttempts && !shouldExit()) {
+            ++attempt;
+            reader.reset(owner.createReader());
+            if (reader == nullptr) {
+                break;
+            }
+        }
+
+        if (owner.chunkStates[chunk].load() != done) {
+            std::cout << "ParallelTrackDecoder: chunk " << chunk << " cannot be decoded after " << attempt << " attempts" << std::endl;
+            owner.chunkStates[chunk].store(failed, std::memory_order_release);
+            owner.numChunksFailed.fetch_add(1);
+        }
+        owner.chunkFinished();
+
+        return reader != nullptr ? jobNeedsRunningAgain : finish();
+    }
+
+private:
+    //how many times a job reads a chunk before it marks it failed
+    static constexpr int maxAttempts = 3;
+
+    JobStatus finish()
+    {
+        owner.jobFinished(shouldExit());
+        return jobHasFinished;
+    }
+
+    ParallelTrackDecoder& owner;
+    std::unique_ptr<AudioFormatReader> reader;
+};
+
+ParallelTrackDecoder::ParallelTrackDecoder(std::function<AudioFormatReader*()> _createReader, JobScheduler& _jobScheduler)
+    : createReader(std::move(_createReader)),
+      jobScheduler(_jobScheduler)
+{
+}
+
+ParallelTrackDecoder::~ParallelTrackDecoder()
+{
+    //asks the jobs to stop after their chunk and waits for them
+    jobScheduler.removeJobs(this, 10000);
+}
+
+//this function opens the track once for its length, allocates the whole buffer and queues the jobs
+bool ParallelTrackDecoder::start()
+{
+    std::unique_ptr<AudioFormatReader> reader(createReader());
+    if (reader == nullptr) {
+        return false;
+    }
+
+    if (reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0) {
+        return false;
+    }
+
+    if (reader->lengthInSamples > (int64) (maxSeconds * reader->sampleRate)) {
+        std::cout << "ParallelTrackDecoder::start track should be shorter than " << maxSeconds << " seconds to decode whole" << std::endl;
+        return false;
+    }
+
+    lengthInSamples = reader->lengthInSamples;
+    sampleRate = reader->sampleRate;
+    floatingPointData = reader->usesFloatingPointData;
+    canSeek = canSeekIn(*reader);
+
+    //the raw channel pointers are taken once here, so the jobs never touch the buffer object itself
+    int numChannels = jlimit(1, 2, (int) reader->numChannels);
+    buffer.setSize(numChannels, (int) lengthInSamples);
+    for (int channel = 0; channel < numChannels; ++channel) {
+        channels[channel] = buffer.getWritePointer(channel);
+    }
+
+    numChunks = (int) ((lengthInSamples + chunkSize - 1) / chunkSize);
+    chunkStates.reset(new std::atomic<uint8>[(size_t) numChunks]);
+    for (int chunk = 0; chunk < numChunks; ++chunk) {
+        chunkStates[chunk].store(waiting);
+    }
+
+    //one worker is left for the deck's other jobs, like its waveform
+    startTime = Time::getMillisecondCounterHiRes();
+    numJobs = canSeek ? jmin(jmax(1, jobScheduler.getNumWorkers() - 1), numChunks) : 1;
+    numJobsRunning = numJobs;
+    for (int job = 0; job < numJobs; ++job) {
+        jobScheduler.addJob(new DecodeJob(*this), JobScheduler::Priority::deck, this, true);
+    }
+    return true;
+}
+
+void ParallelTrackDecoder::setPriorityPosition(int64 sample)
+{
+    priorityPosition.store(sample, std::memory_order_relaxed);
+}
+
+//this function checks the state of every chunk the range touches
+bool ParallelTrackDecoder::isRangeDecoded(int64 first, int64 last) const
+{
+    if (first < 0 || last > lengthInSamples || first >= last) {
+        return false;
+    }
+
+    int lastChunk = (int) ((last - 1) / chunkSize);
+    for (int chunk = (int) (first / chunkSize); chunk <= lastChunk; ++chunk) {
+        if (chunkStates[chunk].load(std::memory_order_acquire) != done) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//this function walks out from the sample's chunk to the first chunk on each side that is not decoded
+Range<int64> ParallelTrackDecoder::getDecodedRangeAround(int64 sample) const
+{
+    if (sample < 0 || sample >= lengthInSamples) {
+        return {};
+    }
+
+    int chunk = (int) (sample / chunkSize);
+    if (chunkStates[chunk].load(std::memory_order_acquire) != done) {
+        return {};
+    }
+
+    int first = chunk;
+    while (first > 0 && chunkStates[first - 1].load(std::memory_order_acquire) == done) {
+        --first;
+    }
+
+    int last = chunk + 1;
+    while (last < numChunks && chunkStates[last].load(std::memory_order_acquire) == done) {
+        ++last;
+    }
+
+    return { (int64) first * chunkSize, jmin(lengthInSamples, (int64) last * chunkSize) };
+}
+
+bool ParallelTrackDecoder::isFinished() const
+{
+    return numChunks > 0 && numChunksDone.load() == numChunks;
+}
+
+bool ParallelTrackDecoder::hasFailed() const
+{
+    return numChunksFailed.load() > 0;
+}
+
+float ParallelTrackDecoder::getProgress() const
+{
+    return numChunks > 0 ? (float) numChunksDone.load() / (float) numChunks : 0.0f;
+}
+
+const AudioBuffer<float>& ParallelTrackDecoder::getBuffer() const
+{
+    return buffer;
+}
+
+int64 ParallelTrackDecoder::getLengthInSamples() const
+{
+    return lengthInSamples;
+}
+
+double ParallelTrackDecoder::getSampleRate() const
+{
+    return sampleRate;
+}
+
+//this function checks whether the reader's stream can be moved to any place, which is what lets each job start in the middle. a stream
+//of unknown length, or one that cannot go back, is read from the start like the format would read it while playing
+bool ParallelTrackDecoder::canSeekIn(AudioFormatReader& reader)
+{
+    InputStream* input = reader.input;
+    if (input == nullptr || input->getTotalLength() <= 0) {
+        return false;
+    }
+
+    int64 position = input->getPosition();
+    bool seeks = input->setPosition(input->getTotalLength() / 2) && input->getPosition() == input->getTotalLength() / 2
+                 && input->setPosition(0) && input->getPosition() == 0;
+    input->setPosition(position);
+    return seeks;
+}
+
+//this function claims the waiting chunk nearest to the priority position. the chunks after it come first, because the playhead is
+//most likely to move forward, so a chunk behind it counts as twice as far away. a track that cannot seek is taken in order
+int ParallelTrackDecoder::claimNextChunk()
+{
+    int priorityChunk = canSeek ? (int) jlimit((int64) 0, (int64) numChunks - 1, priorityPosition.load(std::memory_order_relaxed) / chunkSize) : 0;
+
+    while (true)
+    {
+        int best = -1;
+        int bestDistance = std::numeric_limits<int>::max();
+        for (int chunk = 0; chunk < numChunks; ++chunk) {
+            if (chunkStates[chunk].load(std::memory_order_relaxed) != waiting) {
+                continue;
+            }
+
+            int distance = chunk >= priorityChunk ? chunk - priorityChunk : (priorityChunk - chunk) * 2;
+            if (distance < bestDistance) {
+                best = chunk;
+                bestDistance = distance;
+            }
+        }
+
+        if (best < 0) {
+            return -1;
+        }
+
+        //another job may have taken it since the scan, then the scan is done again
+        uint8 expected = waiting;
+        if (chunkStates[best].compare_exchange_strong(expected, decoding)) {
+            return best;
+        }
+    }
+}
+
+//this function reads a chunk into its place in the buffer. it reads through the raw channel pointers like AudioBuffer's own read does,
+//converting integer samples to floats in place
+bool ParallelTrackDecoder::decodeChunk(AudioFormatReader& reader, int chunk)
+{
+    Tracer::Scope trace("ParallelTrackDecoder::decodeChunk", Tracer::Category::loading);
+    int64 start = (int64) chunk * chunkSize;
+    int numSamples = (int) jmin((int64) chunkSize, lengthInSamples - start);
+    int numChannels = buffer.getNumChannels();
+
+    int* destChannels[2] = {};
+    for (int channel = 0; channel < numChannels; ++channel) {
+        destChannels[channel] = reinterpret_cast<int*>(channels[channel] + start);
+    }
+
+    if (!reader.read(destChannels, numChannels, start, numSamples, false)) {
+        return false;
+    }
+
+    if (!floatingPointData) {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* samples = channels[channel] + start;
+            FloatVectorOperations::convertFixedToFloat(samples, reinterpret_cast<const int*>(samples), 1.0f / (float) 0x7fffffff, numSamples);
+        }
+    }
+
+    chunkStates[chunk].store(done, std::memory_order_release);
+    return true;
+}
+
+//this function counts a finished or failed chunk and reports the decoding time once the last one is done
+void ParallelTrackDecoder::chunkFinished()
+{
+    if (numChunksDone.fetch_add(1) + 1 == numChunks) {
+        double seconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        std::cout << "ParallelTrackDecoder: decoded " << lengthInSamples / sampleRate << " s of audio in " << seconds
+                  << " s with " << numJobs << " jobs";
+        if (hasFailed()) {
+            std::cout << ", " << numChunksFailed.load() << " chunks failed";
+        }
+        std::cout << std::endl;
+    }
+}
+
+//this function fails the chunks nobody took once the last job stops, so a track whose jobs all lost their reader still finishes.
+//jobs that were asked to exit leave them, as the decoder is going away
+void ParallelTrackDecoder::jobFinished(bool exiting)
+{
+    if (numJobsRunning.fetch_sub(1) != 1 || exiting) {
+        return;
+    }
+
+    for (int chunk = 0; chunk < numChunks; ++chunk) {
+        uint8 expected = waiting;
+        if (chunkStates[chunk].compare_exchange_strong(expected, failed)) {
+            numChunksFailed.fetch_add(1);
+            chunkFinished();
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/*====================================================================
+ParallelTrackDecoder.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "JobScheduler.h"
+#include <atomic>
+#include <functional>
+
+//this class decodes a whole track into one buffer in RAM with several deck jobs on the JobScheduler at once. the track is split into
+//chunks and every job opens its own reader, takes the chunk nearest to the playhead that nobody has started and decodes it straight into
+//its place in the buffer, so the audio around the playhead is ready first and the rest fills in behind it. a track whose reader cannot
+//seek is decoded from the start by one job. the audio thread can read any chunk that is finished while the others are still being decoded
+class ParallelTrackDecoder : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<ParallelTrackDecoder>;
+
+    //the samples of one chunk, about 1.5 s at 44.1 kHz
+    static constexpr int chunkSize = 65536;
+
+    //the longest track that is decoded whole, a stereo hour is about 1.3 GB
+    static constexpr double maxSeconds = 3600.0;
+
+    //createReader is called once for the length and once by every job, so each one has a reader of its own
+    ParallelTrackDecoder(std::function<AudioFormatReader*()> createReader, JobScheduler& jobScheduler);
+    ~ParallelTrackDecoder() override;
+
+    //opens the track, allocates the buffer and queues the jobs. returns false if the track cannot be read or is too long
+    bool start();
+
+    //the decoding goes on from the chunk nearest to this sample, called from any thread
+    void setPriorityPosition(int64 sample);
+
+    //whether every sample from first up to (not including) last is decoded, from any thread
+    bool isRangeDecoded(int64 first, int64 last) const;
+
+    //the run of decoded chunks a sample is in, empty if its own chunk is not decoded yet
+    Range<int64> getDecodedRangeAround(int64 sample) const;
+
+    //whether every chunk has been decoded or has failed
+    bool isFinished() const;
+
+    //whether a chunk could not be decoded, those samples are left for the callers to read from the file
+    bool hasFailed() const;
+
+    //the share of the chunks that are decoded, from 0 to 1
+    float getProgress() const;
+
+    //the decoded track, only the ranges isRangeDecoded reports as finished may be read
+    const AudioBuffer<float>& getBuffer() const;
+    int64 getLengthInSamples() const;
+    double getSampleRate() const;
+
+private:
+    class DecodeJob;
+
+    enum ChunkState : uint8
+    {
+        waiting,
+        decoding,
+        done,
+        failed
+    };
+
+    //whether the reader's stream can be moved anywhere in the file, which decides if the chunks can be decoded out of order
+    static bool canSeekIn(AudioFormatReader& reader);
+
+    //claims the waiting chunk nearest to the priority position, -1 when none is left
+    int claimNextChunk();
+
+    //decodes a chunk into its place in the buffer with a job's reader
+    bool decodeChunk(AudioFormatReader& reader, int chunk);
+
+    void chunkFinished();
+
+    //fails the chunks left waiting when the last job stops
+    void jobFinished(bool exiting);
+
+    std::function<AudioFormatReader*()> createReader;
+    JobScheduler& jobScheduler;
+    bool canSeek = false;
+    int numJobs = 0;
+
+    AudioBuffer<float> buffer;
+    float* channels[2] = {};
+    bool floatingPointData = true;
+    int64 lengthInSamples = 0;
+    double sampleRate = 0.0;
+
+    int numChunks = 0;
+    std::unique_ptr<std::atomic<uint8>[]> chunkStates;
+    std::atomic<int> numChunksDone{ 0 };
+    std::atomic<int> numChunksFailed{ 0 };
+    std::atomic<int> numJobsRunning{ 0 };
+    std::atomic<int64> priorityPosition{ 0 };
+    double startTime = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelTrackDecoder)
+};
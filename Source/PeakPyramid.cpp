@@ -0,0 +1,190 @@
+/*====================================================================
+PeakPyramid.cpp
+This class keeps the peaks of a track as a mipmap. The builder finds the min and max of every baseSamplesPerPeak samples across the
+channels with FloatVectorOperations, and as soon as both peaks under a peak of the next level are done that one is worked out too,
+so every level fills in together while the track is decoded. Only the finest level is saved, the rest takes a moment to rebuild.
+====================================================================*/
+
+
+#include "PeakPyramid.h"
+
+PeakPyramid::PeakPyramid(int64 _lengthInSamples, double _sampleRate)
+    : lengthInSamples(jmax((int64) 0, _lengthInSamples)),
+      sampleRate(_sampleRate)
+{
+    int numPeaks = jmax(1, (int) ((lengthInSamples + baseSamplesPerPeak - 1) / baseSamplesPerPeak));
+
+    //halves until the whole track is a single peak
+    while (true) {
+        auto* level = levels.add(new Level());
+        level->numPeaks = numPeaks;
+        level->peaks.resize((size_t) numPeaks * 2, 0);
+
+        if (numPeaks == 1) {
+            break;
+        }
+        numPeaks = (numPeaks + 1) / 2;
+    }
+}
+
+//this function picks the level to draw a zoom from
+int PeakPyramid::getLevelFor(double samplesPerPixel) const
+{
+    int level = 0;
+    while (level + 1 < levels.size() && getSamplesPerPeak(level + 1) <= samplesPerPixel) {
+        ++level;
+    }
+    return level;
+}
+
+//this function returns one peak of a level
+Range<float> PeakPyramid::getPeak(int level, int index) const
+{
+    const auto& peaks = levels[level]->peaks;
+    return { dequantise(peaks[(size_t) index * 2]), dequantise(peaks[(size_t) index * 2 + 1]) };
+}
+
+//this function goes up the levels from a finished peak, as long as it finished the pair under the next peak
+void PeakPyramid::storeParents(int level, int index)
+{
+    while (level + 1 < levels.size() && (index % 2 == 1 || index == levels[level]->numPeaks - 1)) {
+        ++level;
+        index /= 2;
+        storeParent(level, index);
+    }
+}
+
+//this function takes the lowest min and the highest max of the one or two peaks under a peak
+void PeakPyramid::storeParent(int level, int index)
+{
+    const Level& below = *levels[level - 1];
+    Level& above = *levels[level];
+
+    int first = index * 2;
+    int8 minimum = below.peaks[(size_t) first * 2];
+    int8 maximum = below.peaks[(size_t) first * 2 + 1];
+
+    if (first + 1 < below.numPeaks) {
+        minimum = jmin(minimum, below.peaks[(size_t) first * 2 + 2]);
+        maximum = jmax(maximum, below.peaks[(size_t) first * 2 + 3]);
+    }
+
+    above.peaks[(size_t) index * 2] = minimum;
+    above.peaks[(size_t) index * 2 + 1] = maximum;
+    above.numReady.store(index + 1, std::memory_order_release);
+}
+
+//this function turns a sample between -1 and 1 into a byte
+int8 PeakPyramid::quantise(float value)
+{
+    return (int8) roundToInt(jlimit(-1.0f, 1.0f, value) * 127.0f);
+}
+
+//this function turns a stored byte back into a sample between -1 and 1
+float PeakPyramid::dequantise(int8 value)
+{
+    return value / 127.0f;
+}
+
+//identifies the saved data and its layout
+static constexpr int fileMagic = 0x4f545050; //"OTPP"
+static constexpr int fileVersion = 1;
+
+//this function writes the header and the finest level
+bool PeakPyramid::writeTo(OutputStream& stream) const
+{
+    const Level& base = *levels[0];
+
+    stream.writeInt(fileMagic);
+    stream.writeInt(fileVersion);
+    stream.writeInt64(lengthInSamples);
+    stream.writeDouble(sampleRate);
+    stream.writeInt(baseSamplesPerPeak);
+    stream.writeInt(base.numReady.load());
+    return stream.write(base.peaks.data(), base.peaks.size());
+}
+
+//this function reads a pyramid written by writeTo and rebuilds the levels above the finest, it is complete as soon as it is returned
+PeakPyramid::Ptr PeakPyramid::readFrom(InputStream& stream)
+{
+    if (stream.readInt() != fileMagic || stream.readInt() != fileVersion) {
+        return nullptr;
+    }
+
+    int64 length = stream.readInt64();
+    double rate = stream.readDouble();
+    int peakSize = stream.readInt();
+    int peaksReady = stream.readInt();
+
+    if (length <= 0 || rate <= 0.0 || peakSize != baseSamplesPerPeak) {
+        return nullptr;
+    }
+
+    Ptr pyramid = new PeakPyramid(length, rate);
+    Level& base = *pyramid->levels[0];
+    if (peaksReady != base.numPeaks || stream.read(base.peaks.data(), (int) base.peaks.size()) != (int) base.peaks.size()) {
+        return nullptr;
+    }
+    base.numReady.store(base.numPeaks, std::memory_order_release);
+
+    for (int level = 1; level < pyramid->levels.size(); ++level) {
+        for (int index = 0; index < pyramid->levels[level]->numPeaks; ++index) {
+            pyramid->storeParent(level, index);
+        }
+    }
+    return pyramid;
+}
+
+PeakPyramid::Builder::Builder(PeakPyramid& _target)
+    : target(_target)
+{
+}
+
+//this function collects the min and max of every peak the block covers, over all its channels
+void PeakPyramid::Builder::process(const AudioBuffer<float>& block, int numSamples)
+{
+    int position = 0;
+    while (position < numSamples)
+    {
+        int segment = jmin(numSamples - position, baseSamplesPerPeak - samplesInPeak);
+
+        for (int channel = 0; channel < block.getNumChannels(); ++channel) {
+            auto range = FloatVectorOperations::findMinAndMax(block.getReadPointer(channel, position), segment);
+            minimum = jmin(minimum, range.getStart());
+            maximum = jmax(maximum, range.getEnd());
+        }
+
+        position += segment;
+        samplesInPeak += segment;
+
+        if (samplesInPeak == baseSamplesPerPeak) {
+            storePeak();
+        }
+    }
+}
+
+//this function stores the last peak if it was only partly filled
+void PeakPyramid::Builder::finish()
+{
+    if (samplesInPeak > 0) {
+        storePeak();
+    }
+}
+
+//this function writes the current peak, makes it visible to the display and fills in the levels above it
+void PeakPyramid::Builder::storePeak()
+{
+    Level& base = *target.levels[0];
+
+    if (nextPeak < base.numPeaks) {
+        base.peaks[(size_t) nextPeak * 2] = quantise(minimum);
+        base.peaks[(size_t) nextPeak * 2 + 1] = quantise(maximum);
+        base.numReady.store(nextPeak + 1, std::memory_order_release);
+        target.storeParents(0, nextPeak);
+        ++nextPeak;
+    }
+
+    minimum = 0.0f;
+    maximum = 0.0f;
+    samplesInPeak = 0;
+}
@@ -0,0 +1,89 @@
+/*====================================================================
+PeakPyramid.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <vector>
+
+//this class holds the min/max peaks of a track at every zoom: the first level has one peak per baseSamplesPerPeak samples and each
+//level above it halves the one below, so any zoom is drawn from at most two or three peaks per pixel without touching the audio.
+//it is filled from a background thread while the display reads the peaks that are already finished
+class PeakPyramid : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<PeakPyramid>;
+
+    //the finest level, about 1.5 ms at 44.1 kHz
+    static constexpr int baseSamplesPerPeak = 64;
+
+    PeakPyramid(int64 lengthInSamples, double sampleRate);
+
+    int getNumLevels() const { return levels.size(); }
+    int getSamplesPerPeak(int level) const { return baseSamplesPerPeak << level; }
+    int getNumPeaks(int level) const { return levels[level]->numPeaks; }
+    int getNumPeaksReady(int level) const { return levels[level]->numReady.load(std::memory_order_acquire); }
+
+    //the top level is filled in last, from the last peak of the finest level
+    bool isFinished() const { return getNumPeaksReady(getNumLevels() - 1) == getNumPeaks(getNumLevels() - 1); }
+
+    double getSampleRate() const { return sampleRate; }
+    int64 getLengthInSamples() const { return lengthInSamples; }
+
+    //the coarsest level whose peaks are no wider than samplesPerPixel, 0 when zoomed in further than the finest level
+    int getLevelFor(double samplesPerPixel) const;
+
+    //the lowest and highest sample under a peak, from -1 to 1
+    Range<float> getPeak(int level, int index) const;
+
+    //saves the finest level of a finished pyramid to a stream and reads it back, the levels above it are rebuilt on reading.
+    //readFrom returns nullptr if the data is not a peak pyramid
+    bool writeTo(OutputStream& stream) const;
+    static Ptr readFrom(InputStream& stream);
+
+    //this class fills a PeakPyramid block by block during the decoding pass
+    class Builder
+    {
+    public:
+        Builder(PeakPyramid& target);
+
+        void process(const AudioBuffer<float>& block, int numSamples);
+        void finish();
+
+    private:
+        void storePeak();
+
+        PeakPyramid& target;
+
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        int samplesInPeak = 0;
+        int nextPeak = 0;
+    };
+
+private:
+    struct Level
+    {
+        int numPeaks = 0;
+
+        //the min and max of each peak, one byte each
+        std::vector<int8> peaks;
+        std::atomic<int> numReady{ 0 };
+    };
+
+    //works out a peak of a level from the two under it and makes it visible, going on up while it finished a pair
+    void storeParents(int level, int index);
+    void storeParent(int level, int index);
+
+    static int8 quantise(float value);
+    static float dequantise(int8 value);
+
+    int64 lengthInSamples;
+    double sampleRate;
+
+    OwnedArray<Level> levels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakPyramid)
+};
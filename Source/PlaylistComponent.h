@@ -1,68 +1,108 @@
-/*====================================================================
-PlaylistComponent.h
-====================================================================*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include <vector>
-#include <string>
-
-class DeckGUI;
-
-//this class represents a playlist UI element for loading and managing tracks in a DJ-style audio player interface
-class PlaylistComponent  : public juce::Component, public TableListBoxModel, public Button::Listener
-{
-public:
-    PlaylistComponent(DeckGUI& deck1, DeckGUI& deck2);
-    ~PlaylistComponent() override;
-
-    void paint (juce::Graphics&) override;
-
-    void resized() override;
-    
-    int getNumRows() override;
-
-    void paintRowBackground(Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override;
-
-    void paintCell(Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override;
-
-    void buttonClicked(Button* button) override;
-
-    void onRowSelected(int rowIndex);
-
-    //functions to get, remove and search for tracks
-    juce::URL getTrack(int index) const;
-
-    void removeTrack(int rowNumber);
-
-    void searchTracks();
-
-    //to draw all the buttons for each cells
-    Component* refreshComponentForCell(int rowNumber, int columnId, bool isRowSelected, Component* existingComponentToUpdate) override;
-
-
-private:
-    //to choose the file
-    juce::FileChooser fChooser{ "Select a file..." };
-
-    //for users to search for audio
-    juce::TextEditor searchBox;
-
-    //table for the playlist
-    TableListBox tableComponent;
-
-    //vectors to store all the tracks loaded
-    std::vector<juce::File> tracks;
-    std::vector<juce::File> filteredTracks;
-
-
-    DeckGUI& deckGUI1; //reference to the first DeckGUI instance
-    DeckGUI& deckGUI2; //reference to the second DeckGUI instance
-    DeckGUI* activeDeckGUI; //pointer to the currently active DeckGU
-
-    //load button
-    juce::TextButton loadButton{ "Load" };
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlaylistComponent)
-};
+/*====================================================================
+PlaylistComponent.h
+====================================================================*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include <string>
+#include "TrackLibrary.h"
+#include "TrackAnalyser.h"
+#include "AutoMixEngine.h"
+#include "PlaylistImporter.h"
+
+class DeckGUI;
+
+//this class represents a playlist UI element for loading and managing tracks in a DJ-style audio player interface
+class PlaylistComponent  : public juce::Component, public TableListBoxModel, public Button::Listener, public ChangeListener, public Timer
+{
+public:
+    PlaylistComponent(DeckGUI& deck1, DeckGUI& deck2, TrackLibrary& library, TrackAnalyser& analyser);
+    ~PlaylistComponent() override;
+
+    void paint (juce::Graphics&) override;
+
+    void resized() override;
+    
+    int getNumRows() override;
+
+    void paintRowBackground(Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override;
+
+    void paintCell(Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override;
+
+    void buttonClicked(Button* button) override;
+
+    //repaints the table when the library receives new analysis results
+    void changeListenerCallback(ChangeBroadcaster* source) override;
+
+    //keeps the deck 1 suggestions up to date while the deck plays
+    void timerCallback() override;
+
+    void onRowSelected(int rowIndex);
+
+    //functions to get, remove and search for tracks
+    juce::URL getTrack(int index) const;
+
+    void removeTrack(int rowNumber);
+
+    void searchTracks();
+
+    //checks if a track mixes harmonically with what is playing on deck 1
+    bool isCompatibleWithDeck1(const juce::File& track) const;
+
+    //to draw all the buttons for each cells
+    Component* refreshComponentForCell(int rowNumber, int columnId, bool isRowSelected, Component* existingComponentToUpdate) override;
+
+    //the tracks on screen are analysed ahead of the rest of the library
+    void listWasScrolled() override;
+
+
+private:
+    //to choose the file
+    juce::FileChooser fChooser{ "Select a file..." };
+
+    //for users to search for audio
+    juce::TextEditor searchBox;
+
+    //table for the playlist
+    TableListBox tableComponent;
+
+    //vectors to store all the tracks loaded
+    std::vector<juce::File> tracks;
+    std::vector<juce::File> filteredTracks;
+
+
+    DeckGUI& deckGUI1; //reference to the first DeckGUI instance
+    DeckGUI& deckGUI2; //reference to the second DeckGUI instance
+    DeckGUI* activeDeckGUI; //pointer to the currently active DeckGU
+
+    TrackLibrary& trackLibrary; //reference to the library that holds the analysis results
+    TrackAnalyser& trackAnalyser; //reference to the background analyser
+
+    //tells the analyser which tracks are on the rows on screen when they change
+    void updateVisibleTracks();
+    Array<int> visibleTrackIds;
+
+    //load button
+    juce::TextButton loadButton{ "Load" };
+
+    //imports a playlist or another DJ program's collection
+    juce::TextButton importButton{ "Import" };
+    juce::FileChooser importChooser{ "Select a playlist...", File(), PlaylistImporter::getFileWildcard() };
+    PlaylistImporter importer{ trackLibrary, trackAnalyser.getJobScheduler() };
+
+    //toggles showing only tracks that mix with deck 1
+    juce::TextButton matchButton{ "Match Deck 1" };
+
+    //the compatible tracks found by the last query, sorted by id
+    std::vector<int> compatibleTrackIds;
+
+    //toggles automix through the playlist
+    juce::TextButton automixButton{ "Automix" };
+
+    //mixes the playlist across both decks while automix is on
+    AutoMixEngine autoMix{ deckGUI1, deckGUI2, *this, trackLibrary };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlaylistComponent)
+};
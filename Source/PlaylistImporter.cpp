@@ -0,0 +1,651 @@
+/*====================================================================
+PlaylistImporter.cpp
+This class imports playlists and collections a piece at a time. M3U and PLS files are read line by line, and the XML exports go
+through a small scanner that reads the stream in blocks and reports one tag or one text at a time, so only the current batch of
+locations is ever held. The import thread fills a batch, hands it to the JobScheduler as a library job and only waits once a few
+batches are in flight. Batches are committed to the library oldest first, so the tracks keep the order of the playlist.
+====================================================================*/
+
+
+#include "PlaylistImporter.h"
+#include "Tracer.h"
+
+//a track as the playlist gives it, and a second place to look for it (Traktor only knows the disk by its name on a mac)
+struct PlaylistImporter::Location
+{
+    String path;
+    String alternative;
+};
+
+namespace
+{
+    //decodes the %XX escapes of a file URL as UTF-8. URL::removeEscapeChars is not used because it also turns + into a space
+    String decodePercentEscapes(const String& text)
+    {
+        if (!text.containsChar('%')) {
+            return text;
+        }
+
+        MemoryOutputStream bytes;
+        const char* data = text.toRawUTF8();
+
+        for (int i = 0; data[i] != 0; ++i) {
+            int high, low;
+            if (data[i] == '%' && (high = CharacterFunctions::getHexDigitValue((juce_wchar) data[i + 1])) >= 0
+                && (low = CharacterFunctions::getHexDigitValue((juce_wchar) data[i + 2])) >= 0) {
+                bytes.writeByte((char) (high * 16 + low));
+                i += 2;
+            }
+            else {
+                bytes.writeByte(data[i]);
+            }
+        }
+
+        return bytes.toUTF8();
+    }
+
+    //turns a playlist location into a file: a file URL, an absolute path, or a path relative to the playlist's folder
+    File resolveLocation(const String& location, const File& baseFolder)
+    {
+        String path = location.trim();
+
+        if (path.startsWithIgnoreCase("file:")) {
+            path = decodePercentEscapes(path.substring(5));
+
+            //file://localhost/path, file:///path and file:/path all mean /path, file://server/share is a network share
+            if (path.startsWithIgnoreCase("//localhost/")) {
+                path = path.substring(11);
+            }
+            else if (path.startsWith("///")) {
+                path = path.substring(2);
+            }
+
+           #if JUCE_WINDOWS
+            //a drive letter comes after the slash, /C:/Music
+            if (path.length() > 2 && path[0] == '/' && path[2] == ':') {
+                path = path.substring(1);
+            }
+           #endif
+        }
+
+       #if ! JUCE_WINDOWS
+        //playlists written on windows use backslashes
+        path = path.replaceCharacter('\\', '/');
+       #endif
+
+        if (path.isEmpty()) {
+            return {};
+        }
+
+        return File::isAbsolutePath(path) ? File(path) : baseFolder.getChildFile(path);
+    }
+
+    //replaces the five named entities and the numbered ones
+    String decodeEntities(const String& text)
+    {
+        if (!text.containsChar('&')) {
+            return text;
+        }
+
+        String result;
+        int start = 0;
+        int ampersand;
+        while ((ampersand = text.indexOfChar(start, '&')) >= 0) {
+            int semicolon = text.indexOfChar(ampersand, ';');
+            if (semicolon < 0) {
+                break;
+            }
+
+            result += text.substring(start, ampersand);
+            String entity = text.substring(ampersand + 1, semicolon);
+
+            if (entity == "amp")       result += "&";
+            else if (entity == "lt")   result += "<";
+            else if (entity == "gt")   result += ">";
+            else if (entity == "quot") result += "\"";
+            else if (entity == "apos") result += "'";
+            else if (entity.startsWithIgnoreCase("#x")) result += String::charToString((juce_wchar) entity.substring(2).getHexValue32());
+            else if (entity.startsWith("#"))            result += String::charToString((juce_wchar) entity.substring(1).getIntValue());
+            else                       result += text.substring(ampersand, semicolon + 1);
+
+            start = semicolon + 1;
+        }
+
+        return result + text.substring(start);
+    }
+
+    //reads XML a block at a time and reports the start tags with their attributes, the end tags and the text in between. it knows
+    //just enough XML for the collection exports: comments, CDATA and declarations are handled, namespaces and DTDs are not
+    class XmlTagScanner
+    {
+    public:
+        std::function<void(const String& tagName, const StringPairArray& attributes)> onStartTag;
+        std::function<void(const String& tagName)> onEndTag;
+        std::function<void(const String& text)> onText;
+
+        //returns false if it was stopped before the end of the stream
+        bool scan(InputStream& stream, const std::function<bool()>& shouldStop)
+        {
+            HeapBlock<char> block(blockSize);
+
+            while (!stream.isExhausted())
+            {
+                if (shouldStop()) {
+                    return false;
+                }
+
+                int numRead = stream.read(block.getData(), blockSize);
+                if (numRead <= 0) {
+                    break;
+                }
+
+                for (int i = 0; i < numRead; ++i) {
+                    process(block[i]);
+                }
+            }
+            return true;
+        }
+
+    private:
+        enum class Mode
+        {
+            text,
+            tag,
+            comment,
+            cdata,
+            declaration
+        };
+
+        static constexpr int blockSize = 65536;
+
+        void process(char c)
+        {
+            switch (mode)
+            {
+                case Mode::text:
+                    if (c == '<') {
+                        emitText();
+                        mode = Mode::tag;
+                        quote = 0;
+                    }
+                    else {
+                        append(c);
+                    }
+                    break;
+
+                case Mode::tag:
+                    if (quote != 0) {
+                        append(c);
+                        if (c == quote) {
+                            quote = 0;
+                        }
+                    }
+                    else if (c == '>') {
+                        handleTag();
+                        token.clear();
+                        mode = Mode::text;
+                    }
+                    else {
+                        append(c);
+                        startSpecialTag(c);
+                    }
+                    break;
+
+                case Mode::comment:
+                    //a comment ends at the first -->
+                    if (c == '>' && closingChars >= 2) {
+                        mode = Mode::text;
+                    }
+                    closingChars = c == '-' ? closingChars + 1 : 0;
+                    break;
+
+                case Mode::cdata:
+                    //CDATA is text that ends at the first ]]>
+                    if (c == '>' && closingChars >= 2) {
+                        token.resize(token.size() - 2);
+                        emitText();
+                        mode = Mode::text;
+                    }
+                    else {
+                        append(c);
+                    }
+                    closingChars = c == ']' ? closingChars + 1 : 0;
+                    break;
+
+                case Mode::declaration:
+                    if (c == '>') {
+                        token.clear();
+                        mode = Mode::text;
+                    }
+                    break;
+            }
+        }
+
+        //switches to the mode of a comment, CDATA or declaration once the start of the tag shows which one it is
+        void startSpecialTag(char c)
+        {
+            if (token[0] == '?') {
+                mode = Mode::declaration;
+            }
+            else if (token[0] == '!') {
+                if (token == "!--") {
+                    mode = Mode::comment;
+                    token.clear();
+                    closingChars = 0;
+                }
+                else if (token == "![CDATA[") {
+                    mode = Mode::cdata;
+                    token.clear();
+                    closingChars = 0;
+                }
+                else if (std::string("!--").compare(0, token.size(), token) != 0 && std::string("![CDATA[").compare(0, token.size(), token) != 0) {
+                    mode = Mode::declaration;
+                }
+            }
+            else if (c == '"' || c == '\'') {
+                quote = c;
+            }
+        }
+
+        void append(char c)
+        {
+            if ((int) token.size() < PlaylistImporter::maxTokenLength) {
+                token.push_back(c);
+            }
+        }
+
+        //reports the text unless it is only the whitespace between tags
+        void emitText()
+        {
+            bool whitespace = std::all_of(token.begin(), token.end(), [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; });
+            if (!whitespace && onText != nullptr) {
+                onText(decodeEntities(String::fromUTF8(token.data(), (int) token.size()).trim()));
+            }
+            token.clear();
+        }
+
+        //splits a tag into its name and attributes
+        void handleTag()
+        {
+            if (token.empty()) {
+                return;
+            }
+
+            if (token[0] == '/') {
+                if (onEndTag != nullptr) {
+                    onEndTag(String::fromUTF8(token.data() + 1, (int) token.size() - 1).trim());
+                }
+                return;
+            }
+
+            bool selfClosing = token.back() == '/';
+            size_t end = selfClosing ? token.size() - 1 : token.size();
+
+            size_t pos = 0;
+            while (pos < end && !isspace((unsigned char) token[pos])) {
+                ++pos;
+            }
+            String tagName = String::fromUTF8(token.data(), (int) pos);
+
+            StringPairArray attributes;
+            while (pos < end)
+            {
+                while (pos < end && isspace((unsigned char) token[pos])) {
+                    ++pos;
+                }
+
+                size_t nameStart = pos;
+                while (pos < end && token[pos] != '=' && !isspace((unsigned char) token[pos])) {
+                    ++pos;
+                }
+                size_t nameEnd = pos;
+
+                while (pos < end && token[pos] != '"' && token[pos] != '\'') {
+                    ++pos;
+                }
+                if (pos >= end) {
+                    break;
+                }
+
+                char valueQuote = token[pos++];
+                size_t valueStart = pos;
+                while (pos < end && token[pos] != valueQuote) {
+                    ++pos;
+                }
+
+                attributes.set(String::fromUTF8(token.data() + nameStart, (int) (nameEnd - nameStart)),
+                               decodeEntities(String::fromUTF8(token.data() + valueStart, (int) (pos - valueStart))));
+                ++pos;
+            }
+
+            if (onStartTag != nullptr) {
+                onStartTag(tagName, attributes);
+            }
+            if (selfClosing && onEndTag != nullptr) {
+                onEndTag(tagName);
+            }
+        }
+
+        Mode mode = Mode::text;
+        std::string token;
+        char quote = 0;
+        int closingChars = 0;
+    };
+}
+
+//one batch of locations, turned into files that exist on a scheduler worker
+class PlaylistImporter::ResolveJob : public ThreadPoolJob
+{
+public:
+    ResolveJob(const File& _baseFolder)
+        : ThreadPoolJob("Resolve playlist tracks"),
+          baseFolder(_baseFolder)
+    {
+        locations.reserve((size_t) batchSize);
+    }
+
+    void add(Location location)
+    {
+        locations.push_back(std::move(location));
+    }
+
+    int getNumLocations() const
+    {
+        return (int) locations.size();
+    }
+
+    JobStatus runJob() override
+    {
+        files.ensureStorageAllocated((int) locations.size());
+
+        for (const auto& location : locations) {
+            if (shouldExit()) {
+                return jobHasFinished;
+            }
+
+            File file = resolveLocation(location.path, baseFolder);
+            if (!file.existsAsFile() && location.alternative.isNotEmpty()) {
+                file = resolveLocation(location.alternative, baseFolder);
+            }
+
+            if (file.existsAsFile()) {
+                files.add(file);
+            }
+            else {
+                ++numMissing;
+            }
+        }
+
+        //the locations are not needed any more, so a finished batch only holds its files
+        locations.clear();
+        locations.shrink_to_fit();
+        return jobHasFinished;
+    }
+
+    Array<File> files;
+    int numMissing = 0;
+
+private:
+    File baseFolder;
+    std::vector<Location> locations;
+};
+
+PlaylistImporter::PlaylistImporter(TrackLibrary& _library, JobScheduler& _jobScheduler)
+    : Thread("Playlist import"),
+      library(_library),
+      jobScheduler(_jobScheduler)
+{
+}
+
+PlaylistImporter::~PlaylistImporter()
+{
+    //the import thread removes its batches as it stops, anything still on the scheduler is removed here
+    cancel();
+    jobScheduler.removeJobs(this, 10000);
+    cancelPendingUpdate();
+}
+
+//this function checks the format and starts the import thread
+bool PlaylistImporter::startImport(const File& file)
+{
+    if (!file.hasFileExtension(getFileWildcard().removeCharacters("*"))) {
+        std::cout << "PlaylistImporter::startImport file should be an M3U, PLS, XML or NML playlist" << std::endl;
+        return false;
+    }
+
+    cancel();
+
+    {
+        const ScopedLock sl(resultLock);
+        importedFiles.clear();
+        importedIds.clear();
+        finished = false;
+        numImported = 0;
+        numMissing = 0;
+    }
+
+    importFile = file;
+    startThread(Thread::Priority::low);
+    return true;
+}
+
+//this function stops the parser and the resolve jobs, the batches already committed stay in the library
+void PlaylistImporter::cancel()
+{
+    stopThread(10000);
+}
+
+bool PlaylistImporter::isImporting() const
+{
+    return isThreadRunning();
+}
+
+String PlaylistImporter::getFileWildcard()
+{
+    return "*.m3u;*.m3u8;*.pls;*.xml;*.nml";
+}
+
+//this function streams the locations out of the file into batches and commits them as they are resolved
+void PlaylistImporter::run()
+{
+    Tracer::Scope trace("PlaylistImporter::run", Tracer::Category::loading);
+    startTime = Time::getMillisecondCounterHiRes();
+
+    std::unique_ptr<FileInputStream> stream(importFile.createInputStream());
+    File baseFolder = importFile.getParentDirectory();
+    int maxPendingBatches = jobScheduler.getConcurrencyLimit(JobScheduler::Priority::library) * maxPendingBatchesPerWorker;
+
+    std::unique_ptr<ResolveJob> batch;
+    auto submitBatch = [&]() {
+        pendingBatches.add(batch.get());
+        jobScheduler.addJob(batch.release(), JobScheduler::Priority::library, this, false);
+
+        //the parser waits here once enough batches are in flight, which keeps the memory bounded
+        while (pendingBatches.size() >= maxPendingBatches && !threadShouldExit()) {
+            commitOldestBatch();
+        }
+    };
+
+    auto addLocation = [&](Location location) {
+        if (batch == nullptr) {
+            batch.reset(new ResolveJob(baseFolder));
+        }
+        batch->add(std::move(location));
+
+        if (batch->getNumLocations() == batchSize) {
+            submitBatch();
+        }
+    };
+
+    bool read = false;
+    if (stream != nullptr && stream->openedOk()) {
+        if (importFile.hasFileExtension("m3u;m3u8")) {
+            read = readM3u(*stream, addLocation);
+        }
+        else if (importFile.hasFileExtension("pls")) {
+            read = readPls(*stream, addLocation);
+        }
+        else {
+            read = readXml(*stream, addLocation);
+        }
+    }
+    else {
+        std::cout << "PlaylistImporter: cannot open " << importFile.getFullPathName() << std::endl;
+    }
+
+    if (batch != nullptr && !threadShouldExit()) {
+        submitBatch();
+    }
+
+    while (!pendingBatches.isEmpty() && !threadShouldExit()) {
+        commitOldestBatch();
+    }
+
+    //a cancelled import drops the batches that were not committed
+    jobScheduler.removeJobs(this, 10000);
+    pendingBatches.clear();
+
+    std::cout << "PlaylistImporter: " << numImported << " tracks imported, " << numMissing << " not found, from "
+              << importFile.getFileName() << " in " << (Time::getMillisecondCounterHiRes() - startTime) / 1000.0 << " s"
+              << (read ? "" : " (stopped early)") << std::endl;
+
+    {
+        const ScopedLock sl(resultLock);
+        finished = true;
+    }
+    triggerAsyncUpdate();
+}
+
+//this function reads an M3U or M3U8 playlist, where every line that is not a comment is a track
+bool PlaylistImporter::readM3u(InputStream& stream, const std::function<void(Location)>& addLocation)
+{
+    while (!stream.isExhausted())
+    {
+        if (threadShouldExit()) {
+            return false;
+        }
+
+        //an M3U8 file may start with a byte order mark
+        String line = stream.readNextLine().trimCharactersAtStart(String::charToString((juce_wchar) 0xfeff)).trim();
+        if (line.isNotEmpty() && !line.startsWithChar('#') && line.length() <= maxTokenLength) {
+            addLocation({ line, {} });
+        }
+    }
+    return true;
+}
+
+//this function reads a PLS playlist, where the tracks are the FileN= entries
+bool PlaylistImporter::readPls(InputStream& stream, const std::function<void(Location)>& addLocation)
+{
+    while (!stream.isExhausted())
+    {
+        if (threadShouldExit()) {
+            return false;
+        }
+
+        String line = stream.readNextLine().trim();
+        if (line.startsWithIgnoreCase("File") && line.containsChar('=') && line.length() <= maxTokenLength) {
+            addLocation({ line.fromFirstOccurrenceOf("=", false, false).trim(), {} });
+        }
+    }
+    return true;
+}
+
+//this function reads the tracks of the XML collections it knows: rekordbox TRACK Location, VirtualDJ Song FilePath, Traktor LOCATION
+//and the Location keys of an iTunes or Music library plist
+bool PlaylistImporter::readXml(InputStream& stream, const std::function<void(Location)>& addLocation)
+{
+    XmlTagScanner scanner;
+    String currentTag;
+    String lastKey;
+
+    scanner.onStartTag = [&](const String& tagName, const StringPairArray& attributes) {
+        currentTag = tagName;
+
+        if (tagName == "TRACK" && attributes.containsKey("Location")) {
+            addLocation({ attributes["Location"], {} });
+        }
+        else if (tagName == "Song" && attributes.containsKey("FilePath")) {
+            addLocation({ attributes["FilePath"], {} });
+        }
+        else if (tagName == "LOCATION" && attributes.containsKey("FILE")) {
+            //Traktor writes /:Users/:me/:Music/: for the folder and the disk on its own
+            String path = attributes["DIR"].replace("/:", "/") + attributes["FILE"];
+           #if JUCE_WINDOWS
+            addLocation({ attributes["VOLUME"] + path, {} });
+           #else
+            addLocation({ path, "/Volumes/" + attributes["VOLUME"] + path });
+           #endif
+        }
+    };
+
+    scanner.onEndTag = [&](const String& tagName) {
+        currentTag = {};
+
+        //a plist value belongs to the key just before it
+        if (tagName != "key") {
+            lastKey = {};
+        }
+    };
+
+    scanner.onText = [&](const String& text) {
+        if (currentTag == "key") {
+            lastKey = text;
+        }
+        else if (currentTag == "string" && lastKey == "Location") {
+            addLocation({ text, {} });
+        }
+    };
+
+    return scanner.scan(stream, [this] { return threadShouldExit(); });
+}
+
+//this function waits for the oldest batch, adds its files to the library in one go and passes them on to the message thread
+void PlaylistImporter::commitOldestBatch()
+{
+    ResolveJob* job = pendingBatches.getFirst();
+    while (!jobScheduler.waitForJobToFinish(job, 100))
+    {
+        if (threadShouldExit()) {
+            return;
+        }
+    }
+
+    std::vector<int> trackIds = library.addTracks(job->files);
+
+    {
+        const ScopedLock sl(resultLock);
+        importedFiles.addArray(job->files);
+        importedIds.insert(importedIds.end(), trackIds.begin(), trackIds.end());
+        numImported += job->files.size();
+        numMissing += job->numMissing;
+    }
+
+    pendingBatches.remove(0);
+    triggerAsyncUpdate();
+}
+
+//this function hands the committed tracks to the playlist and reports the end of the import
+void PlaylistImporter::handleAsyncUpdate()
+{
+    Array<File> files;
+    std::vector<int> trackIds;
+    bool done;
+    int imported, missing;
+    {
+        const ScopedLock sl(resultLock);
+        files.swapWith(importedFiles);
+        trackIds.swap(importedIds);
+        done = finished;
+        imported = numImported;
+        missing = numMissing;
+    }
+
+    if (!files.isEmpty() && onTracksImported != nullptr) {
+        onTracksImported(files, trackIds);
+    }
+
+    if (done && onFinished != nullptr) {
+        onFinished(imported, missing, threadShouldExit());
+    }
+}
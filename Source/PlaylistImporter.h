@@ -0,0 +1,78 @@
+/*====================================================================
+PlaylistImporter.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TrackLibrary.h"
+#include "JobScheduler.h"
+#include <functional>
+
+//this class imports the tracks of a playlist or of another DJ program's collection into the library: M3U and M3U8, PLS, rekordbox and
+//VirtualDJ XML, Traktor NML and the iTunes / Music library XML. the file is read as a stream, a line or a tag at a time, so a
+//collection of a hundred thousand tracks never sits in memory as a whole. the locations are handed out in batches as library jobs on the
+//JobScheduler that turn them into files and check the files exist, and each batch goes into the library under one lock, in the
+//playlist's order. the file is read on a thread of its own and the tracks are reported batch by batch on the message thread
+class PlaylistImporter : private Thread,
+                         private AsyncUpdater
+{
+public:
+    //the locations resolved by one job, and how many batches may be waiting at once for each worker of the library class, so the
+    //memory stays bounded
+    static constexpr int batchSize = 1024;
+    static constexpr int maxPendingBatchesPerWorker = 2;
+
+    //the longest line, tag or text the parsers keep, anything longer is cut short
+    static constexpr int maxTokenLength = 65536;
+
+    PlaylistImporter(TrackLibrary& library, JobScheduler& jobScheduler);
+    ~PlaylistImporter() override;
+
+    //starts importing a file, stopping an import that is still running. returns false if its format is not known
+    bool startImport(const File& file);
+    void cancel();
+    bool isImporting() const;
+
+    //the file patterns that can be imported
+    static String getFileWildcard();
+
+    //called on the message thread with each batch of tracks that exist, in the playlist's order, and once at the end with the
+    //number imported, the number that could not be found and whether it was stopped early
+    std::function<void(const Array<File>& files, const std::vector<int>& trackIds)> onTracksImported;
+    std::function<void(int numImported, int numMissing, bool cancelled)> onFinished;
+
+private:
+    class ResolveJob;
+    struct Location;
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    //reads the locations out of each format and passes them on as they are found, returns false if the file cannot be read
+    bool readM3u(InputStream& stream, const std::function<void(Location)>& addLocation);
+    bool readPls(InputStream& stream, const std::function<void(Location)>& addLocation);
+    bool readXml(InputStream& stream, const std::function<void(Location)>& addLocation);
+
+    //finishes the oldest batch, adds its tracks to the library and queues them for the message thread
+    void commitOldestBatch();
+
+    TrackLibrary& library;
+    JobScheduler& jobScheduler;
+
+    File importFile;
+
+    //the batches being resolved, oldest first. only the import thread touches them
+    OwnedArray<ResolveJob> pendingBatches;
+
+    //the tracks waiting for the message thread
+    CriticalSection resultLock;
+    Array<File> importedFiles;
+    std::vector<int> importedIds;
+    bool finished = false;
+    int numImported = 0;
+    int numMissing = 0;
+    double startTime = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlaylistImporter)
+};
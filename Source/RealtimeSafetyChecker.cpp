@@ -0,0 +1,396 @@
+/*====================================================================
+RealtimeSafetyChecker.cpp
+This file replaces the global operator new and delete and, on linux, interposes the pthread and libc functions that can block, so
+any call of them from inside the audio callback is reported. The hooks only read thread-local flags until a violation is found, and a
+thread that is reporting is never reported again, so printing the stack trace cannot recurse.
+====================================================================*/
+
+
+#include "RealtimeSafetyChecker.h"
+
+#if OTODECKS_RT_CHECK
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+//the state of each thread, plain thread-locals so the hooks never allocate or lock to read them
+static thread_local int audioCallbackDepth = 0;
+static thread_local int allowanceDepth = 0;
+static thread_local bool isReporting = false;
+
+static std::atomic<int> numViolations{ 0 };
+
+//only the first reports get a full stack trace, after that they are only counted
+static constexpr int maxPrintedViolations = 20;
+
+//the functions whose own locks are allowed, none until the code running the callback allows them
+static StringArray& getAllowedLockCallers()
+{
+    static StringArray callers;
+    return callers;
+}
+
+static CriticalSection& getAllowedLockCallersLock()
+{
+    static CriticalSection lock;
+    return lock;
+}
+
+static const char* getViolationName(RealtimeSafetyChecker::Violation kind)
+{
+    switch (kind)
+    {
+        case RealtimeSafetyChecker::Violation::allocation:   return "allocation";
+        case RealtimeSafetyChecker::Violation::deallocation: return "deallocation";
+        case RealtimeSafetyChecker::Violation::lock:         return "lock";
+        case RealtimeSafetyChecker::Violation::blockingCall: return "blocking call";
+    }
+    return "";
+}
+
+//this function finds the first frame of the backtrace that is not the checker, the lock wrapper or the hooked function
+static String findCallingFrame(const String& backtrace)
+{
+    StringArray frames = StringArray::fromLines(backtrace);
+    StringArray skipped{ "SystemStats", "RealtimeSafetyChecker", "CriticalSection", "ScopedLock", "pthread_", "__GI_" };
+
+    for (auto& frame : frames) {
+        bool skip = frame.trim().isEmpty();
+        for (auto& name : skipped) {
+            skip = skip || frame.contains(name);
+        }
+        if (!skip) {
+            return frame;
+        }
+    }
+    return {};
+}
+
+RealtimeSafetyChecker::ScopedAudioCallback::ScopedAudioCallback()
+{
+    ++audioCallbackDepth;
+}
+
+RealtimeSafetyChecker::ScopedAudioCallback::~ScopedAudioCallback()
+{
+    --audioCallbackDepth;
+}
+
+RealtimeSafetyChecker::ScopedAllowance::ScopedAllowance()
+{
+    ++allowanceDepth;
+}
+
+RealtimeSafetyChecker::ScopedAllowance::~ScopedAllowance()
+{
+    --allowanceDepth;
+}
+
+bool RealtimeSafetyChecker::isEnabled()
+{
+    return true;
+}
+
+//this function reports a violation with its stack trace, unless the thread is not in the callback or the lock is allowed
+void RealtimeSafetyChecker::check(Violation kind, const char* what)
+{
+    if (audioCallbackDepth == 0 || allowanceDepth > 0 || isReporting) {
+        return;
+    }
+
+    //everything below allocates and locks, which must not be reported again
+    isReporting = true;
+
+    String backtrace = SystemStats::getStackBacktrace();
+
+    bool allowed = false;
+    if (kind == Violation::lock) {
+        String caller = findCallingFrame(backtrace);
+        const ScopedLock sl(getAllowedLockCallersLock());
+        for (auto& name : getAllowedLockCallers()) {
+            allowed = allowed || caller.contains(name);
+        }
+    }
+
+    if (!allowed) {
+        int count = ++numViolations;
+        if (count <= maxPrintedViolations) {
+            std::cout << "RealtimeSafetyChecker: " << getViolationName(kind) << " (" << what << ") on the audio thread" << std::endl
+                      << backtrace << std::endl;
+        }
+    }
+
+    isReporting = false;
+}
+
+int RealtimeSafetyChecker::getNumViolations()
+{
+    return numViolations.load();
+}
+
+void RealtimeSafetyChecker::resetViolations()
+{
+    numViolations = 0;
+}
+
+void RealtimeSafetyChecker::allowLocksIn(const String& functionName)
+{
+    const ScopedLock sl(getAllowedLockCallersLock());
+    getAllowedLockCallers().addIfNotAlreadyThere(functionName);
+}
+
+//the replaced global allocation functions, they behave like the default ones apart from the check
+void* operator new(std::size_t size)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::allocation, "operator new");
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::allocation, "operator new");
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept
+{
+    if (memory != nullptr) {
+        RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::deallocation, "operator delete");
+    }
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    operator delete(memory);
+}
+
+//the over-aligned versions, used for types such as SIMD registers with more alignment than malloc gives. they cannot go through
+//malloc and free, so they have an aligned allocator of their own
+static void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::allocation, "aligned operator new");
+    std::size_t bytes = jmax((std::size_t) 1, size);
+    std::size_t align = jmax((std::size_t) alignment, sizeof(void*));
+   #if JUCE_WINDOWS
+    return _aligned_malloc(bytes, align);
+   #else
+    void* memory = nullptr;
+    return posix_memalign(&memory, align, bytes) == 0 ? memory : nullptr;
+   #endif
+}
+
+static void freeAligned(void* memory) noexcept
+{
+    if (memory != nullptr) {
+        RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::deallocation, "aligned operator delete");
+    }
+   #if JUCE_WINDOWS
+    _aligned_free(memory);
+   #else
+    std::free(memory);
+   #endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* memory = allocateAligned(size, alignment)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    freeAligned(memory);
+}
+
+#if JUCE_LINUX
+//these replace the libc and pthread functions for the whole process and forward to the real ones found with dlsym. the pointers are
+//plain statics rather than function statics, whose guard could itself lock a mutex
+template <typename Function>
+static Function findRealFunction(Function& cached, const char* name)
+{
+    if (cached == nullptr) {
+        cached = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    }
+    return cached;
+}
+
+static int (*realMutexLock)(pthread_mutex_t*) = nullptr;
+static int (*realCondWait)(pthread_cond_t*, pthread_mutex_t*) = nullptr;
+static int (*realCondTimedWait)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*) = nullptr;
+static ssize_t (*realWrite)(int, const void*, size_t) = nullptr;
+static ssize_t (*realRead)(int, void*, size_t) = nullptr;
+static int (*realNanosleep)(const struct timespec*, struct timespec*) = nullptr;
+static int (*realUsleep)(useconds_t) = nullptr;
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::lock, "pthread_mutex_lock");
+    return findRealFunction(realMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+extern "C" int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::blockingCall, "pthread_cond_wait");
+    return findRealFunction(realCondWait, "pthread_cond_wait")(condition, mutex);
+}
+
+extern "C" int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::blockingCall, "pthread_cond_timedwait");
+    return findRealFunction(realCondTimedWait, "pthread_cond_timedwait")(condition, mutex, time);
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t numBytes)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::blockingCall, "write");
+    return findRealFunction(realWrite, "write")(fd, data, numBytes);
+}
+
+extern "C" ssize_t read(int fd, void* data, size_t numBytes)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::blockingCall, "read");
+    return findRealFunction(realRead, "read")(fd, data, numBytes);
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::blockingCall, "nanosleep");
+    return findRealFunction(realNanosleep, "nanosleep")(duration, remaining);
+}
+
+extern "C" int usleep(useconds_t microseconds)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::blockingCall, "usleep");
+    return findRealFunction(realUsleep, "usleep")(microseconds);
+}
+#endif
+
+#else
+
+RealtimeSafetyChecker::ScopedAudioCallback::ScopedAudioCallback()
+{
+}
+
+RealtimeSafetyChecker::ScopedAudioCallback::~ScopedAudioCallback()
+{
+}
+
+RealtimeSafetyChecker::ScopedAllowance::ScopedAllowance()
+{
+}
+
+RealtimeSafetyChecker::ScopedAllowance::~ScopedAllowance()
+{
+}
+
+bool RealtimeSafetyChecker::isEnabled()
+{
+    return false;
+}
+
+void RealtimeSafetyChecker::check(Violation, const char*)
+{
+}
+
+int RealtimeSafetyChecker::getNumViolations()
+{
+    return 0;
+}
+
+void RealtimeSafetyChecker::resetViolations()
+{
+}
+
+void RealtimeSafetyChecker::allowLocksIn(const String&)
+{
+}
+
+#endif
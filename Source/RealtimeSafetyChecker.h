@@ -0,0 +1,55 @@
+/*====================================================================
+RealtimeSafetyChecker.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//the checker is compiled in by adding OTODECKS_RT_CHECK=1 to the preprocessor definitions of the exporter, the hooks are left out otherwise
+#ifndef OTODECKS_RT_CHECK
+ #define OTODECKS_RT_CHECK 0
+#endif
+
+//this class finds code that is not real-time safe in the audio callback. while a ScopedAudioCallback is alive on a thread, every heap
+//allocation or deallocation (through operator new and delete, aligned or not), mutex lock and blocking system call (write, read, sleeps and condition
+//waits, linux only) made on that thread is reported with a stack trace
+class RealtimeSafetyChecker
+{
+public:
+    enum class Violation
+    {
+        allocation,
+        deallocation,
+        lock,
+        blockingCall
+    };
+
+    //marks the calling thread as running the audio callback for as long as it exists
+    struct ScopedAudioCallback
+    {
+        ScopedAudioCallback();
+        ~ScopedAudioCallback();
+    };
+
+    //lets reviewed code inside the callback allocate or lock without being reported
+    struct ScopedAllowance
+    {
+        ScopedAllowance();
+        ~ScopedAllowance();
+    };
+
+    //whether the checker is compiled in
+    static bool isEnabled();
+
+    //called by the hooks, reports the violation if the calling thread is inside the audio callback
+    static void check(Violation kind, const char* what);
+
+    //number of violations since the last reset
+    static int getNumViolations();
+    static void resetViolations();
+
+    //locks taken directly by a function whose name contains this text are not reported. nothing is allowed until the code that runs
+    //the callback allows it, next to the reason it is safe
+    static void allowLocksIn(const String& functionName);
+};
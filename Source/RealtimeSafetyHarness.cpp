@@ -0,0 +1,717 @@
+/*====================================================================
+RealtimeSafetyHarness.cpp
+This class checks the audio path for real-time safety. It writes a short test track, plays it on both decks through the same
+MixerAudioSource and MasterRecorder the app uses, and makes the usual deck changes from the calling thread between rendered blocks and
+from a second thread while blocks are rendered. Only the rendering runs inside a ScopedAudioCallback, like getNextAudioBlock in
+MainComponent. Every change is recorded in an automation log, which is replayed at the end and has to give back the master recording
+sample for sample. The job scheduler the decks load on is checked first: the order it runs the classes in, their limits and cancelling.
+====================================================================*/
+
+
+#include "RealtimeSafetyHarness.h"
+#include "RealtimeSafetyChecker.h"
+#include "Tracer.h"
+#include "DJAudioPlayer.h"
+#include "MasterRecorder.h"
+#include "MasterLimiter.h"
+#include "LevelMeter.h"
+#include "MidiController.h"
+#include "SamplerPads.h"
+#include "BufferSizeTuner.h"
+#include "AutomationLog.h"
+#include "AutomationReplay.h"
+#include <cmath>
+
+static constexpr double harnessSampleRate = 44100.0;
+static constexpr int harnessBlockSize = 512;
+
+//the most of a block's time one insert effect may take, on average and in its slowest block
+static constexpr float maxEffectLoad = 0.05f;
+static constexpr float maxEffectPeakLoad = 0.5f;
+
+//the largest difference allowed between the master recording and the replay of the automation log, a few steps of the 24-bit files
+static constexpr float maxReplayDifference = 1.0e-6f;
+
+//this function writes a few seconds of a stereo tone to use as the test track
+static File writeTestTrack()
+{
+    File file = File::createTempFile(".wav");
+
+    WavAudioFormat wavFormat;
+    std::unique_ptr<FileOutputStream> stream(file.createOutputStream());
+    std::unique_ptr<AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), harnessSampleRate, 2, 16, {}, 0));
+    if (writer == nullptr) {
+        return {};
+    }
+    stream.release();
+
+    AudioBuffer<float> tone(2, (int) harnessSampleRate * 20);
+    for (int i = 0; i < tone.getNumSamples(); ++i) {
+        float sample = 0.5f * (float) std::sin(MathConstants<double>::twoPi * 220.0 * i / harnessSampleRate);
+        tone.setSample(0, i, sample);
+        tone.setSample(1, i, sample);
+    }
+    writer->writeFromAudioSampleBuffer(tone, 0, tone.getNumSamples());
+    return file;
+}
+
+//the long sync run: how much set it plays, how long the loop is given to pull the deck in first, and the largest phase error allowed
+//after that, in beats (0.01 of a beat is 5 ms at 120 bpm)
+static constexpr double syncRunSeconds = 600.0;
+static constexpr double syncSettleSeconds = 10.0;
+static constexpr double maxSyncPhaseErrorBeats = 0.01;
+
+//this function writes a click on every beat at 120 bpm, long enough for the sync run. it is FLAC so eleven minutes of mostly silence
+//stay small on disk
+static File writeClickTrack()
+{
+    File file = File::createTempFile(".flac");
+
+    FlacAudioFormat flacFormat;
+    std::unique_ptr<FileOutputStream> stream(file.createOutputStream());
+    std::unique_ptr<AudioFormatWriter> writer(flacFormat.createWriterFor(stream.get(), harnessSampleRate, 2, 16, {}, 0));
+    if (writer == nullptr) {
+        return {};
+    }
+    stream.release();
+
+    int samplesPerBeat = (int) (harnessSampleRate * 0.5);
+    int clickSamples = (int) (harnessSampleRate * 0.005);
+    AudioBuffer<float> beat(2, samplesPerBeat);
+    beat.clear();
+    for (int i = 0; i < clickSamples; ++i) {
+        float sample = 0.5f * (float) std::sin(MathConstants<double>::twoPi * 1000.0 * i / harnessSampleRate);
+        beat.setSample(0, i, sample);
+        beat.setSample(1, i, sample);
+    }
+
+    int numBeats = (int) ((syncRunSeconds + 60.0) * 2.0);
+    for (int index = 0; index < numBeats; ++index) {
+        writer->writeFromAudioSampleBuffer(beat, 0, samplesPerBeat);
+    }
+    return file;
+}
+
+//this function compares the master recording with the replay of the automation log, and says where they first differ and by how much.
+//it returns an empty string when they are the same
+static String compareWithReplay(AudioFormatManager& formatManager, const File& recorded, const File& replayed)
+{
+    std::unique_ptr<AudioFormatReader> recordedReader(formatManager.createReaderFor(recorded));
+    std::unique_ptr<AudioFormatReader> replayedReader(formatManager.createReaderFor(replayed));
+    if (recordedReader == nullptr || replayedReader == nullptr) {
+        return "the recording or the replay cannot be read";
+    }
+
+    int64 length = recordedReader->lengthInSamples;
+    if (replayedReader->lengthInSamples != length) {
+        return "the recording is " + String(length) + " samples long and the replay " + String(replayedReader->lengthInSamples);
+    }
+
+    const int chunkSize = 65536;
+    AudioBuffer<float> recordedChunk(2, chunkSize);
+    AudioBuffer<float> replayedChunk(2, chunkSize);
+    int64 firstDifference = -1;
+    float largestDifference = 0.0f;
+
+    for (int64 start = 0; start < length; start += chunkSize) {
+        int numSamples = (int) jmin((int64) chunkSize, length - start);
+        recordedReader->read(&recordedChunk, 0, numSamples, start, true, true);
+        replayedReader->read(&replayedChunk, 0, numSamples, start, true, true);
+
+        for (int channel = 0; channel < 2; ++channel) {
+            const float* recordedSamples = recordedChunk.getReadPointer(channel);
+            const float* replayedSamples = replayedChunk.getReadPointer(channel);
+            for (int i = 0; i < numSamples; ++i) {
+                float difference = std::abs(recordedSamples[i] - replayedSamples[i]);
+                if (difference > maxReplayDifference && (firstDifference < 0 || start + i < firstDifference)) {
+                    firstDifference = start + i;
+                }
+                largestDifference = jmax(largestDifference, difference);
+            }
+        }
+    }
+
+    if (firstDifference < 0) {
+        return {};
+    }
+    return "the replay differs from the recording from sample " + String(firstDifference) + " (" + String(firstDifference / harnessSampleRate, 3)
+           + " s), by up to " + String(largestDifference, 6);
+}
+
+//a job that runs a function, for the scheduler checks
+class HarnessJob : public ThreadPoolJob
+{
+public:
+    HarnessJob(std::function<void(HarnessJob&)> _body)
+        : ThreadPoolJob("Harness job"),
+          body(std::move(_body))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        body(*this);
+        return jobHasFinished;
+    }
+
+private:
+    std::function<void(HarnessJob&)> body;
+};
+
+//this function waits up to timeoutMs for a condition the scheduler's workers bring about
+static bool waitFor(const std::function<bool()>& condition, int timeoutMs)
+{
+    uint32 start = Time::getMillisecondCounter();
+    while (!condition()) {
+        if ((int) (Time::getMillisecondCounter() - start) >= timeoutMs) {
+            return false;
+        }
+        Thread::sleep(1);
+    }
+    return true;
+}
+
+//this function checks that the job scheduler runs the most urgent class first, keeps every class within its limit and cancels jobs
+//wherever they are, including the ones another worker is stealing at that moment
+static void checkJobScheduler(const std::function<void(bool, const String&)>& expect)
+{
+    int owner = 0;
+
+    //both workers are held by a deck job, then one is let go and runs what was queued one job at a time
+    {
+        JobScheduler scheduler(2);
+        WaitableEvent firstGate(true);
+        WaitableEvent secondGate(true);
+        std::atomic<int> numHeld{ 0 };
+        CriticalSection orderLock;
+        StringArray order;
+
+        for (auto* gate : { &firstGate, &secondGate }) {
+            scheduler.addJob(new HarnessJob([gate, &numHeld](HarnessJob& job) {
+                ++numHeld;
+                while (!gate->wait(10) && !job.shouldExit()) {
+                }
+            }), JobScheduler::Priority::deck, &owner, true);
+        }
+        expect(waitFor([&numHeld] { return numHeld.load() == 2; }, 5000), "the scheduler did not start a deck job on each worker");
+
+        auto addNamed = [&](const String& name, JobScheduler::Priority priority) {
+            scheduler.addJob(new HarnessJob([&orderLock, &order, name](HarnessJob&) {
+                const ScopedLock sl(orderLock);
+                order.add(name);
+            }), priority, &owner, true);
+        };
+        addNamed("library", JobScheduler::Priority::library);
+        addNamed("visible", JobScheduler::Priority::visible);
+        addNamed("deck", JobScheduler::Priority::deck);
+
+        firstGate.signal();
+        expect(waitFor([&scheduler] { return scheduler.getNumJobs() == 1; }, 5000), "the scheduler did not run the queued jobs");
+        {
+            const ScopedLock sl(orderLock);
+            expect(order.joinIntoString(" ") == "deck visible library", "the scheduler ran the classes in the order " + order.joinIntoString(" "));
+        }
+        secondGate.signal();
+        expect(scheduler.removeJobs(&owner, 5000), "the scheduler did not finish the last deck job");
+    }
+
+    //bulk work may use half of the workers, and the rows on screen with it all but one
+    {
+        JobScheduler scheduler(4);
+        CriticalSection countLock;
+        int running[JobScheduler::numPriorities] = {};
+        int mostLibrary = 0;
+        int mostVisibleAndLibrary = 0;
+
+        for (int index = 0; index < 12; ++index) {
+            auto priority = index % 2 == 0 ? JobScheduler::Priority::library : JobScheduler::Priority::visible;
+            scheduler.addJob(new HarnessJob([&, priority](HarnessJob&) {
+                {
+                    const ScopedLock sl(countLock);
+                    ++running[(int) priority];
+                    int library = running[(int) JobScheduler::Priority::library];
+                    mostLibrary = jmax(mostLibrary, library);
+                    mostVisibleAndLibrary = jmax(mostVisibleAndLibrary, library + running[(int) JobScheduler::Priority::visible]);
+                }
+                Thread::sleep(20);
+                const ScopedLock sl(countLock);
+                --running[(int) priority];
+            }), priority, &owner, true);
+        }
+        expect(waitFor([&scheduler] { return scheduler.getNumJobs() == 0; }, 10000), "the scheduler did not run the limited jobs");
+
+        const ScopedLock sl(countLock);
+        expect(mostLibrary >= 1 && mostLibrary <= scheduler.getConcurrencyLimit(JobScheduler::Priority::library),
+               String(mostLibrary) + " library jobs ran at once");
+        expect(mostVisibleAndLibrary <= scheduler.getConcurrencyLimit(JobScheduler::Priority::visible),
+               String(mostVisibleAndLibrary) + " visible and library jobs ran at once");
+    }
+
+    //jobs that only stop when asked are added and cancelled straight away, while idle workers are stealing them. a job that was
+    //missed would never be asked and the cancel would time out
+    {
+        JobScheduler scheduler(4);
+        std::atomic<int> numRan{ 0 };
+        bool cancelled = true;
+
+        for (int round = 0; round < 200 && cancelled; ++round) {
+            for (int index = 0; index < 8; ++index) {
+                scheduler.addJob(new HarnessJob([&numRan](HarnessJob& job) {
+                    ++numRan;
+                    while (!job.shouldExit()) {
+                        Thread::sleep(1);
+                    }
+                }), (JobScheduler::Priority) (index % JobScheduler::numPriorities), &owner, true);
+            }
+            cancelled = scheduler.removeJobs(&owner, 2000) && scheduler.getNumJobs() == 0;
+        }
+        expect(cancelled, "the scheduler did not cancel every job of an owner");
+        expect(numRan.load() > 0, "the scheduler never started a job before it was cancelled");
+
+        //a job that is still queued is taken out without running
+        WaitableEvent gate(true);
+        std::atomic<int> numHeld{ 0 };
+        for (int index = 0; index < scheduler.getNumWorkers(); ++index) {
+            scheduler.addJob(new HarnessJob([&gate, &numHeld](HarnessJob& job) {
+                ++numHeld;
+                while (!gate.wait(10) && !job.shouldExit()) {
+                }
+            }), JobScheduler::Priority::deck, &owner, true);
+        }
+        expect(waitFor([&] { return numHeld.load() == scheduler.getNumWorkers(); }, 5000), "the scheduler did not start a deck job on each worker");
+        std::atomic<bool> queuedRan{ false };
+        HarnessJob queued([&queuedRan](HarnessJob&) { queuedRan = true; });
+        scheduler.addJob(&queued, JobScheduler::Priority::library, &owner, false);
+        expect(scheduler.removeJob(&queued, true, 2000), "the scheduler did not remove a queued job");
+        gate.signal();
+        expect(scheduler.removeJobs(&owner, 5000), "the scheduler did not finish the jobs holding the workers");
+        expect(!queuedRan.load(), "a removed job still ran");
+    }
+}
+
+//this thread makes changes over and over while blocks are rendered, the way the GUI and a MIDI controller make them during a set
+class SetterThread : public Thread
+{
+public:
+    SetterThread(std::function<void(int)> _change)
+        : Thread("Harness setters"),
+          change(std::move(_change))
+    {
+    }
+
+    ~SetterThread() override
+    {
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        for (int count = 0; !threadShouldExit(); ++count) {
+            change(count);
+            Thread::sleep(1);
+        }
+    }
+
+private:
+    std::function<void(int)> change;
+};
+
+int RealtimeSafetyHarness::run()
+{
+    if (!RealtimeSafetyChecker::isEnabled()) {
+        std::cout << "RealtimeSafetyHarness: build with OTODECKS_RT_CHECK=1 to run the checks" << std::endl;
+        return -1;
+    }
+
+    File track = writeTestTrack();
+    if (!track.existsAsFile()) {
+        std::cout << "RealtimeSafetyHarness: cannot write the test track" << std::endl;
+        return -1;
+    }
+    URL trackURL(track);
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    TimeSliceThread readAheadThread("Deck read-ahead");
+    readAheadThread.startThread(Thread::Priority::high);
+    JobScheduler jobScheduler;
+
+    //every change below is logged, so stamping them on the audio thread is checked too
+    AutomationLog automationLog;
+    File automationFile = File::createTempFile(".otolog");
+    automationLog.start(automationFile, MasterLimiter::defaultLookaheadMs);
+
+    DJAudioPlayer player1(formatManager, readAheadThread, jobScheduler);
+    DJAudioPlayer player2(formatManager, readAheadThread, jobScheduler);
+    SamplerPads samplerPads(formatManager, jobScheduler);
+    MixerAudioSource mixerSource;
+    MasterLimiter masterLimiter;
+    LevelMeter masterMeter;
+    BufferSizeTuner bufferSizeTuner;
+
+    //the sync run renders far faster than real time, the fifo is large enough that the replay is compared with every sample
+    MasterRecorder masterRecorder(2, 60.0);
+
+    player1.setAutomationLog(&automationLog, AutomationLog::Target::deck1);
+    player2.setAutomationLog(&automationLog, AutomationLog::Target::deck2);
+    samplerPads.setAutomationLog(&automationLog);
+
+    automationLog.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    player1.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    player2.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    samplerPads.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    mixerSource.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    mixerSource.addInputSource(&player1, false);
+    mixerSource.addInputSource(&player2, false);
+    mixerSource.addInputSource(&samplerPads, false);
+    masterLimiter.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    masterMeter.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    masterRecorder.prepareToPlay(harnessBlockSize, harnessSampleRate);
+    bufferSizeTuner.setDevice(harnessSampleRate, harnessBlockSize, {});
+
+    File recording = File::createTempFile(".wav");
+    masterRecorder.startRecording(recording);
+
+    AudioBuffer<float> buffer(2, harnessBlockSize);
+    AudioSourceChannelInfo bufferToFill(&buffer, 0, harnessBlockSize);
+
+    //renders one block exactly like MainComponent::getNextAudioBlock. the decks take their changes first, and with waitForDecks they
+    //wait for their read-ahead outside the callback before the block is rendered, the same way the replay waits for them
+    auto renderBlock = [&](bool waitForDecks) {
+        {
+            RealtimeSafetyChecker::ScopedAudioCallback audioCallback;
+            automationLog.beginBlock(harnessBlockSize);
+            player1.beginBlock();
+            player2.beginBlock();
+        }
+        if (waitForDecks) {
+            player1.waitUntilReady(1000);
+            player2.waitUntilReady(1000);
+        }
+
+        RealtimeSafetyChecker::ScopedAudioCallback audioCallback;
+        double callbackStart = Time::getMillisecondCounterHiRes() * 0.001;
+        mixerSource.getNextAudioBlock(bufferToFill);
+        masterLimiter.process(bufferToFill);
+        masterMeter.process(bufferToFill);
+        masterRecorder.pushBlock(bufferToFill);
+        bufferSizeTuner.recordCallback(callbackStart, Time::getMillisecondCounterHiRes() * 0.001, harnessBlockSize);
+    };
+
+    //the checks of what the engine does, as opposed to what the checker finds, each failure counts like a violation
+    int failedChecks = 0;
+    auto expect = [&](bool passed, const String& what) {
+        if (!passed) {
+            ++failedChecks;
+            std::cout << "RealtimeSafetyHarness: check failed - " << what << std::endl;
+        }
+    };
+
+    //renders a step after giving the background threads time to catch up with the last change, and the read-ahead with a seek in its
+    //first block. no step may have a violation
+    auto render = [&](const char* step, int numBlocks) {
+        Thread::sleep(300);
+        int before = RealtimeSafetyChecker::getNumViolations();
+
+        for (int i = 0; i < numBlocks; ++i) {
+            renderBlock(i == 0);
+        }
+
+        int found = RealtimeSafetyChecker::getNumViolations() - before;
+        std::cout << "RealtimeSafetyHarness: " << step << (found == 0 ? " ok" : " - " + String(found) + " violations") << std::endl;
+        expect(found == 0, String(step) + " is not real-time safe");
+    };
+
+    checkJobScheduler(expect);
+    std::cout << "RealtimeSafetyHarness: job scheduler checked" << std::endl;
+
+    //the only locks allowed are the ones JUCE's transport and mixer take around every block. nothing else takes them while a set
+    //plays, the transport's is only contended while a source is swapped and the mixer's while an input is added or removed
+    RealtimeSafetyChecker::allowLocksIn("AudioTransportSource");
+    RealtimeSafetyChecker::allowLocksIn("MixerAudioSource");
+
+    //every step is traced as it would be during a set, so the tracing itself is checked too
+    Tracer::setEnabled(true);
+    RealtimeSafetyChecker::resetViolations();
+
+    player1.loadURL(trackURL);
+    player2.loadURL(trackURL);
+    player1.start();
+    player2.start();
+    render("load and play", 200);
+
+    player1.setPosition(10.0);
+    player2.setPositionRelative(0.25);
+    render("seek", 100);
+
+    player1.setBass(4.0);
+    render("bass", 50);
+    player1.setTreble(3.0);
+    render("treble", 50);
+    player2.setMid(-6.0);
+    render("mid", 50);
+
+    player1.setFilter(-0.6);
+    player2.setFilterResonance(0.8);
+    player2.setFilter(0.4);
+    render("filter", 50);
+    player1.setFilter(0.5);
+    render("filter sweep through the middle", 50);
+    player1.setFilter(0.0);
+    player2.setFilter(0.0);
+    render("filter off", 50);
+
+    player1.setSpeed(1.05);
+    player2.setSpeed(0.95);
+    render("speed", 100);
+
+    //the controls move on another thread while the blocks are rendered, so the callback runs against setters that are half done
+    {
+        SetterThread setters([&](int count) {
+            double sweep = (count % 100) / 100.0;
+            player1.setVolume(0.5 + 0.5 * sweep);
+            player2.setSpeed(0.9 + 0.2 * sweep);
+            player1.setBass(-6.0 + 12.0 * sweep);
+            player2.setFilter(sweep - 0.5);
+            player2.setFilterResonance(sweep);
+            player1.setEffectMix(EffectsRack::Effect::echo, (float) sweep);
+        });
+        setters.startThread();
+        render("controls moved during the callback", 200);
+    }
+    player1.setVolume(1.0);
+    player2.setSpeed(0.95);
+    player1.setBass(4.0);
+    player2.setFilter(0.0);
+
+    player1.fadeTo(0.5f, 0.1);
+    player2.fadeTo(0.0f, 0.0);
+    render("fade", 100);
+
+    player1.setBeatGrid(120.0, 0.0);
+    player2.setBeatGrid(124.0, 0.1);
+    player2.setSyncMaster(&player1);
+    render("sync", 200);
+    player2.setSyncMaster(nullptr);
+    render("sync off", 50);
+
+    player1.beginScratch();
+    player1.setScratchVelocity(-2.0);
+    render("scratch", 50);
+    player1.setScratchVelocity(3.0);
+    render("scratch faster", 50);
+    player1.endScratch();
+    render("scratch release", 100);
+
+    player2.setReverse(true);
+    render("reverse", 100);
+    player2.setReverse(false);
+    render("reverse off", 100);
+
+    player1.setSlip(true);
+    player2.setSlip(true);
+    player1.beginScratch();
+    player1.setScratchVelocity(-1.5);
+    render("slip scratch", 50);
+    player1.endScratch();
+    render("slip return from a scratch", 100);
+    player2.setReverse(true);
+    render("slip reverse", 50);
+    player2.setReverse(false);
+    render("slip return from reverse", 100);
+    player1.triggerHotCue(3);
+    render("slip hot cue set", 20);
+    player1.triggerHotCue(3);
+    render("slip hot cue held", 50);
+    player1.releaseHotCue(3);
+    render("slip hot cue release", 100);
+    player1.setSlip(false);
+    player2.setSlip(false);
+
+    //the same messages a controller would send, on this thread instead of the MIDI thread
+    MidiController controller(player1, player2);
+    controller.injectMessage(MidiMessage::controllerEvent(1, 7, 100));
+    controller.injectMessage(MidiMessage::controllerEvent(1, 16, 90));
+    controller.injectMessage(MidiMessage::controllerEvent(2, 13, 70));
+    controller.injectMessage(MidiMessage::controllerEvent(2, 20, 100));
+    render("midi faders, EQ and resonance", 50);
+    controller.injectMessage(MidiMessage::noteOn(1, 54, (uint8) 127));
+    controller.injectMessage(MidiMessage::controllerEvent(1, 22, 3));
+    controller.injectMessage(MidiMessage::controllerEvent(1, 22, 125));
+    render("midi jog", 50);
+    controller.injectMessage(MidiMessage::noteOff(1, 54));
+    controller.injectMessage(MidiMessage::controllerEvent(2, 22, 2));
+    render("midi jog release and nudge", 100);
+
+    //the play button and the hot cue pads are deck commands too, so nothing changes before the audio thread has rendered a block
+    bool deck2Playing = player2.isPlaying();
+    controller.injectMessage(MidiMessage::noteOn(2, 11, (uint8) 127));
+    controller.injectMessage(MidiMessage::noteOff(2, 11));
+    expect(player2.isPlaying() == deck2Playing, "the MIDI play button changed deck 2 outside the audio thread");
+    render("midi play button", 10);
+    expect(player2.isPlaying() != deck2Playing, "the MIDI play button did not toggle deck 2");
+    controller.injectMessage(MidiMessage::noteOn(2, 11, (uint8) 127));
+    controller.injectMessage(MidiMessage::noteOff(2, 11));
+    render("midi play button again", 10);
+    expect(player2.isPlaying() == deck2Playing, "the second MIDI play button press did not toggle deck 2 back");
+
+    //clearing the pad is a command as well, it is empty once a block has taken it
+    player1.clearHotCue(0);
+    render("hot cue cleared", 1);
+    double cueFrom = player1.getPosition() * player1.getLength();
+    controller.injectMessage(MidiMessage::noteOn(1, 0, (uint8) 127));
+    controller.injectMessage(MidiMessage::noteOff(1, 0));
+    expect(player1.getHotCue(0) < 0.0, "the MIDI hot cue pad stored a cue outside the audio thread");
+    render("midi hot cue set", 1);
+    double cueTo = player1.getPosition() * player1.getLength();
+    expect(player1.getHotCue(0) >= cueFrom && player1.getHotCue(0) <= cueTo, "the MIDI hot cue pad did not store the playhead of the block");
+    controller.injectMessage(MidiMessage::noteOn(1, 0, (uint8) 127));
+    controller.injectMessage(MidiMessage::noteOff(1, 0));
+    render("midi hot cue", 100);
+
+    EffectsRack& effects = player1.getEffects();
+    for (int index = 0; index < EffectsRack::numEffects; ++index) {
+        player1.setEffectEnabled((EffectsRack::Effect) index, true);
+    }
+    render("effects on", 200);
+    for (int index = 0; index < EffectsRack::numEffects; ++index) {
+        auto load = effects.getLoad((EffectsRack::Effect) index);
+        String name = EffectsRack::getName((EffectsRack::Effect) index);
+        std::cout << "RealtimeSafetyHarness: " << name << " load " << load.average * 100.0f << "% average, " << load.peak * 100.0f
+                  << "% peak" << std::endl;
+        expect(load.average > 0.0f, name + " was never measured");
+        expect(load.average <= maxEffectLoad, name + " takes " + String(load.average * 100.0f, 1) + "% of a block on average");
+        expect(load.peak <= maxEffectPeakLoad, name + " took " + String(load.peak * 100.0f, 1) + "% of its slowest block");
+        player1.setEffectEnabled((EffectsRack::Effect) index, false);
+    }
+    render("effects off", 100);
+
+    //the deck meters run inside the players, the master one after the limiter
+    auto levels = masterMeter.getLevels();
+    std::cout << "RealtimeSafetyHarness: master peak " << levels.peakDb[0] << " dB, rms " << levels.rmsDb[0] << " dB, short-term "
+              << levels.shortTermLufs << " LUFS" << std::endl;
+
+    //more pad hits than voices, half of them placed on exact samples of the next blocks
+    for (int pad = 0; pad < SamplerPads::numPads; ++pad) {
+        samplerPads.loadSample(pad, track);
+    }
+    int64 padClock = samplerPads.getSamplePosition();
+    for (int hit = 0; hit < SamplerPads::numVoices * 3; ++hit) {
+        samplerPads.trigger(hit % SamplerPads::numPads, 0.5f);
+        samplerPads.pushCommand({ SamplerPads::Command::Type::trigger, hit % SamplerPads::numPads, 0.5f, padClock + hit * 37 });
+    }
+    render("pads with voice stealing", 100);
+
+    samplerPads.setLooping(0, true);
+    samplerPads.trigger(0);
+    render("pad loop", 50);
+    samplerPads.loadSample(0, track);
+    render("pad sample replaced while playing", 50);
+    samplerPads.pushCommand({ SamplerPads::Command::Type::stopAll, 0, 0.0f, -1 });
+    render("pads stopped", 20);
+
+    player2.stop();
+    player2.loadURL(trackURL);
+    player2.start();
+    render("reload while the other deck plays", 100);
+
+    //the scratch window reads the whole decoded track wherever its chunks are done, some of them may still be decoding here
+    player1.setPreloadWholeTracks(true);
+    player1.loadURL(trackURL);
+    player1.start();
+    player1.beginScratch();
+    player1.setScratchVelocity(-3.0);
+    render("scratch while the whole track decodes", 50);
+    player1.endScratch();
+    render("scratch release from the decoded track", 50);
+
+    //the double reads player1's decoded track and waits on the audio thread for player1 to reach its start
+    player2.doubleFrom(player1, trackURL);
+    render("double the other deck", 100);
+
+    //ten minutes of set with one deck synced to the other at a different tempo, rendered as fast as the read-ahead allows. the phase
+    //error between the two beat grids is measured from the decks' positions between blocks, so the drift of the loop is bounded
+    File clickTrack = writeClickTrack();
+    expect(clickTrack.existsAsFile(), "the click track for the sync run could not be written");
+    player1.setPreloadWholeTracks(false);
+    player1.loadURL(URL(clickTrack));
+    player2.loadURL(URL(clickTrack));
+    player1.setBeatGrid(120.0, 0.0);
+    player2.setBeatGrid(123.7, 0.11);
+    player1.setSpeed(1.02);
+    player2.setSpeed(1.0);
+    player1.start();
+    player2.start();
+    render("sync run start", 20);
+    player2.setSyncMaster(&player1);
+
+    {
+        int before = RealtimeSafetyChecker::getNumViolations();
+        int numBlocks = (int) (syncRunSeconds * harnessSampleRate / harnessBlockSize);
+        int settleBlocks = (int) (syncSettleSeconds * harnessSampleRate / harnessBlockSize);
+        double maxError = 0.0;
+        double lastError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block) {
+            renderBlock(true);
+
+            if (block < settleBlocks) {
+                continue;
+            }
+            double beat1 = (player1.getPosition() * player1.getLength() - player1.getFirstBeatSeconds()) * player1.getBeatGridBpm() / 60.0;
+            double beat2 = (player2.getPosition() * player2.getLength() - player2.getFirstBeatSeconds()) * player2.getBeatGridBpm() / 60.0;
+            lastError = beat1 - beat2;
+            lastError -= std::round(lastError);
+            maxError = jmax(maxError, std::abs(lastError));
+        }
+
+        int found = RealtimeSafetyChecker::getNumViolations() - before;
+        std::cout << "RealtimeSafetyHarness: sync for " << syncRunSeconds / 60.0 << " minutes, largest phase error " << maxError
+                  << " beats, " << lastError << " at the end" << (found == 0 ? ", ok" : ", " + String(found) + " violations") << std::endl;
+        expect(found == 0, "the sync run is not real-time safe");
+        expect(player2.isSynced(), "the synced deck dropped out of sync");
+        expect(maxError <= maxSyncPhaseErrorBeats, "the sync phase error reached " + String(maxError, 4) + " beats");
+    }
+    player2.setSyncMaster(nullptr);
+
+    player1.stop();
+    player2.stop();
+    render("stop", 20);
+
+    int numViolations = RealtimeSafetyChecker::getNumViolations();
+
+    File trace = File::createTempFile(".json");
+    if (Tracer::writeChromeTrace(trace)) {
+        std::cout << "RealtimeSafetyHarness: trace written to " << trace.getFullPathName() << std::endl;
+    }
+
+    masterRecorder.stopRecording();
+    automationLog.stop();
+    mixerSource.removeAllInputs();
+    player1.releaseResources();
+    player2.releaseResources();
+
+    //the replay makes every change before the block it was stamped with, so it only gives back the recording if each change was
+    //stamped with the block that first played it
+    expect(masterRecorder.getNumDroppedSamples() == 0, "the master recording dropped samples, it cannot be compared with the replay");
+    expect(automationLog.getNumDroppedEvents() == 0, "the automation log dropped events, it cannot be replayed exactly");
+    File replayed = File::createTempFile(".wav");
+    StringArray replayArguments("--replay=" + automationFile.getFullPathName(), "--replay-out=" + replayed.getFullPathName());
+    int replayResult = AutomationReplay::run(replayArguments);
+    expect(replayResult == 0, "the automation log could not be replayed");
+    if (replayResult == 0) {
+        String difference = compareWithReplay(formatManager, recording, replayed);
+        std::cout << "RealtimeSafetyHarness: replay of the automation log " << (difference.isEmpty() ? "matches the recording" : difference) << std::endl;
+        expect(difference.isEmpty(), "the replay of the automation log does not match the recording");
+    }
+
+    recording.deleteFile();
+    replayed.deleteFile();
+    automationFile.deleteFile();
+    track.deleteFile();
+    clickTrack.deleteFile();
+
+    std::cout << "RealtimeSafetyHarness: " << numViolations << " violations and " << failedChecks << " failed checks in total" << std::endl;
+    return numViolations + failedChecks;
+}
@@ -0,0 +1,17 @@
+/*====================================================================
+RealtimeSafetyHarness.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//this class plays the whole engine through a scripted set without an audio device, rendering blocks as the audio callback would, and
+//counts what the RealtimeSafetyChecker reports and which checks of the engine's behaviour fail. the steps are listed in the .cpp.
+//it is started with the --rt-check command line option and the app exits with 1 on any violation or failed check
+class RealtimeSafetyHarness
+{
+public:
+    //returns the number of violations and failed checks, or -1 if the checker is not compiled in
+    static int run();
+};
@@ -0,0 +1,574 @@
+/*====================================================================
+SamplerPads.cpp
+This class plays the sample pads. Loading decodes the whole file, on the calling thread or on a background worker, and the message
+thread swaps it in through an atomic pointer. The old sample is kept alive until the audio thread has finished a block that started
+after the swap. Each block the audio thread takes
+the queued commands, renders the voices up to the sample of each command that falls in the block, applies it and carries on, so a
+command lands on the exact sample it was given. Samples at the device rate are added with whole-run vector operations, other rates
+are resampled with linear interpolation.
+====================================================================*/
+
+
+#include "SamplerPads.h"
+#include "Tracer.h"
+#include <cmath>
+
+//this job decodes a pad's sample and hands it to the message thread
+class SamplerPads::DecodeJob : public ThreadPoolJob
+{
+public:
+    DecodeJob(SamplerPads& _owner, int _pad, const File& _file, std::function<void(bool)> _onLoaded)
+        : ThreadPoolJob("Decode pad sample"),
+          owner(_owner),
+          pad(_pad),
+          file(_file),
+          onLoaded(std::move(_onLoaded))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        Tracer::Scope trace("SamplerPads::DecodeJob", Tracer::Category::loading);
+        Sample::Ptr sample = owner.decodeSample(file);
+        if (shouldExit()) {
+            return jobHasFinished;
+        }
+
+        {
+            const ScopedLock sl(owner.pendingLock);
+            owner.pendingSamples.add({ pad, sample, file, std::move(onLoaded) });
+        }
+        owner.triggerAsyncUpdate();
+        return jobHasFinished;
+    }
+
+private:
+    SamplerPads& owner;
+    int pad;
+    File file;
+    std::function<void(bool)> onLoaded;
+};
+
+SamplerPads::SamplerPads(AudioFormatManager& _formatManager, JobScheduler& _jobScheduler)
+    : formatManager(_formatManager),
+      jobScheduler(_jobScheduler)
+{
+    for (int pad = 0; pad < numPads; ++pad) {
+        padSamples[pad] = nullptr;
+        looping[pad] = false;
+        playing[pad] = false;
+    }
+}
+
+SamplerPads::~SamplerPads()
+{
+    //stops the decodes that are still running before the pads go away
+    for (int pad = 0; pad < numPads; ++pad) {
+        jobScheduler.removeJobs(&samples[pad], 5000);
+    }
+    cancelPendingUpdate();
+}
+
+//this function stops every voice and sets the fade length for the device rate
+void SamplerPads::prepareToPlay(int, double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+    fadeOutSamples = jmax(1, roundToInt(fadeOutSeconds * sampleRate));
+
+    for (auto& voice : voices) {
+        voice = Voice();
+    }
+    numPending = 0;
+}
+
+void SamplerPads::releaseResources()
+{
+}
+
+//this function renders the pads, stopping at the sample of every command that falls in this block
+void SamplerPads::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+    Tracer::Scope trace("SamplerPads::getNextAudioBlock", Tracer::Category::audio);
+    bufferToFill.clearActiveBufferRegion();
+
+    auto& buffer = *bufferToFill.buffer;
+    int numSamples = bufferToFill.numSamples;
+    int64 blockStart = renderedSamples.load();
+
+    //the loads and settings made during the last block are stamped with this one
+    if (automationLog != nullptr) {
+        automationLog->collect(AutomationLog::Target::pads);
+    }
+
+    //takes the new commands, any that do not fit wait in the queue for the next block
+    while (numPending < commandQueueSize && commandQueue.pop(pending[numPending])) {
+        ++numPending;
+    }
+
+    //a voice still on a sample that was replaced stops here, so the old sample can be freed after this block
+    for (auto& voice : voices) {
+        if (voice.main.sample != nullptr && voice.main.sample != padSamples[voice.main.pad].load()) {
+            voice.main.sample = nullptr;
+        }
+        if (voice.tail.sample != nullptr && voice.tail.sample != padSamples[voice.tail.pad].load()) {
+            voice.tail.sample = nullptr;
+            voice.tailSamplesLeft = 0;
+        }
+    }
+
+    int position = 0;
+    while (true) {
+        //the earliest command due in this block, commands for the same sample keep the order they were pushed in
+        int next = -1;
+        int64 nextTime = 0;
+        for (int i = 0; i < numPending; ++i) {
+            int64 time = jmax(pending[i].samplePosition, blockStart);
+            if (time < blockStart + numSamples && (next < 0 || time < nextTime)) {
+                next = i;
+                nextTime = time;
+            }
+        }
+
+        if (next < 0) {
+            break;
+        }
+
+        int offset = (int) (nextTime - blockStart);
+        if (offset > position) {
+            renderVoices(buffer, bufferToFill.startSample + position, offset - position);
+            position = offset;
+        }
+
+        if (automationLog != nullptr) {
+            recordCommand(pending[next], offset);
+        }
+        applyCommand(pending[next], nextTime);
+        for (int i = next; i < numPending - 1; ++i) {
+            pending[i] = pending[i + 1];
+        }
+        --numPending;
+    }
+
+    if (position < numSamples) {
+        renderVoices(buffer, bufferToFill.startSample + position, numSamples - position);
+    }
+
+    buffer.applyGain(bufferToFill.startSample, numSamples, gain.load());
+
+    bool padPlaying[numPads] = {};
+    for (auto& voice : voices) {
+        if (voice.main.sample != nullptr) {
+            padPlaying[voice.main.pad] = true;
+        }
+    }
+    for (int pad = 0; pad < numPads; ++pad) {
+        playing[pad] = padPlaying[pad];
+    }
+
+    renderedSamples = blockStart + numSamples;
+    ++renderedBlocks;
+}
+
+//this function adds every voice to part of the block, and the fading tails of stopped voices
+void SamplerPads::renderVoices(AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    float fadeStep = 1.0f / fadeOutSamples;
+
+    for (auto& voice : voices) {
+        if (voice.main.sample != nullptr && !renderPlayback(voice.main, buffer, startSample, numSamples, 1.0f, 0.0f)) {
+            voice.main.sample = nullptr;
+        }
+
+        if (voice.tail.sample != nullptr) {
+            int length = jmin(numSamples, voice.tailSamplesLeft);
+            bool going = renderPlayback(voice.tail, buffer, startSample, length, voice.tailSamplesLeft * fadeStep, fadeStep);
+            voice.tailSamplesLeft -= length;
+
+            if (!going || voice.tailSamplesLeft == 0) {
+                voice.tail.sample = nullptr;
+                voice.tailSamplesLeft = 0;
+            }
+        }
+    }
+}
+
+//this function adds a playback to the buffer, a loop wraps round and a one-shot ends at the end of its sample
+bool SamplerPads::renderPlayback(Playback& playback, AudioBuffer<float>& buffer, int startSample, int numSamples, float fadeGain, float fadeStep)
+{
+    const AudioBuffer<float>& data = playback.sample->data;
+    int length = data.getNumSamples();
+    int numChannels = jmin(2, buffer.getNumChannels());
+
+    float* out[2] = {};
+    const float* in[2] = {};
+    for (int channel = 0; channel < numChannels; ++channel) {
+        out[channel] = buffer.getWritePointer(channel, startSample);
+        in[channel] = data.getReadPointer(channel);
+    }
+
+    int done = 0;
+    while (done < numSamples) {
+        if (playback.increment == 1.0 && fadeStep == 0.0f && playback.position == std::floor(playback.position)) {
+            //at the device rate a run up to the end of the sample is one vector operation per channel
+            int index = (int) playback.position;
+            int run = jmin(numSamples - done, length - index);
+            for (int channel = 0; channel < numChannels; ++channel) {
+                FloatVectorOperations::addWithMultiply(out[channel] + done, in[channel] + index, playback.gain, run);
+            }
+            done += run;
+            playback.position += run;
+        }
+        else {
+            while (done < numSamples && playback.position < length) {
+                int index = (int) playback.position;
+                float fraction = (float) (playback.position - index);
+                int nextIndex = index + 1 < length ? index + 1 : (playback.looping ? 0 : index);
+                float sampleGain = playback.gain * fadeGain;
+
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    float a = in[channel][index];
+                    out[channel][done] += (a + fraction * (in[channel][nextIndex] - a)) * sampleGain;
+                }
+
+                fadeGain -= fadeStep;
+                playback.position += playback.increment;
+                ++done;
+            }
+        }
+
+        if (playback.position >= length) {
+            if (!playback.looping) {
+                return false;
+            }
+            playback.position -= length;
+        }
+    }
+    return true;
+}
+
+//this function logs a command at the sample of the block it is carried out on
+void SamplerPads::recordCommand(const Command& command, int offset)
+{
+    AutomationLog::Type type = AutomationLog::Type::padTrigger;
+    if (command.type == Command::Type::stop) {
+        type = AutomationLog::Type::padStop;
+    }
+    else if (command.type == Command::Type::stopAll) {
+        type = AutomationLog::Type::padStopAll;
+    }
+
+    automationLog->record(AutomationLog::Target::pads, type, command.pad, command.velocity, 0.0, offset);
+}
+
+//this function carries out one command at the sample it is due
+void SamplerPads::applyCommand(const Command& command, int64 now)
+{
+    switch (command.type) {
+        case Command::Type::trigger:
+        {
+            if (!isPositiveAndBelow(command.pad, numPads)) {
+                break;
+            }
+
+            //a loop that is playing is stopped by pressing its pad again
+            if (looping[command.pad].load()) {
+                bool stopped = false;
+                for (auto& voice : voices) {
+                    if (voice.main.sample != nullptr && voice.main.pad == command.pad) {
+                        fadeOutVoice(voice);
+                        stopped = true;
+                    }
+                }
+                if (stopped) {
+                    break;
+                }
+            }
+            startVoice(command.pad, command.velocity, now);
+            break;
+        }
+        case Command::Type::stop:
+            for (auto& voice : voices) {
+                if (voice.main.sample != nullptr && voice.main.pad == command.pad) {
+                    fadeOutVoice(voice);
+                }
+            }
+            break;
+        case Command::Type::stopAll:
+            for (auto& voice : voices) {
+                fadeOutVoice(voice);
+            }
+            break;
+    }
+}
+
+//this function starts a pad on a free voice, or takes over the voice that has played longest
+void SamplerPads::startVoice(int pad, float velocity, int64 now)
+{
+    const Sample* sample = padSamples[pad].load();
+    if (sample == nullptr) {
+        return;
+    }
+
+    //a voice that is silent, then one that is only fading, then the oldest
+    Voice* chosen = nullptr;
+    for (auto& voice : voices) {
+        if (voice.main.sample == nullptr && voice.tail.sample == nullptr) {
+            chosen = &voice;
+            break;
+        }
+    }
+    for (int i = 0; chosen == nullptr && i < numVoices; ++i) {
+        if (voices[i].main.sample == nullptr) {
+            chosen = &voices[i];
+        }
+    }
+    if (chosen == nullptr) {
+        chosen = &voices[0];
+        for (auto& voice : voices) {
+            if (voice.startedAt < chosen->startedAt) {
+                chosen = &voice;
+            }
+        }
+        fadeOutVoice(*chosen);
+    }
+
+    chosen->main.sample = sample;
+    chosen->main.pad = pad;
+    chosen->main.position = 0.0;
+    chosen->main.increment = sample->sampleRate / deviceSampleRate;
+    chosen->main.gain = jlimit(0.0f, 1.0f, velocity);
+    chosen->main.looping = looping[pad].load();
+    chosen->startedAt = now;
+}
+
+//this function moves a voice's sound to a tail, which fades out over the next few milliseconds. a voice that is still fading out an
+//earlier sound hands the new tail to another voice whose tail is free, so a tail is only cut short when every voice is fading one,
+//and then it is the one closest to silence
+void SamplerPads::fadeOutVoice(Voice& voice)
+{
+    if (voice.main.sample == nullptr) {
+        return;
+    }
+
+    Voice* host = &voice;
+    if (host->tail.sample != nullptr) {
+        for (auto& other : voices) {
+            if (other.tail.sample == nullptr) {
+                host = &other;
+                break;
+            }
+        }
+    }
+    if (host->tail.sample != nullptr) {
+        for (auto& other : voices) {
+            if (other.tailSamplesLeft < host->tailSamplesLeft) {
+                host = &other;
+            }
+        }
+    }
+
+    host->tail = voice.main;
+    host->tailSamplesLeft = fadeOutSamples;
+    voice.main.sample = nullptr;
+}
+
+//this function decodes a whole file for a pad and swaps it in
+bool SamplerPads::loadSample(int pad, const File& file)
+{
+    if (!isPositiveAndBelow(pad, numPads)) {
+        std::cout << "SamplerPads::loadSample pad should be between 0 and " << numPads - 1 << std::endl;
+        return false;
+    }
+
+    Sample::Ptr sample = decodeSample(file);
+    if (sample == nullptr) {
+        return false;
+    }
+
+    installSample(pad, sample, file);
+    return true;
+}
+
+//this function queues the decode of a file for a pad, replacing one that is still waiting or running for the same pad
+void SamplerPads::loadSampleInBackground(int pad, const File& file, std::function<void(bool)> onLoaded)
+{
+    if (!isPositiveAndBelow(pad, numPads)) {
+        std::cout << "SamplerPads::loadSampleInBackground pad should be between 0 and " << numPads - 1 << std::endl;
+        return;
+    }
+
+    jobScheduler.removeJobs(&samples[pad], 5000);
+    {
+        const ScopedLock sl(pendingLock);
+        pendingSamples.removeIf([pad](const PendingSample& pending) { return pending.pad == pad; });
+    }
+
+    //a sample the user just chose is waited for like a deck's track
+    jobScheduler.addJob(new DecodeJob(*this, pad, file, std::move(onLoaded)), JobScheduler::Priority::deck, &samples[pad], true);
+}
+
+//this function swaps in the samples the decode jobs have finished and tells the callers
+void SamplerPads::handleAsyncUpdate()
+{
+    Array<PendingSample> finished;
+    {
+        const ScopedLock sl(pendingLock);
+        finished.swapWith(pendingSamples);
+    }
+
+    for (auto& pending : finished) {
+        if (pending.sample != nullptr) {
+            installSample(pending.pad, pending.sample, pending.file);
+        }
+        if (pending.onLoaded != nullptr) {
+            pending.onLoaded(pending.sample != nullptr);
+        }
+    }
+}
+
+//this function reads a whole file into memory, a mono file into both channels
+SamplerPads::Sample::Ptr SamplerPads::decodeSample(const File& file) const
+{
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr) {
+        std::cout << "SamplerPads: cannot read " << file.getFullPathName() << std::endl;
+        return nullptr;
+    }
+
+    if (reader->lengthInSamples <= 0 || reader->lengthInSamples > (int64) (maxSampleSeconds * reader->sampleRate)) {
+        std::cout << "SamplerPads: " << file.getFileName() << " should be no longer than " << maxSampleSeconds << " seconds" << std::endl;
+        return nullptr;
+    }
+
+    Sample::Ptr sample = new Sample();
+    sample->data.setSize(2, (int) reader->lengthInSamples);
+    reader->read(&sample->data, 0, (int) reader->lengthInSamples, 0, true, true);
+    sample->sampleRate = reader->sampleRate;
+    sample->name = file.getFileNameWithoutExtension();
+    return sample;
+}
+
+//this function swaps a sample into a pad, the log keeps the file so a replay loads it on the same block
+void SamplerPads::installSample(int pad, Sample::Ptr sample, const File& file)
+{
+    AutomationLog::Action action(automationLog, AutomationLog::Target::pads, AutomationLog::Type::padLoad, pad, 0.0, 0.0, file.getFullPathName());
+
+    Sample::Ptr old = samples[pad];
+    samples[pad] = sample;
+    padSamples[pad] = sample.get();
+
+    //the block count is read after the swap, so any block that started later no longer sees the old sample
+    if (old != nullptr) {
+        retiredSamples.add({ old, renderedBlocks.load() });
+    }
+    releaseRetiredSamples();
+}
+
+//this function empties a pad, its voices stop at the next block
+void SamplerPads::clearSample(int pad)
+{
+    AutomationLog::Action action(automationLog, AutomationLog::Target::pads, AutomationLog::Type::padClear, pad);
+
+    if (!isPositiveAndBelow(pad, numPads)) {
+        return;
+    }
+
+    //a sample that is still being decoded for the pad never arrives
+    jobScheduler.removeJobs(&samples[pad], 5000);
+    {
+        const ScopedLock sl(pendingLock);
+        pendingSamples.removeIf([pad](const PendingSample& pending) { return pending.pad == pad; });
+    }
+
+    if (samples[pad] == nullptr) {
+        return;
+    }
+
+    padSamples[pad] = nullptr;
+    retiredSamples.add({ samples[pad], renderedBlocks.load() });
+    samples[pad] = nullptr;
+    releaseRetiredSamples();
+}
+
+//this function frees the replaced samples once a whole block has been rendered after they were swapped out
+void SamplerPads::releaseRetiredSamples()
+{
+    int64 blocks = renderedBlocks.load();
+    for (int i = retiredSamples.size(); --i >= 0;) {
+        if (blocks >= retiredSamples.getReference(i).retiredAtBlock + 2) {
+            retiredSamples.remove(i);
+        }
+    }
+}
+
+//this function returns the file name of a pad's sample, empty for an empty pad
+String SamplerPads::getSampleName(int pad) const
+{
+    return isPositiveAndBelow(pad, numPads) && samples[pad] != nullptr ? samples[pad]->name : String();
+}
+
+//this function returns the patterns of every format the format manager can read
+String SamplerPads::getFileWildcard() const
+{
+    return formatManager.getWildcardForAllFormats();
+}
+
+void SamplerPads::setLooping(int pad, bool shouldLoop)
+{
+    AutomationLog::Action action(automationLog, AutomationLog::Target::pads, AutomationLog::Type::padLooping, pad, shouldLoop ? 1.0 : 0.0);
+    if (isPositiveAndBelow(pad, numPads)) {
+        looping[pad] = shouldLoop;
+    }
+}
+
+bool SamplerPads::isLooping(int pad) const
+{
+    return isPositiveAndBelow(pad, numPads) && looping[pad].load();
+}
+
+//this function sets the gain of every pad
+void SamplerPads::setGain(float newGain)
+{
+    AutomationLog::Action action(automationLog, AutomationLog::Target::pads, AutomationLog::Type::padGain, 0, newGain);
+
+    if (newGain < 0.0f || newGain > 1.0f) {
+        std::cout << "SamplerPads::setGain gain should be between 0 and 1" << std::endl;
+        return;
+    }
+    gain = newGain;
+}
+
+//this function queues a command for the audio thread
+bool SamplerPads::pushCommand(Command command)
+{
+    return commandQueue.push(command);
+}
+
+//these functions trigger or stop a pad at the start of the next block
+void SamplerPads::trigger(int pad, float velocity)
+{
+    pushCommand({ Command::Type::trigger, pad, velocity, -1 });
+}
+
+void SamplerPads::stop(int pad)
+{
+    pushCommand({ Command::Type::stop, pad, 0.0f, -1 });
+}
+
+//this function returns the pads' clock
+int64 SamplerPads::getSamplePosition() const
+{
+    return renderedSamples.load();
+}
+
+//this function returns whether a pad was heard in the last block
+bool SamplerPads::isPlaying(int pad) const
+{
+    return isPositiveAndBelow(pad, numPads) && playing[pad].load();
+}
+
+//this function sets the log the pads' changes are recorded in
+void SamplerPads::setAutomationLog(AutomationLog* log)
+{
+    automationLog = log;
+}
@@ -0,0 +1,196 @@
+/*====================================================================
+SamplerPads.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include "AutomationLog.h"
+#include "CommandQueue.h"
+#include "JobScheduler.h"
+#include <functional>
+
+//this class is a bank of sample pads that plays into the master next to the decks. each pad holds a one-shot or a loop that is decoded
+//into memory when it is loaded, on the background workers when it is chosen in the GUI. the pads are played by a fixed pool of voices allocated up front: when every voice is busy the oldest
+//one is taken over and faded out, so pressing pads quickly never allocates or reads the disk in the callback. pads are triggered
+//through a command queue, either at the start of the next block or at an exact sample of the pads' own clock
+class SamplerPads : public AudioSource,
+                    private AsyncUpdater
+{
+public:
+    static constexpr int numPads = 8;
+    static constexpr int numVoices = 16;
+
+    //the longest sample a pad takes, so a wrong file cannot fill the memory
+    static constexpr double maxSampleSeconds = 30.0;
+
+    //how long a voice takes to fade out when it is stopped or taken over
+    static constexpr double fadeOutSeconds = 0.005;
+
+    //a pad action for the audio thread
+    struct Command
+    {
+        enum class Type
+        {
+            trigger,   //starts the pad, or stops it if it is a loop that is already playing
+            stop,      //fades out every voice of the pad
+            stopAll    //fades out every voice
+        };
+
+        Type type;
+        int pad;
+        float velocity;
+
+        //the sample of the pads' clock to act on, a time that has passed (or -1) is done at the start of the next block
+        int64 samplePosition;
+    };
+
+    SamplerPads(AudioFormatManager& formatManager, JobScheduler& jobScheduler);
+    ~SamplerPads() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    //decodes a file into memory for a pad on the calling thread, returns false if it cannot be read or is too long. an offline render
+    //uses this, so the sample is there for the very next block
+    bool loadSample(int pad, const File& file);
+
+    //decodes a file for a pad on the background workers and swaps it in on the message thread, then calls onLoaded with whether it
+    //worked. the pad keeps playing its old sample until then, and a second load of the same pad replaces the first
+    void loadSampleInBackground(int pad, const File& file, std::function<void(bool)> onLoaded);
+    void clearSample(int pad);
+    String getSampleName(int pad) const;
+
+    //the file patterns a pad can load
+    String getFileWildcard() const;
+
+    //a looping pad plays until it is triggered again or stopped
+    void setLooping(int pad, bool shouldLoop);
+    bool isLooping(int pad) const;
+
+    //the gain of every pad, from 0 to 1
+    void setGain(float gain);
+
+    //queues a command from any thread, returns false if the queue is full
+    bool pushCommand(Command command);
+
+    //the same as pushing a trigger or stop for the next block
+    void trigger(int pad, float velocity = 1.0f);
+    void stop(int pad);
+
+    //the samples the pads have rendered since the device started, to place commands on
+    int64 getSamplePosition() const;
+
+    //whether a voice of the pad was playing at the end of the last block
+    bool isPlaying(int pad) const;
+
+    //records every pad change in the log, nullptr stops it. set before the audio device starts
+    void setAutomationLog(AutomationLog* log);
+
+private:
+    class DecodeJob;
+
+    //a decoded sample, always two channels
+    struct Sample : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Sample>;
+
+        AudioBuffer<float> data;
+        double sampleRate = 44100.0;
+        String name;
+    };
+
+    //where a voice is in a sample
+    struct Playback
+    {
+        const Sample* sample = nullptr;
+        int pad = 0;
+        double position = 0.0;
+        double increment = 1.0;
+        float gain = 1.0f;
+        bool looping = false;
+    };
+
+    //a voice plays its sound and the faded tail of the sound it was playing before it was stopped or taken over
+    struct Voice
+    {
+        Playback main;
+        Playback tail;
+        int tailSamplesLeft = 0;
+        int64 startedAt = 0;
+    };
+
+    //a sample that was replaced, freed once the audio thread has finished a block without it
+    struct RetiredSample
+    {
+        Sample::Ptr sample;
+        int64 retiredAtBlock;
+    };
+
+    //a sample decoded by a DecodeJob that is waiting for the message thread, sample is nullptr if the file could not be decoded
+    struct PendingSample
+    {
+        int pad = 0;
+        Sample::Ptr sample;
+        File file;
+        std::function<void(bool)> onLoaded;
+    };
+
+    void handleAsyncUpdate() override;
+
+    //reads a whole file into a new sample on any thread, nullptr if it cannot be read or is too long
+    Sample::Ptr decodeSample(const File& file) const;
+
+    //swaps a decoded sample into a pad on the message thread and logs the load
+    void installSample(int pad, Sample::Ptr sample, const File& file);
+
+    //renders every voice into part of the block
+    void renderVoices(AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    //adds a playback to the buffer, fading it from fadeGain down by fadeStep per sample when fading, returns false once it has ended
+    static bool renderPlayback(Playback& playback, AudioBuffer<float>& buffer, int startSample, int numSamples, float fadeGain, float fadeStep);
+
+    void applyCommand(const Command& command, int64 now);
+    void recordCommand(const Command& command, int offset);
+    void startVoice(int pad, float velocity, int64 now);
+    void fadeOutVoice(Voice& voice);
+
+    //frees the replaced samples the audio thread can no longer be using
+    void releaseRetiredSamples();
+
+    AudioFormatManager& formatManager;
+
+    //decodes the samples chosen in the GUI, each pad's jobs have the pad's entry in samples as their owner
+    JobScheduler& jobScheduler;
+    CriticalSection pendingLock;
+    Array<PendingSample> pendingSamples;
+
+    //the samples the message thread owns, and the pointers the audio thread reads
+    Sample::Ptr samples[numPads];
+    std::atomic<Sample*> padSamples[numPads];
+    std::atomic<bool> looping[numPads];
+    Array<RetiredSample> retiredSamples;
+
+    std::atomic<float> gain{ 1.0f };
+
+    AutomationLog* automationLog = nullptr;
+
+    //commands from any thread
+    static constexpr int commandQueueSize = 256;
+    CommandQueue<Command, commandQueueSize> commandQueue;
+
+    //audio thread only: the voices, and the commands that are waiting for their sample
+    Voice voices[numVoices];
+    Command pending[commandQueueSize];
+    int numPending = 0;
+    double deviceSampleRate = 44100.0;
+    int fadeOutSamples = 1;
+
+    std::atomic<int64> renderedSamples{ 0 };
+    std::atomic<int64> renderedBlocks{ 0 };
+    std::atomic<bool> playing[numPads];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplerPads)
+};
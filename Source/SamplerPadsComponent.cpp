@@ -0,0 +1,130 @@
+/*====================================================================
+SamplerPadsComponent.cpp
+This class is the strip of sample pads under the master strip. It draws the pads itself instead of using buttons, so a pad fires on
+the mouse down and a right click can open its menu. Samples are chosen with a FileChooser and decoded on the background workers, the
+pad shows its new sample once it has been swapped in.
+====================================================================*/
+
+
+#include "SamplerPadsComponent.h"
+
+SamplerPadsComponent::SamplerPadsComponent(SamplerPads& _pads)
+    : pads(_pads)
+{
+    startTimerHz(30);
+}
+
+SamplerPadsComponent::~SamplerPadsComponent()
+{
+    stopTimer();
+}
+
+//this function draws each pad with its number and sample, darkcyan while it plays
+void SamplerPadsComponent::paint(Graphics& g)
+{
+    g.fillAll(Colour::fromRGB(29, 22, 22));
+    g.setFont(getHeight() * 0.45f);
+
+    for (int pad = 0; pad < SamplerPads::numPads; ++pad) {
+        auto bounds = getPadBounds(pad);
+        String name = pads.getSampleName(pad);
+
+        g.setColour(drawnPlaying[pad] ? Colours::darkcyan : Colour::fromRGB(39, 55, 77));
+        g.fillRoundedRectangle(bounds.toFloat(), 3.0f);
+
+        //a loop pad has a lighter outline
+        if (pads.isLooping(pad)) {
+            g.setColour(Colour::fromRGB(161, 227, 249));
+            g.drawRoundedRectangle(bounds.toFloat().reduced(0.5f), 3.0f, 1.0f);
+        }
+
+        g.setColour(name.isEmpty() ? Colours::grey : Colours::white);
+        g.drawText(String(pad + 1) + (name.isEmpty() ? String() : "  " + name), bounds.reduced(4, 0), Justification::centredLeft, true);
+    }
+}
+
+//this function triggers the pad under the mouse, or opens its menu on a right click
+void SamplerPadsComponent::mouseDown(const MouseEvent& e)
+{
+    int pad = getPadAt(e.getPosition());
+    if (pad < 0) {
+        return;
+    }
+
+    if (e.mods.isPopupMenu()) {
+        showPadMenu(pad);
+    }
+    else {
+        pads.trigger(pad);
+    }
+}
+
+//this function repaints when a pad starts or stops playing
+void SamplerPadsComponent::timerCallback()
+{
+    bool changed = false;
+    for (int pad = 0; pad < SamplerPads::numPads; ++pad) {
+        bool playing = pads.isPlaying(pad);
+        if (playing != drawnPlaying[pad]) {
+            drawnPlaying[pad] = playing;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        repaint();
+    }
+}
+
+//this function finds the pad under a point
+int SamplerPadsComponent::getPadAt(Point<int> position) const
+{
+    for (int pad = 0; pad < SamplerPads::numPads; ++pad) {
+        if (getPadBounds(pad).contains(position)) {
+            return pad;
+        }
+    }
+    return -1;
+}
+
+//this function splits the strip into equal pads with a small gap
+Rectangle<int> SamplerPadsComponent::getPadBounds(int pad) const
+{
+    int width = getWidth() / SamplerPads::numPads;
+    return Rectangle<int>(pad * width, 0, width, getHeight()).reduced(2);
+}
+
+//this function shows the menu of a pad
+void SamplerPadsComponent::showPadMenu(int pad)
+{
+    PopupMenu menu;
+    menu.addItem(1, "Load sample...");
+    menu.addItem(2, "Loop", true, pads.isLooping(pad));
+    menu.addItem(3, "Clear", pads.getSampleName(pad).isNotEmpty());
+
+    menu.showMenuAsync(PopupMenu::Options().withTargetComponent(this), [this, pad](int result) {
+        if (result == 1) {
+            chooser.reset(new FileChooser("Select a sample...", File(), pads.getFileWildcard()));
+            chooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles, [this, pad](const FileChooser& fileChooser) {
+                File chosenFile = fileChooser.getResult();
+                if (chosenFile.existsAsFile()) {
+                    Component::SafePointer<SamplerPadsComponent> safeThis(this);
+                    pads.loadSampleInBackground(pad, chosenFile, [safeThis](bool) {
+                        if (safeThis != nullptr) {
+                            safeThis->repaint();
+                        }
+                    });
+                }
+            });
+        }
+        else if (result == 2) {
+            pads.setLooping(pad, !pads.isLooping(pad));
+            repaint();
+        }
+        else if (result == 3) {
+            pads.stop(pad);
+            pads.clearSample(pad);
+            repaint();
+        }
+    });
+}
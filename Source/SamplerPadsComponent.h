@@ -0,0 +1,41 @@
+/*====================================================================
+SamplerPadsComponent.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SamplerPads.h"
+
+//this class draws the sample pads in a row. pressing a pad triggers it straight away, on the mouse down, and a right click opens a
+//menu to load a sample, make the pad a loop or clear it. a pad lights up while it is playing
+class SamplerPadsComponent : public Component,
+                             public Timer
+{
+public:
+    SamplerPadsComponent(SamplerPads& pads);
+    ~SamplerPadsComponent() override;
+
+    void paint(Graphics& g) override;
+
+    void mouseDown(const MouseEvent& e) override;
+
+    //follows which pads are playing
+    void timerCallback() override;
+
+private:
+    //the pad under a point, -1 between the pads
+    int getPadAt(Point<int> position) const;
+    Rectangle<int> getPadBounds(int pad) const;
+
+    void showPadMenu(int pad);
+
+    SamplerPads& pads;
+
+    //what was drawn, so the pads are only repainted when one starts or stops
+    bool drawnPlaying[SamplerPads::numPads] = {};
+
+    std::unique_ptr<FileChooser> chooser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplerPadsComponent)
+};
@@ -0,0 +1,351 @@
+/*====================================================================
+ScratchEngine.cpp
+This class keeps the audio around the playhead decoded in a ring buffer so the deck can be scratched and played backwards. The
+background thread grows the window a chunk at a time on whichever side is shorter and drops audio from the far side once the ring is
+full. The audio thread reads the ring without locking: the window it may read is published as one atomic value, and samples are only
+overwritten after any render that could still be reading them has finished. A track that is also being decoded whole by a
+ParallelTrackDecoder is read from that buffer wherever its chunks are done, and the ring only fills the gaps until it is finished.
+====================================================================*/
+
+
+#include "ScratchEngine.h"
+#include "Tracer.h"
+#include <cmath>
+
+//samples decoded per time slice, small enough to share the read-ahead thread with the decks
+static constexpr int chunkSize = 8192;
+
+//the window start goes in the top 40 bits and its length in the bottom 24
+static constexpr int lengthBits = 24;
+static constexpr int64 lengthMask = (1 << lengthBits) - 1;
+
+//4-point, 3rd-order Hermite interpolation between x0 and x1
+static inline float hermite(float xm1, float x0, float x1, float x2, float t)
+{
+    float c1 = 0.5f * (x1 - xm1);
+    float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+    return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+ScratchEngine::ScratchEngine(TimeSliceThread& _readAheadThread)
+    : readAheadThread(_readAheadThread)
+{
+    readAheadThread.addTimeSliceClient(this);
+}
+
+ScratchEngine::~ScratchEngine()
+{
+    readAheadThread.removeTimeSliceClient(this);
+}
+
+//this function swaps in the reader of a new track and starts an empty window at its beginning
+void ScratchEngine::setReader(AudioFormatReader* newReader, ParallelTrackDecoder::Ptr newDecodedTrack)
+{
+    std::unique_ptr<AudioFormatReader> oldReader;
+    AudioBuffer<float> newRing;
+    AudioBuffer<float> newChunkBuffer;
+    int64 newWindowSamples = 0;
+    int64 newCapacity = 0;
+
+    //the ring is allocated before taking the locks so the audio thread is not kept out for long
+    if (newReader != nullptr) {
+        int numChannels = jlimit(1, 2, (int) newReader->numChannels);
+        newWindowSamples = (int64) (windowSeconds * newReader->sampleRate);
+        newCapacity = 2 * newWindowSamples + 4 * chunkSize;
+        jassert(newCapacity <= lengthMask);
+
+        newRing.setSize(numChannels, (int) newCapacity);
+        newChunkBuffer.setSize(numChannels, chunkSize);
+    }
+
+    {
+        const ScopedLock sl(readerLock);
+        const ScopedLock rl(renderLock);
+
+        oldReader = std::move(reader);
+        reader.reset(newReader);
+
+        //the old decoder is released after the locks, with the old reader
+        std::swap(decodedTrack, newDecodedTrack);
+        decodedRange = {};
+        std::swap(ring, newRing);
+        std::swap(chunkBuffer, newChunkBuffer);
+        windowSamples = newWindowSamples;
+        capacity = newCapacity;
+
+        validRange = packRange(0, 0);
+        playhead = 0.0;
+        waitingForRender = false;
+        sourceSampleRate = newReader != nullptr ? newReader->sampleRate : 0.0;
+        totalLength = newReader != nullptr ? newReader->lengthInSamples : 0;
+        ++generation;
+    }
+}
+
+void ScratchEngine::prepareToPlay(int, double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+}
+
+//this function returns the sample rate of the track
+double ScratchEngine::getSourceSampleRate() const
+{
+    return sourceSampleRate.load();
+}
+
+//this function returns the length of the track in its own samples
+int64 ScratchEngine::getTotalLength() const
+{
+    return totalLength.load();
+}
+
+//this function returns how many tracks have been set
+int ScratchEngine::getGeneration() const
+{
+    return generation.load();
+}
+
+//this function moves the centre of the window
+void ScratchEngine::setPlayhead(double position)
+{
+    playhead = position;
+}
+
+//this function interpolates the window at a varying rate, ramping the rate over the block so jog movements never click
+int ScratchEngine::render(AudioBuffer<float>& buffer, int startSample, int numSamples, double& position, double& rate, double targetRate,
+                          double stopAt)
+{
+    targetRate = jlimit(-maxRate, maxRate, targetRate);
+
+    //only fails while a new track is being set
+    const ScopedTryLock stl(renderLock);
+    if (!stl.isLocked() || reader == nullptr) {
+        buffer.clear(startSample, numSamples);
+        rate = targetRate;
+        return numSamples;
+    }
+
+    renderCount.fetch_add(1);
+
+    uint64 range = validRange.load();
+    int64 first = rangeStart(range);
+    int64 last = first + rangeLength(range);
+
+    double step = sourceSampleRate.load() / deviceSampleRate;
+    double end = (double) totalLength.load();
+    double rateStep = (targetRate - rate) / numSamples;
+
+    int numOutputChannels = buffer.getNumChannels();
+    int numRingChannels = ring.getNumChannels();
+    const ParallelTrackDecoder* decoded = decodedTrack.get();
+
+    int i = 0;
+    for (; i < numSamples && position < stopAt; ++i)
+    {
+        int64 index = (int64) std::floor(position);
+        float t = (float) (position - (double) index);
+
+        //the decoded track is looked at again only when the position leaves the run of chunks it was last in
+        if (decoded != nullptr && !(index - 1 >= decodedRange.getStart() && index + 2 < decodedRange.getEnd())) {
+            decodedRange = decoded->getDecodedRangeAround(index);
+        }
+
+        if (decoded != nullptr && index - 1 >= decodedRange.getStart() && index + 2 < decodedRange.getEnd()) {
+            const AudioBuffer<float>& track = decoded->getBuffer();
+            for (int channel = 0; channel < numOutputChannels; ++channel) {
+                const float* src = track.getReadPointer(jmin(channel, track.getNumChannels() - 1), (int) index - 1);
+                buffer.setSample(channel, startSample + i, hermite(src[0], src[1], src[2], src[3], t));
+            }
+        }
+        else if (index - 1 >= first && index + 2 < last) {
+            int64 slot = (index - 1) % capacity;
+            for (int channel = 0; channel < numOutputChannels; ++channel) {
+                const float* src = ring.getReadPointer(jmin(channel, numRingChannels - 1));
+                float xm1 = src[slot];
+                float x0 = src[(slot + 1) % capacity];
+                float x1 = src[(slot + 2) % capacity];
+                float x2 = src[(slot + 3) % capacity];
+                buffer.setSample(channel, startSample + i, hermite(xm1, x0, x1, x2, t));
+            }
+        }
+        else {
+            //not decoded yet, or past either end of the track
+            for (int channel = 0; channel < numOutputChannels; ++channel) {
+                buffer.setSample(channel, startSample + i, 0.0f);
+            }
+        }
+
+        rate += rateStep;
+        position = jlimit(0.0, end, position + rate * step);
+    }
+
+    if (i == numSamples) {
+        rate = targetRate;
+    }
+
+    renderCount.fetch_add(1);
+    return i;
+}
+
+//this function checks the window around the playhead until it is there or the time is up
+bool ScratchEngine::waitUntilFilled(double seconds, int timeoutMs)
+{
+    uint32 started = Time::getMillisecondCounter();
+
+    while (true)
+    {
+        {
+            const ScopedLock sl(readerLock);
+
+            double rate = sourceSampleRate.load();
+            int64 length = totalLength.load();
+            if (reader == nullptr || rate <= 0.0) {
+                return true;
+            }
+
+            //the window never reaches past the ends of the track
+            int64 centre = (int64) playhead.load();
+            int64 first = jlimit((int64) 0, length, centre - (int64) (seconds * rate));
+            int64 last = jlimit((int64) 0, length, centre + (int64) (seconds * rate));
+
+            uint64 range = validRange.load();
+            if ((rangeStart(range) <= first && rangeStart(range) + rangeLength(range) >= last)
+                || (decodedTrack != nullptr && decodedTrack->isRangeDecoded(first, last))) {
+                return true;
+            }
+        }
+
+        if (Time::getMillisecondCounter() - started > (uint32) timeoutMs) {
+            return false;
+        }
+        Thread::sleep(1);
+    }
+}
+
+//this function decodes one chunk on the side of the playhead that has less audio, or starts over after a jump
+int ScratchEngine::useTimeSlice()
+{
+    const ScopedLock sl(readerLock);
+
+    if (reader == nullptr) {
+        return 100;
+    }
+
+    //the decoder works from the playhead outwards, and once it has the whole track the window is not needed
+    if (decodedTrack != nullptr) {
+        decodedTrack->setPriorityPosition((int64) playhead.load());
+        if (decodedTrack->isFinished() && !decodedTrack->hasFailed()) {
+            return 100;
+        }
+    }
+
+    if (waitingForRender && !dropIsSafe()) {
+        return 1;
+    }
+
+    uint64 range = validRange.load();
+    int64 start = rangeStart(range);
+    int64 end = start + rangeLength(range);
+    int64 total = reader->lengthInSamples;
+    int64 centre = jlimit((int64) 0, total, (int64) playhead.load());
+
+    //a seek, the old window is dropped and a new one grows from the playhead
+    if (centre < start - chunkSize || centre > end + chunkSize) {
+        validRange = packRange(centre, 0);
+        if (!dropIsSafe()) {
+            return 1;
+        }
+        start = end = centre;
+    }
+
+    int64 wantStart = jmax((int64) 0, centre - windowSamples);
+    int64 wantEnd = jmin(total, centre + windowSamples);
+    bool needAhead = end < wantEnd;
+    bool needBehind = start > wantStart;
+
+    if (needAhead && (!needBehind || end - centre <= centre - start)) {
+        int numSamples = (int) jmin((int64) chunkSize, wantEnd - end);
+
+        //drops the oldest audio behind the playhead when the ring is full
+        if (end + numSamples - start > capacity) {
+            start = end + numSamples - capacity;
+            validRange = packRange(start, end - start);
+            if (!dropIsSafe()) {
+                return 1;
+            }
+        }
+
+        writeToRing(end, numSamples);
+        validRange = packRange(start, end + numSamples - start);
+        return 0;
+    }
+
+    if (needBehind) {
+        int numSamples = (int) jmin((int64) chunkSize, start - wantStart);
+
+        //drops the audio furthest ahead when the ring is full
+        if (end - (start - numSamples) > capacity) {
+            end = start - numSamples + capacity;
+            validRange = packRange(start, end - start);
+            if (!dropIsSafe()) {
+                return 1;
+            }
+        }
+
+        writeToRing(start - numSamples, numSamples);
+        validRange = packRange(start - numSamples, end - start + numSamples);
+        return 0;
+    }
+
+    return 20;
+}
+
+//this function decodes samples from the track into their slots in the ring
+void ScratchEngine::writeToRing(int64 dest, int numSamples)
+{
+    Tracer::Scope trace("ScratchEngine::writeToRing", Tracer::Category::loading);
+    reader->read(&chunkBuffer, 0, numSamples, dest, true, true);
+
+    int slot = (int) (dest % capacity);
+    int firstPart = jmin(numSamples, (int) (capacity - slot));
+
+    for (int channel = 0; channel < ring.getNumChannels(); ++channel) {
+        ring.copyFrom(channel, slot, chunkBuffer, channel, 0, firstPart);
+        if (firstPart < numSamples) {
+            ring.copyFrom(channel, 0, chunkBuffer, channel, firstPart, numSamples - firstPart);
+        }
+    }
+}
+
+//this function checks whether a render that started before the window shrank has finished
+bool ScratchEngine::dropIsSafe()
+{
+    if (!waitingForRender) {
+        dropRenderCount = renderCount.load();
+        waitingForRender = true;
+    }
+
+    //an odd count means a render was running when the window shrank, it may still hold the old window
+    if ((dropRenderCount & 1) != 0 && renderCount.load() == dropRenderCount) {
+        return false;
+    }
+
+    waitingForRender = false;
+    return true;
+}
+
+uint64 ScratchEngine::packRange(int64 start, int64 length)
+{
+    return ((uint64) start << lengthBits) | (uint64) (length & lengthMask);
+}
+
+int64 ScratchEngine::rangeStart(uint64 range)
+{
+    return (int64) (range >> lengthBits);
+}
+
+int64 ScratchEngine::rangeLength(uint64 range)
+{
+    return (int64) (range & (uint64) lengthMask);
+}
@@ -0,0 +1,98 @@
+/*====================================================================
+ScratchEngine.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include "ParallelTrackDecoder.h"
+
+//this class plays a track at any rate in either direction for scratching and reverse play. a background thread keeps a window of the
+//decoded track in RAM on both sides of the playhead, and the audio thread reads it with 4-point Hermite interpolation, so a jog
+//movement is heard in the next block without any disk access on the audio thread. when the whole track is being decoded into RAM as
+//well, the parts of it that are finished are read instead and the window stops growing once all of it is
+class ScratchEngine : private TimeSliceClient
+{
+public:
+    //how much audio is kept decoded on each side of the playhead
+    static constexpr double windowSeconds = 8.0;
+
+    //the fastest the record can be moved, in either direction
+    static constexpr double maxRate = 8.0;
+
+    //one turn of a jog wheel moves the track by this much, the same as a 33 rpm record
+    static constexpr double secondsPerTurn = 1.8;
+
+    ScratchEngine(TimeSliceThread& readAheadThread);
+    ~ScratchEngine() override;
+
+    //takes ownership of a second reader of the loaded track, nullptr clears it. a decoder of the same track that has been started may be
+    //given too. called on the message thread
+    void setReader(AudioFormatReader* reader, ParallelTrackDecoder::Ptr decodedTrack = nullptr);
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    //the track's sample rate and length in its own samples, 0 if nothing is loaded
+    double getSourceSampleRate() const;
+    int64 getTotalLength() const;
+
+    //goes up by one every time a track is set, so the audio thread can tell that positions it holds are stale
+    int getGeneration() const;
+
+    //tells the background thread where the playhead is, in source samples, so the window stays around it. called on the audio thread
+    void setPlayhead(double position);
+
+    //renders numSamples from position (in source samples) while the rate ramps linearly to targetRate, 1 being normal speed forwards.
+    //it stops early once position reaches stopAt and returns the number of samples written. samples outside the window are silent.
+    //called on the audio thread, never blocks and never allocates
+    int render(AudioBuffer<float>& buffer, int startSample, int numSamples, double& position, double& rate, double targetRate,
+               double stopAt = std::numeric_limits<double>::max());
+
+    //waits up to timeoutMs for the window (or the decoded track) to hold the given number of seconds on each side of the playhead.
+    //for offline rendering, where the audio thread does not give the background thread a device's worth of time between blocks
+    bool waitUntilFilled(double seconds, int timeoutMs);
+
+private:
+    int useTimeSlice() override;
+
+    //copies decoded samples into the ring, dest is an absolute sample position
+    void writeToRing(int64 dest, int numSamples);
+
+    //the window is published as a single value so the audio thread always sees a start and length that belong together
+    static uint64 packRange(int64 start, int64 length);
+    static int64 rangeStart(uint64 range);
+    static int64 rangeLength(uint64 range);
+
+    //waits for a render that may still read samples which were just dropped from the window, true when it is safe to overwrite them
+    bool dropIsSafe();
+
+    TimeSliceThread& readAheadThread;
+
+    //the reader and ring are swapped under both locks, the background thread takes readerLock and the audio thread only tries renderLock
+    CriticalSection readerLock;
+    CriticalSection renderLock;
+    std::unique_ptr<AudioFormatReader> reader;
+    ParallelTrackDecoder::Ptr decodedTrack;
+    AudioBuffer<float> ring;
+    AudioBuffer<float> chunkBuffer;
+    int64 capacity = 0;
+    int64 windowSamples = 0;
+
+    std::atomic<uint64> validRange{ 0 };
+    std::atomic<double> playhead{ 0.0 };
+    std::atomic<double> sourceSampleRate{ 0.0 };
+    std::atomic<int64> totalLength{ 0 };
+    std::atomic<int> generation{ 0 };
+    double deviceSampleRate = 44100.0;
+
+    //odd while the audio thread is reading the ring, the background thread waits for it to move on after dropping samples
+    std::atomic<uint32> renderCount{ 0 };
+    uint32 dropRenderCount = 0;
+    bool waitingForRender = false;
+
+    //audio thread only: the run of decoded chunks the last sample was read from, so the chunk states are not checked every sample
+    Range<int64> decodedRange;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScratchEngine)
+};
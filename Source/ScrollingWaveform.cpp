@@ -0,0 +1,144 @@
+/*====================================================================
+ScrollingWaveform.cpp
+This class draws the zoomed waveform. For the zoom it picks the coarsest pyramid level whose peaks are no wider than a pixel, so each
+column is the union of at most three peaks, and it fills all the columns with one call. It reads the playhead on a 60 Hz timer and
+only repaints when the playhead moved or more of the pyramid was built.
+====================================================================*/
+
+
+#include "ScrollingWaveform.h"
+#include "Tracer.h"
+#include <cmath>
+
+ScrollingWaveform::ScrollingWaveform(DJAudioPlayer& _player, WaveformDisplay& _overview)
+    : player(_player),
+      overview(_overview)
+{
+    //the view fills itself, so nothing behind it is repainted with it
+    setOpaque(true);
+    startTimerHz(60);
+}
+
+ScrollingWaveform::~ScrollingWaveform()
+{
+    stopTimer();
+}
+
+//this function draws the beat grid, the waveform around the playhead, the hot cues and the playhead
+void ScrollingWaveform::paint(Graphics& g)
+{
+    Tracer::Scope trace("ScrollingWaveform::paint", Tracer::Category::gui);
+    g.fillAll(Colour::fromRGB(29, 22, 22));
+
+    int width = getWidth();
+    if (pyramid == nullptr || width <= 0) {
+        return;
+    }
+
+    double sampleRate = pyramid->getSampleRate();
+    double samplesPerPixel = visibleSeconds * sampleRate / width;
+
+    //a line for every beat while they are at least a few pixels apart, brighter on the first beat of each bar
+    double bpm = player.getBeatGridBpm();
+    if (bpm > 0.0 && 60.0 / bpm * sampleRate / samplesPerPixel >= 4.0) {
+        double beatSeconds = 60.0 / bpm;
+        double firstBeat = player.getFirstBeatSeconds();
+        double leftSeconds = playheadSeconds - visibleSeconds * 0.5;
+
+        for (int64 beat = (int64) std::ceil((leftSeconds - firstBeat) / beatSeconds); ; ++beat) {
+            float x = getX(firstBeat + beat * beatSeconds, samplesPerPixel);
+            if (x > width) {
+                break;
+            }
+            g.setColour(beat % 4 == 0 ? Colour::fromRGB(161, 227, 249).withAlpha(0.6f) : Colour::fromRGB(39, 102, 123));
+            g.drawVerticalLine(roundToInt(x), 0.0f, (float) getHeight());
+        }
+    }
+
+    int level = pyramid->getLevelFor(samplesPerPixel);
+    int samplesPerPeak = pyramid->getSamplesPerPeak(level);
+    int ready = pyramid->getNumPeaksReady(level);
+    double leftSample = playheadSeconds * sampleRate - width * 0.5 * samplesPerPixel;
+    float centreY = getHeight() * 0.5f;
+    float halfHeight = getHeight() * 0.45f;
+
+    columns.clear();
+    for (int x = 0; x < width; ++x) {
+        double start = leftSample + x * samplesPerPixel;
+        int firstPeak = jmax(0, (int) std::floor(start / samplesPerPeak));
+        int lastPeak = jmin(ready - 1, (int) std::floor((start + samplesPerPixel) / samplesPerPeak));
+
+        //before the start, after the end, or not built yet
+        if (start + samplesPerPixel < 0.0 || firstPeak > lastPeak) {
+            continue;
+        }
+
+        Range<float> peak = pyramid->getPeak(level, firstPeak);
+        for (int index = firstPeak + 1; index <= lastPeak; ++index) {
+            peak = peak.getUnionWith(pyramid->getPeak(level, index));
+        }
+
+        float top = centreY - peak.getEnd() * halfHeight;
+        columns.addWithoutMerging({ (float) x, top, 1.0f, jmax(1.0f, peak.getLength() * halfHeight) });
+    }
+
+    g.setColour(Colour::fromRGB(161, 227, 249));
+    g.fillRectList(columns);
+
+    //the hot cues with their pad numbers
+    g.setFont(jmin(12.0f, getHeight() * 0.25f));
+    for (int index = 0; index < DJAudioPlayer::numHotCues; ++index) {
+        double cue = player.getHotCue(index);
+        float x = getX(cue, samplesPerPixel);
+        if (cue >= 0.0 && x >= 0.0f && x <= width) {
+            g.setColour(Colours::orange);
+            g.drawVerticalLine(roundToInt(x), 0.0f, (float) getHeight());
+            g.drawText(String(index + 1), roundToInt(x) + 2, 0, 20, (int) (getHeight() * 0.3f), Justification::topLeft, false);
+        }
+    }
+
+    //the playhead stays in the middle
+    g.setColour(Colour::fromRGB(221, 230, 237));
+    g.fillRect(width * 0.5f - 1.0f, 0.0f, 2.0f, (float) getHeight());
+}
+
+//this function zooms in when the wheel goes up and out when it goes down, a step of the wheel is about a factor of two
+void ScrollingWaveform::mouseWheelMove(const MouseEvent&, const MouseWheelDetails& wheel)
+{
+    //at the closest zoom each pixel is one peak of the finest level
+    double sampleRate = pyramid != nullptr ? pyramid->getSampleRate() : 44100.0;
+    double minVisibleSeconds = jmax(1, getWidth()) * (double) PeakPyramid::baseSamplesPerPeak / sampleRate;
+
+    visibleSeconds = jlimit(minVisibleSeconds, maxVisibleSeconds, visibleSeconds * std::pow(2.0, -wheel.deltaY * 4.0));
+    repaint();
+}
+
+//this function goes back to the default zoom
+void ScrollingWaveform::mouseDoubleClick(const MouseEvent&)
+{
+    visibleSeconds = defaultVisibleSeconds;
+    repaint();
+}
+
+//this function picks up a new track, the playhead and any peaks built since the last frame
+void ScrollingWaveform::timerCallback()
+{
+    PeakPyramid::Ptr newPyramid = overview.getPeakPyramid();
+    double length = player.getLength();
+    double newPlayhead = length > 0.0 ? player.getPosition() * length : 0.0;
+    int newReady = newPyramid != nullptr ? newPyramid->getNumPeaksReady(0) : 0;
+
+    if (newPyramid != pyramid || newPlayhead != playheadSeconds || newReady != peaksReady) {
+        pyramid = newPyramid;
+        playheadSeconds = newPlayhead;
+        peaksReady = newReady;
+        repaint();
+    }
+}
+
+//this function maps a time in the track to the view, with the playhead in the middle
+float ScrollingWaveform::getX(double seconds, double samplesPerPixel) const
+{
+    double sampleRate = pyramid != nullptr ? pyramid->getSampleRate() : 44100.0;
+    return (float) (getWidth() * 0.5 + (seconds - playheadSeconds) * sampleRate / samplesPerPixel);
+}
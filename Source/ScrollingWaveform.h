@@ -0,0 +1,50 @@
+/*====================================================================
+ScrollingWaveform.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+#include "WaveformDisplay.h"
+#include "PeakPyramid.h"
+
+//this class is the zoomed view of a deck: the waveform around the playhead, which stays in the middle while the track scrolls past,
+//with the beat grid and the hot cues. the mouse wheel zooms and a double click goes back to the default zoom. it draws from the
+//overview's peak pyramid, so a frame costs the same at any zoom, and redraws at 60 fps
+class ScrollingWaveform : public Component,
+                          public Timer
+{
+public:
+    //how much of the track is shown at the default zoom, and the most that can be shown
+    static constexpr double defaultVisibleSeconds = 8.0;
+    static constexpr double maxVisibleSeconds = 120.0;
+
+    ScrollingWaveform(DJAudioPlayer& player, WaveformDisplay& overview);
+    ~ScrollingWaveform() override;
+
+    void paint(Graphics& g) override;
+
+    void mouseWheelMove(const MouseEvent& e, const MouseWheelDetails& wheel) override;
+    void mouseDoubleClick(const MouseEvent& e) override;
+
+    //follows the playhead and the pyramid while it is being built
+    void timerCallback() override;
+
+private:
+    //the x of a time in the track at the current zoom
+    float getX(double seconds, double samplesPerPixel) const;
+
+    DJAudioPlayer& player;
+    WaveformDisplay& overview;
+
+    PeakPyramid::Ptr pyramid;
+    int peaksReady = 0;
+    double playheadSeconds = 0.0;
+    double visibleSeconds = defaultVisibleSeconds;
+
+    //one rectangle per column, kept between frames so drawing does not allocate
+    RectangleList<float> columns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScrollingWaveform)
+};
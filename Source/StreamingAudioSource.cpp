@@ -0,0 +1,312 @@
+/*====================================================================
+StreamingAudioSource.cpp
+This class reads a file ahead into a ring buffer on the shared deck thread. The audio thread never takes a lock: it checks the buffered
+range, which the read-ahead thread publishes in atomics, copies what it needs and checks the range again to see that nothing was
+overwritten while it copied. Whether each block was buffered gives the stall statistics and lets analysis threads stay off the disk
+while a deck is short of audio.
+====================================================================*/
+
+
+#include "StreamingAudioSource.h"
+#include "Tracer.h"
+#include <limits>
+
+std::atomic<uint32> StreamingAudioSource::lastStarvedMs{ 0 };
+
+//analysis keeps backing off for this long after the last starved block
+static constexpr uint32 starvedHoldMs = 250;
+
+//the most the read-ahead reads in one time slice, so the other decks get their turn
+static constexpr int chunkSamples = 32768;
+
+//how often the read-ahead looks at the play position while the buffer is full, which is how long a seek waits to be noticed
+static constexpr int idleWaitMs = 10;
+
+StreamingAudioSource::StreamingAudioSource(AudioFormatReader* _reader, TimeSliceThread& _readAheadThread, double prefetchSeconds)
+    : reader(_reader),
+      readAheadThread(_readAheadThread),
+      sourceSampleRate(_reader->sampleRate),
+      prefetchSamples(jmax(4096, (int) (prefetchSeconds * _reader->sampleRate)))
+{
+    //a quarter of the window, so there is still time to catch up before the buffer runs dry
+    lowWatermarkSamples = prefetchSamples / 4;
+}
+
+StreamingAudioSource::~StreamingAudioSource()
+{
+    readAheadThread.removeTimeSliceClient(this);
+}
+
+//this function starts the read-ahead, a buffer that is already filling is kept so a preloaded intro is not read again
+void StreamingAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    if (prepared.load()) {
+        return;
+    }
+
+    buffer.setSize(jlimit(1, 2, (int) reader->numChannels), prefetchSamples);
+    prepared = true;
+    readAheadThread.addTimeSliceClient(this);
+}
+
+void StreamingAudioSource::releaseResources()
+{
+    readAheadThread.removeTimeSliceClient(this);
+    prepared = false;
+
+    validStart.store(0);
+    validEnd.store(0);
+    ++generation;
+    buffer.setSize(0, 0);
+}
+
+//this function plays the next block from the buffer and records whether it was ready in time
+void StreamingAudioSource::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+    int64 position = playPosition.load(std::memory_order_relaxed);
+    int numSamples = bufferToFill.numSamples;
+
+    //past the end of a track that does not loop there is only silence, which is not a stall
+    int64 wanted = numSamples;
+    if (!looping.load(std::memory_order_relaxed)) {
+        wanted = jlimit((int64) 0, (int64) numSamples, getTotalLength() - position);
+    }
+
+    uint32 generationBefore = generation.load(std::memory_order_acquire);
+    int64 start = validStart.load(std::memory_order_acquire);
+    int64 end = validEnd.load(std::memory_order_acquire);
+
+    int available = 0;
+    if (prepared.load() && position >= start && position < end) {
+        available = (int) jmin(wanted, end - position);
+    }
+
+    //copies what is buffered out of the ring, a mono file goes to both outputs
+    int ringSize = buffer.getNumSamples();
+    if (available > 0) {
+        int ringStart = (int) (position % ringSize);
+        int firstPart = jmin(available, ringSize - ringStart);
+
+        for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel) {
+            int source = jmin(channel, buffer.getNumChannels() - 1);
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, buffer, source, ringStart, firstPart);
+            if (available > firstPart) {
+                bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample + firstPart, buffer, source, 0, available - firstPart);
+            }
+        }
+
+        //the read-ahead moves validStart on before it overwrites anything and bumps generation before it starts again elsewhere,
+        //so a copy that raced with either is thrown away
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (generation.load(std::memory_order_relaxed) != generationBefore || validStart.load(std::memory_order_relaxed) > position) {
+            available = 0;
+        }
+    }
+
+    if (available < numSamples) {
+        bufferToFill.buffer->clear(bufferToFill.startSample + available, numSamples - available);
+    }
+
+    //a seek made while the block was copied wins over the position moving on
+    playPosition.compare_exchange_strong(position, position + numSamples, std::memory_order_relaxed);
+
+    bool ready = available >= wanted;
+    bool low = !ready;
+    if (ready && end < getReadLimit(position)) {
+        low = end - (position + numSamples) < lowWatermarkSamples;
+    }
+
+    numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (!ready) {
+        //a run of starved blocks is one stall
+        if (currentStallSamples == 0) {
+            numStalls.store(numStalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            Tracer::instant("StreamingAudioSource stall", Tracer::Category::audio);
+        }
+        currentStallSamples += numSamples;
+        stalledSamples.store(stalledSamples.load(std::memory_order_relaxed) + numSamples, std::memory_order_relaxed);
+        if (currentStallSamples > longestStallSamples.load(std::memory_order_relaxed)) {
+            longestStallSamples.store(currentStallSamples, std::memory_order_relaxed);
+        }
+    }
+    else {
+        currentStallSamples = 0;
+    }
+
+    if (low) {
+        lastStarvedMs.store(jmax((uint32) 1, Time::getMillisecondCounter()), std::memory_order_relaxed);
+    }
+}
+
+//this function can be called from any thread, the read-ahead starts again from the new position if it is not buffered
+void StreamingAudioSource::setNextReadPosition(int64 newPosition)
+{
+    playPosition.store(newPosition, std::memory_order_relaxed);
+}
+
+int64 StreamingAudioSource::getNextReadPosition() const
+{
+    return getFilePosition(playPosition.load(std::memory_order_relaxed));
+}
+
+int64 StreamingAudioSource::getTotalLength() const
+{
+    return reader->lengthInSamples;
+}
+
+bool StreamingAudioSource::isLooping() const
+{
+    return looping.load();
+}
+
+void StreamingAudioSource::setLooping(bool shouldLoop)
+{
+    looping = shouldLoop;
+}
+
+//this function returns the sample rate of the file
+double StreamingAudioSource::getSourceSampleRate() const
+{
+    return sourceSampleRate;
+}
+
+//this function returns the position in the file, a looping stream wraps around the length
+int64 StreamingAudioSource::getFilePosition(int64 position) const
+{
+    int64 length = getTotalLength();
+    if (looping.load(std::memory_order_relaxed) && length > 0 && position > 0) {
+        return position % length;
+    }
+    return position;
+}
+
+//this function returns where the read-ahead stops, the end of the track unless it loops
+int64 StreamingAudioSource::getReadLimit(int64 position) const
+{
+    if (looping.load(std::memory_order_relaxed)) {
+        return position + prefetchSamples;
+    }
+    return getTotalLength();
+}
+
+//this function checks the published range, it only reads atomics
+bool StreamingAudioSource::isBuffered(int64 start, int64 end) const
+{
+    return start >= validStart.load(std::memory_order_acquire) && end <= validEnd.load(std::memory_order_acquire);
+}
+
+//this function is the read-ahead thread's turn, it comes back straight away while there is more to read
+int StreamingAudioSource::useTimeSlice()
+{
+    return readNextChunk() ? 1 : idleWaitMs;
+}
+
+//this function reads the next chunk after the buffered range, or starts the range again at the play position after a seek away from it
+bool StreamingAudioSource::readNextChunk()
+{
+    int ringSize = buffer.getNumSamples();
+    if (ringSize == 0) {
+        return false;
+    }
+
+    int64 position = jmax((int64) 0, playPosition.load(std::memory_order_relaxed));
+    int64 start = validStart.load(std::memory_order_relaxed);
+    int64 end = validEnd.load(std::memory_order_relaxed);
+
+    //the range is published empty at the new position before the generation moves on, so the audio thread never sees the new
+    //generation with the old range
+    if (position < start || position > end) {
+        start = end = position;
+        validEnd.store(end, std::memory_order_relaxed);
+        validStart.store(start, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+
+    //a few samples are kept free so the ring never wraps onto the play position
+    int64 limit = jmin(position + ringSize - 4, getReadLimit(position));
+    int numSamples = (int) jmin((int64) chunkSamples, limit - end);
+    if (numSamples <= 0) {
+        return false;
+    }
+
+    //the samples about to be overwritten leave the range before they are touched
+    int64 newStart = jmax(start, end + numSamples - ringSize);
+    if (newStart != start) {
+        validStart.store(newStart, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int ringStart = (int) (end % ringSize);
+    int done = 0;
+    while (done < numSamples) {
+        int part = jmin(numSamples - done, ringSize - (ringStart + done) % ringSize);
+        //a looping stream wraps to the start of the file here
+        int64 filePosition = getFilePosition(end + done);
+        part = (int) jmin((int64) part, getTotalLength() - filePosition);
+        if (part <= 0) {
+            break;
+        }
+
+        reader->read(&buffer, (ringStart + done) % ringSize, part, filePosition, true, true);
+        done += part;
+    }
+
+    //a seek that came in while reading is picked up on the next slice, the samples read are still right for their positions
+    validEnd.store(end + done, std::memory_order_release);
+    bufferReady.signal();
+    return done > 0;
+}
+
+//this function blocks the calling (background) thread until the audio after the read position is buffered
+bool StreamingAudioSource::waitUntilBuffered(double seconds, int timeoutMs)
+{
+    int64 position = playPosition.load(std::memory_order_relaxed);
+    int64 remaining = getTotalLength() - getNextReadPosition();
+    if (looping.load()) {
+        remaining = std::numeric_limits<int64>::max();
+    }
+
+    //the buffer can never hold the whole window, the read-ahead keeps a few samples back
+    int numSamples = (int) jmin(remaining, (int64) (seconds * sourceSampleRate), (int64) prefetchSamples * 3 / 4);
+    if (numSamples <= 0) {
+        return true;
+    }
+
+    uint32 startMs = Time::getMillisecondCounter();
+    while (!isBuffered(position, position + numSamples)) {
+        int elapsed = (int) (Time::getMillisecondCounter() - startMs);
+        if (!prepared.load() || elapsed >= timeoutMs) {
+            return false;
+        }
+        bufferReady.wait(jmin(idleWaitMs, timeoutMs - elapsed));
+    }
+    return true;
+}
+
+//this function returns the stall statistics collected so far
+StreamingAudioSource::Statistics StreamingAudioSource::getStatistics() const
+{
+    Statistics statistics;
+    statistics.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    statistics.numStalls = numStalls.load(std::memory_order_relaxed);
+    statistics.stalledSeconds = stalledSamples.load(std::memory_order_relaxed) / sourceSampleRate;
+    statistics.longestStallSeconds = longestStallSamples.load(std::memory_order_relaxed) / sourceSampleRate;
+    return statistics;
+}
+
+//this function checks whether any playing stream was short of audio very recently
+bool StreamingAudioSource::isPlaybackStarved()
+{
+    uint32 last = lastStarvedMs.load(std::memory_order_relaxed);
+    return last != 0 && Time::getMillisecondCounter() - last < starvedHoldMs;
+}
+
+//this function is called by analysis jobs between reads, so the decks get the disk first
+void StreamingAudioSource::waitWhilePlaybackIsStarved(ThreadPoolJob& job)
+{
+    while (isPlaybackStarved() && !job.shouldExit())
+    {
+        Thread::sleep(20);
+    }
+}
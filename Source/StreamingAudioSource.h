@@ -0,0 +1,96 @@
+/*====================================================================
+StreamingAudioSource.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//this class plays a file through a large read-ahead buffer that is filled on a background thread, so a slow read from a USB stick or
+//network share never blocks the audio callback. it also counts how often playback caught up with the buffer (a stall)
+class StreamingAudioSource : public PositionableAudioSource,
+                             private TimeSliceClient
+{
+public:
+    struct Statistics
+    {
+        int64 numBlocks = 0;             //blocks played
+        int64 numStalls = 0;             //times the buffer ran dry, a run of starved blocks counts once
+        double stalledSeconds = 0.0;     //audio replaced by silence because it was not read in time
+        double longestStallSeconds = 0.0;
+    };
+
+    //takes ownership of the reader, prefetchSeconds is how much audio is kept read ahead of the playhead
+    StreamingAudioSource(AudioFormatReader* reader, TimeSliceThread& readAheadThread, double prefetchSeconds);
+    ~StreamingAudioSource() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill) override;
+
+    void setNextReadPosition(int64 newPosition) override;
+    int64 getNextReadPosition() const override;
+    int64 getTotalLength() const override;
+    bool isLooping() const override;
+    void setLooping(bool shouldLoop) override;
+
+    //the sample rate of the file
+    double getSourceSampleRate() const;
+
+    //waits up to timeoutMs for the given number of seconds after the read position to be buffered
+    bool waitUntilBuffered(double seconds, int timeoutMs);
+
+    Statistics getStatistics() const;
+
+    //true while a playing stream has less than its low watermark buffered, background analysis backs off its disk reads until it recovers
+    static bool isPlaybackStarved();
+    static void waitWhilePlaybackIsStarved(ThreadPoolJob& job);
+
+private:
+    //called on the read-ahead thread, fills the buffer up to a window ahead of the play position
+    int useTimeSlice() override;
+    bool readNextChunk();
+
+    //whether the samples from start to end are all buffered, for any thread
+    bool isBuffered(int64 start, int64 end) const;
+
+    //the position in the file of a position in the stream, which keeps counting past the end while looping
+    int64 getFilePosition(int64 position) const;
+
+    //the stream position the read-ahead stops at, the end of the track unless it loops
+    int64 getReadLimit(int64 position) const;
+
+    std::unique_ptr<AudioFormatReader> reader;
+    TimeSliceThread& readAheadThread;
+
+    double sourceSampleRate;
+    int prefetchSamples;
+    int lowWatermarkSamples;
+
+    //a ring holding the samples from validStart to validEnd, the sample at a position is at position % its length. only the read-ahead
+    //thread writes the ring and the range, and it moves validStart past the samples it is about to overwrite first, so the audio
+    //thread can tell from the range alone whether what it copied is still good. generation goes up whenever the read-ahead starts
+    //again somewhere else after a seek
+    AudioBuffer<float> buffer;
+    std::atomic<int64> validStart{ 0 };
+    std::atomic<int64> validEnd{ 0 };
+    std::atomic<uint32> generation{ 0 };
+    WaitableEvent bufferReady;
+
+    std::atomic<int64> playPosition{ 0 };
+    std::atomic<bool> looping{ false };
+    std::atomic<bool> prepared{ false };
+
+    //written by the audio thread only
+    std::atomic<int64> numBlocks{ 0 };
+    std::atomic<int64> numStalls{ 0 };
+    std::atomic<int64> stalledSamples{ 0 };
+    std::atomic<int64> longestStallSamples{ 0 };
+    int64 currentStallSamples = 0;
+
+    //when a playing stream was last below its low watermark, 0 if never
+    static std::atomic<uint32> lastStarvedMs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingAudioSource)
+};
@@ -0,0 +1,106 @@
+/*====================================================================
+TempoDetector.cpp
+This class finds the tempo of a track by autocorrelating the rises in its energy, then finds the beat phase with a comb over the same
+envelope.
+====================================================================*/
+
+
+#include "TempoDetector.h"
+#include <cmath>
+
+TempoDetector::TempoDetector(double sampleRate)
+    : envelopeRate(sampleRate / hopSize),
+      maxEnvelopeSize((size_t) (maxSecondsAnalysed * sampleRate / hopSize))
+{
+    envelope.reserve(4096);
+}
+
+//this function turns every hop of samples into one onset value: how much the energy rose since the previous hop
+void TempoDetector::pushSamples(const float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        hopEnergy += samples[i] * samples[i];
+
+        if (++samplesInHop == hopSize) {
+            float logEnergy = std::log(hopEnergy / hopSize + 1.0e-9f);
+            float rise = logEnergy - previousLogEnergy;
+
+            if (envelope.size() < maxEnvelopeSize) {
+                envelope.push_back(rise > 0.0f ? rise : 0.0f);
+            }
+
+            previousLogEnergy = logEnergy;
+            hopEnergy = 0.0f;
+            samplesInHop = 0;
+        }
+    }
+}
+
+//this function picks the beat period with the strongest autocorrelation (favouring tempos near 120bpm) and then the phase that lands most beats on onsets
+void TempoDetector::analyse(double& bpm, double& firstBeatSeconds) const
+{
+    bpm = 0.0;
+    firstBeatSeconds = 0.0;
+
+    int minLag = (int) std::floor(envelopeRate * 60.0 / maxBpm);
+    int maxLag = (int) std::ceil(envelopeRate * 60.0 / minBpm);
+    int numFrames = (int) envelope.size();
+
+    if (numFrames < maxLag * 8) {
+        return; //too short to find a beat
+    }
+
+    std::vector<double> autocorrelation((size_t) maxLag + 2, 0.0);
+    for (int lag = minLag - 1; lag <= maxLag + 1; ++lag) {
+        double sum = 0.0;
+        for (int i = lag; i < numFrames; ++i) {
+            sum += (double) envelope[(size_t) i] * envelope[(size_t) (i - lag)];
+        }
+        autocorrelation[(size_t) lag] = sum / (numFrames - lag);
+    }
+
+    int bestLag = 0;
+    double bestScore = 0.0;
+    for (int lag = minLag; lag <= maxLag; ++lag) {
+        //log-gaussian weight around 120bpm stops half and double tempos from winning
+        double lagBpm = 60.0 * envelopeRate / lag;
+        double octaves = std::log2(lagBpm / 120.0);
+        double score = autocorrelation[(size_t) lag] * std::exp(-0.5 * octaves * octaves / 0.25);
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    if (bestLag == 0) {
+        return;
+    }
+
+    //parabolic interpolation around the peak gives a fractional period
+    double left = autocorrelation[(size_t) bestLag - 1];
+    double centre = autocorrelation[(size_t) bestLag];
+    double right = autocorrelation[(size_t) bestLag + 1];
+    double denominator = left - 2.0 * centre + right;
+    double period = bestLag + (denominator < 0.0 ? 0.5 * (left - right) / denominator : 0.0);
+
+    bpm = 60.0 * envelopeRate / period;
+
+    //comb over the envelope for every phase inside one period
+    int numPhases = (int) std::ceil(period);
+    int bestPhase = 0;
+    double bestPhaseScore = -1.0;
+    for (int phase = 0; phase < numPhases; ++phase) {
+        double sum = 0.0;
+        for (double position = phase; position < numFrames; position += period) {
+            sum += envelope[(size_t) position];
+        }
+        if (sum > bestPhaseScore) {
+            bestPhaseScore = sum;
+            bestPhase = phase;
+        }
+    }
+
+    firstBeatSeconds = bestPhase / envelopeRate;
+}
@@ -0,0 +1,37 @@
+/*====================================================================
+TempoDetector.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <vector>
+
+//this class estimates the tempo and the position of the first beat of a track from an onset envelope. it is the beat grid the decks line up with
+class TempoDetector
+{
+public:
+    TempoDetector(double sampleRate);
+
+    void pushSamples(const float* samples, int numSamples);
+
+    //runs the estimate on everything pushed so far. bpm is 0 if no steady beat was found
+    void analyse(double& bpm, double& firstBeatSeconds) const;
+
+private:
+    static constexpr int hopSize = 128;
+    static constexpr double minBpm = 70.0;
+    static constexpr double maxBpm = 180.0;
+
+    //the envelope stops growing after 20 minutes, which is plenty to find the tempo
+    static constexpr double maxSecondsAnalysed = 20.0 * 60.0;
+
+    double envelopeRate;
+    size_t maxEnvelopeSize;
+
+    float hopEnergy = 0.0f;
+    int samplesInHop = 0;
+    float previousLogEnergy = 0.0f;
+
+    std::vector<float> envelope;
+};
@@ -0,0 +1,62 @@
+/*====================================================================
+ThrottledInputStream.cpp
+This class adds a fixed delay to every access of a stream, plus a regular long stall, so the read-ahead and stall statistics of the
+decks can be checked with local files.
+====================================================================*/
+
+
+#include "ThrottledInputStream.h"
+
+ThrottledInputStream::ThrottledInputStream(InputStream* _source, int _latencyMs, int _spikeMs, int _spikeInterval)
+    : source(_source),
+      latencyMs(_latencyMs),
+      spikeMs(_spikeMs),
+      spikeInterval(_spikeInterval)
+{
+}
+
+int64 ThrottledInputStream::getTotalLength()
+{
+    return source->getTotalLength();
+}
+
+bool ThrottledInputStream::isExhausted()
+{
+    return source->isExhausted();
+}
+
+//this function reads from the source after waiting like slow storage
+int ThrottledInputStream::read(void* destBuffer, int maxBytesToRead)
+{
+    waitLikeSlowStorage();
+    return source->read(destBuffer, maxBytesToRead);
+}
+
+int64 ThrottledInputStream::getPosition()
+{
+    return source->getPosition();
+}
+
+//this function seeks the source, seeks on slow storage cost as much as a read
+bool ThrottledInputStream::setPosition(int64 newPosition)
+{
+    if (newPosition != source->getPosition()) {
+        waitLikeSlowStorage();
+    }
+    return source->setPosition(newPosition);
+}
+
+//this function sleeps for the access latency, and for the spike on every spikeInterval'th access
+void ThrottledInputStream::waitLikeSlowStorage()
+{
+    ++numAccesses;
+
+    int delay = latencyMs;
+    if (spikeMs > 0 && spikeInterval > 0 && numAccesses % spikeInterval == 0) {
+        delay += spikeMs;
+    }
+
+    if (delay > 0) {
+        Thread::sleep(delay);
+    }
+}
@@ -0,0 +1,33 @@
+/*====================================================================
+ThrottledInputStream.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//this class stands in for slow storage when testing playback: it wraps a local file stream and makes every read and seek wait like a
+//USB stick or network share would, with a much longer stall every few reads
+class ThrottledInputStream : public InputStream
+{
+public:
+    //takes ownership of the source stream. spikeMs is added to every spikeInterval'th read, 0 turns the spikes off
+    ThrottledInputStream(InputStream* source, int latencyMs, int spikeMs = 0, int spikeInterval = 0);
+
+    int64 getTotalLength() override;
+    bool isExhausted() override;
+    int read(void* destBuffer, int maxBytesToRead) override;
+    int64 getPosition() override;
+    bool setPosition(int64 newPosition) override;
+
+private:
+    void waitLikeSlowStorage();
+
+    std::unique_ptr<InputStream> source;
+    int latencyMs;
+    int spikeMs;
+    int spikeInterval;
+    int numAccesses = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ThrottledInputStream)
+};
@@ -0,0 +1,246 @@
+/*====================================================================
+Tracer.cpp
+This file keeps one ring of events per thread. A thread claims a free ring the first time it records an event and gives it back when
+it ends, so the pools that come and go over a session reuse the same rings. The audio callback never claims one, claiming allocates:
+its ring is set aside when tracing is turned on and is used by whichever thread runs the callback. Only the owning thread writes a ring: it fills the slot
+and then publishes the new count, and the dump copies the ring and leaves out anything that was overwritten while it was copying.
+====================================================================*/
+
+
+#include "Tracer.h"
+#include <atomic>
+
+//one finished scope or moment, a negative duration marks a moment
+struct TraceEvent
+{
+    const char* name;
+    int64 startTicks;
+    int64 durationTicks;
+    Tracer::Category category;
+};
+
+//the events of one thread, written only by that thread
+struct TraceRing
+{
+    std::atomic<bool> inUse{ false };
+    std::atomic<uint64> numWritten{ 0 };
+    char threadName[64] = {};
+    TraceEvent events[Tracer::eventsPerThread];
+};
+
+static std::atomic<bool> enabled{ false };
+static std::atomic<TraceRing*> rings{ nullptr };
+static std::atomic<TraceRing*> audioRing{ nullptr };
+static std::atomic<int64> originTicks{ 0 };
+
+//the ring of the calling thread, plain thread-locals so finding it never allocates
+static thread_local TraceRing* threadRing = nullptr;
+static thread_local bool noRingLeft = false;
+
+//gives the ring back when its thread ends
+struct TraceRingOwner
+{
+    TraceRing* ring = nullptr;
+
+    ~TraceRingOwner()
+    {
+        if (ring != nullptr) {
+            ring->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static const char* getCategoryName(Tracer::Category category)
+{
+    switch (category)
+    {
+        case Tracer::Category::audio:    return "audio";
+        case Tracer::Category::loading:  return "loading";
+        case Tracer::Category::analysis: return "analysis";
+        case Tracer::Category::gui:      return "gui";
+    }
+    return "";
+}
+
+//this function takes the first free ring and names it, or returns nullptr when every ring is taken
+static TraceRing* takeFreeRing(TraceRing* all, const String& threadName)
+{
+    for (int index = 0; index < Tracer::maxThreads; ++index) {
+        bool expected = false;
+        if (!all[index].inUse.compare_exchange_strong(expected, true)) {
+            continue;
+        }
+
+        TraceRing* ring = &all[index];
+        ring->numWritten.store(0, std::memory_order_relaxed);
+        threadName.copyToUTF8(ring->threadName, sizeof(ring->threadName));
+        return ring;
+    }
+    return nullptr;
+}
+
+//this function claims a free ring for the calling thread, which is never the audio callback. it runs once per thread, names the ring
+//and creates the owner that gives it back, both of which allocate
+static TraceRing* claimRing(Tracer::Category category)
+{
+    TraceRing* all = rings.load(std::memory_order_acquire);
+    if (all == nullptr || noRingLeft) {
+        return nullptr;
+    }
+
+    String threadName;
+    if (MessageManager::existsAndIsCurrentThread()) {
+        threadName = "Message thread";
+    }
+    else if (auto* thread = Thread::getCurrentThread()) {
+        threadName = thread->getThreadName();
+    }
+    else {
+        threadName = String(getCategoryName(category)) + " thread";
+    }
+
+    TraceRing* ring = takeFreeRing(all, threadName);
+    if (ring == nullptr) {
+        //every ring is taken, this thread is left out of the trace
+        noRingLeft = true;
+        return nullptr;
+    }
+
+    static thread_local TraceRingOwner owner;
+    owner.ring = ring;
+    threadRing = ring;
+    return ring;
+}
+
+Tracer::Scope::Scope(const char* _name, Category _category)
+    : name(_name),
+      category(_category),
+      startTicks(enabled.load(std::memory_order_relaxed) ? Time::getHighResolutionTicks() : 0)
+{
+}
+
+Tracer::Scope::~Scope()
+{
+    if (startTicks != 0) {
+        record(name, category, startTicks, Time::getHighResolutionTicks() - startTicks);
+    }
+}
+
+void Tracer::instant(const char* name, Category category)
+{
+    if (enabled.load(std::memory_order_relaxed)) {
+        record(name, category, Time::getHighResolutionTicks(), -1);
+    }
+}
+
+//this function allocates every ring the first time and sets the audio callback's aside, they are kept until the app exits so a thread
+//never finds its ring gone
+void Tracer::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled && rings.load() == nullptr) {
+        static std::unique_ptr<TraceRing[]> allocatedRings(new TraceRing[maxThreads]);
+        originTicks = Time::getHighResolutionTicks();
+        audioRing.store(takeFreeRing(allocatedRings.get(), "Audio thread"), std::memory_order_release);
+        rings.store(allocatedRings.get(), std::memory_order_release);
+    }
+    enabled = shouldBeEnabled;
+}
+
+bool Tracer::isEnabled()
+{
+    return enabled.load();
+}
+
+//this function writes the slot after the newest event and then publishes it, so the dump never reads a slot that is half written.
+//a thread without a ring of its own records the audio callback's events in the ring set aside for it, only one thread runs the callback
+//at a time
+void Tracer::record(const char* name, Category category, int64 startTicks, int64 durationTicks)
+{
+    TraceRing* ring = threadRing;
+    if (ring == nullptr) {
+        ring = category == Category::audio ? audioRing.load(std::memory_order_acquire) : claimRing(category);
+    }
+    if (ring == nullptr) {
+        return;
+    }
+
+    uint64 index = ring->numWritten.load(std::memory_order_relaxed);
+    ring->events[index % eventsPerThread] = { name, startTicks, durationTicks, category };
+    ring->numWritten.store(index + 1, std::memory_order_release);
+}
+
+//this function writes the metadata naming each thread and then its events, as complete events and instant events of one process
+bool Tracer::writeChromeTrace(const File& file)
+{
+    TraceRing* all = rings.load(std::memory_order_acquire);
+    if (all == nullptr) {
+        std::cout << "Tracer::writeChromeTrace tracing should be enabled" << std::endl;
+        return false;
+    }
+
+    file.deleteFile();
+    FileOutputStream out(file);
+    if (out.failedToOpen()) {
+        return false;
+    }
+
+    auto toMicroseconds = [](int64 ticks) {
+        return String(Time::highResolutionTicksToSeconds(ticks) * 1.0e6, 3);
+    };
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto writeEvent = [&](const String& json) {
+        out << (first ? "" : ",\n") << json;
+        first = false;
+    };
+
+    int64 origin = originTicks.load();
+    std::vector<TraceEvent> copied((size_t) eventsPerThread);
+
+    for (int index = 0; index < maxThreads; ++index) {
+        TraceRing& ring = all[index];
+        uint64 end = ring.numWritten.load(std::memory_order_acquire);
+        if (end == 0) {
+            continue;
+        }
+
+        uint64 begin = end > (uint64) eventsPerThread ? end - eventsPerThread : 0;
+        for (uint64 event = begin; event < end; ++event) {
+            copied[(size_t) (event - begin)] = ring.events[event % eventsPerThread];
+        }
+
+        //the thread kept writing while its ring was copied, the events it may have overwritten are left out. the slot it was writing
+        //when the count was read again is not published yet and may be half written, so it is left out too
+        uint64 after = ring.numWritten.load(std::memory_order_acquire);
+        uint64 firstValid = after + 1 > (uint64) eventsPerThread ? jmax(begin, after + 1 - eventsPerThread) : begin;
+
+        String tid(index + 1);
+        writeEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":"
+                   + JSON::toString(String(ring.threadName)) + "}}");
+
+        for (uint64 event = firstValid; event < end; ++event) {
+            const TraceEvent& traced = copied[(size_t) (event - begin)];
+            String common = "{\"name\":" + JSON::toString(String(traced.name)) + ",\"cat\":\"" + getCategoryName(traced.category)
+                            + "\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + toMicroseconds(traced.startTicks - origin);
+
+            if (traced.durationTicks < 0) {
+                writeEvent(common + ",\"ph\":\"i\",\"s\":\"t\"}");
+            }
+            else {
+                writeEvent(common + ",\"ph\":\"X\",\"dur\":" + toMicroseconds(traced.durationTicks) + "}");
+            }
+        }
+    }
+
+    out << "\n]}\n";
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+//this function makes a file name from the date and time, in the user's documents
+File Tracer::getDefaultTraceFile()
+{
+    return File::getSpecialLocation(File::userDocumentsDirectory)
+        .getNonexistentChildFile("OtoDecks trace " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"), ".json", false);
+}
@@ -0,0 +1,56 @@
+/*====================================================================
+Tracer.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//this class records timed events from every thread of the app, so a glitch can be traced back to the audio callback, a load, the
+//analysis or the GUI. each thread writes into a ring of its own that was allocated up front, without locking, so a Scope costs two
+//clock reads and one store and tracing can be left on during a set. the last few thousand events of every thread are written out on
+//demand as a Chrome trace, which chrome://tracing and ui.perfetto.dev can open
+class Tracer
+{
+public:
+    //the threads that can be traced at once, and the events kept for each before the oldest are overwritten
+    static constexpr int maxThreads = 64;
+    static constexpr int eventsPerThread = 8192;
+
+    //the kind of work an event is, shown as its category in the trace
+    enum class Category : uint8
+    {
+        audio,
+        loading,
+        analysis,
+        gui
+    };
+
+    //records the time from its creation to its destruction as one event. the name must be a string literal, only its pointer is kept
+    struct Scope
+    {
+        Scope(const char* name, Category category);
+        ~Scope();
+
+        const char* name;
+        Category category;
+        int64 startTicks;
+    };
+
+    //records a moment, such as the read-ahead running dry
+    static void instant(const char* name, Category category);
+
+    //turning tracing on the first time allocates the rings and sets one aside for the audio callback, so it is done on the message
+    //thread before the audio device is opened
+    static void setEnabled(bool shouldBeEnabled);
+    static bool isEnabled();
+
+    //writes what the rings hold as Chrome trace JSON, returns false if the file cannot be written. called on the message thread
+    static bool writeChromeTrace(const File& file);
+
+    //a new file in the documents folder named after the time
+    static File getDefaultTraceFile();
+
+private:
+    static void record(const char* name, Category category, int64 startTicks, int64 durationTicks);
+};
@@ -0,0 +1,255 @@
+/*====================================================================
+TrackAnalyser.cpp
+This class runs the analysis of library tracks on the JobScheduler. Each job decodes one file, fingerprints it and checks the duplicate
+index, estimates its key, beat grid and loudness, then stores the results in the TrackLibrary. The waveforms for the WaveformCache are
+built from the same decoded blocks when the analyser has a cache and they are not saved yet.
+====================================================================*/
+
+
+#include "TrackAnalyser.h"
+#include "Tracer.h"
+#include "MonoAnalysisReader.h"
+#include "KeyDetector.h"
+#include "TempoDetector.h"
+#include "LoudnessAnalyser.h"
+#include "ColouredWaveform.h"
+#include "PeakPyramid.h"
+#include "StreamingAudioSource.h"
+
+//one job analyses one track from start to end
+class TrackAnalyser::AnalysisJob : public ThreadPoolJob
+{
+public:
+    AnalysisJob(TrackAnalyser& _owner, int _trackId, const File& _file)
+        : ThreadPoolJob("Analyse " + _file.getFileName()),
+          owner(_owner),
+          trackId(_trackId),
+          file(_file)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        analyse();
+        owner.jobFinished(trackId);
+        return jobHasFinished;
+    }
+
+private:
+    void analyse()
+    {
+        Tracer::Scope trace("TrackAnalyser::AnalysisJob", Tracer::Category::analysis);
+        std::unique_ptr<AudioFormatReader> reader(owner.formatManager.createReaderFor(file));
+        if (reader == nullptr) {
+            std::cout << "TrackAnalyser: cannot read " << file.getFullPathName() << std::endl;
+            return;
+        }
+
+        //all the analysis shares one decoding pass
+        MonoAnalysisReader monoReader(*reader, FingerprintExtractor::analysisSampleRate, decodeBlockSize);
+        FingerprintExtractor fingerprintExtractor;
+        KeyDetector keyDetector(FingerprintExtractor::analysisSampleRate);
+        TempoDetector tempoDetector(FingerprintExtractor::analysisSampleRate);
+        LoudnessAnalyser loudnessAnalyser(reader->sampleRate, (int) reader->numChannels);
+
+        //the waveforms need every channel at the file's own rate, so they take the blocks before the mixdown
+        WaveformCache* cache = owner.waveformCache;
+        int64 hash = WaveformCache::getHashFor(URL(file));
+        bool buildWaveforms = cache != nullptr && !cache->hasWaveformsFor(hash);
+
+        std::unique_ptr<AudioThumbnail> thumbnail;
+        ColouredWaveform::Ptr coloured;
+        std::unique_ptr<ColouredWaveform::Builder> builder;
+        PeakPyramid::Ptr pyramid;
+        std::unique_ptr<PeakPyramid::Builder> pyramidBuilder;
+        if (buildWaveforms) {
+            thumbnail.reset(new AudioThumbnail(WaveformCache::samplesPerThumbSample, owner.formatManager, cache->getThumbnailCache()));
+            thumbnail->reset((int) reader->numChannels, reader->sampleRate, reader->lengthInSamples);
+            coloured = new ColouredWaveform(reader->lengthInSamples, reader->sampleRate, WaveformCache::samplesPerThumbSample);
+            builder.reset(new ColouredWaveform::Builder(*coloured, decodeBlockSize));
+            pyramid = new PeakPyramid(reader->lengthInSamples, reader->sampleRate);
+            pyramidBuilder.reset(new PeakPyramid::Builder(*pyramid));
+        }
+
+        monoReader.onBlockDecoded = [&](const AudioBuffer<float>& decoded, int64 startSample, int numSamples) {
+            loudnessAnalyser.process(decoded, numSamples);
+            if (buildWaveforms) {
+                thumbnail->addBlock(startSample, decoded, 0, numSamples);
+                builder->process(decoded, numSamples);
+                pyramidBuilder->process(decoded, numSamples);
+            }
+        };
+
+        HeapBlock<float> block(blockSize);
+        int numRead;
+        while ((numRead = monoReader.read(block.getData(), blockSize)) > 0)
+        {
+            //stop early when the analyser is shutting down
+            if (shouldExit()) {
+                return;
+            }
+
+            //the decks read from the same storage and come first
+            StreamingAudioSource::waitWhilePlaybackIsStarved(*this);
+
+            fingerprintExtractor.pushSamples(block.getData(), numRead);
+            keyDetector.pushSamples(block.getData(), numRead);
+            tempoDetector.pushSamples(block.getData(), numRead);
+        }
+
+        owner.storeFingerprint(trackId, fingerprintExtractor.finish());
+
+        //the loudness goes in first because setMusicalInfo is what marks the track as analysed
+        owner.library.setLoudness(trackId, loudnessAnalyser.getIntegratedLoudness());
+
+        double bpm, firstBeat;
+        tempoDetector.analyse(bpm, firstBeat);
+        owner.library.setMusicalInfo(trackId, keyDetector.getKey(), bpm, firstBeat);
+
+        if (buildWaveforms) {
+            builder->finish();
+            pyramidBuilder->finish();
+            cache->getThumbnailCache().storeThumb(*thumbnail, hash);
+            cache->storeColouredWaveform(hash, coloured);
+            cache->storePeakPyramid(hash, pyramid);
+        }
+    }
+
+    static constexpr int blockSize = 4096;
+    static constexpr int decodeBlockSize = 8192;
+
+    TrackAnalyser& owner;
+    int trackId;
+    File file;
+};
+
+TrackAnalyser::TrackAnalyser(AudioFormatManager& _formatManager, TrackLibrary& _library, JobScheduler& _jobScheduler, WaveformCache* _waveformCache)
+    : formatManager(_formatManager),
+      library(_library),
+      jobScheduler(_jobScheduler),
+      waveformCache(_waveformCache)
+{
+}
+
+TrackAnalyser::~TrackAnalyser()
+{
+    //asks the running jobs to stop and waits for them
+    jobScheduler.removeJobs(this, 10000);
+}
+
+//this function adds the fingerprints that were loaded with the library to the duplicate index
+void TrackAnalyser::indexLibraryFingerprints()
+{
+    int numTracks = library.getNumTracks();
+
+    for (int trackId = 0; trackId < numTracks; ++trackId) {
+        if (library.hasFingerprint(trackId)) {
+            const ScopedLock sl(indexLock);
+            duplicateIndex.addAndFindDuplicate(trackId, library.getFingerprint(trackId));
+        }
+    }
+}
+
+//this function adds a job for the track to the scheduler unless every result is already in the library and the cache. a track that
+//is already waiting is moved to the class if it is more urgent than the one it waits in
+bool TrackAnalyser::analyseTrack(int trackId, JobScheduler::Priority priority)
+{
+    {
+        const ScopedLock sl(jobLock);
+        if (queuedJobs.contains(trackId)) {
+            QueuedJob queued = queuedJobs[trackId];
+            if (priority < queued.priority && jobScheduler.setPriority(queued.job, priority)) {
+                queuedJobs.set(trackId, { queued.job, priority });
+            }
+            return true;
+        }
+    }
+
+    File file = library.getFile(trackId);
+    if (!file.existsAsFile()) {
+        return false;
+    }
+
+    bool hasWaveforms = waveformCache == nullptr || waveformCache->hasWaveformsFor(WaveformCache::getHashFor(URL(file)));
+    if (library.isAnalysed(trackId) && library.hasLoudness(trackId) && hasWaveforms) {
+        return false;
+    }
+
+    const ScopedLock sl(jobLock);
+    if (!queuedJobs.contains(trackId)) {
+        auto* job = new AnalysisJob(*this, trackId, file);
+        queuedJobs.set(trackId, { job, priority });
+        jobScheduler.addJob(job, priority, this, true);
+    }
+    return true;
+}
+
+//this function queues the tracks on screen in the visible class and moves the tracks that left the screen back to the library class
+void TrackAnalyser::setVisibleTracks(const Array<int>& trackIds)
+{
+    Array<int> newOnScreen;
+    {
+        const ScopedLock sl(jobLock);
+        for (int trackId : trackIds) {
+            if (!visibleTrackIds.contains(trackId)) {
+                newOnScreen.add(trackId);
+            }
+        }
+        visibleTrackIds = trackIds;
+
+        Array<int> leftScreen;
+        for (HashMap<int, QueuedJob>::Iterator it(queuedJobs); it.next();) {
+            if (it.getValue().priority == JobScheduler::Priority::visible && !trackIds.contains(it.getKey())) {
+                leftScreen.add(it.getKey());
+            }
+        }
+
+        for (int trackId : leftScreen) {
+            QueuedJob queued = queuedJobs[trackId];
+            if (jobScheduler.setPriority(queued.job, JobScheduler::Priority::library)) {
+                queuedJobs.set(trackId, { queued.job, JobScheduler::Priority::library });
+            }
+        }
+    }
+
+    //checking a track reads its file's details, so the tracks that stayed on screen are not checked again
+    for (int trackId : newOnScreen) {
+        analyseTrack(trackId, JobScheduler::Priority::visible);
+    }
+}
+
+//this function returns the number of tracks waiting or being analysed
+int TrackAnalyser::getNumPendingJobs() const
+{
+    const ScopedLock sl(jobLock);
+    return queuedJobs.size();
+}
+
+//this function returns the scheduler the analysis jobs run on
+JobScheduler& TrackAnalyser::getJobScheduler()
+{
+    return jobScheduler;
+}
+
+//this function forgets the job of a track, called by the job itself once it is done with the track
+void TrackAnalyser::jobFinished(int trackId)
+{
+    const ScopedLock sl(jobLock);
+    queuedJobs.remove(trackId);
+}
+
+//this function stores the fingerprint and looks it up in the duplicate index
+void TrackAnalyser::storeFingerprint(int trackId, AcousticFingerprint fingerprint)
+{
+    int originalId;
+    {
+        const ScopedLock sl(indexLock);
+        originalId = duplicateIndex.addAndFindDuplicate(trackId, fingerprint);
+    }
+
+    library.setFingerprint(trackId, std::move(fingerprint));
+
+    if (originalId >= 0) {
+        library.setDuplicateOf(trackId, originalId);
+    }
+}
@@ -0,0 +1,67 @@
+/*====================================================================
+TrackAnalyser.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "AcousticFingerprint.h"
+#include "TrackLibrary.h"
+#include "WaveformCache.h"
+#include "JobScheduler.h"
+
+//this class analyses library tracks in the background on the JobScheduler and writes the results back into the library. each track is
+//queued in a priority class, a track queued again moves up to the more urgent class while it waits. when it is given a WaveformCache
+//the same decoding pass also builds the waveforms of the track and saves them in the cache
+class TrackAnalyser
+{
+public:
+    TrackAnalyser(AudioFormatManager& formatManager, TrackLibrary& library, JobScheduler& jobScheduler, WaveformCache* waveformCache = nullptr);
+    ~TrackAnalyser();
+
+    //queues a track for analysis and returns false if it already has all the results, so a stopped scan carries on where it was
+    bool analyseTrack(int trackId, JobScheduler::Priority priority = JobScheduler::Priority::library);
+
+    //queues the tracks on the playlist rows on screen ahead of the library, and moves the ones still waiting from rows that scrolled
+    //out of view back to the library class
+    void setVisibleTracks(const Array<int>& trackIds);
+
+    //puts the fingerprints loaded from the library file into the duplicate index
+    void indexLibraryFingerprints();
+
+    int getNumPendingJobs() const;
+
+    //the scheduler the analysis runs on, which the other library work shares
+    JobScheduler& getJobScheduler();
+
+private:
+    class AnalysisJob;
+
+    void storeFingerprint(int trackId, AcousticFingerprint fingerprint);
+
+    //called by a job once it has finished with its track
+    void jobFinished(int trackId);
+
+    AudioFormatManager& formatManager;
+    TrackLibrary& library;
+    JobScheduler& jobScheduler;
+    WaveformCache* waveformCache;
+
+    CriticalSection indexLock;
+    DuplicateIndex duplicateIndex;
+
+    //the jobs that have not finished and the class each was queued in, by track
+    struct QueuedJob
+    {
+        AnalysisJob* job;
+        JobScheduler::Priority priority;
+    };
+
+    CriticalSection jobLock;
+    HashMap<int, QueuedJob> queuedJobs;
+
+    //the tracks on screen the last time, only the ones new to the screen are looked at again
+    Array<int> visibleTrackIds;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackAnalyser)
+};
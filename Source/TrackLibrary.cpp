@@ -0,0 +1,321 @@
+/*====================================================================
+TrackLibrary.cpp
+This class keeps one entry per audio file with the results of the background analysis, so that the playlist and the decks can look
+them up by file. The entries are saved to an XML file between sessions.
+====================================================================*/
+
+
+#include "TrackLibrary.h"
+
+namespace
+{
+    //fingerprints are stored as the raw landmark array in base64
+    String fingerprintToString(const AcousticFingerprint& fingerprint)
+    {
+        MemoryBlock data(fingerprint.landmarks.data(), fingerprint.landmarks.size() * sizeof(AcousticFingerprint::Landmark));
+        return data.toBase64Encoding();
+    }
+
+    AcousticFingerprint fingerprintFromString(const String& text)
+    {
+        AcousticFingerprint fingerprint;
+        MemoryBlock data;
+
+        if (text.isNotEmpty() && data.fromBase64Encoding(text)) {
+            size_t numLandmarks = data.getSize() / sizeof(AcousticFingerprint::Landmark);
+            fingerprint.landmarks.resize(numLandmarks);
+            data.copyTo(fingerprint.landmarks.data(), 0, numLandmarks * sizeof(AcousticFingerprint::Landmark));
+        }
+
+        return fingerprint;
+    }
+}
+
+TrackLibrary::TrackLibrary()
+{
+}
+
+TrackLibrary::~TrackLibrary()
+{
+}
+
+//this function adds the file to the library unless it is already there and returns its id
+int TrackLibrary::addTrack(const File& file)
+{
+    const ScopedLock sl(lock);
+    return addTrackLocked(file);
+}
+
+//this function adds every file of the batch while holding the lock once, the listeners hear about the whole batch at the end
+std::vector<int> TrackLibrary::addTracks(const Array<File>& files)
+{
+    std::vector<int> trackIds;
+    trackIds.reserve((size_t) files.size());
+
+    {
+        const ScopedLock sl(lock);
+        for (const auto& file : files) {
+            trackIds.push_back(addTrackLocked(file));
+        }
+    }
+
+    sendChangeMessage();
+    return trackIds;
+}
+
+//this function does the work of addTrack, the lock must already be held
+int TrackLibrary::addTrackLocked(const File& file)
+{
+    String path = file.getFullPathName();
+    if (idsByPath.contains(path)) {
+        return idsByPath[path];
+    }
+
+    int trackId = (int) entries.size();
+    entries.emplace_back();
+    entries.back().file = file;
+    idsByPath.set(path, trackId);
+    return trackId;
+}
+
+//this function finds the id of a file, it returns -1 if the file has not been added
+int TrackLibrary::getTrackId(const File& file) const
+{
+    const ScopedLock sl(lock);
+
+    String path = file.getFullPathName();
+    return idsByPath.contains(path) ? idsByPath[path] : -1;
+}
+
+//this function returns the file of a track id
+File TrackLibrary::getFile(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].file : File();
+}
+
+//this function returns how many tracks the library holds
+int TrackLibrary::getNumTracks() const
+{
+    const ScopedLock sl(lock);
+    return (int) entries.size();
+}
+
+//this function stores the fingerprint calculated by the analyser
+void TrackLibrary::setFingerprint(int trackId, AcousticFingerprint fingerprint)
+{
+    {
+        const ScopedLock sl(lock);
+        if (!isValidId(trackId)) {
+            return;
+        }
+        entries[(size_t) trackId].fingerprint = std::move(fingerprint);
+    }
+    sendChangeMessage();
+}
+
+//this function checks if the track has already been fingerprinted
+bool TrackLibrary::hasFingerprint(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) && !entries[(size_t) trackId].fingerprint.isEmpty();
+}
+
+//this function returns a copy of the fingerprint of a track
+AcousticFingerprint TrackLibrary::getFingerprint(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].fingerprint : AcousticFingerprint();
+}
+
+//this function marks a track as a duplicate of another one
+void TrackLibrary::setDuplicateOf(int trackId, int originalTrackId)
+{
+    {
+        const ScopedLock sl(lock);
+        if (!isValidId(trackId)) {
+            return;
+        }
+        entries[(size_t) trackId].duplicateOf = originalTrackId;
+    }
+    sendChangeMessage();
+}
+
+//this function returns the track this one duplicates, or -1
+int TrackLibrary::getDuplicateOf(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].duplicateOf : -1;
+}
+
+//this function stores the key and beat grid and adds the track to the harmonic index
+void TrackLibrary::setMusicalInfo(int trackId, int key, double bpm, double firstBeatSeconds)
+{
+    {
+        const ScopedLock sl(lock);
+        if (!isValidId(trackId)) {
+            return;
+        }
+
+        Entry& entry = entries[(size_t) trackId];
+        entry.analysed = true;
+        entry.key = key;
+        entry.bpm = bpm;
+        entry.firstBeat = firstBeatSeconds;
+        harmonicIndex.addTrack(trackId, key, bpm);
+    }
+    sendChangeMessage();
+}
+
+//this function checks if the key and tempo of the track are known
+bool TrackLibrary::isAnalysed(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) && entries[(size_t) trackId].analysed;
+}
+
+//this function returns the key of the track, -1 if unknown
+int TrackLibrary::getKey(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].key : -1;
+}
+
+//this function returns the tempo of the track, 0 if unknown
+double TrackLibrary::getBpm(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].bpm : 0.0;
+}
+
+//this function returns where the first beat of the track is in seconds
+double TrackLibrary::getFirstBeat(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].firstBeat : 0.0;
+}
+
+//this function stores the integrated loudness of a track
+void TrackLibrary::setLoudness(int trackId, double loudness)
+{
+    {
+        const ScopedLock sl(lock);
+        if (!isValidId(trackId)) {
+            return;
+        }
+        entries[(size_t) trackId].loudness = loudness;
+        entries[(size_t) trackId].loudnessMeasured = true;
+    }
+    sendChangeMessage();
+}
+
+//this function returns whether the loudness of a track has been measured
+bool TrackLibrary::hasLoudness(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) && entries[(size_t) trackId].loudnessMeasured;
+}
+
+double TrackLibrary::getLoudness(int trackId) const
+{
+    const ScopedLock sl(lock);
+    return isValidId(trackId) ? entries[(size_t) trackId].loudness : 0.0;
+}
+
+//this function asks the harmonic index for tracks that mix well with the given key and tempo
+std::vector<int> TrackLibrary::findCompatibleTracks(int key, double bpm, double bpmTolerance, int excludeTrackId) const
+{
+    std::vector<int> result;
+
+    const ScopedLock sl(lock);
+    harmonicIndex.findCompatible(key, bpm, bpmTolerance, result, excludeTrackId);
+    return result;
+}
+
+//this function returns where the library is saved
+File TrackLibrary::getDefaultLibraryFile()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory)
+        .getChildFile("OtoDecks")
+        .getChildFile("library.xml");
+}
+
+//this function reads the entries saved by saveTo and adds them to the library
+bool TrackLibrary::loadFrom(const File& file)
+{
+    std::unique_ptr<XmlElement> xml = XmlDocument::parse(file);
+    if (xml == nullptr || !xml->hasTagName("LIBRARY")) {
+        return false;
+    }
+
+    {
+        const ScopedLock sl(lock);
+
+        //first pass adds every track so that duplicate paths can be turned into ids
+        for (auto* track : xml->getChildWithTagNameIterator("TRACK")) {
+            int trackId = addTrackLocked(File(track->getStringAttribute("path")));
+            Entry& entry = entries[(size_t) trackId];
+
+            entry.fingerprint = fingerprintFromString(track->getStringAttribute("fingerprint"));
+            entry.analysed = track->getBoolAttribute("analysed");
+            entry.key = track->getIntAttribute("key", -1);
+            entry.bpm = track->getDoubleAttribute("bpm");
+            entry.firstBeat = track->getDoubleAttribute("firstBeat");
+            entry.loudness = track->getDoubleAttribute("loudness");
+            entry.loudnessMeasured = track->hasAttribute("loudness");
+
+            if (entry.analysed) {
+                harmonicIndex.addTrack(trackId, entry.key, entry.bpm);
+            }
+        }
+
+        for (auto* track : xml->getChildWithTagNameIterator("TRACK")) {
+            String originalPath = track->getStringAttribute("duplicateOf");
+            if (originalPath.isNotEmpty() && idsByPath.contains(originalPath)) {
+                entries[(size_t) idsByPath[track->getStringAttribute("path")]].duplicateOf = idsByPath[originalPath];
+            }
+        }
+    }
+
+    sendChangeMessage();
+    return true;
+}
+
+//this function writes every entry into an XML file
+bool TrackLibrary::saveTo(const File& file) const
+{
+    XmlElement xml("LIBRARY");
+
+    {
+        const ScopedLock sl(lock);
+
+        for (const auto& entry : entries) {
+            auto* track = xml.createNewChildElement("TRACK");
+            track->setAttribute("path", entry.file.getFullPathName());
+            track->setAttribute("analysed", entry.analysed);
+            track->setAttribute("key", entry.key);
+            track->setAttribute("bpm", entry.bpm);
+            track->setAttribute("firstBeat", entry.firstBeat);
+
+            if (entry.loudnessMeasured) {
+                track->setAttribute("loudness", entry.loudness);
+            }
+
+            if (isValidId(entry.duplicateOf)) {
+                track->setAttribute("duplicateOf", entries[(size_t) entry.duplicateOf].file.getFullPathName());
+            }
+            if (!entry.fingerprint.isEmpty()) {
+                track->setAttribute("fingerprint", fingerprintToString(entry.fingerprint));
+            }
+        }
+    }
+
+    file.getParentDirectory().createDirectory();
+    return xml.writeTo(file);
+}
+
+//this function checks if an id belongs to an entry
+bool TrackLibrary::isValidId(int trackId) const
+{
+    return trackId >= 0 && trackId < (int) entries.size();
+}
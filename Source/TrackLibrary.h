@@ -0,0 +1,83 @@
+/*====================================================================
+TrackLibrary.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "AcousticFingerprint.h"
+#include "HarmonicIndex.h"
+#include <vector>
+
+//this class stores what the application knows about every track that has been added, independent of what the playlist is currently showing.
+//it can be read and written from the analysis threads and sends a change message whenever an entry is updated
+class TrackLibrary : public ChangeBroadcaster
+{
+public:
+    TrackLibrary();
+    ~TrackLibrary();
+
+    //adds a file and returns its id. adding the same file again returns the id it already has
+    int addTrack(const File& file);
+
+    //adds a batch of files under one lock with one change message, for imports of thousands of tracks. returns their ids in order
+    std::vector<int> addTracks(const Array<File>& files);
+
+    //returns -1 if the file is not in the library
+    int getTrackId(const File& file) const;
+    File getFile(int trackId) const;
+    int getNumTracks() const;
+
+    //acoustic fingerprint and the track it duplicates (-1 if it is not a duplicate)
+    void setFingerprint(int trackId, AcousticFingerprint fingerprint);
+    bool hasFingerprint(int trackId) const;
+    AcousticFingerprint getFingerprint(int trackId) const;
+    void setDuplicateOf(int trackId, int originalTrackId);
+    int getDuplicateOf(int trackId) const;
+
+    //key (see KeyDetector), tempo and the position of the first beat. setting them marks the track as analysed
+    void setMusicalInfo(int trackId, int key, double bpm, double firstBeatSeconds);
+    bool isAnalysed(int trackId) const;
+    int getKey(int trackId) const;
+    double getBpm(int trackId) const;
+    double getFirstBeat(int trackId) const;
+
+    //integrated loudness in LUFS, 0 until it has been measured. a measured 0 LUFS still counts as measured
+    void setLoudness(int trackId, double loudness);
+    bool hasLoudness(int trackId) const;
+    double getLoudness(int trackId) const;
+
+    //ids of tracks that mix harmonically with the given key within a tempo range, answered from the HarmonicIndex
+    std::vector<int> findCompatibleTracks(int key, double bpm, double bpmTolerance, int excludeTrackId = -1) const;
+
+    //the library file lives in the user's application data folder
+    static File getDefaultLibraryFile();
+    bool loadFrom(const File& file);
+    bool saveTo(const File& file) const;
+
+private:
+    struct Entry
+    {
+        File file;
+        AcousticFingerprint fingerprint;
+        int duplicateOf = -1;
+        bool analysed = false;
+        int key = -1;
+        double bpm = 0.0;
+        double firstBeat = 0.0;
+        double loudness = 0.0;
+        bool loudnessMeasured = false;
+    };
+
+    bool isValidId(int trackId) const;
+    int addTrackLocked(const File& file);
+
+    CriticalSection lock;
+
+    //track ids are indexes into this vector, entries are never removed
+    std::vector<Entry> entries;
+    HashMap<String, int> idsByPath;
+    HarmonicIndex harmonicIndex;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackLibrary)
+};
@@ -0,0 +1,239 @@
+/*====================================================================
+WaveformCache.cpp
+This class stores the thumbnail, coloured waveform and peak pyramid of each track under the same hash, dropping the oldest tracks when
+it is full.
+Every finished waveform is also written to the cache folder, one file per kind named after the hash, and a lookup that misses in
+memory reads it back from there.
+====================================================================*/
+
+
+#include "WaveformCache.h"
+
+//an AudioThumbnailCache that saves every finished thumbnail to the cache folder and loads it back when it is not in memory
+class WaveformCache::DiskThumbnailCache : public AudioThumbnailCache
+{
+public:
+    DiskThumbnailCache(WaveformCache& _owner, int maxNumThumbs)
+        : AudioThumbnailCache(maxNumThumbs),
+          owner(_owner)
+    {
+    }
+
+protected:
+    void saveNewlyFinishedThumbnail(const AudioThumbnailBase& thumb, int64 hashCode) override
+    {
+        //a thumbnail that was just read from its file is already saved
+        if (loadingFromDisk) {
+            return;
+        }
+
+        File file = owner.getThumbnailFile(hashCode);
+        if (file == File()) {
+            return;
+        }
+
+        //writes to a temporary file first so an interrupted write never leaves a broken thumbnail behind
+        TemporaryFile temp(file);
+        if (auto stream = std::unique_ptr<FileOutputStream>(temp.getFile().createOutputStream())) {
+            thumb.saveTo(*stream);
+            stream.reset();
+            temp.overwriteTargetFileWithTemporary();
+        }
+    }
+
+    bool loadNewThumb(AudioThumbnailBase& thumb, int64 hashCode) override
+    {
+        File file = owner.getThumbnailFile(hashCode);
+        if (!file.existsAsFile()) {
+            return false;
+        }
+
+        FileInputStream stream(file);
+        if (!stream.openedOk() || !thumb.loadFrom(stream)) {
+            return false;
+        }
+
+        //keeps it in memory for the next lookup without writing the file again. loadThumb calls this with the cache's lock held and
+        //storeThumb takes the same lock, so no other thread's thumbnail is stored while the flag is set
+        loadingFromDisk = true;
+        storeThumb(thumb, hashCode);
+        loadingFromDisk = false;
+        return true;
+    }
+
+private:
+    WaveformCache& owner;
+    bool loadingFromDisk = false;
+};
+
+WaveformCache::WaveformCache(int _maxNumTracks, JobScheduler& _jobScheduler, const File& _cacheFolder)
+    : maxNumTracks(_maxNumTracks),
+      jobScheduler(_jobScheduler),
+      cacheFolder(_cacheFolder),
+      thumbnailCache(new DiskThumbnailCache(*this, _maxNumTracks))
+{
+    if (cacheFolder != File()) {
+        cacheFolder.createDirectory();
+    }
+}
+
+WaveformCache::~WaveformCache()
+{
+    //each WaveformDisplay stops the waveform it is building before it goes
+}
+
+//this function returns the cache of AudioThumbnail data
+AudioThumbnailCache& WaveformCache::getThumbnailCache()
+{
+    return *thumbnailCache;
+}
+
+//this function looks up the coloured waveform of a track, in memory first and then on disk
+ColouredWaveform::Ptr WaveformCache::findColouredWaveform(int64 hash)
+{
+    {
+        const ScopedLock sl(lock);
+        if (colouredWaveforms.contains(hash)) {
+            return colouredWaveforms[hash];
+        }
+    }
+
+    File file = getColouredWaveformFile(hash);
+    if (!file.existsAsFile()) {
+        return nullptr;
+    }
+
+    FileInputStream stream(file);
+    ColouredWaveform::Ptr waveform = stream.openedOk() ? ColouredWaveform::readFrom(stream) : nullptr;
+    if (waveform != nullptr) {
+        const ScopedLock sl(lock);
+        if (!colouredWaveforms.contains(hash)) {
+            storedOrder.add(hash);
+        }
+        colouredWaveforms.set(hash, waveform);
+    }
+    return waveform;
+}
+
+//this function stores a finished coloured waveform on disk and in memory, removing the oldest one if the cache is full
+void WaveformCache::storeColouredWaveform(int64 hash, ColouredWaveform::Ptr waveform)
+{
+    File file = getColouredWaveformFile(hash);
+    if (file != File()) {
+        TemporaryFile temp(file);
+        if (auto stream = std::unique_ptr<FileOutputStream>(temp.getFile().createOutputStream())) {
+            bool written = waveform->writeTo(*stream);
+            stream.reset();
+            if (written) {
+                temp.overwriteTargetFileWithTemporary();
+            }
+        }
+    }
+
+    const ScopedLock sl(lock);
+
+    if (!colouredWaveforms.contains(hash)) {
+        storedOrder.add(hash);
+    }
+    colouredWaveforms.set(hash, waveform);
+
+    while (storedOrder.size() > maxNumTracks) {
+        colouredWaveforms.remove(storedOrder.getFirst());
+        storedOrder.remove(0);
+    }
+}
+
+//this function looks up the peak pyramid of a track, in memory first and then on disk
+PeakPyramid::Ptr WaveformCache::findPeakPyramid(int64 hash)
+{
+    {
+        const ScopedLock sl(lock);
+        if (peakPyramids.contains(hash)) {
+            return peakPyramids[hash];
+        }
+    }
+
+    File file = getPeakPyramidFile(hash);
+    if (!file.existsAsFile()) {
+        return nullptr;
+    }
+
+    FileInputStream stream(file);
+    PeakPyramid::Ptr pyramid = stream.openedOk() ? PeakPyramid::readFrom(stream) : nullptr;
+    if (pyramid != nullptr) {
+        const ScopedLock sl(lock);
+        if (!peakPyramids.contains(hash)) {
+            pyramidOrder.add(hash);
+        }
+        peakPyramids.set(hash, pyramid);
+    }
+    return pyramid;
+}
+
+//this function stores a finished peak pyramid on disk and in memory, removing the oldest one if the cache is full
+void WaveformCache::storePeakPyramid(int64 hash, PeakPyramid::Ptr pyramid)
+{
+    File file = getPeakPyramidFile(hash);
+    if (file != File()) {
+        TemporaryFile temp(file);
+        if (auto stream = std::unique_ptr<FileOutputStream>(temp.getFile().createOutputStream())) {
+            bool written = pyramid->writeTo(*stream);
+            stream.reset();
+            if (written) {
+                temp.overwriteTargetFileWithTemporary();
+            }
+        }
+    }
+
+    const ScopedLock sl(lock);
+
+    if (!peakPyramids.contains(hash)) {
+        pyramidOrder.add(hash);
+    }
+    peakPyramids.set(hash, pyramid);
+
+    while (pyramidOrder.size() > maxNumTracks) {
+        peakPyramids.remove(pyramidOrder.getFirst());
+        pyramidOrder.remove(0);
+    }
+}
+
+//this function checks the cache folder for all three files of a track
+bool WaveformCache::hasWaveformsFor(int64 hash) const
+{
+    return getThumbnailFile(hash).existsAsFile() && getColouredWaveformFile(hash).existsAsFile() && getPeakPyramidFile(hash).existsAsFile();
+}
+
+//this function returns the scheduler the waveform jobs run on
+JobScheduler& WaveformCache::getJobScheduler()
+{
+    return jobScheduler;
+}
+
+//this function returns the same hash AudioThumbnail uses for a URLInputSource
+int64 WaveformCache::getHashFor(const URL& url)
+{
+    return URLInputSource(url).hashCode();
+}
+
+//this function returns the waveform folder in the user's application data folder
+File WaveformCache::getDefaultCacheFolder()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile("OtoDecks").getChildFile("Waveforms");
+}
+
+//these functions return the files of a track in the cache folder, File() when there is no folder
+File WaveformCache::getThumbnailFile(int64 hash) const
+{
+    return cacheFolder == File() ? File() : cacheFolder.getChildFile(String::toHexString(hash) + ".thumb");
+}
+
+File WaveformCache::getColouredWaveformFile(int64 hash) const
+{
+    return cacheFolder == File() ? File() : cacheFolder.getChildFile(String::toHexString(hash) + ".colours");
+}
+
+File WaveformCache::getPeakPyramidFile(int64 hash) const
+{
+    return cacheFolder == File() ? File() : cacheFolder.getChildFile(String::toHexString(hash) + ".peaks");
+}
@@ -0,0 +1,66 @@
+/*====================================================================
+WaveformCache.h
+====================================================================*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "ColouredWaveform.h"
+#include "PeakPyramid.h"
+#include "JobScheduler.h"
+
+//this class keeps the waveform data of recently loaded tracks: the AudioThumbnail data and, next to it under the same hash, the coloured 3-band waveform
+//and the peak pyramid of the zoomed view. all three are also saved in a folder on disk, so waveforms built in an earlier session or by the batch
+//analyser are found without decoding the track. it also hands out the scheduler the tracks are decoded on to build them
+class WaveformCache
+{
+public:
+    //samples per point of the thumbnail, the coloured waveform uses the same bins
+    static constexpr int samplesPerThumbSample = 1000;
+
+    //cacheFolder can be File() to keep the waveforms in memory only
+    WaveformCache(int maxNumTracks, JobScheduler& jobScheduler, const File& cacheFolder = getDefaultCacheFolder());
+    ~WaveformCache();
+
+    AudioThumbnailCache& getThumbnailCache();
+
+    //returns nullptr if the track has not been analysed yet
+    ColouredWaveform::Ptr findColouredWaveform(int64 hash);
+    void storeColouredWaveform(int64 hash, ColouredWaveform::Ptr waveform);
+
+    //returns nullptr if the track has not been analysed yet
+    PeakPyramid::Ptr findPeakPyramid(int64 hash);
+    void storePeakPyramid(int64 hash, PeakPyramid::Ptr pyramid);
+
+    //whether all three kinds of waveform data of a track are saved on disk
+    bool hasWaveformsFor(int64 hash) const;
+
+    //the scheduler that builds the waveforms in the background
+    JobScheduler& getJobScheduler();
+
+    //the hash the thumbnail cache uses for a track, so every kind of data is stored under the same key
+    static int64 getHashFor(const URL& url);
+
+    //the folder next to the library file
+    static File getDefaultCacheFolder();
+
+private:
+    class DiskThumbnailCache;
+
+    File getThumbnailFile(int64 hash) const;
+    File getColouredWaveformFile(int64 hash) const;
+    File getPeakPyramidFile(int64 hash) const;
+
+    int maxNumTracks;
+    JobScheduler& jobScheduler;
+    File cacheFolder;
+    std::unique_ptr<DiskThumbnailCache> thumbnailCache;
+
+    CriticalSection lock;
+    HashMap<int64, ColouredWaveform::Ptr> colouredWaveforms;
+    Array<int64> storedOrder;
+    HashMap<int64, PeakPyramid::Ptr> peakPyramids;
+    Array<int64> pyramidOrder;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformCache)
+};
@@ -1,104 +1,303 @@
-/*====================================================================
-WaveformDisplay.cpp
-I have created this with the help of the tutorial from this course. I update and change majority of the codes and changed the looks of the wave form by giving it a gradient.
-This class is responsible for rendering the visual waveform of an audio file. And generating it onto the application by using paint().
-====================================================================*/
-
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "WaveformDisplay.h"
-
-WaveformDisplay::WaveformDisplay(AudioFormatManager& formatManagerToUse,
-    AudioThumbnailCache& cacheToUse) :
-    audioThumb(1000, formatManagerToUse, cacheToUse),
-    fileLoaded(false),
-    position(0)
-
-{
-    //adds change listenr to audioThumn
-    audioThumb.addChangeListener(this);
-}
-
-WaveformDisplay::~WaveformDisplay()
-{
-}
-
-//this function paints waveform display for an audio file
-void WaveformDisplay::paint(Graphics& g)
-{
-    g.fillAll(Colour::fromRGB(29, 22, 22)); //set background color
-    g.setColour(Colour::fromRGB(29, 22, 22)); //set outline color
-    g.drawRect(getLocalBounds(), 1); //draw an outline around the component
-    g.setColour(Colours::lightcoral); //setting the color of the waveform to light coral
-
-    //checks if the file is loaded. If it is, the waveform will be drawn
-    if (fileLoaded)
-    {
-        //add padding to the top and bottom
-        int padding = 10;
-        int usableHeight = getHeight() - 2 * padding; //height for the waveform with padding
-
-        //create a gradient from top to bottom
-        ColourGradient gradient(Colours::lightblue, 0.0f, 0.0f, //start color at the top
-            Colours::darkblue, 0.0f, (float)getHeight(), //end color at the bottom
-            false); //vertical gradient
-
-        g.setGradientFill(gradient); //set the gradient fill
-
-        //draw the waveform with the gradient above
-        audioThumb.drawChannel(g,
-            getLocalBounds().withTop(padding).withHeight(usableHeight), //apply height padding
-            0,
-            audioThumb.getTotalLength(),
-            0,
-            1.0f
-        );
-
-        //draw the playhead
-        g.setColour(Colour::fromRGB(221, 230, 237));
-        g.drawRect(position * getWidth(), 0, getWidth() / 20, getHeight()); //set the position of the rectangle with it moving.
-    }
-}
-
-//this function loads the url and repaints the waveform if file is loaded
-void WaveformDisplay::loadURL(URL audioURL)
-{
-    //clears audioThumb values
-    audioThumb.clear();
-    //variable to check if it is loaded
-    fileLoaded = audioThumb.setSource(new URLInputSource(audioURL));
-    if (fileLoaded)
-    {
-        repaint(); //paints the waveform
-    }
-    else {
-        std::cout << "wfd: not loaded! " << std::endl;
-    }
-
-}
-
-//this function repaints the waveform when a change is broadcasted.
-void WaveformDisplay::changeListenerCallback(ChangeBroadcaster* source)
-{
-    repaint();
-}
-
-//this function finds the postion of where the audio is and repaint if needed
-void WaveformDisplay::setPositionRelative(double pos)
-{
-    if (pos != position)
-    {
-        position = pos;
-        repaint();
-    }
-
-
-}
-
-//this function clears the audio thumbnail and removes the waveform
-void WaveformDisplay::clear()
-{
-    audioThumb.clear();  // This clears the audio thumbnail
-    fileLoaded = false;
-    repaint();  // Redraw the component
-}
+/*====================================================================
+WaveformDisplay.cpp
+I have created this with the help of the tutorial from this course. I update and change majority of the codes and changed the looks of the wave form by giving it a gradient.
+This class is responsible for rendering the visual waveform of an audio file. And generating it onto the application by using paint().
+The waveform is coloured by the low, mid and high bands of the deck EQ. One background decoding pass fills the AudioThumbnail, the
+coloured waveform and the peak pyramid of the zoomed view, so none of them adds another scan of the file.
+====================================================================*/
+
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WaveformDisplay.h"
+#include "Tracer.h"
+#include "StreamingAudioSource.h"
+
+//this job decodes the track once and feeds every block to the thumbnail and to the band analysis
+class WaveformDisplay::BuildJob : public ThreadPoolJob
+{
+public:
+    BuildJob(WaveformDisplay& _owner, const URL& _url, int64 _hash, int _loadId)
+        : ThreadPoolJob("Build waveform"),
+          owner(_owner),
+          url(_url),
+          hash(_hash),
+          loadId(_loadId)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        Tracer::Scope trace("WaveformDisplay::BuildJob", Tracer::Category::analysis);
+        std::unique_ptr<AudioFormatReader> reader(owner.formatManager.createReaderFor(url.createInputStream(false)));
+        if (reader == nullptr) {
+            std::cout << "wfd: not loaded! " << std::endl;
+            return jobHasFinished;
+        }
+
+        ColouredWaveform::Ptr coloured = new ColouredWaveform(reader->lengthInSamples, reader->sampleRate, WaveformCache::samplesPerThumbSample);
+        ColouredWaveform::Builder builder(*coloured, blockSize);
+        PeakPyramid::Ptr pyramid = new PeakPyramid(reader->lengthInSamples, reader->sampleRate);
+        PeakPyramid::Builder pyramidBuilder(*pyramid);
+
+        //hands the waveforms to the display straight away so it can draw the bins as they are finished
+        Component::SafePointer<WaveformDisplay> safeOwner(&owner);
+        int id = loadId;
+        MessageManager::callAsync([safeOwner, coloured, pyramid, id]() {
+            if (safeOwner != nullptr && safeOwner->loadCounter == id) {
+                safeOwner->colouredWaveform = coloured;
+                safeOwner->peakPyramid = pyramid;
+                safeOwner->fileLoaded = true;
+                safeOwner->repaint();
+            }
+        });
+
+        owner.audioThumb.reset((int) reader->numChannels, reader->sampleRate, reader->lengthInSamples);
+
+        AudioBuffer<float> block((int) reader->numChannels, blockSize);
+        for (int64 start = 0; start < reader->lengthInSamples; start += blockSize)
+        {
+            if (shouldExit()) {
+                return jobHasFinished;
+            }
+
+            //the decks read from the same storage and come first
+            StreamingAudioSource::waitWhilePlaybackIsStarved(*this);
+
+            int numSamples = (int) jmin((int64) blockSize, reader->lengthInSamples - start);
+            reader->read(&block, 0, numSamples, start, true, true);
+
+            owner.audioThumb.addBlock(start, block, 0, numSamples);
+            builder.process(block, numSamples);
+            pyramidBuilder.process(block, numSamples);
+        }
+
+        builder.finish();
+        pyramidBuilder.finish();
+
+        //every kind of waveform data is kept under the same hash
+        owner.waveformCache.getThumbnailCache().storeThumb(owner.audioThumb, hash);
+        owner.waveformCache.storeColouredWaveform(hash, coloured);
+        owner.waveformCache.storePeakPyramid(hash, pyramid);
+        return jobHasFinished;
+    }
+
+private:
+    static constexpr int blockSize = 32768;
+
+    WaveformDisplay& owner;
+    URL url;
+    int64 hash;
+    int loadId;
+};
+
+WaveformDisplay::WaveformDisplay(AudioFormatManager& formatManagerToUse,
+    WaveformCache& cacheToUse) :
+    formatManager(formatManagerToUse),
+    waveformCache(cacheToUse),
+    audioThumb(WaveformCache::samplesPerThumbSample, formatManagerToUse, cacheToUse.getThumbnailCache()),
+    fileLoaded(false),
+    position(0)
+
+{
+    //adds change listenr to audioThumn
+    audioThumb.addChangeListener(this);
+}
+
+WaveformDisplay::~WaveformDisplay()
+{
+    //the job uses audioThumb, so it has to stop first
+    cancelBuild();
+}
+
+//this function paints waveform display for an audio file
+void WaveformDisplay::paint(Graphics& g)
+{
+    Tracer::Scope trace("WaveformDisplay::paint", Tracer::Category::gui);
+    g.fillAll(Colour::fromRGB(29, 22, 22)); //set background color
+    g.setColour(Colour::fromRGB(29, 22, 22)); //set outline color
+    g.drawRect(getLocalBounds(), 1); //draw an outline around the component
+    g.setColour(Colours::lightcoral); //setting the color of the waveform to light coral
+
+    //checks if the file is loaded. If it is, the waveform will be drawn
+    if (fileLoaded)
+    {
+        //add padding to the top and bottom
+        int padding = 10;
+        int usableHeight = getHeight() - 2 * padding; //height for the waveform with padding
+
+        //draws the coloured waveform when it is available, the plain thumbnail otherwise
+        if (colouredWaveform != nullptr) {
+            drawColouredWaveform(g, getLocalBounds().withTop(padding).withHeight(usableHeight));
+        }
+        else {
+            //create a gradient from top to bottom
+            ColourGradient gradient(Colours::lightblue, 0.0f, 0.0f, //start color at the top
+                Colours::darkblue, 0.0f, (float)getHeight(), //end color at the bottom
+                false); //vertical gradient
+
+            g.setGradientFill(gradient); //set the gradient fill
+
+            //draw the waveform with the gradient above
+            audioThumb.drawChannel(g,
+                getLocalBounds().withTop(padding).withHeight(usableHeight), //apply height padding
+                0,
+                audioThumb.getTotalLength(),
+                0,
+                1.0f
+            );
+        }
+
+        //draw the playhead
+        g.setColour(Colour::fromRGB(221, 230, 237));
+        g.drawRect(position * getWidth(), 0, getWidth() / 20, getHeight()); //set the position of the rectangle with it moving.
+    }
+}
+
+//this function draws the peak of each band as a vertical line per pixel, low in red, mid in green and high in blue
+void WaveformDisplay::drawColouredWaveform(Graphics& g, Rectangle<int> area)
+{
+    int numBins = colouredWaveform->getNumBins();
+    int numBinsReady = colouredWaveform->getNumBinsReady();
+    int width = area.getWidth();
+
+    if (numBins == 0 || width <= 0) {
+        return;
+    }
+
+    const Colour bandColours[ColouredWaveform::numBands] = {
+        Colour::fromRGBA(255, 70, 70, 220),  //low
+        Colour::fromRGBA(80, 230, 100, 200), //mid
+        Colour::fromRGBA(90, 150, 255, 200)  //high
+    };
+
+    float centreY = (float) area.getCentreY();
+    float halfHeight = area.getHeight() * 0.5f;
+
+    for (int x = 0; x < width; ++x) {
+        int firstBin = (int) ((int64) x * numBins / width);
+        int endBin = jmax(firstBin + 1, (int) ((int64) (x + 1) * numBins / width));
+        endBin = jmin(endBin, numBinsReady);
+
+        //bins that have not been analysed yet are left empty
+        if (firstBin >= endBin) {
+            break;
+        }
+
+        for (int band = 0; band < ColouredWaveform::numBands; ++band) {
+            float level = 0.0f;
+            for (int bin = firstBin; bin < endBin; ++bin) {
+                level = jmax(level, colouredWaveform->getLevel(bin, (ColouredWaveform::Band) band));
+            }
+
+            g.setColour(bandColours[band]);
+            g.drawVerticalLine(area.getX() + x, centreY - level * halfHeight, centreY + level * halfHeight);
+        }
+    }
+}
+
+//this function loads the url and repaints the waveform if file is loaded
+void WaveformDisplay::loadURL(URL audioURL)
+{
+    //stops building the previous track and clears audioThumb values
+    cancelBuild();
+    audioThumb.clear();
+    colouredWaveform = nullptr;
+    peakPyramid = nullptr;
+    fileLoaded = false;
+    ++loadCounter;
+
+    int64 hash = WaveformCache::getHashFor(audioURL);
+
+    //uses the cached data if the thumbnail, the coloured waveform and the peak pyramid are all there
+    ColouredWaveform::Ptr cached = waveformCache.findColouredWaveform(hash);
+    PeakPyramid::Ptr cachedPyramid = cached != nullptr ? waveformCache.findPeakPyramid(hash) : nullptr;
+    if (cachedPyramid != nullptr && waveformCache.getThumbnailCache().loadThumb(audioThumb, hash))
+    {
+        colouredWaveform = cached;
+        peakPyramid = cachedPyramid;
+        fileLoaded = true;
+    }
+    else {
+        //builds both in the background with the deck's load, the display fills in as the job goes and shows the track once the job
+        //could open it
+        buildJob.reset(new BuildJob(*this, audioURL, hash, loadCounter));
+        waveformCache.getJobScheduler().addJob(buildJob.get(), JobScheduler::Priority::deck, this, false);
+    }
+
+    repaint(); //paints the waveform
+}
+
+//this function takes the finished coloured waveform and peak pyramid of the other display, they are reference counted and only read
+//once finished, and copies its thumbnail
+void WaveformDisplay::shareFrom(const WaveformDisplay& other, URL audioURL)
+{
+    bool finished = other.colouredWaveform != nullptr && other.colouredWaveform->isFinished()
+                    && other.peakPyramid != nullptr && other.peakPyramid->isFinished()
+                    && other.audioThumb.isFullyLoaded();
+    if (!finished) {
+        loadURL(audioURL);
+        return;
+    }
+
+    cancelBuild();
+    ++loadCounter;
+
+    colouredWaveform = other.colouredWaveform;
+    peakPyramid = other.peakPyramid;
+
+    //the thumbnail is copied through its saved form, it is only drawn when there is no coloured waveform
+    MemoryOutputStream thumbData;
+    other.audioThumb.saveTo(thumbData);
+    MemoryInputStream thumbInput(thumbData.getData(), thumbData.getDataSize(), false);
+    audioThumb.loadFrom(thumbInput);
+
+    fileLoaded = true;
+    repaint();
+}
+
+//this function stops the job building the waveform and waits for it, the job uses this display so it is only deleted once it has stopped
+void WaveformDisplay::cancelBuild()
+{
+    if (buildJob != nullptr) {
+        while (!waveformCache.getJobScheduler().removeJob(buildJob.get(), true, 5000)) {
+            std::cout << "WaveformDisplay::cancelBuild the waveform job is still running, waiting for it" << std::endl;
+        }
+        buildJob.reset();
+    }
+}
+
+//this function repaints the waveform when a change is broadcasted.
+void WaveformDisplay::changeListenerCallback(ChangeBroadcaster* source)
+{
+    repaint();
+}
+
+//this function finds the postion of where the audio is and repaint if needed
+void WaveformDisplay::setPositionRelative(double pos)
+{
+    if (pos != position)
+    {
+        position = pos;
+        repaint();
+    }
+
+
+}
+
+//this function returns the peak pyramid of the loaded track
+PeakPyramid::Ptr WaveformDisplay::getPeakPyramid() const
+{
+    return peakPyramid;
+}
+
+//this function clears the audio thumbnail and removes the waveform
+void WaveformDisplay::clear()
+{
+    cancelBuild();
+    ++loadCounter;
+    colouredWaveform = nullptr;
+    peakPyramid = nullptr;
+    audioThumb.clear();  // This clears the audio thumbnail
+    fileLoaded = false;
+    repaint();  // Redraw the component
+}
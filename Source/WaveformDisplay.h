@@ -1,38 +1,66 @@
-/*====================================================================
-WaveformDisplay.h
-====================================================================*/
-
-
-#pragma once
-
-#include "../JuceLibraryCode/JuceHeader.h"
-
-//this class displays an audio waveform and handles interactions like setting the playhead position
-class WaveformDisplay    : public Component, 
-                           public ChangeListener
-{
-public:
-    WaveformDisplay( AudioFormatManager & 	formatManagerToUse,
-                    AudioThumbnailCache & 	cacheToUse );
-    ~WaveformDisplay();
-
-    void paint (Graphics&) override;
-
-    void changeListenerCallback (ChangeBroadcaster *source) override;
-
-    void loadURL(URL audioURL);
-
-    void clear();
-
-    // set the relative position of the playhead
-    void setPositionRelative(double pos);
-
-private:
-    AudioThumbnail audioThumb;
-
-    bool fileLoaded;
-
-    double position;
-    
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformDisplay)
-};
+/*====================================================================
+WaveformDisplay.h
+====================================================================*/
+
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "ColouredWaveform.h"
+#include "PeakPyramid.h"
+#include "WaveformCache.h"
+
+//this class displays an audio waveform and handles interactions like setting the playhead position
+class WaveformDisplay    : public Component,
+                           public ChangeListener
+{
+public:
+    WaveformDisplay( AudioFormatManager & 	formatManagerToUse,
+                    WaveformCache & 	cacheToUse );
+    ~WaveformDisplay();
+
+    void paint (Graphics&) override;
+
+    void changeListenerCallback (ChangeBroadcaster *source) override;
+
+    void loadURL(URL audioURL);
+
+    //shows the waveform of the track another display has loaded, sharing its data instead of decoding the track again. only finished
+    //data is shared, a build that is cancelled would leave it half filled for good, so while the other display is still building this
+    //falls back to loadURL, which finds the cached data or builds it
+    void shareFrom(const WaveformDisplay& other, URL audioURL);
+
+    void clear();
+
+    // set the relative position of the playhead
+    void setPositionRelative(double pos);
+
+    //the peaks of the loaded track for the zoomed view, filled in while the track is decoded, nullptr before a load
+    PeakPyramid::Ptr getPeakPyramid() const;
+
+private:
+    class BuildJob;
+
+    //stops the background job that is building the waveform, if any
+    void cancelBuild();
+
+    //draws the 3-band waveform, one column per pixel
+    void drawColouredWaveform(Graphics& g, Rectangle<int> area);
+
+    AudioFormatManager& formatManager;
+    WaveformCache& waveformCache;
+
+    AudioThumbnail audioThumb;
+    ColouredWaveform::Ptr colouredWaveform;
+    PeakPyramid::Ptr peakPyramid;
+    std::unique_ptr<BuildJob> buildJob;
+
+    //counts the loads so results of a cancelled build are ignored
+    int loadCounter = 0;
+
+    bool fileLoaded;
+
+    double position;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformDisplay)
+};